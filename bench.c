@@ -0,0 +1,516 @@
+// clock_gettime lives behind POSIX, which -std=c99 hides unless we ask for it
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "matrix.h"
+
+// MARK - Benchmarks
+// Every public operation is timed on square matrices of each data type, at sizes that double from --min-size
+// up to --max-size. Each measurement repeats the operation (doubling the count each round) until it has run
+// for at least --min-time seconds, and reports the time per operation, the memory traffic and arithmetic it
+// implies, and how many allocations the library made per operation.
+// Results are printed as a table, or as JSON with --json so runs can be compared between library versions.
+// Run with `make bench`, passing options through BENCH_ARGS, for example `make bench BENCH_ARGS="--json"`.
+
+// MARK - Allocation counting
+// The makefile links this program with the allocator wrapped (-Wl,--wrap=...), so every malloc, calloc and
+// realloc made by the library comes through here first and can be counted.
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long allocations = 0;
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// MARK - Fixtures
+
+// Everything one benchmark works on. Which matrices are used depends on the operation.
+typedef struct {
+    int size;
+    DataType data_type;
+    StorageType storage;
+    Matrix a;
+    Matrix b;
+    Matrix c;
+    MatrixElement *line;
+} Fixture;
+
+// Fill a matrix with small values that are different from cell to cell
+static void fillMatrix(Matrix *mat, int seed) {
+    for (int r = 0; r < mat->rows; r++) {
+        for (int c = 0; c < mat->cols; c++) {
+            int value = (r * 7 + c * 3 + seed) % 17 - 8;
+            if (mat->data_type == INT) {
+                setIntElement(mat, r, c, value);
+            } else if (mat->data_type == DOUBLE) {
+                setDoubleElement(mat, r, c, value * 0.5);
+            } else {
+                setCharElement(mat, r, c, (char)('a' + value + 8));
+            }
+        }
+    }
+}
+
+// Create a filled square matrix of the fixture's size, type and storage
+// Returns 1 on success and 0 if it couldn't be allocated
+static int fixtureMatrix(Fixture *fixture, Matrix *mat, int seed) {
+    *mat = createMatrixWithStorage(fixture->size, fixture->size, fixture->data_type, fixture->storage);
+    if (!isValid(mat)) {
+        return 0;
+    }
+    fillMatrix(mat, seed);
+    return 1;
+}
+
+// Set up a fixture with one operand
+static int setupOne(Fixture *fixture) {
+    return fixtureMatrix(fixture, &fixture->a, 1);
+}
+
+// Set up a fixture with two different operands
+static int setupTwo(Fixture *fixture) {
+    return fixtureMatrix(fixture, &fixture->a, 1) && fixtureMatrix(fixture, &fixture->b, 2);
+}
+
+// Set up a fixture with an operand and an identical copy of it, so comparing them reads every value
+static int setupCopy(Fixture *fixture) {
+    if (!fixtureMatrix(fixture, &fixture->a, 1)) {
+        return 0;
+    }
+    fixture->b = deepCopyMatrix(&fixture->a);
+    return isValid(&fixture->b);
+}
+
+// Set up a fixture with an operand and a row's worth of elements to write into it
+static int setupLine(Fixture *fixture) {
+    if (!fixtureMatrix(fixture, &fixture->a, 1)) {
+        return 0;
+    }
+    fixture->line = getRowOrColumn(&fixture->a, ROW, 0);
+    return fixture->line != NULL;
+}
+
+// Set up a fixture with nothing in it, for operations that make their own matrices
+static int setupNothing(Fixture *fixture) {
+    (void)fixture;
+    return 1;
+}
+
+// Free everything a fixture holds
+static void teardown(Fixture *fixture) {
+    freeMatrix(&fixture->a);
+    freeMatrix(&fixture->b);
+    freeMatrix(&fixture->c);
+    free(fixture->line);
+    fixture->line = NULL;
+}
+
+// MARK - Operations
+// Each one runs the operation once. 'rep' counts up from 0, for operations that need to vary what they do.
+
+static void runCreate(Fixture *fixture, long rep) {
+    (void)rep;
+    Matrix mat = createMatrixWithStorage(fixture->size, fixture->size, fixture->data_type, fixture->storage);
+    freeMatrix(&mat);
+}
+
+static void runAdd(Fixture *fixture, long rep) {
+    (void)rep;
+    Matrix result = addMatrices(&fixture->a, &fixture->b);
+    freeMatrix(&result);
+}
+
+static void runSubtract(Fixture *fixture, long rep) {
+    (void)rep;
+    Matrix result = subtractMatrices(&fixture->a, &fixture->b);
+    freeMatrix(&result);
+}
+
+static void runMultiply(Fixture *fixture, long rep) {
+    (void)rep;
+    Matrix result = multiplyMatrices(&fixture->a, &fixture->b);
+    freeMatrix(&result);
+}
+
+static void runDeepCopy(Fixture *fixture, long rep) {
+    (void)rep;
+    Matrix copy = deepCopyMatrix(&fixture->a);
+    freeMatrix(&copy);
+}
+
+static void runSameness(Fixture *fixture, long rep) {
+    (void)rep;
+    checkMatrixSameness(&fixture->a, &fixture->b);
+}
+
+static void runRotate(Fixture *fixture, long rep) {
+    (void)rep;
+    rotateMatrix(&fixture->a);
+}
+
+// Copy out the top left quarter
+static void runSubset(Fixture *fixture, long rep) {
+    (void)rep;
+    int half = (fixture->size > 1) ? fixture->size / 2 - 1 : 0;
+    Matrix subset = createMatrixSubset(fixture->a, 0, half, 0, half);
+    freeMatrix(&subset);
+}
+
+// Shrink to half the size and grow back again, one step per rep
+static void runResize(Fixture *fixture, long rep) {
+    int size = (rep % 2 == 0) ? fixture->size / 2 : fixture->size;
+    resizeMatrix(&fixture->a, size, size);
+}
+
+static void runGetRow(Fixture *fixture, long rep) {
+    free(getRowOrColumn(&fixture->a, ROW, (int)(rep % fixture->size)));
+}
+
+static void runGetColumn(Fixture *fixture, long rep) {
+    free(getRowOrColumn(&fixture->a, COL, (int)(rep % fixture->size)));
+}
+
+static void runSetRow(Fixture *fixture, long rep) {
+    setRowOrColumn(&fixture->a, (int)(rep % fixture->size), ROW, fixture->line, fixture->size);
+}
+
+static void runSetColumn(Fixture *fixture, long rep) {
+    setRowOrColumn(&fixture->a, (int)(rep % fixture->size), COL, fixture->line, fixture->size);
+}
+
+// MARK - Cost models
+// How many matrix values one operation reads and writes, and how many arithmetic operations it does,
+// for an n x n matrix. These turn the time per operation into GB/s and GFLOP/s.
+
+static double valuesSquare(double n) {
+    return n * n;
+}
+
+static double valuesTwice(double n) {
+    return 2 * n * n;
+}
+
+static double valuesThrice(double n) {
+    return 3 * n * n;
+}
+
+// A quarter is read and written
+static double valuesSubset(double n) {
+    return 2 * (n / 2) * (n / 2);
+}
+
+// A quarter of the values are copied each way
+static double valuesResize(double n) {
+    return 2 * (n / 2) * (n / 2);
+}
+
+// One row or column is read, and written into the result (or the other way round)
+static double valuesLine(double n) {
+    return 2 * n;
+}
+
+static double flopsElementwise(double n) {
+    return n * n;
+}
+
+static double flopsMultiply(double n) {
+    return 2 * n * n * n;
+}
+
+// One benchmarked operation
+typedef struct {
+    const char *name;
+    int charSupported;
+    int cubic;
+    int (*setup)(Fixture *fixture);
+    void (*run)(Fixture *fixture, long rep);
+    double (*values)(double n);
+    double (*flops)(double n);
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+    {"create_free", 1, 0, setupNothing, runCreate,     valuesSquare, NULL},
+    {"add",         0, 0, setupTwo,     runAdd,        valuesThrice, flopsElementwise},
+    {"subtract",    0, 0, setupTwo,     runSubtract,   valuesThrice, flopsElementwise},
+    {"multiply",    0, 1, setupTwo,     runMultiply,   valuesThrice, flopsMultiply},
+    {"deep_copy",   1, 0, setupOne,     runDeepCopy,   valuesTwice,  NULL},
+    {"sameness",    1, 0, setupCopy,    runSameness,   valuesTwice,  NULL},
+    {"rotate",      1, 0, setupOne,     runRotate,     valuesTwice,  NULL},
+    {"subset",      1, 0, setupOne,     runSubset,     valuesSubset, NULL},
+    {"resize",      1, 0, setupOne,     runResize,     valuesResize, NULL},
+    {"get_row",     1, 0, setupOne,     runGetRow,     valuesLine,   NULL},
+    {"get_column",  1, 0, setupOne,     runGetColumn,  valuesLine,   NULL},
+    {"set_row",     1, 0, setupLine,    runSetRow,     valuesLine,   NULL},
+    {"set_column",  1, 0, setupLine,    runSetColumn,  valuesLine,   NULL},
+};
+
+#define BENCHMARK_COUNT ((int)(sizeof(benchmarks) / sizeof(benchmarks[0])))
+
+// MARK - Measurement
+
+// Options from the command line
+typedef struct {
+    int minSize;
+    int maxSize;
+    double minTime;
+    double maxOpTime;
+    int json;
+    StorageType storage;
+    const char *ops;
+    const char *types;
+} Options;
+
+// One measurement
+typedef struct {
+    long reps;
+    double nsPerOp;
+    double gbPerSecond;
+    double gflopPerSecond;
+    double allocsPerOp;
+} Result;
+
+// Seconds on a clock that only goes forwards
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+// Whether 'name' is in a comma separated list. A NULL list holds everything.
+static int listed(const char *list, const char *name) {
+    if (list == NULL) {
+        return 1;
+    }
+    size_t length = strlen(name);
+    for (const char *start = list; *start != '\0';) {
+        const char *end = strchr(start, ',');
+        size_t itemLength = (end != NULL) ? (size_t)(end - start) : strlen(start);
+        if (itemLength == length && strncmp(start, name, length) == 0) {
+            return 1;
+        }
+        if (end == NULL) {
+            break;
+        }
+        start = end + 1;
+    }
+    return 0;
+}
+
+// Size in bytes of one stored value
+static double valueBytes(DataType data_type, StorageType storage) {
+    if (storage == ELEMENT_STORAGE) {
+        return (double)sizeof(MatrixElement);
+    }
+    if (data_type == INT) {
+        return (double)sizeof(int);
+    }
+    return (data_type == DOUBLE) ? (double)sizeof(double) : (double)sizeof(char);
+}
+
+// Time one benchmark on one fixture
+// Returns 1 with the result filled in, or 0 if the fixture couldn't be set up
+static int measure(const Benchmark *benchmark, Fixture *fixture, const Options *options, Result *result) {
+    if (!benchmark->setup(fixture)) {
+        return 0;
+    }
+
+    // One untimed run first, so first-touch page faults and the thread pool starting up aren't counted
+    long rep = 0;
+    benchmark->run(fixture, rep++);
+
+    // Double the reps until a round lasts long enough
+    long reps = 1;
+    double elapsed = 0.0;
+    unsigned long allocated = 0;
+    for (;;) {
+        unsigned long allocationsBefore = allocations;
+        double start = now();
+        for (long i = 0; i < reps; i++) {
+            benchmark->run(fixture, rep++);
+        }
+        elapsed = now() - start;
+        allocated = allocations - allocationsBefore;
+        if (elapsed >= options->minTime || reps >= (1L << 40)) {
+            break;
+        }
+        reps *= 2;
+    }
+    teardown(fixture);
+
+    double n = (double)fixture->size;
+    double seconds = elapsed / (double)reps;
+    result->reps = reps;
+    result->nsPerOp = seconds * 1e9;
+    result->gbPerSecond = benchmark->values(n) * valueBytes(fixture->data_type, fixture->storage) / seconds / 1e9;
+    result->gflopPerSecond = (benchmark->flops != NULL) ? benchmark->flops(n) / seconds / 1e9 : -1.0;
+    result->allocsPerOp = (double)allocated / (double)reps;
+    return 1;
+}
+
+// Names of the data types, for output
+static const char *dataTypeName(DataType data_type) {
+    if (data_type == INT) {
+        return "INT";
+    }
+    return (data_type == DOUBLE) ? "DOUBLE" : "CHAR";
+}
+
+// Names of the instruction sets, for output
+static const char *instructionSetName(InstructionSet isa) {
+    switch (isa) {
+        case ISA_SSE2:
+            return "sse2";
+        case ISA_AVX2:
+            return "avx2";
+        case ISA_AVX512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+// Print one result as a table row, or as a JSON object
+static void printResult(const Options *options, const Benchmark *benchmark, const Fixture *fixture,
+                        const Result *result, int *first) {
+    if (options->json) {
+        printf("%s\n    {\"op\": \"%s\", \"type\": \"%s\", \"size\": %d, \"reps\": %ld, \"ns_per_op\": %.1f, "
+               "\"gb_per_s\": %.3f, ",
+               *first ? "" : ",", benchmark->name, dataTypeName(fixture->data_type), fixture->size, result->reps,
+               result->nsPerOp, result->gbPerSecond);
+        if (result->gflopPerSecond >= 0.0) {
+            printf("\"gflop_per_s\": %.3f, ", result->gflopPerSecond);
+        } else {
+            printf("\"gflop_per_s\": null, ");
+        }
+        printf("\"allocs_per_op\": %.2f}", result->allocsPerOp);
+    } else {
+        printf("%-12s %-7s %6d %14.1f %10.3f ", benchmark->name, dataTypeName(fixture->data_type), fixture->size,
+               result->nsPerOp, result->gbPerSecond);
+        if (result->gflopPerSecond >= 0.0) {
+            printf("%10.3f ", result->gflopPerSecond);
+        } else {
+            printf("%10s ", "-");
+        }
+        printf("%10.2f\n", result->allocsPerOp);
+    }
+    *first = 0;
+    fflush(stdout);
+}
+
+// Print how to use the program
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --json               print results as JSON\n"
+            "  --min-size N         smallest matrix size (default 4)\n"
+            "  --max-size N         largest matrix size (default 8192)\n"
+            "  --min-time SECONDS   shortest time to repeat each measurement for (default 0.2)\n"
+            "  --max-op-time SEC    skip sizes expected to take longer than this per operation (default 2)\n"
+            "  --packed             use packed storage instead of element storage\n"
+            "  --ops LIST           comma separated operations to run (default all)\n"
+            "  --types LIST         comma separated data types to run, from INT,DOUBLE,CHAR (default all)\n",
+            program);
+}
+
+int main(int argc, char *argv[]) {
+    Options options = {4, 8192, 0.2, 2.0, 0, ELEMENT_STORAGE, NULL, NULL};
+    for (int i = 1; i < argc; i++) {
+        int hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--json") == 0) {
+            options.json = 1;
+        } else if (strcmp(argv[i], "--packed") == 0) {
+            options.storage = PACKED_STORAGE;
+        } else if (strcmp(argv[i], "--min-size") == 0 && hasValue) {
+            options.minSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-size") == 0 && hasValue) {
+            options.maxSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            options.minTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-op-time") == 0 && hasValue) {
+            options.maxOpTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--ops") == 0 && hasValue) {
+            options.ops = argv[++i];
+        } else if (strcmp(argv[i], "--types") == 0 && hasValue) {
+            options.types = argv[++i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.minSize < 2) {
+        options.minSize = 2;
+    }
+
+    if (options.json) {
+        printf("{\n  \"isa\": \"%s\",\n  \"threads\": %d,\n  \"storage\": \"%s\",\n  \"min_time_s\": %.3f,\n"
+               "  \"results\": [",
+               instructionSetName(getInstructionSet()), getThreadCount(),
+               (options.storage == PACKED_STORAGE) ? "packed" : "element", options.minTime);
+    } else {
+        printf("# isa %s, %d threads, %s storage\n", instructionSetName(getInstructionSet()), getThreadCount(),
+               (options.storage == PACKED_STORAGE) ? "packed" : "element");
+        printf("%-12s %-7s %6s %14s %10s %10s %10s\n", "op", "type", "size", "ns/op", "GB/s", "GFLOP/s",
+               "allocs/op");
+    }
+
+    DataType types[] = {INT, DOUBLE, CHAR};
+    int first = 1;
+    for (int b = 0; b < BENCHMARK_COUNT; b++) {
+        const Benchmark *benchmark = &benchmarks[b];
+        if (!listed(options.ops, benchmark->name)) {
+            continue;
+        }
+        for (int t = 0; t < 3; t++) {
+            if (!listed(options.types, dataTypeName(types[t])) || (types[t] == CHAR && !benchmark->charSupported)) {
+                continue;
+            }
+
+            // Sizes double until the next one would take too long, going by how the last one did
+            double lastSeconds = 0.0;
+            for (int size = options.minSize; size <= options.maxSize; size *= 2) {
+                double growth = benchmark->cubic ? 8.0 : 4.0;
+                if (lastSeconds * growth > options.maxOpTime) {
+                    break;
+                }
+                Fixture fixture;
+                memset(&fixture, 0, sizeof(fixture));
+                fixture.size = size;
+                fixture.data_type = types[t];
+                fixture.storage = options.storage;
+
+                Result result;
+                if (!measure(benchmark, &fixture, &options, &result)) {
+                    teardown(&fixture);
+                    fprintf(stderr, "Skipping %s %s %d: out of memory\n", benchmark->name, dataTypeName(types[t]),
+                            size);
+                    break;
+                }
+                printResult(&options, benchmark, &fixture, &result, &first);
+                lastSeconds = result.nsPerOp * 1e-9;
+            }
+        }
+    }
+
+    if (options.json) {
+        printf("\n  ]\n}\n");
+    }
+    return EXIT_SUCCESS;
+}
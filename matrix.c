@@ -1,82 +1,282 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include "matrix.h"
+#include "matrix_internal.h"
+#include "matrix_text.h"
+
+// Packed INT storage promises 4 byte values, so refuse to build anywhere that isn't true
+typedef char packed_int_must_be_32_bits[(sizeof(int) == 4) ? 1 : -1];
+
+// Storage order for matrices created without asking for one
+// The makefile can pick it with -DROW_MAJOR_ORDER or -DCOLUMN_MAJOR_ORDER, and row major wins if neither is set
+#ifdef COLUMN_MAJOR_ORDER
+#define DEFAULT_STORAGE_ORDER COLUMN_MAJOR
+#else
+#define DEFAULT_STORAGE_ORDER ROW_MAJOR
+#endif
+
+// Edge length of the square tiles used when walking two matrices stored in different orders.
+// A 32x32 tile of the largest element is 8KB, so the tiles of both matrices fit in L1 together.
+#define ORDER_TILE 32
+
+// Size in bytes of a single value of a data type
+static size_t valueSize(DataType data_type) {
+    switch (data_type) {
+        case INT:
+            return sizeof(int);
+        case DOUBLE:
+            return sizeof(double);
+        case CHAR:
+            return sizeof(char);
+    }
+    return sizeof(MatrixElement);
+}
 
-// Create Matrix Function
-// Accepts an int of rows, an int of columns, and then a data type enum from the header
+// Size in bytes of one stored element
+// Element storage spends a whole MatrixElement union on every cell, packed storage only the native value
+static size_t storedSize(DataType data_type, StorageType storage) {
+    if (storage == PACKED_STORAGE) {
+        return valueSize(data_type);
+    }
+    return sizeof(MatrixElement);
+}
+
+// Size in bytes of one stored element of a matrix
+static size_t storedElementSize(const Matrix *mat) {
+    return storedSize(mat->data_type, mat->storage);
+}
+
+// Size in bytes of one stored element of a view
+static size_t viewElementSize(const MatrixView *view) {
+    return storedSize(view->data_type, view->storage);
+}
+
+// How many native values apart two neighbouring stored elements of a view are.
+// Every member of a union starts at the union's own address, so a pointer to a stored element
+// is also a pointer to its value, and stepping by this spacing walks the values of either storage type.
+static size_t viewValueSpacing(const MatrixView *view) {
+    return viewElementSize(view) / valueSize(view->data_type);
+}
+
+// Number of rows (row major) or columns (column major), which are the contiguous lines of the block
+static int primaryDimension(const Matrix *mat) {
+    return (mat->order == ROW_MAJOR) ? mat->rows : mat->cols;
+}
+
+// Length of each contiguous line of the block
+static int secondaryDimension(const Matrix *mat) {
+    return (mat->order == ROW_MAJOR) ? mat->cols : mat->rows;
+}
+
+// Number of rows (row major) or columns (column major) in a view, which are its lines in memory
+static int viewLines(const MatrixView *view) {
+    return (view->order == ROW_MAJOR) ? view->rows : view->cols;
+}
+
+// Number of elements along each line of a view
+static int viewLineLength(const MatrixView *view) {
+    return (view->order == ROW_MAJOR) ? view->cols : view->rows;
+}
+
+// Whether the lines of a view follow each other with no gap, so the whole view is one contiguous run
+static int viewIsContiguous(const MatrixView *view) {
+    return viewLines(view) <= 1 || view->ld == viewLineLength(view);
+}
+
+// Index of the element at (row, col) of a view inside the block, counted in stored elements
+static size_t viewElementIndex(const MatrixView *view, int row, int col) {
+    if (view->order == ROW_MAJOR) {
+        return view->offset + (size_t)row * view->ld + col;
+    }
+    return view->offset + (size_t)col * view->ld + row;
+}
+
+// Address of the value stored at (row, col) of a view
+static void *viewElementAddress(const MatrixView *view, int row, int col) {
+    return (char *)view->block + viewElementIndex(view, row, col) * viewElementSize(view);
+}
+
+// Address of the first value of a view
+void *viewValues(const MatrixView *view) {
+    return (char *)view->block + view->offset * viewElementSize(view);
+}
+
+// Strides between neighbouring rows and neighbouring columns of a view, counted in native values
+void viewValueStrides(const MatrixView *view, size_t *rowStride, size_t *colStride) {
+    size_t spacing = viewValueSpacing(view);
+    if (view->order == ROW_MAJOR) {
+        *rowStride = (size_t)view->ld * spacing;
+        *colStride = spacing;
+    } else {
+        *rowStride = spacing;
+        *colStride = (size_t)view->ld * spacing;
+    }
+}
+
+// Strides of a view along the lines of a reference storage order, counted in native values
+// 'line' moves from one row (or column) of the reference order to the next, and 'step' moves along it
+static void viewLineStrides(const MatrixView *view, StorageOrder reference, size_t *line, size_t *step) {
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    if (reference == ROW_MAJOR) {
+        *line = rowStride;
+        *step = colStride;
+    } else {
+        *line = colStride;
+        *step = rowStride;
+    }
+}
+
+// Address of the value stored at (row, col) of a matrix
+static void *elementAddress(const Matrix *mat, int row, int col) {
+    MatrixView view = viewMatrix(mat);
+    return viewElementAddress(&view, row, col);
+}
+
+// Read a stored value into a MatrixElement
+static MatrixElement readElement(const void *address, DataType data_type) {
+    MatrixElement element = {0};
+    switch (data_type) {
+        case INT:
+            element.int_val = *(const int *)address;
+            break;
+        case DOUBLE:
+            element.double_val = *(const double *)address;
+            break;
+        case CHAR:
+            element.char_val = *(const char *)address;
+            break;
+    }
+    return element;
+}
+
+// Write the member of a MatrixElement that matches the data type to a stored value
+static void writeElement(void *address, DataType data_type, MatrixElement element) {
+    switch (data_type) {
+        case INT:
+            *(int *)address = element.int_val;
+            break;
+        case DOUBLE:
+            *(double *)address = element.double_val;
+            break;
+        case CHAR:
+            *(char *)address = element.char_val;
+            break;
+    }
+}
+
+// Allocate the storage for a matrix whose rows, cols, data_type, storage and order are already set
+// All elements live in one aligned block. For element storage the 'data' pointer table sits at the end
+// of that same block, so a whole matrix costs a single heap allocation no matter how big it is.
+// Packed matrices have no table, because MatrixElement pointers can't point at packed values.
+// Returns 1 on success and 0 if the allocation failed
+static int allocateMatrixStorage(Matrix *mat) {
+    mat->data = NULL;
+    mat->block = NULL;
+
+    // Lines of the block are rows or columns based on the storage order
+    int primaryDim = primaryDimension(mat);
+    int secondaryDim = secondaryDimension(mat);
+
+    // Nothing to allocate for an empty matrix
+    if (primaryDim <= 0) {
+        return 1;
+    }
+    if (secondaryDim < 0) {
+        return 0;
+    }
+
+    // Guard against the size computation wrapping around
+    size_t elementSize = storedElementSize(mat);
+    if ((size_t)secondaryDim > (SIZE_MAX / 2) / elementSize / (size_t)primaryDim) {
+        return 0;
+    }
+
+    // Round the element area up to a whole number of alignment units so the pointer table that follows stays aligned
+    size_t elementBytes = (size_t)primaryDim * (size_t)secondaryDim * elementSize;
+    elementBytes = (elementBytes + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+    size_t tableBytes = (mat->storage == ELEMENT_STORAGE) ? (size_t)primaryDim * sizeof(MatrixElement *) : 0;
+
+    // Zero-filled memory doubles as the default value for every data type (all 0 bits is 0.0 for IEEE doubles)
+    // The block comes from whichever allocator this thread has installed
+    mat->block = matrixBlockCalloc(elementBytes + tableBytes);
+    if (mat->block == NULL) {
+        return 0;
+    }
+
+    // Point each 'row' (which might be a row or a column based on the storage order) into the block
+    if (mat->storage == ELEMENT_STORAGE) {
+        MatrixElement *elements = (MatrixElement *)mat->block;
+        mat->data = (MatrixElement **)((char *)mat->block + elementBytes);
+        for (int i = 0; i < primaryDim; i++) {
+            mat->data[i] = elements + (size_t)i * secondaryDim;
+        }
+    }
+    return 1;
+}
+
+// Create a matrix with a chosen storage order and storage type
+// Accepts an int of rows, an int of columns, a data type enum, a storage order enum and a storage type enum from the header
 // Returns a matrix
-Matrix createMatrix(int rows, int cols, DataType data_type) {
+Matrix createMatrixWithLayout(int rows, int cols, DataType data_type, StorageOrder order, StorageType storage) {
 
-    // Declare a matrix with its rows, columns, and data types from parameters
+    // Declare a matrix with its rows, columns, data type and layout from parameters
     Matrix mat;
     mat.rows = rows;
     mat.cols = cols;
     mat.data_type = data_type;
-
-    // Set storage order based on definition
-    #ifdef ROW_MAJOR_ORDER
-    int primaryDim = rows;
-    int secondaryDim = cols;
-    #elif defined(COLUMN_MAJOR_ORDER)
-    int primaryDim = cols;
-    int secondaryDim = rows;
-    #endif
+    mat.storage = storage;
+    mat.order = order;
 
     // Memory Allocation
-    // Allocate memory for the 'rows' which might represent actual rows or columns based on the storage order
-    mat.data = (MatrixElement **)malloc(primaryDim * sizeof(MatrixElement *));
-
-    // Exit if we fail to allocate
-    if (mat.data == NULL) {
-        printf("Memory allocation failed for matrix rows\n");
+    // One aligned block holds every element (plus the table of row pointers into it for element storage)
+    if (!allocateMatrixStorage(&mat)) {
+        printf("Memory allocation failed for matrix of %d x %d\n", rows, cols);
         exit(EXIT_FAILURE);
     }
 
-    // Allocate memory for each 'row' which could be a row or a column of elements pending storage order
-    // Iterate over primary dimension and add the secondary dimensions
-    for (int i = 0; i < primaryDim; i++) {
-        mat.data[i] = (MatrixElement *)malloc(secondaryDim * sizeof(MatrixElement));
-        
-        // If we don't have data, memory allocation failed
-        if (!mat.data[i]) {
-            printf("Memory allocation failed for matrix columns at row %d\n", i);
-            // Free previously allocated memory to avoid leaks
-            for (int j = 0; j < i; j++) {
-                free(mat.data[j]);
-            }
-            free(mat.data);
-            exit(EXIT_FAILURE);
-        }
-
-        // Initialize elements to default values, pending data type either all 0 bytes, or 0.0 for doubles
-        if (data_type == INT || data_type == CHAR) {
-            memset(mat.data[i], 0, cols * sizeof(MatrixElement));
-        } else if (data_type == DOUBLE) {
-            for (int c = 0; c < cols; c++) {
-                mat.data[i][c].double_val = 0.0;
-            }
-        }
-    }
-
     // Return the resulting matrix
     return mat;
 }
 
+// Create a matrix with a chosen storage type in the default storage order
+// Accepts an int of rows, an int of columns, a data type enum and a storage type enum from the header
+// Returns a matrix
+Matrix createMatrixWithStorage(int rows, int cols, DataType data_type, StorageType storage) {
+    return createMatrixWithLayout(rows, cols, data_type, DEFAULT_STORAGE_ORDER, storage);
+}
+
+// Create Matrix Function
+// Accepts an int of rows, an int of columns, and then a data type enum from the header
+// Returns a matrix
+Matrix createMatrix(int rows, int cols, DataType data_type) {
+    return createMatrixWithStorage(rows, cols, data_type, ELEMENT_STORAGE);
+}
+
+// Create a packed matrix, which stores each cell as its native type instead of a full MatrixElement
+// Accepts an int of rows, an int of columns, and then a data type enum from the header
+// Returns a matrix
+Matrix createPackedMatrix(int rows, int cols, DataType data_type) {
+    return createMatrixWithStorage(rows, cols, data_type, PACKED_STORAGE);
+}
+
 // I wanted a way to detect for INVALID conditions in my testing, such as
 // attempting to add matricies of incompatible data types or similar.
 // In these error states, I will return a specific "invalid" matrix
 // There is also a function to detect this specific "invalid" matrix
 
-// Create a matrix with our pre-determined "invalid" 
+// Create a matrix with our pre-determined "invalid"
 Matrix invalidMatrix() {
     return createMatrix(0,0,INT);
 }
 
 // Detect our specified "invalid" matrix
 int isValid(const Matrix *mat) {
-    // Verify our matrix isn't null, data isn't null, and our rows and columns are greater than 0.
-    if (mat != NULL && mat->data != NULL && mat->rows > 0 && mat->cols > 0) {
+    // Verify our matrix isn't null, its storage isn't null, and our rows and columns are greater than 0.
+    if (mat != NULL && mat->block != NULL && mat->rows > 0 && mat->cols > 0) {
         return 1;
     } else {
         return 0;
@@ -87,32 +287,8 @@ int isValid(const Matrix *mat) {
 // Accepts a matrix
 // Does not return
 void printMatrix(Matrix mat) {
-
-    // Iterate over rows
-    for (int r = 0; r < mat.rows; r++) {
-
-        // Iterate over columns
-        for (int c = 0; c < mat.cols; c++) {
-
-            // Switch based on the data type of the matrix
-            switch (mat.data_type) {
-                // Print the data in the appropriate way
-                case INT:
-                    printf("%d\t", mat.data[r][c].int_val);
-                    break;
-                case DOUBLE:
-                    printf("%f\t", mat.data[r][c].double_val);
-                    break;
-                case CHAR:
-                    printf("%c\t", mat.data[r][c].char_val);
-                    break;
-                default:
-                    printf("Unknown data type\t");
-            }
-        }
-        // Add a line break at the end of each row
-        printf("\n");
-    }
+    MatrixView view = viewMatrix(&mat);
+    printMatrixView(&view);
 }
 
 // Get matrix dimensions
@@ -128,95 +304,158 @@ void getMatrixDimensions(Matrix mat, int *rows, int *cols) {
 // Returns void
 void setMatrixElement(Matrix *mat, int row, int col, MatrixElement data) {
     #ifdef ENABLE_BOUNDS_CHECK
-    // Bounds checking needs to account for storage order
-    #ifdef ROW_MAJOR_ORDER
+    // Row and column are always logical, the storage order is handled by the element address
     if (row < 0 || row >= mat->rows || col < 0 || col >= mat->cols) {
-    #elif defined(COLUMN_MAJOR_ORDER)
-    if (col < 0 || col >= mat->rows || row < 0 || row >= mat->cols) {
-    #endif
         printf("Error: Index out of bounds\n");
         return;
     }
     #endif
 
+    // Make sure we know how to store this type
+    if (mat->data_type != INT && mat->data_type != DOUBLE && mat->data_type != CHAR) {
+        printf("Error: Unknown data type\n");
+        return;
+    }
+
     // Assign the provided data to the specified location in the matrix
-    #ifdef ROW_MAJOR_ORDER
-    int targetRow = row, targetCol = col;
-    #elif defined(COLUMN_MAJOR_ORDER)
-    int targetRow = col, targetCol = row;
-    #endif
+    // The address accounts for both the storage order and the storage type
+    writeElement(elementAddress(mat, row, col), mat->data_type, data);
+}
 
-    switch (mat->data_type) {
-        case INT:
-            mat->data[targetRow][targetCol].int_val = data.int_val;
-            break;
-        case DOUBLE:
-            mat->data[targetRow][targetCol].double_val = data.double_val;
-            break;
-        case CHAR:
-            mat->data[targetRow][targetCol].char_val = data.char_val;
-            break;
-        default:
-            printf("Error: Unknown data type\n");
-            break;
+// Copy 'count' values of 'size' bytes from 'in' to 'out', where neighbouring values are 'inStep' and 'outStep'
+// values apart. Runs that are contiguous on both sides are a single memcpy, the rest is a gather or scatter with
+// the value type known, four values at a time.
+static void copyStridedValues(char *out, size_t outStep, const char *in, size_t inStep, size_t count, size_t size) {
+    if (outStep == 1 && inStep == 1) {
+        memcpy(out, in, count * size);
+        return;
+    }
+    #define COPY_STRIDED(type)                                                                                      \
+        {                                                                                                           \
+            type *to = (type *)out;                                                                                 \
+            const type *from = (const type *)in;                                                                    \
+            size_t k = 0;                                                                                           \
+            for (; k + 4 <= count; k += 4) {                                                                        \
+                type a = from[k * inStep], b = from[(k + 1) * inStep];                                              \
+                type c = from[(k + 2) * inStep], d = from[(k + 3) * inStep];                                        \
+                to[k * outStep] = a;                                                                                \
+                to[(k + 1) * outStep] = b;                                                                          \
+                to[(k + 2) * outStep] = c;                                                                          \
+                to[(k + 3) * outStep] = d;                                                                          \
+            }                                                                                                       \
+            for (; k < count; k++) {                                                                                \
+                to[k * outStep] = from[k * inStep];                                                                 \
+            }                                                                                                       \
+        }
+    if (size == sizeof(double)) {
+        COPY_STRIDED(double)
+    } else if (size == sizeof(int)) {
+        COPY_STRIDED(int)
+    } else {
+        COPY_STRIDED(char)
     }
+    #undef COPY_STRIDED
 }
 
-// Function to set all the elements in a given row or column.
-// Accepts a matrix pointer, an index for the row or column, ROC as row or column, an array of elements, and a number of elements
-// Returns void
-void setRowOrColumn(Matrix *mat, int index, RowOrCol roc, MatrixElement *elements, int numElements) {
+// Find the values of one row or column of a matrix
+// Accepts a matrix pointer, ROW or COL, and an index, plus output parameters for how many values the line has and how
+// many native values apart they are
+// Returns the address of the first value
+static char *matrixLineValues(const Matrix *mat, RowOrCol roc, int index, int *count, size_t *step) {
+    MatrixView view = viewMatrix(mat);
+    size_t rowStride, colStride;
+    viewValueStrides(&view, &rowStride, &colStride);
+    *count = (roc == ROW) ? mat->cols : mat->rows;
+    *step = (roc == ROW) ? colStride : rowStride;
+    return (char *)viewValues(&view) + (size_t)index * ((roc == ROW) ? rowStride : colStride) * valueSize(mat->data_type);
+}
+
+// Check a matrix has a row or column at an index
+// Accepts a matrix pointer, ROW or COL, and an index
+// Returns MATRIX_SUCCESS or the reason it doesn't
+static MatrixStatus checkLineIndex(const Matrix *mat, RowOrCol roc, int index) {
+    if (!mat || !mat->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (mat->data_type != INT && mat->data_type != DOUBLE && mat->data_type != CHAR) {
+        printf("Error: Unknown data type\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+
     // Bounds checks which can be disabled
     #ifdef ENABLE_BOUNDS_CHECK
-    // Adjust the bounds check based on storage order
-    #ifdef ROW_MAJOR_ORDER
-    if ((roc == ROW && (index < 0 || index >= mat->rows)) || 
+    if ((roc == ROW && (index < 0 || index >= mat->rows)) ||
         (roc == COL && (index < 0 || index >= mat->cols))) {
         printf("Error: Index out of bounds\n");
-        return;
-    }
-    #elif defined(COLUMN_MAJOR_ORDER)
-    if ((roc == ROW && (index < 0 || index >= mat->cols)) || 
-        (roc == COL && (index < 0 || index >= mat->rows))) {
-        printf("Error: Index out of bounds\n");
-        return;
+        return MATRIX_ERROR_SIZE_MISMATCH;
     }
+    #else
+    (void)roc;
+    (void)index;
     #endif
-    #endif
+    return MATRIX_SUCCESS;
+}
 
-    // Check if we provided enough elements
-    #ifdef ROW_MAJOR_ORDER
-    int count = (roc == ROW) ? mat->cols : mat->rows;
-    #elif defined(COLUMN_MAJOR_ORDER)
-    int count = (roc == ROW) ? mat->rows : mat->cols;
-    #endif
-    if (numElements < count) {
+// Check a row or column of a matrix can be copied to or from a buffer
+// Accepts a matrix pointer, ROW or COL, an index, the buffer and how many values it has room for
+// Returns MATRIX_SUCCESS or the reason it can't
+static MatrixStatus checkLineAccess(const Matrix *mat, RowOrCol roc, int index, const void *buffer, int numValues) {
+    MatrixStatus status = checkLineIndex(mat, roc, index);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    if (!buffer) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+
+    // Check if we provided enough room
+    if (numValues < ((roc == ROW) ? mat->cols : mat->rows)) {
         printf("Error: Not enough elements provided\n");
-        return;
+        return MATRIX_ERROR_SIZE_MISMATCH;
     }
+    return MATRIX_SUCCESS;
+}
 
-    // Add the elements if everything is good
-    #ifdef ROW_MAJOR_ORDER
-    if (roc == ROW) {
-        for (int col = 0; col < mat->cols; col++) {
-            setMatrixElement(mat, index, col, elements[col]);
-        }
-    } else {
-        for (int row = 0; row < mat->rows; row++) {
-            setMatrixElement(mat, row, index, elements[row]);
-        }
+// How many native values apart neighbouring MatrixElements of an array are.
+// Every member of the union starts at its address, so an array of them is also a strided run of values.
+static size_t elementArrayStep(DataType data_type) {
+    return sizeof(MatrixElement) / valueSize(data_type);
+}
+
+// Function to set all the elements in a given row or column.
+// Accepts a matrix pointer, an index for the row or column, ROC as row or column, an array of elements, and a number of elements
+// Returns void
+void setRowOrColumn(Matrix *mat, int index, RowOrCol roc, MatrixElement *elements, int numElements) {
+    if (checkLineAccess(mat, roc, index, elements, numElements) != MATRIX_SUCCESS) {
+        return;
     }
-    #elif defined(COLUMN_MAJOR_ORDER)
-    if (roc == ROW) {
-        for (int row = 0; row < mat->rows; row++) {
-            setMatrixElement(mat, row, index, elements[row]);
-        }
-    } else {  // roc == COL
-        for (int col = 0; col < mat->cols; col++) {
-            setMatrixElement(mat, index, col, elements[col]);
-        }
+
+    // Scatter the member of each element that matches the data type straight into the line
+    int count;
+    size_t step;
+    char *line = matrixLineValues(mat, roc, index, &count, &step);
+    copyStridedValues(line, step, (const char *)elements, elementArrayStep(mat->data_type), (size_t)count,
+                      valueSize(mat->data_type));
+}
+
+// Function to set all the elements in a given row or column from native values
+// Accepts a matrix pointer, ROW or COL, an index, and an array of at least a line's worth of int, double or char
+// values to match the matrix's data type
+// Returns MATRIX_SUCCESS, or an error status with the matrix untouched
+MatrixStatus setRowOrColumnValues(Matrix *mat, RowOrCol roc, int index, const void *values, int numValues) {
+    MatrixStatus status = checkLineAccess(mat, roc, index, values, numValues);
+    if (status != MATRIX_SUCCESS) {
+        return status;
     }
-    #endif
+
+    // A line that runs along the storage is one memcpy, one that runs across it a strided scatter
+    int count;
+    size_t step;
+    char *line = matrixLineValues(mat, roc, index, &count, &step);
+    copyStridedValues(line, step, (const char *)values, 1, (size_t)count, valueSize(mat->data_type));
+    return MATRIX_SUCCESS;
 }
 
 // Create a matrix from a subset of a larger matrix
@@ -232,21 +471,9 @@ Matrix createMatrixSubset(Matrix original, int startRow, int endRow, int startCo
     }
     #endif
 
-    // Calculate new matrix dimensions
-    int rows = endRow - startRow + 1;
-    int cols = endCol - startCol + 1;
-
-    // Create new matrix
-    Matrix newMatrix = createMatrix(rows, cols, original.data_type);
-
-    // Copy data from original matrix to new matrix
-    for (int r = startRow; r <= endRow; r++) {
-        for (int c = startCol; c <= endCol; c++) {
-            newMatrix.data[r - startRow][c - startCol] = original.data[r][c];
-        }
-    }
-
-    return newMatrix;
+    // Look at the region through a view, then copy the view into a matrix of its own
+    MatrixView view = createMatrixView(&original, startRow, endRow, startCol, endCol);
+    return copyMatrixView(&view);
 }
 
 // Resize a matrix
@@ -262,45 +489,38 @@ void resizeMatrix(Matrix *mat, int newRows, int newCols) {
     }
     #endif
 
-    // Allocate new data array
-    MatrixElement **newData = malloc(newRows * sizeof(MatrixElement *));
-    if (!newData) {
-        printf("Memory allocation failed for new data rows.\n");
+    // Allocate the new storage as one contiguous block
+    Matrix resized;
+    resized.rows = newRows;
+    resized.cols = newCols;
+    resized.data_type = mat->data_type;
+    resized.storage = mat->storage;
+    resized.order = mat->order;
+    if (!allocateMatrixStorage(&resized)) {
+        printf("Memory allocation failed for resized matrix.\n");
         return;
     }
 
-    for (int i = 0; i < newRows; i++) {
-        newData[i] = malloc(newCols * sizeof(MatrixElement));
-        if (!newData[i]) {
-            printf("Memory allocation failed for new data columns at row %d.\n", i);
-            // Free already allocated rows
-            for (int j = 0; j < i; j++) {
-                free(newData[j]);
-            }
-            free(newData);
-            return;
-        }
-    }
-
-    // Copy data from old matrix to new matrix
-    int minRows = (newRows > mat->rows) ? mat->rows : newRows;
-    int minCols = (newCols > mat->cols) ? mat->cols : newCols;
-    for (int r = 0; r < minRows; r++) {
-        for (int c = 0; c < minCols; c++) {
-            newData[r][c] = mat->data[r][c];
+    // Copy data from old matrix to new matrix, one contiguous run per row (or column) at a time.
+    // New cells past the old dimensions stay zeroed.
+    int newPrimary = primaryDimension(&resized);
+    int oldPrimary = primaryDimension(mat);
+    int minPrimary = (newPrimary > oldPrimary) ? oldPrimary : newPrimary;
+    size_t newSecondary = (size_t)secondaryDimension(&resized);
+    size_t oldSecondary = (size_t)secondaryDimension(mat);
+    size_t minSecondary = (newSecondary > oldSecondary) ? oldSecondary : newSecondary;
+    size_t elementSize = storedElementSize(mat);
+    if (minSecondary > 0) {
+        for (int i = 0; i < minPrimary; i++) {
+            memcpy((char *)resized.block + (size_t)i * newSecondary * elementSize,
+                   (char *)mat->block + (size_t)i * oldSecondary * elementSize,
+                   minSecondary * elementSize);
         }
     }
 
-    // Free old data
-    for (int i = 0; i < mat->rows; i++) {
-        free(mat->data[i]);
-    }
-    free(mat->data);
-
-    // Update matrix properties
-    mat->data = newData;
-    mat->rows = newRows;
-    mat->cols = newCols;
+    // Free old data and take over the new storage
+    freeMatrix(mat);
+    *mat = resized;
 }
 
 // Set matrix subset
@@ -317,9 +537,11 @@ void setMatrixSubset(Matrix *sourceMat, Matrix *destMat, int startRow, int start
     #endif
 
     // Copy data from source matrix to destination matrix
+    // The two matrices may be stored differently, so go through a MatrixElement
     for (int r = 0; r < sourceMat->rows; r++) {
         for (int c = 0; c < sourceMat->cols; c++) {
-            destMat->data[startRow + r][startCol + c] = sourceMat->data[r][c];
+            MatrixElement element = readElement(elementAddress(sourceMat, r, c), sourceMat->data_type);
+            writeElement(elementAddress(destMat, startRow + r, startCol + c), destMat->data_type, element);
         }
     }
 }
@@ -341,234 +563,1341 @@ MatrixElement getMatrixElement(Matrix mat, int row, int col) {
     }
     #endif
 
-    #ifdef ROW_MAJOR_ORDER
-    return mat.data[row][col];  // Access element in row-major order
-    #elif defined(COLUMN_MAJOR_ORDER)
-    return mat.data[col][row];  // Access element in column-major order
-    #endif
+    // The address accounts for both the storage order and the storage type
+    return readElement(elementAddress(&mat, row, col), mat.data_type);
 }
 
-// Get a row or column in the matrix
-// Accepts a matrix pointer, and a Row Or Column enum, along with an index
-// Returns a MatrixElement pointer
-MatrixElement* getRowOrColumn(Matrix *mat, RowOrCol roc, int index) {
-
-    // Check if the index is out of bounds
+// Check that (row, col) is inside a matrix for the typed accessors
+// Returns 1 if it is, and prints an error and returns 0 if it is not
+static int typedAccessInBounds(const Matrix *mat, int row, int col) {
     #ifdef ENABLE_BOUNDS_CHECK
-    if ((roc == ROW && (index < 0 || index >= mat->rows)) || 
-        (roc == COL && (index < 0 || index >= mat->cols))) {
+    if (row < 0 || row >= mat->rows || col < 0 || col >= mat->cols) {
         printf("Error: Index out of bounds\n");
-        return NULL;
+        return 0;
     }
+    #else
+    (void)mat;
+    (void)row;
+    (void)col;
     #endif
+    return 1;
+}
 
-    // Allocate memory for the row or column 
-    MatrixElement *result = NULL;
-
-    // Get a row
-    if (roc == ROW) {
-        // Get a row
-        // Allocate memory for the row based on the number of columns
-        result = (MatrixElement *)malloc(mat->cols * sizeof(MatrixElement));
-
-        // Catch errors with memory allocation
-        if (!result) {
-            printf("Memory allocation failed\n");
-            return NULL;
-        }
-
-        // Put the data into the memory location
-        for (int i = 0; i < mat->cols; i++) {
-            result[i] = mat->data[index][i];
-        }
-    
-    // Get a column
-    } else {
-        // Allocate memory for the column based on the number of rows
-        result = (MatrixElement *)malloc(mat->rows * sizeof(MatrixElement));
-
-        // Catch errors with memory allocation
-        if (!result) {
-            printf("Memory allocation failed\n");
-            return NULL;
-        }
+// Typed accessors
+// These read and write a cell as a plain int, double or char without going through a MatrixElement,
+// and work for both storage types. Values of a different data type are converted.
 
-        // Put the data into the memory location
-        for (int i = 0; i < mat->rows; i++) {
-            result[i] = mat->data[i][index];
-        }
+// Get an element as an int
+int getIntElement(const Matrix *mat, int row, int col) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return 0;
     }
-    return result;
+    const void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            return *(const int *)address;
+        case DOUBLE:
+            return (int)*(const double *)address;
+        case CHAR:
+            return *(const char *)address;
+    }
+    return 0;
 }
 
-// Function to add 2 matricies together
-// Accepts two different matrix pointers
-// Returns a matrix
-Matrix addMatrices(const Matrix *mat1, const Matrix *mat2) {
-    // Confirm our matricies are the same size, or it won't work.
-    if (mat1->rows != mat2->rows || mat1->cols != mat2->cols) {
-        printf("Error: Matrices dimensions do not match.\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+// Get an element as a double
+double getDoubleElement(const Matrix *mat, int row, int col) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return 0.0;
     }
-
-    // Confirm we hav ethe same data type in each matrix or it won't work
-    if (mat1->data_type != mat2->data_type) {
-        printf("Error: Matrices data types do not match.\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+    const void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            return *(const int *)address;
+        case DOUBLE:
+            return *(const double *)address;
+        case CHAR:
+            return *(const char *)address;
     }
+    return 0.0;
+}
 
-    // Create the new matrix to store the result in
-    Matrix result = createMatrix(mat1->rows, mat1->cols, mat1->data_type);
-
-    // Perform the actual addition
-    for (int i = 0; i < mat1->rows; i++) {
-        for (int j = 0; j < mat1->cols; j++) {
-            switch (mat1->data_type) {
-                case INT:
-                    result.data[i][j].int_val = mat1->data[i][j].int_val + mat2->data[i][j].int_val;
-                    break;
-                case DOUBLE:
-                    result.data[i][j].double_val = mat1->data[i][j].double_val + mat2->data[i][j].double_val;
-                    break;
-                case CHAR:
-                    printf("Error: Addition not supported for CHAR type matrices.\n");
-                    printf("Returning empty matrix to indicate error state.\n");
-                    return invalidMatrix();
-                    break;
-            }
-        }
+// Get an element as a char
+char getCharElement(const Matrix *mat, int row, int col) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return 0;
     }
-
-    return result;
+    const void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            return (char)*(const int *)address;
+        case DOUBLE:
+            return (char)*(const double *)address;
+        case CHAR:
+            return *(const char *)address;
+    }
+    return 0;
 }
 
-// Function to subtract 2 matricies
-// Accepts two different matrix pointers
-// Returns a matrix
-Matrix subtractMatrices(const Matrix *mat1, const Matrix *mat2) {
-    // Confirm our matricies are the same size, or it won't work.
-    if (mat1->rows != mat2->rows || mat1->cols != mat2->cols) {
-        printf("Error: Matrices dimensions do not match.\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+// Set an element from an int
+void setIntElement(Matrix *mat, int row, int col, int value) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return;
     }
-
-    // Confirm we hav ethe same data type in each matrix or it won't work
-    if (mat1->data_type != mat2->data_type) {
-        printf("Error: Matrices data types do not match.\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+    void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            *(int *)address = value;
+            break;
+        case DOUBLE:
+            *(double *)address = value;
+            break;
+        case CHAR:
+            *(char *)address = (char)value;
+            break;
     }
+}
 
-    // Create the new matrix to store the result in
-    Matrix result = createMatrix(mat1->rows, mat1->cols, mat1->data_type);
-
-    // Perform the actual addition
-    for (int i = 0; i < mat1->rows; i++) {
-        for (int j = 0; j < mat1->cols; j++) {
-            switch (mat1->data_type) {
-                case INT:
-                    result.data[i][j].int_val = mat1->data[i][j].int_val - mat2->data[i][j].int_val;
-                    break;
-                case DOUBLE:
-                    result.data[i][j].double_val = mat1->data[i][j].double_val - mat2->data[i][j].double_val;
-                    break;
-                case CHAR:
-                    printf("Error: Subtraction not supported for CHAR type matrices.\n");
-                    printf("Returning empty matrix to indicate error state.\n");
-                    return invalidMatrix();
-            }
-        }
+// Set an element from a double
+void setDoubleElement(Matrix *mat, int row, int col, double value) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return;
     }
+    void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            *(int *)address = (int)value;
+            break;
+        case DOUBLE:
+            *(double *)address = value;
+            break;
+        case CHAR:
+            *(char *)address = (char)value;
+            break;
+    }
+}
+
+// Set an element from a char
+void setCharElement(Matrix *mat, int row, int col, char value) {
+    if (!typedAccessInBounds(mat, row, col)) {
+        return;
+    }
+    void *address = elementAddress(mat, row, col);
+    switch (mat->data_type) {
+        case INT:
+            *(int *)address = value;
+            break;
+        case DOUBLE:
+            *(double *)address = value;
+            break;
+        case CHAR:
+            *(char *)address = value;
+            break;
+    }
+}
+
+// Raw buffers of packed matrices
+// Each returns the packed values in storage order, or NULL if the matrix isn't packed or holds another type
+
+// Get the int buffer of a packed INT matrix
+int *getIntBuffer(const Matrix *mat) {
+    if (mat->storage != PACKED_STORAGE || mat->data_type != INT) {
+        return NULL;
+    }
+    return (int *)mat->block;
+}
+
+// Get the double buffer of a packed DOUBLE matrix
+double *getDoubleBuffer(const Matrix *mat) {
+    if (mat->storage != PACKED_STORAGE || mat->data_type != DOUBLE) {
+        return NULL;
+    }
+    return (double *)mat->block;
+}
+
+// Get the char buffer of a packed CHAR matrix
+char *getCharBuffer(const Matrix *mat) {
+    if (mat->storage != PACKED_STORAGE || mat->data_type != CHAR) {
+        return NULL;
+    }
+    return (char *)mat->block;
+}
+
+// Report a bad access through one of the Checked inline accessors in matrix.h, and stop the program.
+// It lives here so that matrix.h doesn't need stdio.h and stdlib.h.
+// Accepts a message
+// Does not return
+void matrixAccessFailed(const char *message) {
+    printf("Error: %s\n", message);
+    exit(EXIT_FAILURE);
+}
+
+// MARK - Views
+// A view looks at a rectangle of a matrix in place. It is just an offset, a leading dimension and an extent,
+// so making one costs the same no matter how big the rectangle is, and it never owns or frees anything.
+
+// Create a view of a whole matrix
+// Accepts a matrix pointer
+// Returns a view
+MatrixView viewMatrix(const Matrix *mat) {
+    MatrixView view;
+    view.rows = mat->rows;
+    view.cols = mat->cols;
+    view.data_type = mat->data_type;
+    view.storage = mat->storage;
+    view.order = mat->order;
+    view.block = mat->block;
+    view.offset = 0;
+
+    // Neighbouring lines of a matrix follow each other with no gap
+    int lineLength = (mat->order == ROW_MAJOR) ? mat->cols : mat->rows;
+    view.ld = (lineLength > 0) ? lineLength : 1;
+    return view;
+}
+
+// Create a view of part of a view
+// Accepts a view pointer, a starting row, ending row, starting col, ending col (inclusive, like createMatrixSubset)
+// Returns a view, which is empty if the range doesn't fit
+MatrixView createSubView(const MatrixView *view, int startRow, int endRow, int startCol, int endCol) {
+    MatrixView sub = *view;
+
+    // A view outside its parent could read someone else's memory, so this check is always on
+    if (startRow < 0 || endRow >= view->rows || startRow > endRow ||
+        startCol < 0 || endCol >= view->cols || startCol > endCol) {
+        printf("Error: Index out of bounds or invalid range.\n");
+        sub.rows = 0;
+        sub.cols = 0;
+        sub.block = NULL;
+        sub.offset = 0;
+        return sub;
+    }
+
+    // Same block and leading dimension, just a new starting point and extent
+    sub.offset = viewElementIndex(view, startRow, startCol);
+    sub.rows = endRow - startRow + 1;
+    sub.cols = endCol - startCol + 1;
+    return sub;
+}
+
+// Create a view of part of a matrix
+// Accepts a matrix pointer, a starting row, ending row, starting col, ending col (inclusive, like createMatrixSubset)
+// Returns a view, which is empty if the range doesn't fit
+MatrixView createMatrixView(const Matrix *original, int startRow, int endRow, int startCol, int endCol) {
+    MatrixView whole = viewMatrix(original);
+    return createSubView(&whole, startRow, endRow, startCol, endCol);
+}
+
+// Function to view a view transposed, without moving anything
+// A row major view of some lines is the same memory as a column major view of the same lines,
+// so swapping the dimensions and the order is all a transpose takes.
+// Accepts a view pointer
+// Returns a view of the same cells, with rows and columns swapped
+MatrixView transposeMatrixView(const MatrixView *view) {
+    MatrixView transposed = *view;
+    transposed.rows = view->cols;
+    transposed.cols = view->rows;
+    transposed.order = (view->order == ROW_MAJOR) ? COLUMN_MAJOR : ROW_MAJOR;
+    return transposed;
+}
+
+// Get a specific element of a view
+// Accepts a view pointer, a row int and a column int
+// Returns the element
+MatrixElement getViewElement(const MatrixView *view, int row, int col) {
+
+    // Check if the row and column indices are within the bounds of the view
+    #ifdef ENABLE_BOUNDS_CHECK
 
+    // A default element to return if we're out of bounds
+    MatrixElement defaultElement = {0};
+
+    if (row < 0 || row >= view->rows || col < 0 || col >= view->cols) {
+        printf("Error: Index out of bounds\n");
+        return defaultElement;
+    }
+    #endif
+
+    return readElement(viewElementAddress(view, row, col), view->data_type);
+}
+
+// Where each cell of a rearranged view comes from: cell (row, col) reads the value at
+// origin + row * rowStep + col * colStep, with the steps counted in native values and either of them negative.
+// Copies between storage orders, transposes and rotations are all just different walks over the source.
+typedef struct {
+    const char *origin;
+    ptrdiff_t rowStep;
+    ptrdiff_t colStep;
+    size_t size;
+} ValueWalk;
+
+// Walk a source view turned 'turns' quarter turns clockwise, after transposing it if 'transposed' is set
+static ValueWalk rotatedWalk(const MatrixView *source, int turns, int transposed) {
+    size_t rowStride, colStride;
+    viewValueStrides(source, &rowStride, &colStride);
+    ptrdiff_t down = (ptrdiff_t)rowStride;
+    ptrdiff_t across = (ptrdiff_t)colStride;
+    ptrdiff_t lastRow = source->rows - 1;
+    ptrdiff_t lastCol = source->cols - 1;
+    if (transposed) {
+        ptrdiff_t swap = down;
+        down = across;
+        across = swap;
+        swap = lastRow;
+        lastRow = lastCol;
+        lastCol = swap;
+    }
+
+    // A clockwise quarter turn reads each output row up a column of the source, starting from the bottom
+    ValueWalk walk;
+    ptrdiff_t start = 0;
+    switch (turns & 3) {
+        case 1:
+            start = lastRow * down;
+            walk.rowStep = across;
+            walk.colStep = -down;
+            break;
+        case 2:
+            start = lastRow * down + lastCol * across;
+            walk.rowStep = -down;
+            walk.colStep = -across;
+            break;
+        case 3:
+            start = lastCol * across;
+            walk.rowStep = -across;
+            walk.colStep = down;
+            break;
+        default:
+            walk.rowStep = down;
+            walk.colStep = across;
+            break;
+    }
+    walk.size = valueSize(source->data_type);
+    walk.origin = (const char *)viewValues(source) + start * (ptrdiff_t)walk.size;
+    return walk;
+}
+
+// Copy a tile of 'rows' x 'cols' values of 'size' bytes, with the strides of both sides counted in values
+// When one side runs contiguously along rows and the other along columns the tile is a transpose,
+// which goes to the vector kernels; a source running backwards is handled by walking both sides backwards.
+static void gatherTile(char *out, ptrdiff_t outRow, ptrdiff_t outCol, const char *in, ptrdiff_t inRow,
+                       ptrdiff_t inCol, int rows, int cols, size_t size) {
+    // A tile is the same copy with its rows and columns swapped, so make the output contiguous along its rows
+    if (outRow == 1 && outCol != 1) {
+        ptrdiff_t swap = outRow;
+        outRow = outCol;
+        outCol = swap;
+        swap = inRow;
+        inRow = inCol;
+        inCol = swap;
+        int count = rows;
+        rows = cols;
+        cols = count;
+    }
+    if ((size == sizeof(int) || size == sizeof(double)) && outCol == 1 && (inRow == 1 || inRow == -1)) {
+        if (inRow == -1) {
+            out += (rows - 1) * outRow * (ptrdiff_t)size;
+            in -= (ptrdiff_t)(rows - 1) * (ptrdiff_t)size;
+            outRow = -outRow;
+            inRow = 1;
+        }
+        if (size == sizeof(int)) {
+            matrixKernels()->transposeInts((int *)out, outRow, (const int *)in, inCol, rows, cols);
+        } else {
+            matrixKernels()->transposeDoubles((double *)out, outRow, (const double *)in, inCol, rows, cols);
+        }
+        return;
+    }
+
+    // Anything else is copied a value at a time, with the natural type of each size so it stays a plain load and store
+    for (int r = 0; r < rows; r++) {
+        char *to = out + r * outRow * (ptrdiff_t)size;
+        const char *from = in + r * inRow * (ptrdiff_t)size;
+        switch (size) {
+            case sizeof(double):
+                for (int c = 0; c < cols; c++) {
+                    ((double *)to)[c * outCol] = ((const double *)from)[c * inCol];
+                }
+                break;
+            case sizeof(int):
+                for (int c = 0; c < cols; c++) {
+                    ((int *)to)[c * outCol] = ((const int *)from)[c * inCol];
+                }
+                break;
+            default:
+                for (int c = 0; c < cols; c++) {
+                    to[c * outCol] = from[c * inCol];
+                }
+                break;
+        }
+    }
+}
+
+// Fill rows 'startRow' up to 'endRow' of a view from a walk, one ORDER_TILE square at a time
+// so neither side is walked against its grain for long
+static void gatherRows(const MatrixView *out, const ValueWalk *walk, int startRow, int endRow) {
+    size_t rowStride, colStride;
+    viewValueStrides(out, &rowStride, &colStride);
+    ptrdiff_t size = (ptrdiff_t)walk->size;
+    char *values = (char *)viewValues(out);
+    for (int row = startRow; row < endRow; row += ORDER_TILE) {
+        int rows = (row + ORDER_TILE < endRow) ? ORDER_TILE : endRow - row;
+        for (int col = 0; col < out->cols; col += ORDER_TILE) {
+            int cols = (col + ORDER_TILE < out->cols) ? ORDER_TILE : out->cols - col;
+            char *to = values + ((ptrdiff_t)row * (ptrdiff_t)rowStride + (ptrdiff_t)col * (ptrdiff_t)colStride) * size;
+            const char *from = walk->origin + (row * walk->rowStep + col * walk->colStep) * size;
+            gatherTile(to, (ptrdiff_t)rowStride, (ptrdiff_t)colStride, from, walk->rowStep, walk->colStep, rows, cols,
+                       walk->size);
+        }
+    }
+}
+
+// One rearranging copy, shared between threads a band of ORDER_TILE rows at a time
+typedef struct {
+    const MatrixView *out;
+    const ValueWalk *walk;
+} GatherJob;
+
+// Fill bands 'start' up to 'end' of a job
+static void gatherRange(void *context, int task, size_t start, size_t end) {
+    const GatherJob *job = (const GatherJob *)context;
+    (void)task;
+    int endRow = (int)end * ORDER_TILE;
+    gatherRows(job->out, job->walk, (int)start * ORDER_TILE, (endRow < job->out->rows) ? endRow : job->out->rows);
+}
+
+// Fill a whole view from a walk over a source that doesn't overlap it
+static void gatherView(const MatrixView *out, const ValueWalk *walk) {
+    if (out->rows == 0 || out->cols == 0) {
+        return;
+    }
+    GatherJob job = {out, walk};
+    size_t bands = ((size_t)out->rows + ORDER_TILE - 1) / ORDER_TILE;
+    size_t grain = PARALLEL_MIN_VALUES / ((size_t)ORDER_TILE * out->cols) + 1;
+    parallelRange(bands, parallelRangeCount(bands, grain), gatherRange, &job);
+}
+
+// One copy of a view, shared between threads
+typedef struct {
+    char *destination;
+    const char *source;
+    size_t lineBytes;
+    size_t destinationLineBytes;
+    size_t sourceLineBytes;
+    int singleRun;
+} CopyJob;
+
+// Copy lines 'start' up to 'end' of a job, or bytes 'start' up to 'end' of a single run
+static void copyRange(void *context, int task, size_t start, size_t end) {
+    const CopyJob *job = (const CopyJob *)context;
+    (void)task;
+    if (job->singleRun) {
+        memcpy(job->destination + start, job->source + start, end - start);
+        return;
+    }
+    for (size_t i = start; i < end; i++) {
+        memcpy(job->destination + i * job->destinationLineBytes, job->source + i * job->sourceLineBytes,
+               job->lineBytes);
+    }
+}
+
+// Copy the values of a view into another view of the same size and data type
+// Views stored the same way are copied a contiguous line at a time (or all at once if neither has gaps),
+// with big copies shared between the threads. Otherwise values are gathered one ORDER_TILE square at a time.
+static void copyViewInto(const MatrixView *out, const MatrixView *view) {
+    if (out->storage != view->storage || out->order != view->order) {
+        ValueWalk walk = rotatedWalk(view, 0, 0);
+        gatherView(out, &walk);
+        return;
+    }
+
+    size_t elementSize = viewElementSize(view);
+    CopyJob job;
+    job.destination = (char *)viewValues(out);
+    job.source = (const char *)viewValues(view);
+    job.lineBytes = (size_t)viewLineLength(view) * elementSize;
+    job.destinationLineBytes = (size_t)out->ld * elementSize;
+    job.sourceLineBytes = (size_t)view->ld * elementSize;
+    job.singleRun = viewIsContiguous(out) && viewIsContiguous(view);
+
+    size_t count = job.singleRun ? (size_t)viewLines(view) * job.lineBytes : (size_t)viewLines(view);
+    size_t grain = job.singleRun ? PARALLEL_MIN_VALUES * elementSize : PARALLEL_MIN_VALUES / viewLineLength(view) + 1;
+    parallelRange(count, parallelRangeCount(count, grain), copyRange, &job);
+}
+
+// Copy a view into a new matrix of its own
+// Accepts a view pointer
+// Returns a matrix with the same order and storage type as the viewed matrix
+Matrix copyMatrixView(const MatrixView *view) {
+    Matrix copy = createMatrixWithLayout(view->rows, view->cols, view->data_type, view->order, view->storage);
+    if (copy.block == NULL || view->block == NULL) {
+        return copy;
+    }
+    MatrixView out = viewMatrix(&copy);
+    copyViewInto(&out, view);
+    return copy;
+}
+
+// Print a view
+// Accepts a view pointer
+// Does not return
+void printMatrixView(const MatrixView *view) {
+    // printMatrix's layout: a tab after every value, with doubles to 6 places like printf's "%f"
+    TextFormat format = {TEXT_PRINT, 6};
+    writeMatrixViewText(view, format, fileTextSink(stdout));
+}
+
+// Get a row or column in the matrix
+// Accepts a matrix pointer, and a Row Or Column enum, along with an index
+// Returns a MatrixElement pointer, which the caller frees
+MatrixElement* getRowOrColumn(Matrix *mat, RowOrCol roc, int index) {
+    // Check the index before allocating anything
+    if (checkLineIndex(mat, roc, index) != MATRIX_SUCCESS) {
+        return NULL;
+    }
+
+    // Allocate memory for the row or column
+    int count = (roc == ROW) ? mat->cols : mat->rows;
+    MatrixElement *result = (MatrixElement *)malloc(count * sizeof(MatrixElement));
+
+    // Catch errors with memory allocation
+    if (!result) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+
+    // Put the data into the memory location
+    getRowOrColumnInto(mat, roc, index, result, count);
     return result;
 }
 
-// Function to multiply two matricies
+// Get a row or column in the matrix, into an array the caller provides, without allocating
+// Accepts a matrix pointer, ROW or COL, an index, and an array with room for at least a line's worth of elements
+// Returns MATRIX_SUCCESS, or an error status with the array untouched
+MatrixStatus getRowOrColumnInto(const Matrix *mat, RowOrCol roc, int index, MatrixElement *elements, int numElements) {
+    MatrixStatus status = checkLineAccess(mat, roc, index, elements, numElements);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // Clear the elements, so the members other than the one for the data type read as 0, then gather the values
+    int count;
+    size_t step;
+    const char *line = matrixLineValues(mat, roc, index, &count, &step);
+    memset(elements, 0, (size_t)count * sizeof(MatrixElement));
+    copyStridedValues((char *)elements, elementArrayStep(mat->data_type), line, step, (size_t)count,
+                      valueSize(mat->data_type));
+    return MATRIX_SUCCESS;
+}
+
+// Get a row or column in the matrix as native values, into an array the caller provides, without allocating
+// Accepts a matrix pointer, ROW or COL, an index, and an array of int, double or char to match the matrix's data
+// type, with room for at least a line's worth of values
+// Returns MATRIX_SUCCESS, or an error status with the array untouched
+MatrixStatus getRowOrColumnValues(const Matrix *mat, RowOrCol roc, int index, void *values, int numValues) {
+    MatrixStatus status = checkLineAccess(mat, roc, index, values, numValues);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // A line that runs along the storage is one memcpy, one that runs across it a strided gather
+    int count;
+    size_t step;
+    const char *line = matrixLineValues(mat, roc, index, &count, &step);
+    copyStridedValues((char *)values, 1, line, step, (size_t)count, valueSize(mat->data_type));
+    return MATRIX_SUCCESS;
+}
+
+// Add or subtract two runs of ints into a third
+// Each run steps by its own spacing (1 when packed, more when each value sits in a MatrixElement).
+// Runs that share a spacing of 1 or 2 go to the vector kernels, anything else is done one value at a time.
+static void combineInts(int *out, size_t outStep, const int *a, size_t aStep, const int *b, size_t bStep,
+                        size_t count, int subtract) {
+    if (outStep == aStep && aStep == bStep && aStep <= 2) {
+        matrixKernels()->combineInts(out, a, b, count, aStep, subtract);
+        return;
+    }
+    for (size_t k = 0; k < count; k++) {
+        int left = a[k * aStep];
+        int right = b[k * bStep];
+        out[k * outStep] = subtract ? left - right : left + right;
+    }
+}
+
+// Add or subtract two runs of doubles into a third
+// Doubles fill a whole MatrixElement, so both storage types are always contiguous here.
+static void combineDoubles(double *out, const double *a, const double *b, size_t count, int subtract) {
+    matrixKernels()->combineDoubles(out, a, b, count, subtract);
+}
+
+// Add or subtract ints of matrices stored in different orders
+// 'lines' and 'length' follow the result's order. The walk goes one ORDER_TILE square at a time,
+// so the operand that is read against its grain only ever touches a few cache lines at once.
+static void combineIntTiles(int *out, size_t outLine, size_t outStep,
+                            const int *a, size_t aLine, size_t aStep,
+                            const int *b, size_t bLine, size_t bStep,
+                            int lines, int length, int subtract) {
+    for (int tileLine = 0; tileLine < lines; tileLine += ORDER_TILE) {
+        int lineEnd = (tileLine + ORDER_TILE < lines) ? tileLine + ORDER_TILE : lines;
+        for (int tileStep = 0; tileStep < length; tileStep += ORDER_TILE) {
+            int stepEnd = (tileStep + ORDER_TILE < length) ? tileStep + ORDER_TILE : length;
+            for (int i = tileLine; i < lineEnd; i++) {
+                for (int j = tileStep; j < stepEnd; j++) {
+                    int left = a[i * aLine + j * aStep];
+                    int right = b[i * bLine + j * bStep];
+                    out[i * outLine + j * outStep] = subtract ? left - right : left + right;
+                }
+            }
+        }
+    }
+}
+
+// Add or subtract doubles of matrices stored in different orders, one tile at a time
+static void combineDoubleTiles(double *out, size_t outLine, size_t outStep,
+                               const double *a, size_t aLine, size_t aStep,
+                               const double *b, size_t bLine, size_t bStep,
+                               int lines, int length, int subtract) {
+    for (int tileLine = 0; tileLine < lines; tileLine += ORDER_TILE) {
+        int lineEnd = (tileLine + ORDER_TILE < lines) ? tileLine + ORDER_TILE : lines;
+        for (int tileStep = 0; tileStep < length; tileStep += ORDER_TILE) {
+            int stepEnd = (tileStep + ORDER_TILE < length) ? tileStep + ORDER_TILE : length;
+            for (int i = tileLine; i < lineEnd; i++) {
+                for (int j = tileStep; j < stepEnd; j++) {
+                    double left = a[i * aLine + j * aStep];
+                    double right = b[i * bLine + j * bStep];
+                    out[i * outLine + j * outStep] = subtract ? left - right : left + right;
+                }
+            }
+        }
+    }
+}
+
+// One add or subtract, shared between threads
+// Everything is walked along the lines of the result's order, and 'singleRun' marks the case where
+// there are no gaps and nothing to reorder, so all the values can be treated as one run.
+typedef struct {
+    DataType data_type;
+    int subtract;
+    int sameOrder;
+    int singleRun;
+    void *out;
+    const void *a;
+    const void *b;
+    size_t outLine, outStep;
+    size_t aLine, aStep;
+    size_t bLine, bStep;
+    int lines;
+    int length;
+} CombineJob;
+
+// Add or subtract lines 'start' up to 'end' of a job, or values 'start' up to 'end' of a single run
+static void combineRange(void *context, int task, size_t start, size_t end) {
+    const CombineJob *job = (const CombineJob *)context;
+    (void)task;
+
+    if (job->singleRun) {
+        if (job->data_type == INT) {
+            combineInts((int *)job->out + start * job->outStep, job->outStep,
+                        (const int *)job->a + start * job->aStep, job->aStep,
+                        (const int *)job->b + start * job->bStep, job->bStep, end - start, job->subtract);
+        } else if (job->data_type == DOUBLE) {
+            combineDoubles((double *)job->out + start, (const double *)job->a + start,
+                           (const double *)job->b + start, end - start, job->subtract);
+        }
+        return;
+    }
+
+    if (job->sameOrder) {
+        for (size_t i = start; i < end; i++) {
+            if (job->data_type == INT) {
+                combineInts((int *)job->out + i * job->outLine, job->outStep,
+                            (const int *)job->a + i * job->aLine, job->aStep,
+                            (const int *)job->b + i * job->bLine, job->bStep, (size_t)job->length, job->subtract);
+            } else if (job->data_type == DOUBLE) {
+                combineDoubles((double *)job->out + i * job->outLine, (const double *)job->a + i * job->aLine,
+                               (const double *)job->b + i * job->bLine, (size_t)job->length, job->subtract);
+            }
+        }
+        return;
+    }
+
+    // Otherwise walk tile by tile
+    if (job->data_type == INT) {
+        combineIntTiles((int *)job->out + start * job->outLine, job->outLine, job->outStep,
+                        (const int *)job->a + start * job->aLine, job->aLine, job->aStep,
+                        (const int *)job->b + start * job->bLine, job->bLine, job->bStep,
+                        (int)(end - start), job->length, job->subtract);
+    } else if (job->data_type == DOUBLE) {
+        combineDoubleTiles((double *)job->out + start * job->outLine, job->outLine, job->outStep,
+                           (const double *)job->a + start * job->aLine, job->aLine, job->aStep,
+                           (const double *)job->b + start * job->bLine, job->bLine, job->bStep,
+                           (int)(end - start), job->length, job->subtract);
+    }
+}
+
+// Check that two views can be added or subtracted, printing why not if they can't
+// Returns MATRIX_SUCCESS or the reason they can't
+static MatrixStatus checkCombineOperands(const MatrixView *view1, const MatrixView *view2, int subtract) {
+    // Confirm our matricies are the same size, or it won't work.
+    if (view1->rows != view2->rows || view1->cols != view2->cols) {
+        printf("Error: Matrices dimensions do not match.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+
+    // Confirm we hav ethe same data type in each matrix or it won't work
+    if (view1->data_type != view2->data_type) {
+        printf("Error: Matrices data types do not match.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+
+    // Characters can't be added or subtracted
+    if (view1->data_type == CHAR) {
+        if (subtract) {
+            printf("Error: Subtraction not supported for CHAR type matrices.\n");
+        } else {
+            printf("Error: Addition not supported for CHAR type matrices.\n");
+        }
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// Add or subtract two checked views into a third of the same size
+// The result may be one of the operands, because every value is read before the same value is written
+static void combineViewsInto(const MatrixView *out, const MatrixView *view1, const MatrixView *view2, int subtract) {
+    // Walk everything along the lines of the result's order
+    CombineJob job;
+    job.data_type = view1->data_type;
+    job.subtract = subtract;
+    job.sameOrder = (view1->order == out->order && view2->order == out->order);
+    job.out = viewValues(out);
+    job.a = viewValues(view1);
+    job.b = viewValues(view2);
+    viewLineStrides(out, out->order, &job.outLine, &job.outStep);
+    viewLineStrides(view1, out->order, &job.aLine, &job.aStep);
+    viewLineStrides(view2, out->order, &job.bLine, &job.bStep);
+    job.lines = viewLines(out);
+    job.length = viewLineLength(out);
+
+    // When all three share an order every line is a run of values,
+    // and with no gaps between lines the whole thing is a single run
+    job.singleRun = job.sameOrder && viewIsContiguous(out) && viewIsContiguous(view1) && viewIsContiguous(view2);
+
+    // Share the values (or lines) out between the threads
+    size_t count = job.singleRun ? (size_t)job.lines * job.length : (size_t)job.lines;
+    size_t grain = job.singleRun ? PARALLEL_MIN_VALUES : PARALLEL_MIN_VALUES / job.length + 1;
+    parallelRange(count, parallelRangeCount(count, grain), combineRange, &job);
+}
+
+// Shared body of the add and subtract functions
+static Matrix combineViews(const MatrixView *view1, const MatrixView *view2, int subtract) {
+    if (checkCombineOperands(view1, view2, subtract) != MATRIX_SUCCESS) {
+        printf("Returning empty matrix to indicate error state.\n");
+        return invalidMatrix();
+    }
+
+    // Create the new matrix to store the result in, stored the same way as the first matrix
+    Matrix result = createMatrixWithLayout(view1->rows, view1->cols, view1->data_type, view1->order, view1->storage);
+    MatrixView out = viewMatrix(&result);
+    if (result.block == NULL) {
+        return result;
+    }
+    combineViewsInto(&out, view1, view2, subtract);
+    return result;
+}
+
+// Check that a destination can hold a result of the given size and data type, printing why not if it can't
+// Returns MATRIX_SUCCESS or the reason it can't
+static MatrixStatus checkDestination(const MatrixView *dest, int rows, int cols, DataType data_type) {
+    if (dest->block == NULL) {
+        printf("Error: Destination matrix is not valid.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (dest->rows != rows || dest->cols != cols) {
+        printf("Error: Destination matrix dimensions do not match the result.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (dest->data_type != data_type) {
+        printf("Error: Destination matrix data type does not match the result.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// Whether two matricies share an element block but lay it out differently, so one can't be written over the other
+static int layoutsClash(const Matrix *mat1, const Matrix *mat2) {
+    return mat1->block == mat2->block && (mat1->order != mat2->order || mat1->storage != mat2->storage);
+}
+
+// Shared body of the add and subtract into functions
+static MatrixStatus combineMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2, int subtract) {
+    if (!dest || !mat1 || !mat2 || !mat1->block || !mat2->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    MatrixView out = viewMatrix(dest);
+    MatrixStatus status = checkCombineOperands(&view1, &view2, subtract);
+    if (status == MATRIX_SUCCESS) {
+        status = checkDestination(&out, mat1->rows, mat1->cols, mat1->data_type);
+    }
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // Writing over an operand is fine as long as the destination reads its elements the same way
+    if (layoutsClash(dest, mat1) || layoutsClash(dest, mat2)) {
+        printf("Error: Destination matrix shares its elements with an operand stored differently.\n");
+        return MATRIX_ERROR_ALIASING;
+    }
+    combineViewsInto(&out, &view1, &view2, subtract);
+    return MATRIX_SUCCESS;
+}
+
+// Function to add 2 matricies together
 // Accepts two different matrix pointers
 // Returns a matrix
-Matrix multiplyMatrices(const Matrix *mat1, const Matrix *mat2) {
+Matrix addMatrices(const Matrix *mat1, const Matrix *mat2) {
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    return combineViews(&view1, &view2, 0);
+}
+
+// Function to add 2 views together
+// Accepts two view pointers
+// Returns a matrix
+Matrix addMatrixViews(const MatrixView *view1, const MatrixView *view2) {
+    return combineViews(view1, view2, 0);
+}
+
+// Function to subtract 2 matricies
+// Accepts two different matrix pointers
+// Returns a matrix
+Matrix subtractMatrices(const Matrix *mat1, const Matrix *mat2) {
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    return combineViews(&view1, &view2, 1);
+}
+
+// Function to subtract 2 views
+// Accepts two view pointers
+// Returns a matrix
+Matrix subtractMatrixViews(const MatrixView *view1, const MatrixView *view2) {
+    return combineViews(view1, view2, 1);
+}
+
+// Function to add 2 matricies into a matrix that already exists
+// Accepts the destination and two matrix pointers. The destination may be either of the two.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus addMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2) {
+    return combineMatricesInto(dest, mat1, mat2, 0);
+}
+
+// Function to subtract 2 matricies into a matrix that already exists
+// Accepts the destination and two matrix pointers. The destination may be either of the two.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus subtractMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2) {
+    return combineMatricesInto(dest, mat1, mat2, 1);
+}
+
+// Loop orders for multiplication
+// Each one keeps the innermost loop on contiguous memory for a particular combination of layouts
+typedef enum {
+    DOT_LOOP,    // Row of A dotted with column of B, for a row major A and a column major B
+    ROW_LOOP,    // Rows of B scaled into rows of C, for a row major A, B and C
+    COLUMN_LOOP  // Columns of A scaled into columns of C, for a column major A and C
+} MultiplyLoop;
+
+// Multiply ints with the chosen loop order, adding alpha * A * B into C
+// m is the rows of A, n the columns of B and p the shared dimension
+static void multiplyInts(int *c, const int *a, const int *b, const MultiplyStrides *st,
+                         int m, int n, int p, int alpha, MultiplyLoop loop) {
+    if (loop == DOT_LOOP) {
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                int sum = 0;
+                for (int k = 0; k < p; k++) {
+                    sum += a[i * st->aRow + k * st->aCol] * b[k * st->bRow + j * st->bCol];
+                }
+                c[i * st->cRow + j * st->cCol] += alpha * sum;
+            }
+        }
+    } else if (loop == ROW_LOOP) {
+        for (int i = 0; i < m; i++) {
+            for (int k = 0; k < p; k++) {
+                int scale = alpha * a[i * st->aRow + k * st->aCol];
+                for (int j = 0; j < n; j++) {
+                    c[i * st->cRow + j * st->cCol] += scale * b[k * st->bRow + j * st->bCol];
+                }
+            }
+        }
+    } else {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < p; k++) {
+                int scale = alpha * b[k * st->bRow + j * st->bCol];
+                for (int i = 0; i < m; i++) {
+                    c[i * st->cRow + j * st->cCol] += a[i * st->aRow + k * st->aCol] * scale;
+                }
+            }
+        }
+    }
+}
+
+// Multiply doubles with the chosen loop order, adding alpha * A * B into C
+static void multiplyDoubles(double *c, const double *a, const double *b, const MultiplyStrides *st,
+                            int m, int n, int p, double alpha, MultiplyLoop loop) {
+    if (loop == DOT_LOOP) {
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < n; j++) {
+                double sum = 0.0;
+                for (int k = 0; k < p; k++) {
+                    sum += a[i * st->aRow + k * st->aCol] * b[k * st->bRow + j * st->bCol];
+                }
+                c[i * st->cRow + j * st->cCol] += alpha * sum;
+            }
+        }
+    } else if (loop == ROW_LOOP) {
+        for (int i = 0; i < m; i++) {
+            for (int k = 0; k < p; k++) {
+                double scale = alpha * a[i * st->aRow + k * st->aCol];
+                for (int j = 0; j < n; j++) {
+                    c[i * st->cRow + j * st->cCol] += scale * b[k * st->bRow + j * st->bCol];
+                }
+            }
+        }
+    } else {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < p; k++) {
+                double scale = alpha * b[k * st->bRow + j * st->bCol];
+                for (int i = 0; i < m; i++) {
+                    c[i * st->cRow + j * st->cCol] += a[i * st->aRow + k * st->aCol] * scale;
+                }
+            }
+        }
+    }
+}
+
+// Check that two views can be multiplied, printing why not if they can't
+// Returns MATRIX_SUCCESS or the reason they can't
+static MatrixStatus checkMultiplyOperands(const MatrixView *view1, const MatrixView *view2) {
     // Confirm that matrix 1 columns == matrix 2 rows otherwise it won't work.
-    if (mat1->cols != mat2->rows) {
+    if (view1->cols != view2->rows) {
         printf("Error: Matrix dimensions do not allow multiplication (cols of mat1 must equal rows of mat2).\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+        return MATRIX_ERROR_SIZE_MISMATCH;
     }
 
     // Confirm matching data types, or it won't work.
-    if (mat1->data_type != mat2->data_type) {
+    if (view1->data_type != view2->data_type) {
         printf("Error: Data types of matrices do not match.\n");
-        printf("Returning empty matrix to indicate error state.\n");
-        return invalidMatrix();
+        return MATRIX_ERROR_TYPE_MISMATCH;
     }
+    return MATRIX_SUCCESS;
+}
 
-    // Create the result matrix with the data type from mat1 (which is also the data type of mat2)
-    Matrix result = createMatrix(mat1->rows, mat2->cols, mat1->data_type);
+// Zero every value of a view
+static void clearView(const MatrixView *view) {
+    size_t lineBytes = (size_t)viewLineLength(view) * viewElementSize(view);
+    if (viewIsContiguous(view)) {
+        memset(viewValues(view), 0, (size_t)viewLines(view) * lineBytes);
+        return;
+    }
+    for (int i = 0; i < viewLines(view); i++) {
+        memset((char *)viewValues(view) + (size_t)i * view->ld * viewElementSize(view), 0, lineBytes);
+    }
+}
 
-    // Begin multiplication
-    // Iterate over the rows of matrix 1
-    for (int i = 0; i < mat1->rows; i++) {
+// Multiply every value of an INT or DOUBLE view by 'scale'. A scale of 0 clears the view without reading it.
+static void scaleView(const MatrixView *view, double scale) {
+    if (scale == 1.0) {
+        return;
+    }
+    if (scale == 0.0) {
+        clearView(view);
+        return;
+    }
+    size_t line, step;
+    viewLineStrides(view, view->order, &line, &step);
+    for (int i = 0; i < viewLines(view); i++) {
+        for (int j = 0; j < viewLineLength(view); j++) {
+            if (view->data_type == INT) {
+                ((int *)viewValues(view))[i * line + j * step] *= (int)scale;
+            } else if (view->data_type == DOUBLE) {
+                ((double *)viewValues(view))[i * line + j * step] *= scale;
+            }
+        }
+    }
+}
 
-        // Iterate over the columns in matrix 2
-        for (int j = 0; j < mat2->cols; j++) {
+// Whether a scale can be applied to INT values, which means it is a whole number an int can hold.
+// The range is checked first, because converting NaN, an infinity or an out of range double to int is undefined.
+int isIntScale(double scale) {
+    return scale >= INT_MIN && scale <= INT_MAX && scale == (int)scale;
+}
 
-            // Iterate over the columns in matrix 1
-            for (int k = 0; k < mat1->cols; k++) {
+// Work out alpha * view1 * view2 + beta * out for checked views, where out shares no elements with either operand.
+// A beta of 0 overwrites the result without reading it. INT views take scales that pass isIntScale.
+static void multiplyViewsInto(const MatrixView *out, const MatrixView *view1, const MatrixView *view2,
+                              double alpha, double beta) {
+    // INT scales are only converted once the views are known to be INT, where the caller has checked them
+    int intAlpha = 0, intBeta = 0;
+    if (view1->data_type == INT) {
+        intAlpha = (int)alpha;
+        intBeta = (int)beta;
+    }
 
-                // Add the product of the row/column matches to the result matrix cells
-                if (mat1->data_type == INT) {
-                    result.data[i][j].int_val += mat1->data[i][k].int_val * mat2->data[k][j].int_val;
-                } else if (mat1->data_type == DOUBLE) {
-                    result.data[i][j].double_val += mat1->data[i][k].double_val * mat2->data[k][j].double_val;
-                }
-            }
+    // Work out how far apart neighbouring rows and columns are in each block
+    MultiplyStrides strides;
+    viewValueStrides(view1, &strides.aRow, &strides.aCol);
+    viewValueStrides(view2, &strides.bRow, &strides.bCol);
+    viewValueStrides(out, &strides.cRow, &strides.cCol);
+
+    // Big multiplications go through the blocked GEMM, which packs its operands and so doesn't mind their layouts
+    int m = view1->rows, n = view2->cols, p = view1->cols;
+    if ((size_t)m * n * p >= GEMM_MIN_VOLUME) {
+        int done = 0;
+        if (view1->data_type == INT) {
+            done = gemmInts((int *)viewValues(out), (const int *)viewValues(view1), (const int *)viewValues(view2),
+                            &strides, m, n, p, intAlpha, intBeta);
+        } else if (view1->data_type == DOUBLE) {
+            done = gemmDoubles((double *)viewValues(out), (const double *)viewValues(view1),
+                               (const double *)viewValues(view2), &strides, m, n, p, alpha, beta);
+        }
+        // If the packing buffers couldn't be had, the plain loops below still get the job done
+        if (done) {
+            return;
         }
     }
+
+    // The plain loops add into the result, so it is scaled by beta first
+    scaleView(out, beta);
+
+    // Pick the loop order that suits the layouts
+    MultiplyLoop loop;
+    if (out->order == COLUMN_MAJOR && view1->order == COLUMN_MAJOR) {
+        loop = COLUMN_LOOP;
+    } else if (view2->order == COLUMN_MAJOR) {
+        loop = DOT_LOOP;
+    } else {
+        loop = ROW_LOOP;
+    }
+
+    // Begin multiplication, with the data type checked once up front
+    if (view1->data_type == INT) {
+        multiplyInts((int *)viewValues(out), (const int *)viewValues(view1), (const int *)viewValues(view2), &strides,
+                     m, n, p, intAlpha, loop);
+    } else if (view1->data_type == DOUBLE) {
+        multiplyDoubles((double *)viewValues(out), (const double *)viewValues(view1),
+                        (const double *)viewValues(view2), &strides, m, n, p, alpha, loop);
+    }
+}
+
+// Function to multiply two views
+// Accepts two view pointers
+// Returns a matrix
+Matrix multiplyMatrixViews(const MatrixView *view1, const MatrixView *view2) {
+    if (checkMultiplyOperands(view1, view2) != MATRIX_SUCCESS) {
+        printf("Returning empty matrix to indicate error state.\n");
+        return invalidMatrix();
+    }
+
+    // Create the result matrix with the data type and layout from mat1
+    Matrix result = createMatrixWithLayout(view1->rows, view2->cols, view1->data_type, view1->order, view1->storage);
+    MatrixView out = viewMatrix(&result);
+    if (result.block == NULL) {
+        return result;
+    }
+    // The new result is already zeroed, so it can simply be added into
+    multiplyViewsInto(&out, view1, view2, 1.0, 1.0);
     return result;
 }
 
+// Function to multiply two matricies
+// Accepts two different matrix pointers
+// Returns a matrix
+Matrix multiplyMatrices(const Matrix *mat1, const Matrix *mat2) {
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    return multiplyMatrixViews(&view1, &view2);
+}
+
+// Function to work out dest = alpha * op(view1) * op(view2) + beta * dest, where op() optionally transposes
+// The transposes are read straight from the operands and never stored, and a beta of 0 ignores what dest held.
+// Accepts the transpose flags, alpha, the two operand views, beta, and a destination view that shares no matrix
+// with either operand. INT views need whole number scales, and CHAR views can't be multiplied.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus gemmMatrixViews(Transpose transpose1, Transpose transpose2, double alpha, const MatrixView *view1,
+                             const MatrixView *view2, double beta, const MatrixView *dest) {
+    if (!dest || !view1 || !view2 || !view1->block || !view2->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView op1 = (transpose1 == TRANSPOSE) ? transposeMatrixView(view1) : *view1;
+    MatrixView op2 = (transpose2 == TRANSPOSE) ? transposeMatrixView(view2) : *view2;
+    MatrixStatus status = checkMultiplyOperands(&op1, &op2);
+    if (status == MATRIX_SUCCESS) {
+        status = checkDestination(dest, op1.rows, op2.cols, op1.data_type);
+    }
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // Characters can't be multiplied, and ints can only be scaled by whole numbers
+    if (op1.data_type == CHAR) {
+        printf("Error: Multiplication not supported for CHAR type matrices.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    if (op1.data_type == INT && (!isIntScale(alpha) || !isIntScale(beta))) {
+        printf("Error: INT matrices can only be scaled by whole numbers.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+
+    // Every result value needs a whole row and column of the operands, so it can't be written over them
+    if (dest->block == view1->block || dest->block == view2->block) {
+        printf("Error: Destination matrix can't be an operand of a multiplication.\n");
+        return MATRIX_ERROR_ALIASING;
+    }
+    multiplyViewsInto(dest, &op1, &op2, alpha, beta);
+    return MATRIX_SUCCESS;
+}
+
+// Function to work out dest = alpha * op(mat1) * op(mat2) + beta * dest, the same way as gemmMatrixViews
+// Accepts the transpose flags, alpha, the two operands, beta, and a destination that is neither operand
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus gemmMatrices(Transpose transpose1, Transpose transpose2, double alpha, const Matrix *mat1,
+                          const Matrix *mat2, double beta, Matrix *dest) {
+    if (!dest || !mat1 || !mat2) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    MatrixView out = viewMatrix(dest);
+    return gemmMatrixViews(transpose1, transpose2, alpha, &view1, &view2, beta, &out);
+}
+
+// Function to multiply two matricies into a matrix that already exists
+// Accepts the destination and two matrix pointers. The destination can't be either of the two,
+// because every result value needs a whole row and column of the operands.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus multiplyMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2) {
+    return gemmMatrices(NO_TRANSPOSE, NO_TRANSPOSE, 1.0, mat1, mat2, 0.0, dest);
+}
+
 // Function to creaet a deep copy of a matrix
 // Accepts a matrix pointer
 // Returns a matrix
 Matrix deepCopyMatrix(const Matrix *source) {
 
     // Make sure we have a valid data source
-    if (!source || !source->data) {
+    if (!source || !source->block) {
         printf("Error: Invalid source matrix for copying.\n");
         return invalidMatrix();
     }
 
-    // Create a new matrix with the same dimensions and type
-    Matrix copy = createMatrix(source->rows, source->cols, source->data_type);
+    // Copy the whole matrix through a view of it.
+    // The matrix is contiguous, so this is a single memcpy of its block.
+    MatrixView view = viewMatrix(source);
+    Matrix copy = copyMatrixView(&view);
 
     // If we fail to copy, return invalid
-    if (!copy.data) {
+    if (!copy.block) {
         printf("Error: Memory allocation failed for matrix copy.\n");
         return invalidMatrix();
     }
+    return copy;
+}
+
+// Function to copy a matrix into a matrix that already exists
+// Accepts the destination and source matrix pointers. They may be stored differently, and are converted as they go.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus copyMatrixInto(Matrix *dest, const Matrix *source) {
+    if (!dest || !source || !source->block) {
+        printf("Error: Invalid source matrix for copying.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView out = viewMatrix(dest);
+    MatrixView view = viewMatrix(source);
+    MatrixStatus status = checkDestination(&out, source->rows, source->cols, source->data_type);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // A matrix that shares its elements with the source already holds the copy, unless they read them differently
+    if (dest->block == source->block) {
+        if (layoutsClash(dest, source)) {
+            printf("Error: Destination matrix shares its elements with an operand stored differently.\n");
+            return MATRIX_ERROR_ALIASING;
+        }
+        return MATRIX_SUCCESS;
+    }
+    copyViewInto(&out, &view);
+    return MATRIX_SUCCESS;
+}
+
+// Compare two runs of values of the same data type, each stepping by its own spacing
+// Returns 1 if every value matches, and 0 as soon as one doesn't
+static int runsEqual(DataType data_type, const void *first, size_t firstStep, const void *second, size_t secondStep,
+                     size_t count) {
+    // Runs that line up go to the vector kernels, and packed chars have no padding so their bytes can be compared directly
+    if (data_type == INT && firstStep == secondStep && firstStep <= 2) {
+        return matrixKernels()->equalInts((const int *)first, (const int *)second, count, firstStep);
+    }
+    if (data_type == DOUBLE && firstStep == 1 && secondStep == 1) {
+        return matrixKernels()->equalDoubles((const double *)first, (const double *)second, count);
+    }
+    if (data_type == CHAR && firstStep == 1 && secondStep == 1) {
+        return memcmp(first, second, count) == 0;
+    }
 
-    // Once we have a matrix to put stuff in, copy all the data cell by cell
-    // Iterate over rows in the source
-    for (int i = 0; i < source->rows; i++) {
-        // Iterate over columns in the source
-        for (int j = 0; j < source->cols; j++) {
-            switch (source->data_type) {
-                // Copy the data based on type
-                case INT:
-                    copy.data[i][j].int_val = source->data[i][j].int_val;
-                    break;
-                case DOUBLE:
-                    copy.data[i][j].double_val = source->data[i][j].double_val;
-                    break;
-                case CHAR:
-                    copy.data[i][j].char_val = source->data[i][j].char_val;
-                    break;
+    // Compare based on data types, exiting as soon as we see a != to save cycles
+    switch (data_type) {
+        case INT: {
+            const int *a = (const int *)first;
+            const int *b = (const int *)second;
+            for (size_t k = 0; k < count; k++) {
+                if (a[k * firstStep] != b[k * secondStep]) {
+                    return 0;
+                }
+            }
+            break;
+        }
+        case DOUBLE: {
+            const double *a = (const double *)first;
+            const double *b = (const double *)second;
+            for (size_t k = 0; k < count; k++) {
+                if (a[k * firstStep] != b[k * secondStep]) {
+                    return 0;
+                }
+            }
+            break;
+        }
+        case CHAR: {
+            const char *a = (const char *)first;
+            const char *b = (const char *)second;
+            for (size_t k = 0; k < count; k++) {
+                if (a[k * firstStep] != b[k * secondStep]) {
+                    return 0;
+                }
             }
+            break;
         }
     }
-    return copy;
+    return 1;
+}
+
+// One comparison of two same-shaped views, shared between threads
+// Both views are walked along the lines of the first view's order. 'equal' holds one answer per range.
+typedef struct {
+    DataType data_type;
+    const char *first;
+    const char *second;
+    size_t line1, step1;
+    size_t line2, step2;
+    size_t size;
+    int length;
+    int strip;
+    int singleRun;
+    int *equal;
+} CompareJob;
+
+// Compare lines 'start' up to 'end' of a job, or values 'start' up to 'end' of a single run
+static void compareRange(void *context, int task, size_t start, size_t end) {
+    const CompareJob *job = (const CompareJob *)context;
+    if (job->singleRun) {
+        job->equal[task] = runsEqual(job->data_type, job->first + start * job->step1 * job->size, job->step1,
+                                     job->second + start * job->step2 * job->size, job->step2, end - start);
+        return;
+    }
+
+    // Line by line, in strips of 'strip' values
+    job->equal[task] = 1;
+    for (int stripStart = 0; stripStart < job->length; stripStart += job->strip) {
+        int stripLength = (stripStart + job->strip < job->length) ? job->strip : job->length - stripStart;
+        for (size_t i = start; i < end; i++) {
+            if (!runsEqual(job->data_type, job->first + (i * job->line1 + stripStart * job->step1) * job->size,
+                           job->step1, job->second + (i * job->line2 + stripStart * job->step2) * job->size,
+                           job->step2, (size_t)stripLength)) {
+                job->equal[task] = 0;
+                return;
+            }
+        }
+    }
+}
+
+// Compare the values of two same-shaped views of the same data type
+// Returns 1 if every value matches, and 0 if one doesn't
+static int viewValuesEqual(const MatrixView *view1, const MatrixView *view2) {
+    CompareJob job;
+    job.data_type = view1->data_type;
+    job.first = (const char *)viewValues(view1);
+    job.second = (const char *)viewValues(view2);
+    viewLineStrides(view1, view1->order, &job.line1, &job.step1);
+    viewLineStrides(view2, view1->order, &job.line2, &job.step2);
+    job.size = valueSize(view1->data_type);
+    job.length = viewLineLength(view1);
+
+    // With matching orders and no gaps, both views are one run each.
+    // Otherwise they are compared line by line, and mismatched orders go in strips of ORDER_TILE
+    // so the view read against its grain stays in cache.
+    job.singleRun = view1->order == view2->order && viewIsContiguous(view1) && viewIsContiguous(view2);
+    job.strip = (view1->order == view2->order) ? job.length : ORDER_TILE;
+
+    // Share the values (or lines) out between the threads, each with its own answer
+    size_t count = job.singleRun ? (size_t)viewLines(view1) * job.length : (size_t)viewLines(view1);
+    size_t grain = job.singleRun ? PARALLEL_MIN_VALUES : PARALLEL_MIN_VALUES / job.length + 1;
+    int ranges = parallelRangeCount(count, grain);
+    int onlyAnswer = 1;
+    job.equal = (ranges > 1) ? (int *)malloc((size_t)ranges * sizeof(int)) : NULL;
+    if (job.equal == NULL) {
+        ranges = 1;
+        job.equal = &onlyAnswer;
+    }
+    parallelRange(count, ranges, compareRange, &job);
+
+    int equal = 1;
+    for (int i = 0; i < ranges; i++) {
+        equal = equal && job.equal[i];
+    }
+    if (job.equal != &onlyAnswer) {
+        free(job.equal);
+    }
+    return equal;
+}
+
+// Function to check for view same-ness
+// Accepts two view pointers
+// Returns an enum of "Sameness" with values "INSTANCE" "ELEMENT" or "NEITHER".
+Sameness checkViewSameness(const MatrixView *view1, const MatrixView *view2) {
+    // Check if both views are the same instance
+    if (view1 == view2) {
+        return INSTANCE;
+    }
+
+    // Check if both views are null
+    if (view1 == NULL && view2 == NULL) {
+        return ELEMENT;
+    // Check if only one view is null so we can exit early
+    } else if (view1 == NULL || view2 == NULL) {
+        return NEITHER;
+    }
+
+    // Check dimensions and type before comparing elements, so we can exit early
+    if (view1->rows != view2->rows || view1->cols != view2->cols || view1->data_type != view2->data_type) {
+        return NEITHER;
+    }
+
+    // Two views that look at exactly the same cells the same way are the same instance
+    if (view1->block == view2->block && view1->offset == view2->offset && view1->ld == view2->ld &&
+        view1->order == view2->order && view1->storage == view2->storage) {
+        return INSTANCE;
+    }
+
+    // Element-wise comparison
+    if (!viewValuesEqual(view1, view2)) {
+        return NEITHER;
+    }
+
+    // If we get here, all elements are the same, but the views are not the same instance
+    return ELEMENT;
 }
 
 // Function to check for matrix same-ness
@@ -588,83 +1917,257 @@ Sameness checkMatrixSameness(const Matrix *mat1, const Matrix *mat2) {
         return NEITHER;
     }
 
-    // Check dimensions and type before comparing elements, so we can exit early
-    if (mat1->rows != mat2->rows || mat1->cols != mat2->cols || mat1->data_type != mat2->data_type) {
-        return NEITHER;
+    // Compare the matricies through views of them
+    MatrixView view1 = viewMatrix(mat1);
+    MatrixView view2 = viewMatrix(mat2);
+    return checkViewSameness(&view1, &view2);
+}
+
+// Change the storage order of a matrix
+// Accepts a matrix pointer and the storage order it should end up in
+// Returns void, because the matrix is converted in place
+void convertMatrixOrder(Matrix *mat, StorageOrder order) {
+    // Nothing to do if the matrix is already stored that way
+    if (mat->order == order) {
+        return;
     }
 
-    // Element-wise comparison
+    // Allocate storage for the new order
+    Matrix converted = *mat;
+    converted.order = order;
+    if (!allocateMatrixStorage(&converted)) {
+        printf("Memory allocation failed for converted matrix.\n");
+        return;
+    }
 
-    // Iterate over rows
-    for (int i = 0; i < mat1->rows; i++) {
-        // Iterate over columns
-        for (int j = 0; j < mat1->cols; j++) {
-            // Compare based on data types, exiting as soon as we see a != to save cycles
-            switch (mat1->data_type) {
-                case INT:
-                    if (mat1->data[i][j].int_val != mat2->data[i][j].int_val) {
-                        return NEITHER;
-                    }
-                    break;
-                case DOUBLE:
-                    if (mat1->data[i][j].double_val != mat2->data[i][j].double_val) {
-                        return NEITHER;
-                    }
-                    break;
-                case CHAR:
-                    if (mat1->data[i][j].char_val != mat2->data[i][j].char_val) {
-                        return NEITHER;
-                    }
-                    break;
-            }
+    // The rows of one order are the columns of the other, so this is a transposing copy of the block
+    if (mat->block != NULL) {
+        MatrixView out = viewMatrix(&converted);
+        MatrixView view = viewMatrix(mat);
+        copyViewInto(&out, &view);
+    }
+
+    // Free the old storage and take over the new one
+    freeMatrix(mat);
+    *mat = converted;
+}
+
+// MARK - Rotation
+// Every rotation and transpose reads each value once and writes it once, through a ValueWalk over the source,
+// one ORDER_TILE square at a time.
+
+// Number of clockwise quarter turns in a rotation
+static int rotationTurns(Rotation rotation) {
+    switch (rotation) {
+        case ROTATE_180:
+            return 2;
+        case ROTATE_270:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+// One in place quarter turn of a square matrix, shared between threads a tile of its top left quadrant at a time
+typedef struct {
+    const MatrixView *whole;
+    int turns;
+    int tileCols;
+} QuarterTurnJob;
+
+// Turn the cells of tiles 'start' up to 'end' of the top left quadrant, and the three tiles they turn into
+static void quarterTurnRange(void *context, int task, size_t start, size_t end) {
+    const QuarterTurnJob *job = (const QuarterTurnJob *)context;
+    const MatrixView *whole = job->whole;
+    int n = whole->rows;
+    int half = n / 2;
+    int wide = n - half;
+    MatrixElement scratch[ORDER_TILE * ORDER_TILE];
+    (void)task;
+
+    for (size_t tile = start; tile < end; tile++) {
+        int i0 = (int)(tile / job->tileCols) * ORDER_TILE;
+        int j0 = (int)(tile % job->tileCols) * ORDER_TILE;
+        int i1 = (i0 + ORDER_TILE < half) ? i0 + ORDER_TILE : half;
+        int j1 = (j0 + ORDER_TILE < wide) ? j0 + ORDER_TILE : wide;
+
+        // A clockwise turn moves each cell of corner[k + 1] into corner[k] (and a counterclockwise one the other way).
+        // Rows above n / 2 and columns left of (n + 1) / 2 meet every such cycle of four tiles exactly once,
+        // so no two tiles of the quadrant share a cycle and they can be turned on different threads.
+        MatrixView corner[4];
+        corner[0] = createSubView(whole, i0, i1 - 1, j0, j1 - 1);
+        corner[1] = createSubView(whole, n - j1, n - j0 - 1, i0, i1 - 1);
+        corner[2] = createSubView(whole, n - i1, n - i0 - 1, n - j1, n - j0 - 1);
+        corner[3] = createSubView(whole, j0, j1 - 1, n - i1, n - i0 - 1);
+
+        // The first tile is saved before it is written over, and becomes the source of the last one
+        MatrixView saved = {i1 - i0, j1 - j0, whole->data_type, PACKED_STORAGE, ROW_MAJOR, scratch, 0, j1 - j0};
+        ValueWalk walk = rotatedWalk(&corner[0], 0, 0);
+        gatherRows(&saved, &walk, 0, saved.rows);
+
+        int step = (job->turns == 1) ? 1 : 3;
+        for (int k = 0, at = 0; k < 4; k++) {
+            int from = (at + step) % 4;
+            walk = rotatedWalk((from == 0) ? &saved : &corner[from], job->turns, 0);
+            gatherRows(&corner[at], &walk, 0, corner[at].rows);
+            at = from;
         }
     }
+}
 
-    // If we get here, all elements are the same, but the matricies are not the same instance
-    return ELEMENT;
+// One in place half turn, which swaps each of the first half of a block's stored elements with its mirror image
+typedef struct {
+    char *block;
+    size_t count;
+    size_t elementSize;
+} ReverseJob;
+
+// Swap stored elements 'start' up to 'end' of a job with the matching ones from the far end of the block
+static void reverseRange(void *context, int task, size_t start, size_t end) {
+    const ReverseJob *job = (const ReverseJob *)context;
+    (void)task;
+    size_t last = job->count - 1;
+    switch (job->elementSize) {
+        case sizeof(MatrixElement):
+            for (size_t i = start; i < end; i++) {
+                MatrixElement *elements = (MatrixElement *)job->block;
+                MatrixElement temp = elements[i];
+                elements[i] = elements[last - i];
+                elements[last - i] = temp;
+            }
+            break;
+        case sizeof(int):
+            for (size_t i = start; i < end; i++) {
+                int *values = (int *)job->block;
+                int temp = values[i];
+                values[i] = values[last - i];
+                values[last - i] = temp;
+            }
+            break;
+        default:
+            for (size_t i = start; i < end; i++) {
+                char temp = job->block[i];
+                job->block[i] = job->block[last - i];
+                job->block[last - i] = temp;
+            }
+            break;
+    }
 }
 
-// Rotate amatrix 90 clockwise
-// Accepts a matrix pointer
-// Returns void, because our matrix is being rotated in place so no return is needed
-RotationStatus rotateMatrix(Matrix *mat) {
-    if (mat == NULL || mat->data == NULL || mat->rows == 0 || mat->cols == 0) {
+// Rotate a matrix in place
+// A half turn of any matrix is its stored elements in reverse order. A quarter turn of a square matrix moves
+// four tiles at once, one from each quadrant, through a small scratch tile, which fuses the transpose
+// and the reversal into a single pass that stays in cache.
+// Accepts a matrix pointer and the rotation, clockwise
+// Returns SUCCESS, or the reason it couldn't be rotated with the matrix untouched
+RotationStatus rotateMatrixBy(Matrix *mat, Rotation rotation) {
+    if (mat == NULL || mat->block == NULL || mat->rows == 0 || mat->cols == 0) {
         printf("Error: Null matrix or data.\n");
         return ERROR_NULL_POINTER;
     }
-    
+
+    int turns = rotationTurns(rotation);
+    if (turns == 2) {
+        ReverseJob job = {(char *)mat->block, (size_t)mat->rows * mat->cols, storedElementSize(mat)};
+        size_t pairs = job.count / 2;
+        parallelRange(pairs, parallelRangeCount(pairs, PARALLEL_MIN_VALUES), reverseRange, &job);
+        return SUCCESS;
+    }
+
     if (mat->rows != mat->cols) {
         printf("Error: Only square matrices can be rotated in place.\n");
         return ERROR_NOT_SQUARE;
     }
 
-    int n = mat->rows;  // The matrix is n x n
-    // Transpose the matrix
-    for (int i = 0; i < n; i++) {
-        for (int j = i; j < n; j++) {
-            // Swap element at (i, j) with element at (j, i)
-            MatrixElement temp = mat->data[i][j];
-            mat->data[i][j] = mat->data[j][i];
-            mat->data[j][i] = temp;
-        }
+    // Column major matrices turn the same way through their views, which know how the cells are laid out
+    MatrixView whole = viewMatrix(mat);
+    int half = mat->rows / 2;
+    int wide = mat->rows - half;
+    QuarterTurnJob job = {&whole, turns, (wide + ORDER_TILE - 1) / ORDER_TILE};
+    size_t tiles = (size_t)((half + ORDER_TILE - 1) / ORDER_TILE) * job.tileCols;
+    size_t grain = PARALLEL_MIN_VALUES / (4 * ORDER_TILE * ORDER_TILE) + 1;
+    parallelRange(tiles, parallelRangeCount(tiles, grain), quarterTurnRange, &job);
+    return SUCCESS;
+}
+
+// Rotate a matrix 90 degrees clockwise
+// Accepts a matrix pointer
+// Returns SUCCESS, or the reason it couldn't be rotated with the matrix untouched
+RotationStatus rotateMatrix(Matrix *mat) {
+    return rotateMatrixBy(mat, ROTATE_90);
+}
+
+// Shared body of the transpose and rotate into functions
+static MatrixStatus rearrangeViewInto(const MatrixView *dest, const MatrixView *source, int turns, int transposed) {
+    if (!dest || !source || !source->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    int swapped = (turns & 1) != transposed;
+    MatrixStatus status = checkDestination(dest, swapped ? source->cols : source->rows,
+                                           swapped ? source->rows : source->cols, source->data_type);
+    if (status != MATRIX_SUCCESS) {
+        return status;
     }
 
-    // Reverse each row
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n / 2; j++) {
-            // Swap element at (i, j) with element at (i, n-j-1)
-            MatrixElement temp = mat->data[i][j];
-            mat->data[i][j] = mat->data[i][n - j - 1];
-            mat->data[i][n - j - 1] = temp;
-        }
+    // Values move all over the place, so they can't be written over the ones still to be read
+    if (dest->block == source->block) {
+        printf("Error: Destination matrix can't be the matrix being rearranged.\n");
+        return MATRIX_ERROR_ALIASING;
     }
-    return SUCCESS;
+    ValueWalk walk = rotatedWalk(source, turns, transposed);
+    gatherView(dest, &walk);
+    return MATRIX_SUCCESS;
+}
+
+// Function to transpose a view into a destination view, moving the values rather than just relabelling them
+// Accepts the destination and source view pointers. They may be stored differently, but can't share a matrix.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus transposeViewInto(const MatrixView *dest, const MatrixView *source) {
+    return rearrangeViewInto(dest, source, 0, 1);
+}
+
+// Function to rotate a view of any shape into a destination view
+// Accepts the destination and source view pointers, which can't share a matrix, and the rotation, clockwise
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus rotateViewInto(const MatrixView *dest, const MatrixView *source, Rotation rotation) {
+    return rearrangeViewInto(dest, source, rotationTurns(rotation), 0);
+}
+
+// Shared body of the functions that create a transposed or rotated copy
+static Matrix createRearrangedMatrix(const Matrix *mat, int turns, int transposed) {
+    if (mat == NULL || mat->block == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return invalidMatrix();
+    }
+    int swapped = (turns & 1) != transposed;
+    Matrix result = createMatrixWithLayout(swapped ? mat->cols : mat->rows, swapped ? mat->rows : mat->cols,
+                                           mat->data_type, mat->order, mat->storage);
+    MatrixView out = viewMatrix(&result);
+    MatrixView view = viewMatrix(mat);
+    ValueWalk walk = rotatedWalk(&view, turns, transposed);
+    gatherView(&out, &walk);
+    return result;
+}
+
+// Function to create the transpose of a matrix
+// Accepts a matrix pointer
+// Returns a new matrix stored the same way as the original, with its rows and columns swapped
+Matrix createTransposedMatrix(const Matrix *mat) {
+    return createRearrangedMatrix(mat, 0, 1);
+}
+
+// Function to create a rotated copy of a matrix of any shape
+// Accepts a matrix pointer and the rotation, clockwise
+// Returns a new matrix stored the same way as the original
+Matrix createRotatedMatrix(const Matrix *mat, Rotation rotation) {
+    return createRearrangedMatrix(mat, rotationTurns(rotation), 0);
 }
 
 // Free the memory allocated to a matrix
+// The elements and the row pointer table share one block, so this is a single free
 void freeMatrix(Matrix *mat) {
-    for (int i = 0; i < mat->rows; i++) {
-        free(mat->data[i]);
-    }
-    free(mat->data);
+    alignedFree(mat->block);
+    mat->block = NULL;
+    mat->data = NULL;
 }
@@ -1,6 +1,13 @@
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <stddef.h>
+
+// The library is C, so C++ callers (and matrix.hpp) need its names left unmangled
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // An enum that allows us to specify the type of data our matrix will be filled with.
 typedef enum {
     INT,
@@ -28,6 +35,58 @@ typedef enum {
     ERROR_NOT_SQUARE = -2
 } RotationStatus;
 
+// Enum for how far a matrix is rotated, clockwise
+typedef enum {
+    ROTATE_90,
+    ROTATE_180,
+    ROTATE_270
+} Rotation;
+
+// Enum for the results of the functions that write into an existing matrix
+typedef enum {
+    MATRIX_SUCCESS = 0,
+    MATRIX_ERROR_NULL_POINTER = -1,
+    MATRIX_ERROR_SIZE_MISMATCH = -2,
+    MATRIX_ERROR_TYPE_MISMATCH = -3,
+    MATRIX_ERROR_UNSUPPORTED_TYPE = -4,
+    MATRIX_ERROR_ALIASING = -5,
+    MATRIX_ERROR_IO = -6,
+    MATRIX_ERROR_FORMAT = -7,
+    MATRIX_ERROR_SINGULAR = -8
+} MatrixStatus;
+
+// Enum for whether a multiplication operand is used as it is or transposed
+typedef enum {
+    NO_TRANSPOSE,
+    TRANSPOSE
+} Transpose;
+
+// Enum for how the cells of a matrix are stored
+// ELEMENT_STORAGE keeps a full MatrixElement union per cell, reachable through 'data'.
+// PACKED_STORAGE keeps only the native value per cell (a 4 byte int, a double or a char),
+// which is up to 8x smaller, and has no 'data' table.
+typedef enum {
+    ELEMENT_STORAGE,
+    PACKED_STORAGE
+} StorageType;
+
+// Enum for the order the cells of a matrix are laid out in
+// ROW_MAJOR keeps each row contiguous, COLUMN_MAJOR keeps each column contiguous
+typedef enum {
+    ROW_MAJOR,
+    COLUMN_MAJOR
+} StorageOrder;
+
+// Enum for the instruction sets the arithmetic kernels can be built on
+// ISA_AUTO picks the best one the CPU supports, the rest force a specific one (mostly for testing).
+typedef enum {
+    ISA_AUTO,
+    ISA_SCALAR,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_AVX512
+} InstructionSet;
+
 // A union to use for our actual elements that will go into the matrix
 typedef union {
     int int_val;
@@ -36,13 +95,47 @@ typedef union {
 } MatrixElement;
 
 // Struct for matrix, with rows, columns, data type, and elements
+// Every element lives in one aligned block, laid out in the matrix's own storage order.
+// With element storage, 'data' holds a pointer to the start of each row (or column in column major order)
+// inside it. Packed matrices leave 'data' NULL and are read through the typed accessors.
 typedef struct {
     int rows;
     int cols;
     DataType data_type;
     MatrixElement **data;
+    void *block;
+    StorageType storage;
+    StorageOrder order;
 } Matrix;
 
+// Struct for a view, a window onto a rectangle of a matrix that doesn't copy or own anything
+// The view starts 'offset' stored elements into the viewed matrix's block, and neighbouring rows
+// (or columns in column major order) start 'ld' stored elements apart.
+// A view is only good for as long as the matrix it looks at isn't freed, resized or converted.
+typedef struct {
+    int rows;
+    int cols;
+    DataType data_type;
+    StorageType storage;
+    StorageOrder order;
+    void *block;
+    size_t offset;
+    int ld;
+} MatrixView;
+
+// Struct for an allocator that matrix blocks can come from
+// 'allocate' returns 'size' bytes (with any alignment) or NULL, and 'release' gets back a pointer it returned
+// along with the same size. 'context' is passed to both. An allocator with no allocate function is the system one.
+typedef struct {
+    void *(*allocate)(void *context, size_t size);
+    void (*release)(void *context, void *ptr, size_t size);
+    void *context;
+} MatrixAllocator;
+
+// Built in allocators: an arena that releases everything at once, and a pool that recycles blocks by size
+typedef struct MatrixArena MatrixArena;
+typedef struct MatrixPool MatrixPool;
+
 // MARK - Function prototypes
 
 // Detect invalid return matricies
@@ -54,6 +147,15 @@ Matrix invalidMatrix();
 // A create matrix prototype
 Matrix createMatrix(int rows, int cols, DataType data_type);
 
+// Create a matrix with a chosen storage order and storage type
+Matrix createMatrixWithLayout(int rows, int cols, DataType data_type, StorageOrder order, StorageType storage);
+
+// Create a matrix with a chosen storage type
+Matrix createMatrixWithStorage(int rows, int cols, DataType data_type, StorageType storage);
+
+// Create a packed matrix
+Matrix createPackedMatrix(int rows, int cols, DataType data_type);
+
 // A print matrix prototype
 void printMatrix(Matrix mat);
 
@@ -66,6 +168,9 @@ void setMatrixElement(Matrix *mat, int row, int col, MatrixElement data);
 // Set row or column
 void setRowOrColumn(Matrix *mat, int index, RowOrCol roc, MatrixElement *elements, int numElements);
 
+// Set a row or column from an array of native int, double or char values, matching the matrix's data type
+MatrixStatus setRowOrColumnValues(Matrix *mat, RowOrCol roc, int index, const void *values, int numValues);
+
 // Create a matrix from a subset of a larger matrix
 Matrix createMatrixSubset(Matrix original, int startRow, int endRow, int startCol, int endCol);
 
@@ -78,9 +183,147 @@ void setMatrixSubset(Matrix *sourceMat, Matrix *destMat, int startRow, int start
 // Get matrix element
 MatrixElement getMatrixElement(Matrix mat, int row, int col);
 
+// Typed element getters, for either storage type
+int getIntElement(const Matrix *mat, int row, int col);
+double getDoubleElement(const Matrix *mat, int row, int col);
+char getCharElement(const Matrix *mat, int row, int col);
+
+// Typed element setters, for either storage type
+void setIntElement(Matrix *mat, int row, int col, int value);
+void setDoubleElement(Matrix *mat, int row, int col, double value);
+void setCharElement(Matrix *mat, int row, int col, char value);
+
+// Raw value buffers of packed matrices
+int *getIntBuffer(const Matrix *mat);
+double *getDoubleBuffer(const Matrix *mat);
+char *getCharBuffer(const Matrix *mat);
+
+// MARK - Inline element access
+// These compile into the caller's loop, so reading or writing a cell is an index calculation and a load or store,
+// for either storage order and storage type. The plain ones check nothing: the matrix (or view) must hold the type
+// asked for and (row, col) must be inside it. The Checked ones check both, and report the first bad access and
+// stop the program, so use them while a loop is being written and the plain ones once it is right.
+// For loops the compiler can vectorize, copy the Matrix or MatrixView into a local variable first. Otherwise a
+// store through an int or char pointer might change its rows or cols, and they are read again every time.
+// Loops over ints and chars also need -O3, which splits them by storage type.
+
+// Report a bad inline access and stop the program
+void matrixAccessFailed(const char *message);
+
+// Index of the cell at (row, col) of a matrix, counted in stored elements from the start of its block
+static inline size_t matrixCellIndex(const Matrix *mat, int row, int col) {
+    return (mat->order == ROW_MAJOR) ? (size_t)row * mat->cols + col : (size_t)col * mat->rows + row;
+}
+
+// Index of the cell at (row, col) of a view, counted in stored elements from the start of its matrix's block
+static inline size_t viewCellIndex(const MatrixView *view, int row, int col) {
+    return view->offset + ((view->order == ROW_MAJOR) ? (size_t)row * view->ld + col : (size_t)col * view->ld + row);
+}
+
+// Address of the int or char stored at an index of a block. Every member of a MatrixElement starts at its address,
+// and a double is as big as the whole union, so only ints and chars depend on the storage type. Written as a choice
+// between two addresses, the compiler can split a loop into one copy for each storage type and vectorize both.
+static inline int *intCellAddress(void *block, StorageType storage, size_t index) {
+    return (storage == PACKED_STORAGE) ? (int *)block + index : &((MatrixElement *)block)[index].int_val;
+}
+static inline char *charCellAddress(void *block, StorageType storage, size_t index) {
+    return (storage == PACKED_STORAGE) ? (char *)block + index : &((MatrixElement *)block)[index].char_val;
+}
+
+// The cell at (row, col) of an INT, DOUBLE or CHAR matrix, unchecked
+static inline int *intElementAt(const Matrix *mat, int row, int col) {
+    return intCellAddress(mat->block, mat->storage, matrixCellIndex(mat, row, col));
+}
+static inline double *doubleElementAt(const Matrix *mat, int row, int col) {
+    return (double *)mat->block + matrixCellIndex(mat, row, col);
+}
+static inline char *charElementAt(const Matrix *mat, int row, int col) {
+    return charCellAddress(mat->block, mat->storage, matrixCellIndex(mat, row, col));
+}
+
+// The cell at (row, col) of an INT, DOUBLE or CHAR view, unchecked
+static inline int *viewIntElementAt(const MatrixView *view, int row, int col) {
+    return intCellAddress(view->block, view->storage, viewCellIndex(view, row, col));
+}
+static inline double *viewDoubleElementAt(const MatrixView *view, int row, int col) {
+    return (double *)view->block + viewCellIndex(view, row, col);
+}
+static inline char *viewCharElementAt(const MatrixView *view, int row, int col) {
+    return charCellAddress(view->block, view->storage, viewCellIndex(view, row, col));
+}
+
+// Check an inline access to a matrix or view of 'rows' x 'cols' cells of 'data_type', and stop the program if it
+// is out of bounds or of the wrong type
+static inline void checkElementAccess(const void *block, int rows, int cols, DataType data_type, DataType wanted,
+                                      int row, int col) {
+    if (block == NULL) {
+        matrixAccessFailed("Null matrix or data.");
+    }
+    if (data_type != wanted) {
+        matrixAccessFailed("Data type does not match the accessor.");
+    }
+    if (row < 0 || row >= rows || col < 0 || col >= cols) {
+        matrixAccessFailed("Index out of bounds");
+    }
+}
+
+// The cell at (row, col) of an INT, DOUBLE or CHAR matrix, checked
+static inline int *intElementAtChecked(const Matrix *mat, int row, int col) {
+    checkElementAccess(mat->block, mat->rows, mat->cols, mat->data_type, INT, row, col);
+    return intElementAt(mat, row, col);
+}
+static inline double *doubleElementAtChecked(const Matrix *mat, int row, int col) {
+    checkElementAccess(mat->block, mat->rows, mat->cols, mat->data_type, DOUBLE, row, col);
+    return doubleElementAt(mat, row, col);
+}
+static inline char *charElementAtChecked(const Matrix *mat, int row, int col) {
+    checkElementAccess(mat->block, mat->rows, mat->cols, mat->data_type, CHAR, row, col);
+    return charElementAt(mat, row, col);
+}
+
+// The cell at (row, col) of an INT, DOUBLE or CHAR view, checked
+static inline int *viewIntElementAtChecked(const MatrixView *view, int row, int col) {
+    checkElementAccess(view->block, view->rows, view->cols, view->data_type, INT, row, col);
+    return viewIntElementAt(view, row, col);
+}
+static inline double *viewDoubleElementAtChecked(const MatrixView *view, int row, int col) {
+    checkElementAccess(view->block, view->rows, view->cols, view->data_type, DOUBLE, row, col);
+    return viewDoubleElementAt(view, row, col);
+}
+static inline char *viewCharElementAtChecked(const MatrixView *view, int row, int col) {
+    checkElementAccess(view->block, view->rows, view->cols, view->data_type, CHAR, row, col);
+    return viewCharElementAt(view, row, col);
+}
+
+// Create a view of a whole matrix
+MatrixView viewMatrix(const Matrix *mat);
+
+// Create a view of part of a matrix, without copying
+MatrixView createMatrixView(const Matrix *original, int startRow, int endRow, int startCol, int endCol);
+
+// Create a view of part of a view, without copying
+MatrixView createSubView(const MatrixView *view, int startRow, int endRow, int startCol, int endCol);
+
+// View a view transposed, without moving anything
+MatrixView transposeMatrixView(const MatrixView *view);
+
+// Get view element
+MatrixElement getViewElement(const MatrixView *view, int row, int col);
+
+// Copy a view into a new matrix
+Matrix copyMatrixView(const MatrixView *view);
+
+// Print a view
+void printMatrixView(const MatrixView *view);
+
 // Get row or column
 MatrixElement* getRowOrColumn(Matrix *mat, RowOrCol roc, int index);
 
+// Get a row or column into an array the caller provides, without allocating.
+// getRowOrColumnValues fills an array of native int, double or char values, matching the matrix's data type.
+MatrixStatus getRowOrColumnInto(const Matrix *mat, RowOrCol roc, int index, MatrixElement *elements, int numElements);
+MatrixStatus getRowOrColumnValues(const Matrix *mat, RowOrCol roc, int index, void *values, int numValues);
+
 // Add matricies
 Matrix addMatrices(const Matrix *mat1, const Matrix *mat2);
 
@@ -90,16 +333,86 @@ Matrix subtractMatrices(const Matrix *mat1, const Matrix *mat2);
 // Multiply Matricies
 Matrix multiplyMatrices(const Matrix *mat1, const Matrix *mat2);
 
+// Add, subtract and multiply views
+Matrix addMatrixViews(const MatrixView *view1, const MatrixView *view2);
+Matrix subtractMatrixViews(const MatrixView *view1, const MatrixView *view2);
+Matrix multiplyMatrixViews(const MatrixView *view1, const MatrixView *view2);
+
 // Create a deep copy of a matrix
 Matrix deepCopyMatrix(const Matrix *source);
 
+// Add, subtract, multiply and copy into a matrix that already exists, without allocating a result
+// The destination must already have the result's dimensions and data type. It can be an operand of an add
+// or subtract (to work in place), but not of a multiply.
+MatrixStatus addMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2);
+MatrixStatus subtractMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2);
+MatrixStatus multiplyMatricesInto(Matrix *dest, const Matrix *mat1, const Matrix *mat2);
+MatrixStatus copyMatrixInto(Matrix *dest, const Matrix *source);
+
+// General multiply, dest = alpha * op(mat1) * op(mat2) + beta * dest, where op() optionally transposes its operand
+// without copying it. The destination can't be either operand, and a beta of 0 ignores what it held.
+MatrixStatus gemmMatrices(Transpose transpose1, Transpose transpose2, double alpha, const Matrix *mat1,
+                          const Matrix *mat2, double beta, Matrix *dest);
+MatrixStatus gemmMatrixViews(Transpose transpose1, Transpose transpose2, double alpha, const MatrixView *view1,
+                             const MatrixView *view2, double beta, const MatrixView *dest);
+
 // Check matrix same-ness
 Sameness checkMatrixSameness(const Matrix *mat1, const Matrix *mat2);
 
+// Check view same-ness
+Sameness checkViewSameness(const MatrixView *view1, const MatrixView *view2);
+
 // Rotate matrix
 RotationStatus rotateMatrix(Matrix *mat);
 
+// Rotate a matrix in place, clockwise. Quarter turns need a square matrix, a half turn works on any shape.
+RotationStatus rotateMatrixBy(Matrix *mat, Rotation rotation);
+
+// Create a transposed or rotated copy of a matrix of any shape, stored the same way
+Matrix createTransposedMatrix(const Matrix *mat);
+Matrix createRotatedMatrix(const Matrix *mat, Rotation rotation);
+
+// Transpose or rotate a view into a destination view that doesn't share its matrix
+MatrixStatus transposeViewInto(const MatrixView *dest, const MatrixView *source);
+MatrixStatus rotateViewInto(const MatrixView *dest, const MatrixView *source, Rotation rotation);
+
+// Change the storage order of a matrix
+void convertMatrixOrder(Matrix *mat, StorageOrder order);
+
+// Choose the instruction set the arithmetic kernels use
+int setInstructionSet(InstructionSet isa);
+
+// Get the instruction set the arithmetic kernels are using
+InstructionSet getInstructionSet(void);
+
+// Set how many threads the library may use
+void setThreadCount(int threads);
+
+// Get how many threads the library may use
+int getThreadCount(void);
+
+// Install the allocator new matrices on this thread come from, or NULL for the system allocator
+void setMatrixAllocator(const MatrixAllocator *allocator);
+
+// Get the allocator new matrices on this thread come from
+MatrixAllocator getMatrixAllocator(void);
+
+// Create, reset and free an arena, and get an allocator for it
+MatrixArena *createMatrixArena(size_t chunkSize);
+MatrixAllocator matrixArenaAllocator(MatrixArena *arena);
+void resetMatrixArena(MatrixArena *arena);
+void freeMatrixArena(MatrixArena *arena);
+
+// Create and free a pool, and get an allocator for it
+MatrixPool *createMatrixPool(size_t maxCachedBytes);
+MatrixAllocator matrixPoolAllocator(MatrixPool *pool);
+void freeMatrixPool(MatrixPool *pool);
+
 // Free the memory from a matrix
 void freeMatrix(Matrix *mat);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,329 @@
+#ifndef MATRIX_HPP
+#define MATRIX_HPP
+
+// A typed C++ face on the matrix library, header only. Needs C++11 and links against libmatrix.a like C does.
+// matrix::Matrix<T, Layout> owns a packed matrix of T (int, double or char) laid out by Layout (RowMajor or
+// ColumnMajor). Both are template parameters, so reading or writing an element is one inline index calculation
+// on a typed pointer, with no DataType switch and no descriptor copied by value. Whole matrix operations call
+// straight into the C library, which picks its SIMD kernels and threads once per call, not once per element.
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include "matrix.h"
+
+namespace matrix {
+
+// The DataType each element type is stored as
+template <typename T> struct ElementType;
+template <> struct ElementType<int> { static const DataType value = INT; };
+template <> struct ElementType<double> { static const DataType value = DOUBLE; };
+template <> struct ElementType<char> { static const DataType value = CHAR; };
+template <typename T> struct ElementType<const T> : ElementType<T> {};
+
+// Layouts, which say how (row, col) maps to an offset along lines 'ld' values apart
+struct RowMajor {
+    static const StorageOrder order = ROW_MAJOR;
+    static std::size_t index(int row, int col, std::size_t ld) { return (std::size_t)row * ld + col; }
+    static int lines(int rows, int) { return rows; }
+    static int lineLength(int, int cols) { return cols; }
+};
+
+struct ColumnMajor {
+    static const StorageOrder order = COLUMN_MAJOR;
+    static std::size_t index(int row, int col, std::size_t ld) { return (std::size_t)col * ld + row; }
+    static int lines(int, int cols) { return cols; }
+    static int lineLength(int rows, int) { return rows; }
+};
+
+// The layout of the same memory with rows and columns swapped
+template <typename Layout> struct Transposed;
+template <> struct Transposed<RowMajor> { typedef ColumnMajor type; };
+template <> struct Transposed<ColumnMajor> { typedef RowMajor type; };
+
+// Thrown when the C library refuses an operation, carrying the status it returned
+class Error : public std::runtime_error {
+public:
+    Error(MatrixStatus status, const char *what) : std::runtime_error(what), status_(status) {}
+    MatrixStatus status() const { return status_; }
+
+private:
+    MatrixStatus status_;
+};
+
+// Throw an Error for anything but MATRIX_SUCCESS
+inline void check(MatrixStatus status, const char *what) {
+    if (status != MATRIX_SUCCESS) {
+        throw Error(status, what);
+    }
+}
+
+// A non-owning window onto a rectangle of a packed matrix. It's three ints and two words, so pass it by value.
+// Use View<const T, Layout> for one that can only be read. Like a C MatrixView, it's only good for as long as
+// the matrix it looks at is alive and hasn't been resized.
+template <typename T, typename Layout = RowMajor>
+class View {
+public:
+    typedef T value_type;
+    typedef Layout layout;
+
+    View() : block_(NULL), offset_(0), rows_(0), cols_(0), ld_(1) {}
+    View(T *block, std::size_t offset, int rows, int cols, std::size_t ld)
+        : block_(block), offset_(offset), rows_(rows), cols_(cols), ld_(ld) {}
+
+    // A read only view of a writable one
+    template <typename U>
+    View(const View<U, Layout> &other)
+        : block_(other.block()), offset_(other.offset()), rows_(other.rows()), cols_(other.cols()), ld_(other.ld()) {}
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    std::size_t ld() const { return ld_; }
+    std::size_t offset() const { return offset_; }
+    T *block() const { return block_; }
+    T *data() const { return block_ + offset_; }
+    bool empty() const { return block_ == NULL; }
+
+    // The element at (row, col). Checked only when built with ENABLE_BOUNDS_CHECK, like the C accessors.
+    T &operator()(int row, int col) const {
+#ifdef ENABLE_BOUNDS_CHECK
+        if (row < 0 || row >= rows_ || col < 0 || col >= cols_) {
+            throw std::out_of_range("Index out of bounds");
+        }
+#endif
+        return block_[offset_ + Layout::index(row, col, ld_)];
+    }
+
+    // A view of part of this one, with inclusive ends like createSubView
+    View sub(int startRow, int endRow, int startCol, int endCol) const {
+        if (startRow < 0 || endRow >= rows_ || startRow > endRow || startCol < 0 || endCol >= cols_ ||
+            startCol > endCol) {
+            throw std::out_of_range("Index out of bounds or invalid range");
+        }
+        return View(block_, offset_ + Layout::index(startRow, startCol, ld_), endRow - startRow + 1,
+                    endCol - startCol + 1, ld_);
+    }
+
+    // The same memory with rows and columns swapped, without moving anything
+    View<T, typename Transposed<Layout>::type> transposed() const {
+        return View<T, typename Transposed<Layout>::type>(block_, offset_, cols_, rows_, ld_);
+    }
+
+    // The C view of the same cells, for passing to the rest of the library
+    MatrixView c() const {
+        MatrixView view;
+        view.rows = rows_;
+        view.cols = cols_;
+        view.data_type = ElementType<T>::value;
+        view.storage = PACKED_STORAGE;
+        view.order = Layout::order;
+        view.block = const_cast<void *>(static_cast<const void *>(block_));
+        view.offset = offset_;
+        view.ld = (int)ld_;
+        return view;
+    }
+
+private:
+    T *block_;
+    std::size_t offset_;
+    int rows_;
+    int cols_;
+    std::size_t ld_;
+};
+
+// An owning packed matrix of T laid out by Layout. It can be moved but not copied (use clone() for a deep copy),
+// and frees its block when it goes out of scope. A default constructed or moved from matrix is empty.
+template <typename T, typename Layout = RowMajor>
+class Matrix {
+public:
+    typedef T value_type;
+    typedef Layout layout;
+    typedef View<T, Layout> view_type;
+    typedef View<const T, Layout> const_view_type;
+
+    Matrix() : mat_(emptyMatrix()) {}
+
+    // A zero filled matrix, from the allocator installed on this thread. Throws std::invalid_argument for empty
+    // dimensions. Like createMatrix, running out of memory ends the program.
+    Matrix(int rows, int cols) : mat_(emptyMatrix()) {
+        if (rows <= 0 || cols <= 0) {
+            throw std::invalid_argument("Matrix dimensions must be positive");
+        }
+        mat_ = createMatrixWithLayout(rows, cols, ElementType<T>::value, Layout::order, PACKED_STORAGE);
+    }
+
+    // Take ownership of a C matrix, which must be packed, hold T and be laid out by Layout
+    static Matrix adopt(::Matrix mat) {
+        if (mat.block == NULL) {
+            throw Error(MATRIX_ERROR_NULL_POINTER, "Matrix is invalid");
+        }
+        if (mat.storage != PACKED_STORAGE || mat.data_type != ElementType<T>::value || mat.order != Layout::order) {
+            freeMatrix(&mat);
+            throw Error(MATRIX_ERROR_TYPE_MISMATCH, "Matrix isn't stored the way this type expects");
+        }
+        Matrix result;
+        result.mat_ = mat;
+        return result;
+    }
+
+    // Moves never throw, so standard containers move matrices instead of trying to copy them
+    Matrix(Matrix &&other) noexcept : mat_(other.mat_) { other.mat_ = emptyMatrix(); }
+
+    Matrix &operator=(Matrix &&other) noexcept {
+        if (this != &other) {
+            release();
+            mat_ = other.mat_;
+            other.mat_ = emptyMatrix();
+        }
+        return *this;
+    }
+
+    Matrix(const Matrix &) = delete;
+    Matrix &operator=(const Matrix &) = delete;
+
+    ~Matrix() { release(); }
+
+    // A deep copy, through deepCopyMatrix
+    Matrix clone() const {
+        if (empty()) {
+            return Matrix();
+        }
+        return adopt(deepCopyMatrix(&mat_));
+    }
+
+    int rows() const { return mat_.rows; }
+    int cols() const { return mat_.cols; }
+    bool empty() const { return mat_.block == NULL; }
+
+    // The values in storage order, with lines Layout::lineLength(rows, cols) long
+    T *data() { return static_cast<T *>(mat_.block); }
+    const T *data() const { return static_cast<const T *>(mat_.block); }
+
+    // The element at (row, col). Checked only when built with ENABLE_BOUNDS_CHECK, like the C accessors.
+    T &operator()(int row, int col) {
+        checkIndex(row, col);
+        return data()[Layout::index(row, col, ld())];
+    }
+    const T &operator()(int row, int col) const {
+        checkIndex(row, col);
+        return data()[Layout::index(row, col, ld())];
+    }
+
+    // Views of all or part (inclusive ends) of the matrix
+    view_type view() { return view_type(data(), 0, rows(), cols(), ld()); }
+    const_view_type view() const { return const_view_type(data(), 0, rows(), cols(), ld()); }
+    view_type view(int startRow, int endRow, int startCol, int endCol) {
+        return view().sub(startRow, endRow, startCol, endCol);
+    }
+    const_view_type view(int startRow, int endRow, int startCol, int endCol) const {
+        return view().sub(startRow, endRow, startCol, endCol);
+    }
+
+    // The C matrix underneath, for passing to the rest of the library. It stays owned by this object.
+    ::Matrix *c() { return &mat_; }
+    const ::Matrix *c() const { return &mat_; }
+
+    // Give up ownership of the C matrix, leaving this one empty. The caller frees it with freeMatrix.
+    ::Matrix release_c() {
+        ::Matrix mat = mat_;
+        mat_ = emptyMatrix();
+        return mat;
+    }
+
+private:
+    ::Matrix mat_;
+
+    static ::Matrix emptyMatrix() {
+        ::Matrix mat;
+        mat.rows = 0;
+        mat.cols = 0;
+        mat.data_type = ElementType<T>::value;
+        mat.data = NULL;
+        mat.block = NULL;
+        mat.storage = PACKED_STORAGE;
+        mat.order = Layout::order;
+        return mat;
+    }
+
+    std::size_t ld() const { return (std::size_t)Layout::lineLength(mat_.rows, mat_.cols); }
+
+    void checkIndex(int row, int col) const {
+#ifdef ENABLE_BOUNDS_CHECK
+        if (row < 0 || row >= mat_.rows || col < 0 || col >= mat_.cols) {
+            throw std::out_of_range("Index out of bounds");
+        }
+#else
+        (void)row;
+        (void)col;
+#endif
+    }
+
+    void release() {
+        if (mat_.block != NULL) {
+            freeMatrix(&mat_);
+        }
+        mat_ = emptyMatrix();
+    }
+};
+
+// Arithmetic into an existing destination, which must already have the result's dimensions.
+// Add and subtract may work in place; multiply needs a destination separate from both operands.
+template <typename T, typename L1, typename L2, typename L3>
+void addInto(Matrix<T, L1> &dest, const Matrix<T, L2> &a, const Matrix<T, L3> &b) {
+    check(addMatricesInto(dest.c(), a.c(), b.c()), "Matrices can't be added");
+}
+
+template <typename T, typename L1, typename L2, typename L3>
+void subtractInto(Matrix<T, L1> &dest, const Matrix<T, L2> &a, const Matrix<T, L3> &b) {
+    check(subtractMatricesInto(dest.c(), a.c(), b.c()), "Matrices can't be subtracted");
+}
+
+template <typename T, typename L1, typename L2, typename L3>
+void multiplyInto(Matrix<T, L1> &dest, const Matrix<T, L2> &a, const Matrix<T, L3> &b) {
+    check(multiplyMatricesInto(dest.c(), a.c(), b.c()), "Matrices can't be multiplied");
+}
+
+// Copy a view into another of the same size, whatever either's layout. They can't share a matrix.
+template <typename T, typename L1, typename U, typename L2>
+void copyInto(const View<T, L1> &dest, const View<U, L2> &source) {
+    MatrixView to = dest.c();
+    MatrixView from = source.transposed().c();
+    check(transposeViewInto(&to, &from), "View can't be copied");
+}
+
+// Arithmetic into a new matrix laid out like the left operand
+template <typename T, typename L1, typename L2>
+Matrix<T, L1> operator+(const Matrix<T, L1> &a, const Matrix<T, L2> &b) {
+    Matrix<T, L1> result(a.rows(), a.cols());
+    addInto(result, a, b);
+    return result;
+}
+
+template <typename T, typename L1, typename L2>
+Matrix<T, L1> operator-(const Matrix<T, L1> &a, const Matrix<T, L2> &b) {
+    Matrix<T, L1> result(a.rows(), a.cols());
+    subtractInto(result, a, b);
+    return result;
+}
+
+template <typename T, typename L1, typename L2>
+Matrix<T, L1> operator*(const Matrix<T, L1> &a, const Matrix<T, L2> &b) {
+    Matrix<T, L1> result(a.rows(), b.cols());
+    multiplyInto(result, a, b);
+    return result;
+}
+
+// Compare two matrices value by value, whatever their layouts
+template <typename T, typename L1, typename L2>
+bool operator==(const Matrix<T, L1> &a, const Matrix<T, L2> &b) {
+    return checkMatrixSameness(a.c(), b.c()) != NEITHER;
+}
+
+template <typename T, typename L1, typename L2>
+bool operator!=(const Matrix<T, L1> &a, const Matrix<T, L2> &b) {
+    return !(a == b);
+}
+
+} // namespace matrix
+
+#endif
@@ -0,0 +1,424 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_internal.h"
+
+// MARK - Aligned blocks
+// Every matrix block and scratch buffer is aligned to MATRIX_ALIGNMENT. A small header sits right in front of
+// the aligned address, recording the pointer the memory really starts at and which allocator it came from,
+// so alignedFree can hand it back to the right place whatever allocator is installed by then.
+
+// The allocator each thread creates matrices with. GCC and Clang give every thread its own,
+// anywhere else one allocator is shared by the whole program.
+#if defined(__GNUC__) || defined(__clang__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL
+#endif
+
+// No allocate function means the system allocator
+static THREAD_LOCAL MatrixAllocator threadAllocator = {NULL, NULL, NULL};
+
+// Kept in front of every aligned block
+typedef struct {
+    void *raw;
+    MatrixAllocator allocator;
+    size_t size;
+} BlockHeader;
+
+// Allocate a zero-filled aligned block from an allocator
+// Returns NULL if the allocation failed
+static void *allocatorCalloc(const MatrixAllocator *allocator, size_t size) {
+    if (size > SIZE_MAX - MATRIX_ALIGNMENT - sizeof(BlockHeader)) {
+        return NULL;
+    }
+    size_t total = size + MATRIX_ALIGNMENT + sizeof(BlockHeader);
+    void *raw = (allocator->allocate != NULL) ? allocator->allocate(allocator->context, total) : malloc(total);
+    if (raw == NULL) {
+        return NULL;
+    }
+
+    // Leave room for the header, then round up to the next aligned address
+    uintptr_t start = (uintptr_t)raw + sizeof(BlockHeader);
+    uintptr_t aligned = (start + MATRIX_ALIGNMENT - 1) & ~(uintptr_t)(MATRIX_ALIGNMENT - 1);
+    BlockHeader *header = (BlockHeader *)aligned - 1;
+    header->raw = raw;
+    header->allocator = *allocator;
+    header->size = total;
+
+    // Memory from a pool or arena may have been used before, so it is always cleared
+    memset((void *)aligned, 0, size);
+    return (void *)aligned;
+}
+
+// Allocate a zero-filled block of scratch memory aligned to MATRIX_ALIGNMENT, straight from the system
+// Returns NULL if the allocation failed
+void *alignedCalloc(size_t size) {
+    MatrixAllocator system = {NULL, NULL, NULL};
+    return allocatorCalloc(&system, size);
+}
+
+// Allocate a zero-filled matrix block aligned to MATRIX_ALIGNMENT, from this thread's allocator
+// Returns NULL if the allocation failed
+void *matrixBlockCalloc(size_t size) {
+    return allocatorCalloc(&threadAllocator, size);
+}
+
+// Free a block from alignedCalloc or matrixBlockCalloc, giving it back to the allocator it came from
+void alignedFree(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    BlockHeader *header = (BlockHeader *)ptr - 1;
+    if (header->allocator.allocate == NULL) {
+        free(header->raw);
+    } else if (header->allocator.release != NULL) {
+        header->allocator.release(header->allocator.context, header->raw, header->size);
+    }
+}
+
+// Install the allocator new matrices on this thread are created with
+// Accepts an allocator, which is copied, or NULL to go back to the system allocator
+// Does not return
+void setMatrixAllocator(const MatrixAllocator *allocator) {
+    if (allocator == NULL || allocator->allocate == NULL) {
+        MatrixAllocator system = {NULL, NULL, NULL};
+        threadAllocator = system;
+    } else {
+        threadAllocator = *allocator;
+    }
+}
+
+// Get the allocator new matrices on this thread are created with
+// Accepts nothing
+// Returns a copy of the installed allocator, which has no allocate function for the system allocator
+MatrixAllocator getMatrixAllocator(void) {
+    return threadAllocator;
+}
+
+// MARK - Shards
+// Arenas and pools are split into shards, each with its own lock and memory, and every thread works in a shard of
+// its own. Threads are handed shards in turn the first time they allocate, so threads sharing one arena or pool only
+// meet on a lock when there are more of them than shards, or while an arena is being reset.
+// Without thread local variables every thread works in the first shard.
+
+#define ALLOC_SHARDS 16
+
+// Padding after each shard, which keeps the locks of neighbouring shards off the same cache line
+#define SHARD_PADDING 64
+
+// Find the shard the calling thread works in
+static int threadShard(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    static unsigned int nextShard = 0;
+    static THREAD_LOCAL int shard = -1;
+    if (shard < 0) {
+        shard = (int)(__sync_fetch_and_add(&nextShard, 1u) % ALLOC_SHARDS);
+    }
+    return shard;
+#else
+    return 0;
+#endif
+}
+
+// Add to a byte count shared by every shard, returning the new count. Without atomics there is only one shard
+// working, and its lock is held around every change.
+static size_t addSharedBytes(size_t *count, size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __sync_add_and_fetch(count, bytes);
+#else
+    *count += bytes;
+    return *count;
+#endif
+}
+
+// Take from a byte count shared by every shard, returning the new count
+static size_t subtractSharedBytes(size_t *count, size_t bytes) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __sync_sub_and_fetch(count, bytes);
+#else
+    *count -= bytes;
+    return *count;
+#endif
+}
+
+// MARK - Arena
+// An arena hands out memory by bumping an offset through big chunks, and never frees anything on its own.
+// Everything it handed out goes at once when it is reset. After a reset the chunks are merged into one,
+// so a workload that needs the same memory every time stops allocating after its first round.
+
+// Allocations are rounded to this, which keeps every block header naturally aligned
+#define ARENA_GRANULE 16
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t capacity;
+    size_t used;
+} ArenaChunk;
+
+typedef struct {
+    pthread_mutex_t lock;
+    ArenaChunk *chunks;
+    char padding[SHARD_PADDING];
+} ArenaShard;
+
+struct MatrixArena {
+    size_t chunkSize;
+    ArenaShard shards[ALLOC_SHARDS];
+};
+
+// The memory of a chunk starts right after it, rounded up to the granule
+static char *chunkMemory(ArenaChunk *chunk) {
+    size_t offset = (sizeof(ArenaChunk) + ARENA_GRANULE - 1) & ~(size_t)(ARENA_GRANULE - 1);
+    return (char *)chunk + offset;
+}
+
+// Start a new chunk of at least 'capacity' bytes in front of the others in a shard
+// Returns the chunk, or NULL if it couldn't be allocated
+static ArenaChunk *pushChunk(ArenaShard *shard, size_t capacity) {
+    ArenaChunk *chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) + ARENA_GRANULE + capacity);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next = shard->chunks;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    shard->chunks = chunk;
+    return chunk;
+}
+
+// Bump allocate from the calling thread's shard of an arena
+static void *arenaAllocate(void *context, size_t size) {
+    MatrixArena *arena = (MatrixArena *)context;
+    ArenaShard *shard = &arena->shards[threadShard()];
+    size = (size + ARENA_GRANULE - 1) & ~(size_t)(ARENA_GRANULE - 1);
+    pthread_mutex_lock(&shard->lock);
+    ArenaChunk *chunk = shard->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        chunk = pushChunk(shard, (size > arena->chunkSize) ? size : arena->chunkSize);
+    }
+    void *ptr = NULL;
+    if (chunk != NULL) {
+        ptr = chunkMemory(chunk) + chunk->used;
+        chunk->used += size;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return ptr;
+}
+
+// Memory goes back to an arena all at once, in resetMatrixArena
+static void arenaRelease(void *context, void *ptr, size_t size) {
+    (void)context;
+    (void)ptr;
+    (void)size;
+}
+
+// Create an arena
+// Accepts the size of the chunks it takes from the system, in bytes (0 picks 1MB)
+// Returns the arena, or NULL if it couldn't be allocated
+MatrixArena *createMatrixArena(size_t chunkSize) {
+    MatrixArena *arena = (MatrixArena *)malloc(sizeof(MatrixArena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        pthread_mutex_init(&arena->shards[i].lock, NULL);
+        arena->shards[i].chunks = NULL;
+    }
+    arena->chunkSize = (chunkSize > 0) ? chunkSize : ((size_t)1 << 20);
+    return arena;
+}
+
+// Get an allocator that creates matrices in an arena, for setMatrixAllocator
+// Accepts an arena
+// Returns the allocator
+MatrixAllocator matrixArenaAllocator(MatrixArena *arena) {
+    MatrixAllocator allocator = {arenaAllocate, arenaRelease, arena};
+    return allocator;
+}
+
+// Release every matrix created in an arena at once. None of them may be used (or freed) afterwards.
+// Accepts an arena
+// Does not return
+void resetMatrixArena(MatrixArena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        ArenaShard *shard = &arena->shards[i];
+        pthread_mutex_lock(&shard->lock);
+
+        // One chunk is simply rewound. Several are swapped for a single chunk as big as all of them together.
+        if (shard->chunks != NULL && shard->chunks->next != NULL) {
+            size_t total = 0;
+            while (shard->chunks != NULL) {
+                ArenaChunk *next = shard->chunks->next;
+                total += shard->chunks->capacity;
+                free(shard->chunks);
+                shard->chunks = next;
+            }
+            pushChunk(shard, total);
+        } else if (shard->chunks != NULL) {
+            shard->chunks->used = 0;
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
+
+// Free an arena and every matrix created in it
+// Accepts an arena
+// Does not return
+void freeMatrixArena(MatrixArena *arena) {
+    if (arena == NULL) {
+        return;
+    }
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        ArenaShard *shard = &arena->shards[i];
+        while (shard->chunks != NULL) {
+            ArenaChunk *next = shard->chunks->next;
+            free(shard->chunks);
+            shard->chunks = next;
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+    free(arena);
+}
+
+// MARK - Pool
+// A pool keeps freed blocks on one free list per size class and hands them out again to the next request of
+// the same class. Classes go up in quarters of a power of two, so a block is at most 25% bigger than asked
+// for, and blocks for same-shaped matrices always come back to the same list. A block freed on one thread goes on
+// that thread's lists, ready for the next matrix it creates.
+
+// Every size up to 2^POOL_MAX_BITS has a class, and bigger requests skip the pool entirely
+#define POOL_MIN_BITS 6
+#define POOL_MAX_BITS 40
+#define POOL_CLASSES ((POOL_MAX_BITS - POOL_MIN_BITS) * 4 + 1)
+
+typedef struct {
+    pthread_mutex_t lock;
+    void *freeLists[POOL_CLASSES];
+    char padding[SHARD_PADDING];
+} PoolShard;
+
+// The cap covers the free blocks of every shard together, so 'cachedBytes' is only kept when there is a cap
+struct MatrixPool {
+    size_t cachedBytes;
+    size_t maxCachedBytes;
+    PoolShard shards[ALLOC_SHARDS];
+};
+
+// Find the size class of a request
+// Returns the class, or -1 for a request too big to pool, and sets the size of the class's blocks
+static int poolClass(size_t size, size_t *classSize) {
+    if (size <= ((size_t)1 << POOL_MIN_BITS)) {
+        *classSize = (size_t)1 << POOL_MIN_BITS;
+        return 0;
+    }
+
+    // size is in (2^bits, 2^(bits + 1)], which is split into four quarters
+    int bits = 0;
+    while (bits < POOL_MAX_BITS && ((size_t)1 << (bits + 1)) < size) {
+        bits++;
+    }
+    if (bits >= POOL_MAX_BITS) {
+        return -1;
+    }
+    size_t base = (size_t)1 << bits;
+    size_t quarter = base / 4;
+    size_t quarters = (size - base + quarter - 1) / quarter;
+    *classSize = base + quarters * quarter;
+    return (bits - POOL_MIN_BITS) * 4 + (int)quarters;
+}
+
+// Take a block from the calling thread's shard of a pool, or from the system if its class has none free
+static void *poolAllocate(void *context, size_t size) {
+    MatrixPool *pool = (MatrixPool *)context;
+    PoolShard *shard = &pool->shards[threadShard()];
+    size_t classSize = size;
+    int index = poolClass(size, &classSize);
+    if (index < 0) {
+        return malloc(size);
+    }
+
+    pthread_mutex_lock(&shard->lock);
+    void *block = shard->freeLists[index];
+    if (block != NULL) {
+        shard->freeLists[index] = *(void **)block;
+        if (pool->maxCachedBytes > 0) {
+            subtractSharedBytes(&pool->cachedBytes, classSize);
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return (block != NULL) ? block : malloc(classSize);
+}
+
+// Put a block back on a free list of the calling thread's shard, or give it back to the system if the pool is full
+static void poolRelease(void *context, void *ptr, size_t size) {
+    MatrixPool *pool = (MatrixPool *)context;
+    PoolShard *shard = &pool->shards[threadShard()];
+    size_t classSize = size;
+    int index = poolClass(size, &classSize);
+    if (index >= 0) {
+        pthread_mutex_lock(&shard->lock);
+        int keep = 1;
+        if (pool->maxCachedBytes > 0 && addSharedBytes(&pool->cachedBytes, classSize) > pool->maxCachedBytes) {
+            subtractSharedBytes(&pool->cachedBytes, classSize);
+            keep = 0;
+        }
+        if (keep) {
+            *(void **)ptr = shard->freeLists[index];
+            shard->freeLists[index] = ptr;
+        }
+        pthread_mutex_unlock(&shard->lock);
+        if (keep) {
+            return;
+        }
+    }
+    free(ptr);
+}
+
+// Create a pool
+// Accepts the most bytes of free blocks it keeps for reuse (0 for no limit)
+// Returns the pool, or NULL if it couldn't be allocated
+MatrixPool *createMatrixPool(size_t maxCachedBytes) {
+    MatrixPool *pool = (MatrixPool *)calloc(1, sizeof(MatrixPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        pthread_mutex_init(&pool->shards[i].lock, NULL);
+    }
+    pool->maxCachedBytes = maxCachedBytes;
+    return pool;
+}
+
+// Get an allocator that creates matrices from a pool, for setMatrixAllocator
+// Accepts a pool
+// Returns the allocator
+MatrixAllocator matrixPoolAllocator(MatrixPool *pool) {
+    MatrixAllocator allocator = {poolAllocate, poolRelease, pool};
+    return allocator;
+}
+
+// Free a pool and the blocks it is keeping. Every matrix created from it must have been freed first.
+// Accepts a pool
+// Does not return
+void freeMatrixPool(MatrixPool *pool) {
+    if (pool == NULL) {
+        return;
+    }
+    for (int i = 0; i < ALLOC_SHARDS; i++) {
+        PoolShard *shard = &pool->shards[i];
+        for (int c = 0; c < POOL_CLASSES; c++) {
+            while (shard->freeLists[c] != NULL) {
+                void *next = *(void **)shard->freeLists[c];
+                free(shard->freeLists[c]);
+                shard->freeLists[c] = next;
+            }
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+    free(pool);
+}
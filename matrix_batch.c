@@ -0,0 +1,432 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_batch.h"
+
+// MARK - Batches
+// A batch is checked once per call, not once per matrix, and then worked through with no allocation per matrix.
+// Adding and subtracting are one pass over the values (a single run when the batches have no gaps).
+// Small matrices are multiplied BATCH_LANES at a time: a group of them is interleaved so that the same cell of
+// every matrix sits side by side, and the batch multiply kernel then works on one matrix per SIMD lane, which
+// keeps the vectors full however small the matrices are. Matrices big enough for the blocked GEMM go to it one
+// at a time instead. Either way the work is shared between threads.
+
+// Size in bytes of a single batch value
+static size_t batchValueSize(DataType data_type) {
+    return (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+}
+
+// The batch returned in error states, which has no matrices or buffer
+static MatrixBatch invalidMatrixBatch(void) {
+    MatrixBatch batch = {0, 0, 0, INT, ROW_MAJOR, NULL, 1, 0};
+    return batch;
+}
+
+// Number of rows (row major) or columns (column major) in each matrix of a batch, and the length of each
+static int batchLines(const MatrixBatch *batch) {
+    return (batch->order == ROW_MAJOR) ? batch->rows : batch->cols;
+}
+
+static int batchLineLength(const MatrixBatch *batch) {
+    return (batch->order == ROW_MAJOR) ? batch->cols : batch->rows;
+}
+
+// Strides between neighbouring rows and columns of each matrix of a batch, in values
+static void batchStrides(const MatrixBatch *batch, size_t *rowStride, size_t *colStride) {
+    *rowStride = (batch->order == ROW_MAJOR) ? (size_t)batch->ld : 1;
+    *colStride = (batch->order == ROW_MAJOR) ? 1 : (size_t)batch->ld;
+}
+
+// Address of the value at (row, col) of matrix 'index' of a batch
+static char *batchValueAt(const MatrixBatch *batch, int index, int row, int col) {
+    size_t rowStride, colStride;
+    batchStrides(batch, &rowStride, &colStride);
+    size_t value = (size_t)index * batch->stride + (size_t)row * rowStride + (size_t)col * colStride;
+    return (char *)batch->values + value * batchValueSize(batch->data_type);
+}
+
+// Whether the matrices of a batch follow each other with no gaps, so the whole batch is one contiguous run
+static int batchIsContiguous(const MatrixBatch *batch) {
+    return batch->ld == batchLineLength(batch) && batch->stride == (size_t)batch->rows * batch->cols;
+}
+
+// Range of bytes a batch's values are spread over
+static void batchExtent(const MatrixBatch *batch, const char **first, const char **end) {
+    *first = (const char *)batch->values;
+    *end = batchValueAt(batch, batch->count - 1, batch->rows - 1, batch->cols - 1) + batchValueSize(batch->data_type);
+}
+
+// Whether two batches have any values in common
+static int batchesOverlap(const MatrixBatch *batch1, const MatrixBatch *batch2) {
+    const char *first1, *end1, *first2, *end2;
+    batchExtent(batch1, &first1, &end1);
+    batchExtent(batch2, &first2, &end2);
+    return first1 < end2 && first2 < end1;
+}
+
+// Whether two batches look at exactly the same values in exactly the same way
+static int sameBatchLayout(const MatrixBatch *batch1, const MatrixBatch *batch2) {
+    return batch1->values == batch2->values && batch1->order == batch2->order && batch1->ld == batch2->ld &&
+           batch1->stride == batch2->stride;
+}
+
+// Function to create a batch of matrices
+// Accepts how many matrices, their dimensions, data type (INT or DOUBLE) and storage order
+// Returns a batch of zero filled matrices packed one after the other, or an invalid batch on error
+MatrixBatch createMatrixBatch(int count, int rows, int cols, DataType data_type, StorageOrder order) {
+    if (count <= 0 || rows <= 0 || cols <= 0) {
+        printf("Error: Invalid matrix dimensions.\n");
+        return invalidMatrixBatch();
+    }
+    if (data_type != INT && data_type != DOUBLE) {
+        printf("Error: Batches only hold INT or DOUBLE values.\n");
+        return invalidMatrixBatch();
+    }
+    size_t size = batchValueSize(data_type);
+    if ((size_t)rows * cols > SIZE_MAX / size / (size_t)count) {
+        printf("Memory allocation failed for a batch of %d matrices\n", count);
+        return invalidMatrixBatch();
+    }
+
+    MatrixBatch batch;
+    batch.count = count;
+    batch.rows = rows;
+    batch.cols = cols;
+    batch.data_type = data_type;
+    batch.order = order;
+    batch.ld = (order == ROW_MAJOR) ? cols : rows;
+    batch.stride = (size_t)rows * cols;
+    batch.values = matrixBlockCalloc((size_t)count * batch.stride * size);
+    if (batch.values == NULL) {
+        printf("Memory allocation failed for a batch of %d matrices\n", count);
+        return invalidMatrixBatch();
+    }
+    return batch;
+}
+
+// Detect an invalid batch
+// Accepts a batch pointer
+// Returns 1 if the batch has matrices with rows, columns and values, 0 otherwise
+int isValidBatch(const MatrixBatch *batch) {
+    return batch != NULL && batch->values != NULL && batch->count > 0 && batch->rows > 0 && batch->cols > 0;
+}
+
+// Function to view one matrix of a batch
+// Accepts a batch pointer and the index of the matrix
+// Returns a view of it, which is empty if there is no such matrix
+MatrixView batchMatrixView(const MatrixBatch *batch, int index) {
+    MatrixView view;
+    view.rows = 0;
+    view.cols = 0;
+    view.data_type = (batch != NULL) ? batch->data_type : INT;
+    view.storage = PACKED_STORAGE;
+    view.order = (batch != NULL) ? batch->order : ROW_MAJOR;
+    view.block = NULL;
+    view.offset = 0;
+    view.ld = 1;
+    if (!isValidBatch(batch) || index < 0 || index >= batch->count) {
+        printf("Error: Index out of bounds\n");
+        return view;
+    }
+    view.rows = batch->rows;
+    view.cols = batch->cols;
+    view.block = batch->values;
+    view.offset = (size_t)index * batch->stride;
+    view.ld = batch->ld;
+    return view;
+}
+
+// Free a batch made by createMatrixBatch
+// Accepts a batch pointer
+// Does not return
+void freeMatrixBatch(MatrixBatch *batch) {
+    if (batch == NULL) {
+        return;
+    }
+    alignedFree(batch->values);
+    *batch = invalidMatrixBatch();
+}
+
+// Check the batches of an operation suit each other
+// Accepts the destination and operand batches, and whether the operation is a multiplication
+// Returns MATRIX_SUCCESS or the reason they don't
+static MatrixStatus checkBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2,
+                                 int multiply) {
+    if (!isValidBatch(dest) || !isValidBatch(batch1) || !isValidBatch(batch2)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (batch1->data_type != batch2->data_type || dest->data_type != batch1->data_type) {
+        printf("Error: Data types of matrices do not match.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    if (batch1->data_type != INT && batch1->data_type != DOUBLE) {
+        printf("Error: Batches only hold INT or DOUBLE values.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    if (batch1->count != batch2->count || dest->count != batch1->count) {
+        printf("Error: Batches hold different numbers of matrices.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (multiply) {
+        if (batch1->cols != batch2->rows) {
+            printf("Error: Matrix dimensions do not allow multiplication (cols of mat1 must equal rows of mat2).\n");
+            return MATRIX_ERROR_SIZE_MISMATCH;
+        }
+        if (dest->rows != batch1->rows || dest->cols != batch2->cols) {
+            printf("Error: Destination matrix dimensions do not match the result.\n");
+            return MATRIX_ERROR_SIZE_MISMATCH;
+        }
+        if (batchesOverlap(dest, batch1) || batchesOverlap(dest, batch2)) {
+            printf("Error: Destination matrix can't be an operand of a multiplication.\n");
+            return MATRIX_ERROR_ALIASING;
+        }
+        return MATRIX_SUCCESS;
+    }
+    if (batch1->rows != batch2->rows || batch1->cols != batch2->cols || dest->rows != batch1->rows ||
+        dest->cols != batch1->cols) {
+        printf("Error: Matrices dimensions do not match.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if ((batchesOverlap(dest, batch1) && !sameBatchLayout(dest, batch1)) ||
+        (batchesOverlap(dest, batch2) && !sameBatchLayout(dest, batch2))) {
+        printf("Error: Destination matrix shares its elements with an operand stored differently.\n");
+        return MATRIX_ERROR_ALIASING;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// MARK - Adding and subtracting
+
+// One batch addition or subtraction, shared between threads.
+// With 'singleRun' the items are values of one long run; otherwise each item is a line of a destination matrix.
+typedef struct {
+    const MatrixBatch *dest;
+    const MatrixBatch *batch1;
+    const MatrixBatch *batch2;
+    int subtract;
+    int singleRun;
+} BatchCombineJob;
+
+// Add or subtract 'count' values spaced 'step' apart for each of the three, one at a time
+static void combineStrided(DataType data_type, char *out, size_t outStep, const char *a, size_t aStep,
+                           const char *b, size_t bStep, size_t count, int subtract) {
+    if (data_type == DOUBLE) {
+        double *to = (double *)out;
+        const double *x = (const double *)a;
+        const double *y = (const double *)b;
+        for (size_t k = 0; k < count; k++) {
+            to[k * outStep] = subtract ? x[k * aStep] - y[k * bStep] : x[k * aStep] + y[k * bStep];
+        }
+    } else {
+        int *to = (int *)out;
+        const int *x = (const int *)a;
+        const int *y = (const int *)b;
+        for (size_t k = 0; k < count; k++) {
+            unsigned int left = (unsigned int)x[k * aStep];
+            unsigned int right = (unsigned int)y[k * bStep];
+            to[k * outStep] = (int)(subtract ? left - right : left + right);
+        }
+    }
+}
+
+// Add or subtract items 'start' up to 'end' of a job
+static void combineBatchRange(void *context, int task, size_t start, size_t end) {
+    const BatchCombineJob *job = (const BatchCombineJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    (void)task;
+    DataType data_type = job->dest->data_type;
+    size_t size = batchValueSize(data_type);
+    if (job->singleRun) {
+        char *out = (char *)job->dest->values + start * size;
+        const char *a = (const char *)job->batch1->values + start * size;
+        const char *b = (const char *)job->batch2->values + start * size;
+        if (data_type == DOUBLE) {
+            kernels->combineDoubles((double *)out, (const double *)a, (const double *)b, end - start, job->subtract);
+        } else {
+            kernels->combineInts((int *)out, (const int *)a, (const int *)b, end - start, 1, job->subtract);
+        }
+        return;
+    }
+
+    // Walk each destination line, and each operand along it with whatever stride its own order gives
+    int lines = batchLines(job->dest);
+    int length = batchLineLength(job->dest);
+    StorageOrder along = job->dest->order;
+    size_t step1 = (job->batch1->order == along) ? 1 : (size_t)job->batch1->ld;
+    size_t step2 = (job->batch2->order == along) ? 1 : (size_t)job->batch2->ld;
+    for (size_t item = start; item < end; item++) {
+        int index = (int)(item / lines);
+        int line = (int)(item % lines);
+        int row = (along == ROW_MAJOR) ? line : 0;
+        int col = (along == ROW_MAJOR) ? 0 : line;
+        char *out = batchValueAt(job->dest, index, row, col);
+        const char *a = batchValueAt(job->batch1, index, row, col);
+        const char *b = batchValueAt(job->batch2, index, row, col);
+        if (step1 != 1 || step2 != 1) {
+            combineStrided(data_type, out, 1, a, step1, b, step2, (size_t)length, job->subtract);
+        } else if (data_type == DOUBLE) {
+            kernels->combineDoubles((double *)out, (const double *)a, (const double *)b, (size_t)length,
+                                    job->subtract);
+        } else {
+            kernels->combineInts((int *)out, (const int *)a, (const int *)b, (size_t)length, 1, job->subtract);
+        }
+    }
+}
+
+// Add or subtract two batches into a third
+static MatrixStatus combineMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1,
+                                         const MatrixBatch *batch2, int subtract) {
+    MatrixStatus status = checkBatches(dest, batch1, batch2, 0);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    BatchCombineJob job = {dest, batch1, batch2, subtract, 0};
+    job.singleRun = batch1->order == dest->order && batch2->order == dest->order && batchIsContiguous(dest) &&
+                    batchIsContiguous(batch1) && batchIsContiguous(batch2);
+    size_t values = (size_t)dest->count * dest->stride;
+    size_t lineValues = (size_t)batchLineLength(dest);
+    size_t items = job.singleRun ? values : (size_t)dest->count * batchLines(dest);
+    size_t grain = job.singleRun ? PARALLEL_MIN_VALUES : (PARALLEL_MIN_VALUES + lineValues - 1) / lineValues;
+    parallelRange(items, parallelRangeCount(items, grain), combineBatchRange, &job);
+    return MATRIX_SUCCESS;
+}
+
+// Function to add every pair of matrices of two batches
+// Accepts a destination batch and two operand batches, all holding the same number of same sized matrices
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus addMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2) {
+    return combineMatrixBatches(dest, batch1, batch2, 0);
+}
+
+// Function to subtract every pair of matrices of two batches
+// Accepts a destination batch and two operand batches, all holding the same number of same sized matrices
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus subtractMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2) {
+    return combineMatrixBatches(dest, batch1, batch2, 1);
+}
+
+// MARK - Multiplying
+
+// One batch multiplication of small matrices, shared between threads a group of BATCH_LANES matrices at a time
+typedef struct {
+    const MatrixBatch *dest;
+    const MatrixBatch *batch1;
+    const MatrixBatch *batch2;
+    char *scratch;
+    size_t taskBytes;
+} BatchMultiplyJob;
+
+// Copy matrices 'first' up to 'first + used' of a batch into lanes, or back out of them
+// Cell (r, c) of lane l is at [(r * cols + c) * BATCH_LANES + l], so the lanes are filled one cell at a time
+static void moveLanes(const MatrixBatch *batch, int first, int used, char *lanes, int gather) {
+    size_t rowStride, colStride;
+    batchStrides(batch, &rowStride, &colStride);
+    size_t stride = batch->stride;
+    for (int r = 0; r < batch->rows; r++) {
+        for (int c = 0; c < batch->cols; c++) {
+            size_t value = (size_t)first * stride + (size_t)r * rowStride + (size_t)c * colStride;
+            size_t slot = ((size_t)r * batch->cols + c) * BATCH_LANES;
+            if (batch->data_type == DOUBLE) {
+                double *values = (double *)batch->values + value;
+                double *slots = (double *)lanes + slot;
+                for (int l = 0; l < used; l++) {
+                    if (gather) {
+                        slots[l] = values[l * stride];
+                    } else {
+                        values[l * stride] = slots[l];
+                    }
+                }
+            } else {
+                int *values = (int *)batch->values + value;
+                int *slots = (int *)lanes + slot;
+                for (int l = 0; l < used; l++) {
+                    if (gather) {
+                        slots[l] = values[l * stride];
+                    } else {
+                        values[l * stride] = slots[l];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Multiply groups 'start' up to 'end' of a job, interleaving each group into this task's own 'taskBytes' of the
+// job's scratch space
+static void multiplyBatchRange(void *context, int task, size_t start, size_t end) {
+    const BatchMultiplyJob *job = (const BatchMultiplyJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    int m = job->batch1->rows;
+    int p = job->batch1->cols;
+    int n = job->batch2->cols;
+    size_t size = batchValueSize(job->dest->data_type);
+    size_t aValues = (size_t)m * p * BATCH_LANES;
+    size_t bValues = (size_t)p * n * BATCH_LANES;
+    char *a = job->scratch + (size_t)task * job->taskBytes;
+    char *b = a + aValues * size;
+    char *c = b + bValues * size;
+    for (size_t group = start; group < end; group++) {
+        int first = (int)group * BATCH_LANES;
+        int used = (job->dest->count - first < BATCH_LANES) ? job->dest->count - first : BATCH_LANES;
+
+        // Lanes past the end of the batch keep whatever the last group left, and their results are never stored
+        moveLanes(job->batch1, first, used, a, 1);
+        moveLanes(job->batch2, first, used, b, 1);
+        if (job->dest->data_type == DOUBLE) {
+            kernels->batchMultiplyDoubles((double *)c, (const double *)a, (const double *)b, m, n, p);
+        } else {
+            kernels->batchMultiplyInts((int *)c, (const int *)a, (const int *)b, m, n, p);
+        }
+        moveLanes(job->dest, first, used, c, 0);
+    }
+}
+
+// Function to multiply every pair of matrices of two batches
+// Accepts a destination batch and two operand batches holding the same number of matrices, where the operands'
+// dimensions allow multiplication and the destination has the result's. It can't overlap either operand.
+// Returns MATRIX_SUCCESS, or an error status with the destination untouched
+MatrixStatus multiplyMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2) {
+    MatrixStatus status = checkBatches(dest, batch1, batch2, 1);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    int m = batch1->rows;
+    int p = batch1->cols;
+    int n = batch2->cols;
+    size_t volume = (size_t)m * n * p;
+
+    // Big matrices are worth the blocked GEMM, which shares each of them between threads by itself
+    if (volume >= GEMM_MIN_VOLUME) {
+        for (int t = 0; t < dest->count; t++) {
+            MatrixView out = batchMatrixView(dest, t);
+            MatrixView view1 = batchMatrixView(batch1, t);
+            MatrixView view2 = batchMatrixView(batch2, t);
+            status = gemmMatrixViews(NO_TRANSPOSE, NO_TRANSPOSE, 1.0, &view1, &view2, 0.0, &out);
+            if (status != MATRIX_SUCCESS) {
+                return status;
+            }
+        }
+        return MATRIX_SUCCESS;
+    }
+
+    size_t groups = ((size_t)dest->count + BATCH_LANES - 1) / BATCH_LANES;
+    size_t groupVolume = volume * BATCH_LANES;
+    int ranges = parallelRangeCount(groups, (PARALLEL_MIN_VOLUME + groupVolume - 1) / groupVolume);
+
+    // Every range's interleaved A, B and C are taken before any work starts, so running out leaves the destination
+    // untouched. Each range's share is rounded up to the alignment.
+    BatchMultiplyJob job = {dest, batch1, batch2, NULL, 0};
+    size_t values = ((size_t)m * p + (size_t)p * n + (size_t)m * n) * BATCH_LANES;
+    job.taskBytes = values * batchValueSize(dest->data_type);
+    job.taskBytes = (job.taskBytes + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+    job.scratch = (char *)alignedCalloc((size_t)ranges * job.taskBytes);
+    if (job.scratch == NULL) {
+        printf("Memory allocation failed for batch multiplication scratch space.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    parallelRange(groups, ranges, multiplyBatchRange, &job);
+    alignedFree(job.scratch);
+    return MATRIX_SUCCESS;
+}
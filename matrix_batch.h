@@ -0,0 +1,51 @@
+#ifndef MATRIX_BATCH_H
+#define MATRIX_BATCH_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Struct for a batch of matrices that all have the same dimensions, data type and storage order, in one buffer
+// Matrix t of the batch starts 't * stride' values into 'values', and inside it neighbouring rows (or columns in
+// column major order) start 'ld' values apart, so the batch is a strided 3-D array of packed ints or doubles.
+// createMatrixBatch makes a batch that owns its buffer. A batch can also be filled in by hand over any buffer
+// laid out this way, in which case it must not be passed to freeMatrixBatch.
+typedef struct {
+    int count;
+    int rows;
+    int cols;
+    DataType data_type;
+    StorageOrder order;
+    void *values;
+    int ld;
+    size_t stride;
+} MatrixBatch;
+
+// Create a batch of 'count' zero filled INT or DOUBLE matrices, one after the other with no gaps
+MatrixBatch createMatrixBatch(int count, int rows, int cols, DataType data_type, StorageOrder order);
+
+// Detect an invalid batch
+int isValidBatch(const MatrixBatch *batch);
+
+// View one matrix of a batch, without copying
+MatrixView batchMatrixView(const MatrixBatch *batch, int index);
+
+// Add, subtract or multiply every pair of matrices of two batches into a third batch, all in one call.
+// The batches must hold as many matrices as each other, but each may be stored in either order with any strides.
+// Adding and subtracting can work in place (the destination may be either operand, laid out the same way),
+// but a multiplication needs a destination that doesn't overlap either operand.
+MatrixStatus addMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2);
+MatrixStatus subtractMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2);
+MatrixStatus multiplyMatrixBatches(const MatrixBatch *dest, const MatrixBatch *batch1, const MatrixBatch *batch2);
+
+// Free a batch made by createMatrixBatch
+void freeMatrixBatch(MatrixBatch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
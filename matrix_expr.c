@@ -0,0 +1,623 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_expr.h"
+
+// MARK - Expressions
+// An expression is a list of nodes, each referring only to nodes before it, so the list is already in an order
+// they can be worked out in. Evaluating a node walks the destination a chunk of EXPR_CHUNK cells at a time:
+// every input the node needs is read where it is if it's contiguous, or gathered into a small buffer (a "slot")
+// if not, every operation runs into a slot of its own, and the last one writes straight into the destination
+// whenever it can. Slots are handed back as soon as the last operation that reads them is done, so a long chain
+// only needs a handful of them, all in L1.
+
+// Cells worked out together. Operations always run over whole chunks (the end of a short one is ignored),
+// so their loops have a fixed length the compiler can turn into vector instructions without any tail.
+#define EXPR_CHUNK 256
+
+// Kinds of expression nodes
+typedef enum {
+    EXPR_INPUT,
+    EXPR_SCALAR,
+    EXPR_ADD,
+    EXPR_SUBTRACT,
+    EXPR_MULTIPLY,
+    EXPR_DIVIDE,
+    EXPR_MIN,
+    EXPR_MAX,
+    EXPR_NEGATE,
+    EXPR_ABS
+} ExprOp;
+
+// One node of an expression. 'a' and 'b' are the operands of an operation (b is -1 for one with a single operand)
+typedef struct {
+    ExprOp op;
+    int a;
+    int b;
+    double scalar;
+    MatrixView view;
+} ExprNode;
+
+struct MatrixExpr {
+    ExprNode *nodes;
+    int count;
+    int capacity;
+    int hasInputs;
+    int rows;
+    int cols;
+    DataType data_type;
+    MatrixStatus status;
+};
+
+// Remember the first mistake made building an expression
+static int exprFailed(MatrixExpr *expr, MatrixStatus status) {
+    if (expr->status == MATRIX_SUCCESS) {
+        expr->status = status;
+    }
+    return -1;
+}
+
+// Function to create an empty expression
+// Accepts nothing
+// Returns the expression, or NULL if it couldn't be allocated
+MatrixExpr *createMatrixExpr(void) {
+    MatrixExpr *expr = (MatrixExpr *)calloc(1, sizeof(MatrixExpr));
+    if (expr == NULL) {
+        printf("Memory allocation failed for expression.\n");
+    }
+    return expr;
+}
+
+// Function to free an expression
+// Accepts an expression pointer, which may be NULL
+// Does not return
+void freeMatrixExpr(MatrixExpr *expr) {
+    if (expr != NULL) {
+        free(expr->nodes);
+        free(expr);
+    }
+}
+
+// Append a node to an expression
+// Returns its handle, or -1 if there was no room for it
+static int addNode(MatrixExpr *expr, ExprNode node) {
+    if (expr->count == expr->capacity) {
+        int capacity = (expr->capacity > 0) ? expr->capacity * 2 : 16;
+        ExprNode *nodes = (ExprNode *)realloc(expr->nodes, (size_t)capacity * sizeof(ExprNode));
+        if (nodes == NULL) {
+            printf("Memory allocation failed for expression node.\n");
+            return exprFailed(expr, MATRIX_ERROR_NULL_POINTER);
+        }
+        expr->nodes = nodes;
+        expr->capacity = capacity;
+    }
+    expr->nodes[expr->count] = node;
+    return expr->count++;
+}
+
+// Function to add an input view to an expression
+// Accepts an expression pointer and a view with the same dimensions and data type as every other input
+// Returns the node's handle, or -1 on error
+int exprInput(MatrixExpr *expr, const MatrixView *view) {
+    if (expr == NULL) {
+        printf("Error: Null expression.\n");
+        return -1;
+    }
+    if (view == NULL || view->block == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return exprFailed(expr, MATRIX_ERROR_NULL_POINTER);
+    }
+    if (view->data_type == CHAR) {
+        printf("Error: Expressions not supported for CHAR type matrices.\n");
+        return exprFailed(expr, MATRIX_ERROR_UNSUPPORTED_TYPE);
+    }
+    if (expr->hasInputs && (view->rows != expr->rows || view->cols != expr->cols)) {
+        printf("Error: Expression input dimensions do not match.\n");
+        return exprFailed(expr, MATRIX_ERROR_SIZE_MISMATCH);
+    }
+    if (expr->hasInputs && view->data_type != expr->data_type) {
+        printf("Error: Expression input data types do not match.\n");
+        return exprFailed(expr, MATRIX_ERROR_TYPE_MISMATCH);
+    }
+    expr->hasInputs = 1;
+    expr->rows = view->rows;
+    expr->cols = view->cols;
+    expr->data_type = view->data_type;
+
+    ExprNode node = {EXPR_INPUT, -1, -1, 0.0, *view};
+    return addNode(expr, node);
+}
+
+// Function to add a scalar to an expression
+// Accepts an expression pointer and the scalar's value
+// Returns the node's handle, or -1 on error
+int exprScalar(MatrixExpr *expr, double value) {
+    if (expr == NULL) {
+        printf("Error: Null expression.\n");
+        return -1;
+    }
+    ExprNode node = {EXPR_SCALAR, -1, -1, value, {0, 0, DOUBLE, PACKED_STORAGE, ROW_MAJOR, NULL, 0, 1}};
+    return addNode(expr, node);
+}
+
+// Add an operation on one or two earlier nodes
+// Returns its handle, or -1 if an operand is missing (which has already been reported if it came from an error)
+static int addOperation(MatrixExpr *expr, ExprOp op, int a, int b, int operands) {
+    if (expr == NULL) {
+        printf("Error: Null expression.\n");
+        return -1;
+    }
+    if (a == -1 || (operands == 2 && b == -1)) {
+        return exprFailed(expr, MATRIX_ERROR_NULL_POINTER);
+    }
+    if (a < 0 || a >= expr->count || (operands == 2 && (b < 0 || b >= expr->count))) {
+        printf("Error: Expression node does not exist.\n");
+        return exprFailed(expr, MATRIX_ERROR_NULL_POINTER);
+    }
+    ExprNode node = {op, a, (operands == 2) ? b : -1, 0.0, {0, 0, DOUBLE, PACKED_STORAGE, ROW_MAJOR, NULL, 0, 1}};
+    return addNode(expr, node);
+}
+
+// Functions to add an element-wise operation to an expression
+// Accept an expression pointer and the handles of the operands
+// Return the node's handle, or -1 on error
+int exprAdd(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_ADD, a, b, 2);
+}
+
+int exprSubtract(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_SUBTRACT, a, b, 2);
+}
+
+int exprMultiply(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_MULTIPLY, a, b, 2);
+}
+
+int exprDivide(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_DIVIDE, a, b, 2);
+}
+
+int exprMin(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_MIN, a, b, 2);
+}
+
+int exprMax(MatrixExpr *expr, int a, int b) {
+    return addOperation(expr, EXPR_MAX, a, b, 2);
+}
+
+int exprNegate(MatrixExpr *expr, int a) {
+    return addOperation(expr, EXPR_NEGATE, a, -1, 1);
+}
+
+int exprAbs(MatrixExpr *expr, int a) {
+    return addOperation(expr, EXPR_ABS, a, -1, 1);
+}
+
+// MARK - Evaluation
+
+// Work out an operation on a whole chunk of doubles. 'out' is never one of the operands.
+static void applyDoubles(ExprOp op, double *restrict out, const double *restrict a, const double *restrict b) {
+    switch (op) {
+        case EXPR_ADD:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = a[k] + b[k];
+            }
+            break;
+        case EXPR_SUBTRACT:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = a[k] - b[k];
+            }
+            break;
+        case EXPR_MULTIPLY:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = a[k] * b[k];
+            }
+            break;
+        case EXPR_DIVIDE:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = a[k] / b[k];
+            }
+            break;
+        case EXPR_MIN:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (b[k] < a[k]) ? b[k] : a[k];
+            }
+            break;
+        case EXPR_MAX:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (b[k] > a[k]) ? b[k] : a[k];
+            }
+            break;
+        case EXPR_NEGATE:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = -a[k];
+            }
+            break;
+        case EXPR_ABS:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = fabs(a[k]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Work out an operation on a whole chunk of ints. Adding, subtracting and multiplying wrap around on overflow,
+// like the vector kernels do, so they are done on unsigned ints where wrapping is well defined.
+static void applyInts(ExprOp op, int *restrict out, const int *restrict a, const int *restrict b) {
+    switch (op) {
+        case EXPR_ADD:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (int)((unsigned)a[k] + (unsigned)b[k]);
+            }
+            break;
+        case EXPR_SUBTRACT:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (int)((unsigned)a[k] - (unsigned)b[k]);
+            }
+            break;
+        case EXPR_MULTIPLY:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (int)((unsigned)a[k] * (unsigned)b[k]);
+            }
+            break;
+        case EXPR_MIN:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (b[k] < a[k]) ? b[k] : a[k];
+            }
+            break;
+        case EXPR_MAX:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (b[k] > a[k]) ? b[k] : a[k];
+            }
+            break;
+        case EXPR_NEGATE:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (int)(0u - (unsigned)a[k]);
+            }
+            break;
+        case EXPR_ABS:
+            for (int k = 0; k < EXPR_CHUNK; k++) {
+                out[k] = (a[k] < 0) ? (int)(0u - (unsigned)a[k]) : a[k];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// One node of the evaluation, with the slot it can write to and the steps of its operands
+typedef struct {
+    const ExprNode *node;
+    int slot;
+    int a;
+    int b;
+} ExprStep;
+
+// One evaluation of a node, shared between threads a chunk at a time
+// 'destShared' is set when the destination is also an input, so results can't be written straight into it
+typedef struct {
+    const ExprStep *steps;
+    int stepCount;
+    int slots;
+    const MatrixView *dest;
+    int destShared;
+    DataType data_type;
+    int lineLength;
+    int chunksPerLine;
+    char *scratch;
+    size_t taskBytes;
+} ExprJob;
+
+// Copy 'count' values spaced 'step' apart into or out of a slot
+static void copyRun(void *to, size_t toStep, const void *from, size_t fromStep, size_t count, size_t size) {
+    if (toStep == 1 && fromStep == 1) {
+        memcpy(to, from, count * size);
+    } else if (size == sizeof(double)) {
+        for (size_t k = 0; k < count; k++) {
+            ((double *)to)[k * toStep] = ((const double *)from)[k * fromStep];
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            ((int *)to)[k * toStep] = ((const int *)from)[k * fromStep];
+        }
+    }
+}
+
+// Address of the value at (row, col) of a view, and the stride along the destination's lines
+static char *viewValueAt(const MatrixView *view, int row, int col, StorageOrder along, size_t *step) {
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    *step = (along == ROW_MAJOR) ? colStride : rowStride;
+    size_t size = (view->data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+    return (char *)viewValues(view) + ((size_t)row * rowStride + (size_t)col * colStride) * size;
+}
+
+// Evaluate chunks 'start' up to 'end' of a job.
+// Each task works in its own 'taskBytes' of the job's scratch space: its slots, then where each step's values are.
+static void evaluateRange(void *context, int task, size_t start, size_t end) {
+    const ExprJob *job = (const ExprJob *)context;
+    size_t size = (job->data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+    size_t slotBytes = EXPR_CHUNK * size;
+    char *slots = job->scratch + (size_t)task * job->taskBytes;
+    const char **values = (const char **)(slots + (size_t)job->slots * slotBytes);
+
+    // Scalars never change, so their slots are filled once
+    for (int s = 0; s < job->stepCount; s++) {
+        const ExprStep *step = &job->steps[s];
+        char *slot = slots + (size_t)step->slot * slotBytes;
+        values[s] = slot;
+        for (int k = 0; k < EXPR_CHUNK && step->node->op == EXPR_SCALAR; k++) {
+            if (job->data_type == DOUBLE) {
+                ((double *)slot)[k] = step->node->scalar;
+            } else {
+                ((int *)slot)[k] = (int)step->node->scalar;
+            }
+        }
+    }
+
+    StorageOrder along = job->dest->order;
+    int last = job->stepCount - 1;
+    for (size_t item = start; item < end; item++) {
+        int line = (int)(item / job->chunksPerLine);
+        int first = (int)(item % job->chunksPerLine) * EXPR_CHUNK;
+        int count = (job->lineLength - first < EXPR_CHUNK) ? job->lineLength - first : EXPR_CHUNK;
+        int row = (along == ROW_MAJOR) ? line : first;
+        int col = (along == ROW_MAJOR) ? first : line;
+        size_t destStep;
+        char *to = viewValueAt(job->dest, row, col, along, &destStep);
+
+        // A whole chunk of contiguous values is read (or written) where it is. Anything else, including the
+        // short chunk at the end of a line, is gathered into a slot first, so operations always see whole chunks.
+        int whole = (count == EXPR_CHUNK);
+        for (int s = 0; s <= last; s++) {
+            const ExprStep *step = &job->steps[s];
+            char *out = slots + (size_t)step->slot * slotBytes;
+            if (step->node->op == EXPR_INPUT) {
+                size_t inputStep;
+                const char *input = viewValueAt(&step->node->view, row, col, along, &inputStep);
+                if (whole && inputStep == 1) {
+                    values[s] = input;
+                } else {
+                    copyRun(out, 1, input, inputStep, (size_t)count, size);
+                    values[s] = out;
+                }
+                continue;
+            }
+            if (step->node->op == EXPR_SCALAR) {
+                continue;
+            }
+            if (s == last && whole && destStep == 1 && !job->destShared) {
+                out = to;
+            }
+            if (job->data_type == DOUBLE) {
+                applyDoubles(step->node->op, (double *)out, (const double *)values[step->a],
+                             (const double *)values[step->b]);
+            } else {
+                applyInts(step->node->op, (int *)out, (const int *)values[step->a], (const int *)values[step->b]);
+            }
+            values[s] = out;
+        }
+
+        // The last step is the node being evaluated
+        if (values[last] != to) {
+            copyRun(to, destStep, values[last], 1, (size_t)count, size);
+        }
+    }
+}
+
+// Whether the lines of a view follow each other with no gap, so the whole view is one contiguous run
+static int viewIsContiguous(const MatrixView *view) {
+    int lines = (view->order == ROW_MAJOR) ? view->rows : view->cols;
+    return lines <= 1 || view->ld == ((view->order == ROW_MAJOR) ? view->cols : view->rows);
+}
+
+// Whether two views look at exactly the same cells in exactly the same way
+static int sameViewLayout(const MatrixView *view1, const MatrixView *view2) {
+    return view1->block == view2->block && view1->offset == view2->offset && view1->ld == view2->ld &&
+           view1->order == view2->order && view1->storage == view2->storage && view1->rows == view2->rows &&
+           view1->cols == view2->cols;
+}
+
+// Function to evaluate a node of an expression into a destination
+// Only the nodes the evaluated one depends on are worked out. The destination may be one of the inputs,
+// as long as it is viewed exactly the same way, because each chunk is read before it is written.
+// Accepts an expression pointer, a node handle, and a destination view with the inputs' dimensions and data type
+// Returns MATRIX_SUCCESS, or an error status (the first made building the expression, if any) with the
+// destination untouched
+MatrixStatus evaluateMatrixExpr(MatrixExpr *expr, int node, const MatrixView *dest) {
+    if (expr == NULL || dest == NULL || dest->block == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (expr->status != MATRIX_SUCCESS) {
+        return expr->status;
+    }
+    if (node < 0 || node >= expr->count) {
+        printf("Error: Expression node does not exist.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+
+    // Without inputs, an expression of scalars takes its size and data type from the destination
+    int rows = expr->hasInputs ? expr->rows : dest->rows;
+    int cols = expr->hasInputs ? expr->cols : dest->cols;
+    DataType data_type = expr->hasInputs ? expr->data_type : dest->data_type;
+    if (dest->rows != rows || dest->cols != cols) {
+        printf("Error: Destination matrix dimensions do not match the result.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (dest->data_type != data_type) {
+        printf("Error: Destination matrix data type does not match the result.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    if (data_type == CHAR) {
+        printf("Error: Expressions not supported for CHAR type matrices.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+
+    // Find the nodes this one needs, and check they suit the data type and the destination
+    char *needed = (char *)calloc((size_t)node + 1, 1);
+    int *stepOf = (int *)malloc(((size_t)node + 1) * sizeof(int));
+    int *lastUse = (int *)malloc(((size_t)node + 1) * sizeof(int));
+    int *slotOf = (int *)malloc(((size_t)node + 1) * sizeof(int));
+    int *freeSlots = (int *)malloc(((size_t)node + 1) * sizeof(int));
+    ExprStep *steps = (ExprStep *)malloc(((size_t)node + 1) * sizeof(ExprStep));
+    MatrixStatus status = MATRIX_SUCCESS;
+    if (needed == NULL || stepOf == NULL || lastUse == NULL || slotOf == NULL || freeSlots == NULL || steps == NULL) {
+        printf("Memory allocation failed for expression evaluation.\n");
+        status = MATRIX_ERROR_NULL_POINTER;
+    } else {
+        needed[node] = 1;
+        for (int i = node; i >= 0; i--) {
+            const ExprNode *n = &expr->nodes[i];
+            lastUse[i] = -1;
+            if (!needed[i]) {
+                continue;
+            }
+            if (n->a >= 0) {
+                needed[n->a] = 1;
+            }
+            if (n->b >= 0) {
+                needed[n->b] = 1;
+            }
+            if (data_type == INT && n->op == EXPR_DIVIDE) {
+                printf("Error: Division not supported for INT type expressions.\n");
+                status = MATRIX_ERROR_UNSUPPORTED_TYPE;
+            } else if (data_type == INT && n->op == EXPR_SCALAR &&
+                       (!(n->scalar >= INT_MIN && n->scalar <= INT_MAX) || n->scalar != (int)n->scalar)) {
+                printf("Error: INT expressions can only use whole number scalars.\n");
+                status = MATRIX_ERROR_UNSUPPORTED_TYPE;
+            } else if (n->op == EXPR_INPUT && n->view.block == dest->block && !sameViewLayout(&n->view, dest)) {
+                printf("Error: Destination matrix shares its elements with an input viewed differently.\n");
+                status = MATRIX_ERROR_ALIASING;
+            }
+        }
+    }
+    if (status != MATRIX_SUCCESS) {
+        free(needed);
+        free(stepOf);
+        free(lastUse);
+        free(slotOf);
+        free(freeSlots);
+        free(steps);
+        return status;
+    }
+
+    // Give each needed node a slot. An operation's slot is taken before its operands' are handed back,
+    // so it never writes over what it reads. Scalars are filled before anything runs, so each gets a new slot
+    // that nothing else ever uses.
+    for (int i = 0; i <= node; i++) {
+        if (needed[i]) {
+            if (expr->nodes[i].a >= 0) {
+                lastUse[expr->nodes[i].a] = i;
+            }
+            if (expr->nodes[i].b >= 0) {
+                lastUse[expr->nodes[i].b] = i;
+            }
+        }
+    }
+    int slots = 0;
+    int freeCount = 0;
+    int stepCount = 0;
+    for (int i = 0; i <= node; i++) {
+        if (!needed[i]) {
+            continue;
+        }
+        const ExprNode *n = &expr->nodes[i];
+        slotOf[i] = (freeCount > 0 && n->op != EXPR_SCALAR) ? freeSlots[--freeCount] : slots++;
+
+        // One operand nodes read 'a' twice, which is harmless
+        int a = (n->a >= 0) ? stepOf[n->a] : 0;
+        ExprStep step = {n, slotOf[i], a, (n->b >= 0) ? stepOf[n->b] : a};
+        stepOf[i] = stepCount;
+        steps[stepCount++] = step;
+        int operands[2] = {n->a, (n->b != n->a) ? n->b : -1};
+        for (int k = 0; k < 2; k++) {
+            int o = operands[k];
+            if (o >= 0 && lastUse[o] == i && expr->nodes[o].op != EXPR_SCALAR) {
+                freeSlots[freeCount++] = slotOf[o];
+            }
+        }
+    }
+
+    // Walk the destination along its own lines, a chunk at a time
+    ExprJob job;
+    job.steps = steps;
+    job.stepCount = stepCount;
+    job.slots = slots;
+    job.dest = dest;
+    job.destShared = 0;
+    for (int s = 0; s < stepCount; s++) {
+        job.destShared |= (steps[s].node->op == EXPR_INPUT && steps[s].node->view.block == dest->block);
+    }
+    job.data_type = data_type;
+    int lines = (dest->order == ROW_MAJOR) ? rows : cols;
+    job.lineLength = (dest->order == ROW_MAJOR) ? cols : rows;
+
+    // When every view runs on from one line to the next in the same order, the whole lot is one long line,
+    // so narrow matrices still get whole chunks
+    int singleRun = viewIsContiguous(dest);
+    for (int s = 0; s < stepCount; s++) {
+        const MatrixView *view = &steps[s].node->view;
+        if (steps[s].node->op == EXPR_INPUT && (view->order != dest->order || !viewIsContiguous(view))) {
+            singleRun = 0;
+        }
+    }
+    if (singleRun && (size_t)lines * job.lineLength <= INT_MAX) {
+        job.lineLength *= lines;
+        lines = 1;
+    }
+    job.chunksPerLine = (job.lineLength + EXPR_CHUNK - 1) / EXPR_CHUNK;
+    size_t items = (size_t)lines * job.chunksPerLine;
+    int ranges = parallelRangeCount(items, PARALLEL_MIN_VALUES / EXPR_CHUNK);
+
+    // Every range's scratch space is taken before any work starts, so running out leaves the destination untouched.
+    // Slots are whole multiples of the alignment, and each range's share is rounded up to one as well.
+    size_t size = (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+    job.taskBytes = (size_t)slots * EXPR_CHUNK * size + (size_t)stepCount * sizeof(const char *);
+    job.taskBytes = (job.taskBytes + MATRIX_ALIGNMENT - 1) & ~(size_t)(MATRIX_ALIGNMENT - 1);
+    job.scratch = (char *)alignedCalloc((size_t)ranges * job.taskBytes);
+    if (job.scratch == NULL) {
+        printf("Memory allocation failed for expression scratch space.\n");
+        status = MATRIX_ERROR_NULL_POINTER;
+    } else {
+        parallelRange(items, ranges, evaluateRange, &job);
+        alignedFree(job.scratch);
+    }
+
+    free(needed);
+    free(stepOf);
+    free(lastUse);
+    free(slotOf);
+    free(freeSlots);
+    free(steps);
+    return status;
+}
+
+// Function to evaluate a node of an expression into a new matrix
+// Accepts an expression pointer and a node handle
+// Returns a packed matrix with the inputs' dimensions and data type, or an invalid matrix on error
+Matrix createMatrixFromExpr(MatrixExpr *expr, int node) {
+    if (expr == NULL) {
+        printf("Error: Null expression.\n");
+        return invalidMatrix();
+    }
+    if (expr->status != MATRIX_SUCCESS) {
+        return invalidMatrix();
+    }
+    if (!expr->hasInputs) {
+        printf("Error: Expression has no inputs to take its dimensions from.\n");
+        return invalidMatrix();
+    }
+    Matrix result = createPackedMatrix(expr->rows, expr->cols, expr->data_type);
+    MatrixView out = viewMatrix(&result);
+    if (evaluateMatrixExpr(expr, node, &out) != MATRIX_SUCCESS) {
+        freeMatrix(&result);
+        return invalidMatrix();
+    }
+    return result;
+}
@@ -0,0 +1,44 @@
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// An element-wise expression over views and scalars, built up a node at a time and worked out later.
+// Evaluating it does every operation in one pass: each input value is read once and each result is written
+// once, and everything in between stays in small buffers in cache instead of temporary matrices.
+typedef struct MatrixExpr MatrixExpr;
+
+// Create an empty expression, and free one along with all its nodes (but not the matrices its views look at)
+MatrixExpr *createMatrixExpr(void);
+void freeMatrixExpr(MatrixExpr *expr);
+
+// Add a node to an expression, returning a handle for later nodes to use, or -1 on error.
+// Every input must have the same dimensions and data type, INT or DOUBLE, and is read when the expression is
+// evaluated rather than when it is added. A scalar stands for every cell, and must be a whole number in an INT
+// expression. INT expressions can't divide. The first mistake is remembered and returned by evaluateMatrixExpr.
+int exprInput(MatrixExpr *expr, const MatrixView *view);
+int exprScalar(MatrixExpr *expr, double value);
+int exprAdd(MatrixExpr *expr, int a, int b);
+int exprSubtract(MatrixExpr *expr, int a, int b);
+int exprMultiply(MatrixExpr *expr, int a, int b);
+int exprDivide(MatrixExpr *expr, int a, int b);
+int exprMin(MatrixExpr *expr, int a, int b);
+int exprMax(MatrixExpr *expr, int a, int b);
+int exprNegate(MatrixExpr *expr, int a);
+int exprAbs(MatrixExpr *expr, int a);
+
+// Evaluate a node into a destination view, which can be stored any way and can be one of the inputs
+MatrixStatus evaluateMatrixExpr(MatrixExpr *expr, int node, const MatrixView *dest);
+
+// Evaluate a node into a new packed matrix in the default storage order
+Matrix createMatrixFromExpr(MatrixExpr *expr, int node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
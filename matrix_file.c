@@ -0,0 +1,448 @@
+// mmap, open and fstat live behind POSIX, which -std=c99 hides unless we ask for it
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+#include "matrix_file.h"
+
+// MARK - Matrix files
+// A matrix file is a fixed 64 byte header and then the values, exactly as a packed matrix keeps them in memory,
+// starting at an offset aligned to MATRIX_FILE_ALIGNMENT. Mapping a file therefore costs the same whatever its
+// size: the header is checked, and the view looks straight at the mapped values, which the system reads in as
+// they are touched. Values are written in the machine's own byte order, which the header records so a file from
+// a machine with the other order is refused rather than misread.
+//
+// The checksum covers the values only, so a file can be opened without reading them. It is FNV-1a taken over
+// 64 bit words instead of bytes (a final partial word is padded with zeros), followed by the length in bytes,
+// which is fast enough to check at disk speed.
+
+#define MATRIX_FILE_MAGIC "MTRXFILE"
+#define MATRIX_FILE_VERSION 1
+#define MATRIX_FILE_BYTE_ORDER 0x01020304u
+
+#define CHECKSUM_BASIS 0xcbf29ce484222325ull
+#define CHECKSUM_PRIME 0x100000001b3ull
+
+// How many bytes of values saveMatrixView gathers before writing them out, when they aren't stored packed
+#define WRITE_BUFFER_BYTES ((size_t)64 << 10)
+
+// The header at the start of every matrix file, 64 bytes with no padding
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t dataType;
+    uint32_t order;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t valueSize;
+    uint32_t alignment;
+    uint64_t payloadOffset;
+    uint64_t payloadSize;
+    uint64_t checksum;
+} MatrixFileHeader;
+
+// Refuses to compile if the header ever picks up padding
+typedef char MatrixFileHeaderIs64Bytes[(sizeof(MatrixFileHeader) == 64) ? 1 : -1];
+
+// A running checksum, which can be fed any number of bytes at a time
+typedef struct {
+    uint64_t hash;
+    unsigned char pending[8];
+    size_t pendingBytes;
+    uint64_t length;
+} Checksum;
+
+struct MatrixWriter {
+    FILE *file;
+    MatrixFileHeader header;
+    size_t expected;
+    size_t written;
+    Checksum checksum;
+    int failed;
+};
+
+// Size in bytes of a single value in a matrix file
+static size_t fileValueSize(DataType data_type) {
+    switch (data_type) {
+        case INT:
+            return sizeof(int);
+        case DOUBLE:
+            return sizeof(double);
+        case CHAR:
+            return sizeof(char);
+    }
+    return 0;
+}
+
+// Start a checksum
+static void startChecksum(Checksum *checksum) {
+    checksum->hash = CHECKSUM_BASIS;
+    checksum->pendingBytes = 0;
+    checksum->length = 0;
+}
+
+// Mix one 64 bit word into a checksum
+static uint64_t mixWord(uint64_t hash, const unsigned char *bytes) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    return (hash ^ word) * CHECKSUM_PRIME;
+}
+
+// Add bytes to a checksum
+static void updateChecksum(Checksum *checksum, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    checksum->length += size;
+
+    // Finish the word left over from last time before taking whole words straight from the data
+    if (checksum->pendingBytes > 0) {
+        size_t take = 8 - checksum->pendingBytes;
+        if (take > size) {
+            take = size;
+        }
+        memcpy(checksum->pending + checksum->pendingBytes, bytes, take);
+        checksum->pendingBytes += take;
+        bytes += take;
+        size -= take;
+        if (checksum->pendingBytes < 8) {
+            return;
+        }
+        checksum->hash = mixWord(checksum->hash, checksum->pending);
+        checksum->pendingBytes = 0;
+    }
+
+    uint64_t hash = checksum->hash;
+    for (; size >= 8; size -= 8, bytes += 8) {
+        hash = mixWord(hash, bytes);
+    }
+    checksum->hash = hash;
+    memcpy(checksum->pending, bytes, size);
+    checksum->pendingBytes = size;
+}
+
+// Finish a checksum
+static uint64_t finishChecksum(const Checksum *checksum) {
+    uint64_t hash = checksum->hash;
+    if (checksum->pendingBytes > 0) {
+        unsigned char last[8] = {0};
+        memcpy(last, checksum->pending, checksum->pendingBytes);
+        hash = mixWord(hash, last);
+    }
+    return (hash ^ checksum->length) * CHECKSUM_PRIME;
+}
+
+// MARK - Writing
+
+// Function to start writing a matrix file
+// The file is created with a blank header, and only gets its real one from closeMatrixWriter once every value
+// is in, so a file that was never finished can't be mistaken for a matrix.
+// Accepts the file path, the matrix's dimensions and data type, and the order its values will be written in
+// Returns a writer, or NULL on error
+MatrixWriter *openMatrixWriter(const char *path, int rows, int cols, DataType data_type, StorageOrder order) {
+    if (path == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return NULL;
+    }
+    if (rows <= 0 || cols <= 0) {
+        printf("Error: Invalid matrix dimensions.\n");
+        return NULL;
+    }
+
+    MatrixWriter *writer = (MatrixWriter *)calloc(1, sizeof(MatrixWriter));
+    if (writer == NULL) {
+        printf("Memory allocation failed for matrix writer\n");
+        return NULL;
+    }
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        printf("Error: Could not open %s for writing.\n", path);
+        free(writer);
+        return NULL;
+    }
+
+    MatrixFileHeader *header = &writer->header;
+    memcpy(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic));
+    header->version = MATRIX_FILE_VERSION;
+    header->byteOrder = MATRIX_FILE_BYTE_ORDER;
+    header->dataType = (uint32_t)data_type;
+    header->order = (uint32_t)order;
+    header->rows = (uint32_t)rows;
+    header->cols = (uint32_t)cols;
+    header->valueSize = (uint32_t)fileValueSize(data_type);
+    header->alignment = MATRIX_FILE_ALIGNMENT;
+    header->payloadOffset = MATRIX_FILE_ALIGNMENT;
+    header->payloadSize = (uint64_t)rows * (uint64_t)cols * header->valueSize;
+    writer->expected = (size_t)rows * (size_t)cols;
+    startChecksum(&writer->checksum);
+
+    // The values start right after the header, which is exactly one alignment long
+    unsigned char blank[MATRIX_FILE_ALIGNMENT] = {0};
+    if (fwrite(blank, 1, sizeof(blank), writer->file) != sizeof(blank)) {
+        writer->failed = 1;
+    }
+    return writer;
+}
+
+// Function to write the next values of a matrix file
+// Accepts a writer, and an array of 'count' values of its data type (ints, doubles or chars) in its order
+// Returns MATRIX_SUCCESS or an error status. Writing past the end of the matrix writes nothing.
+MatrixStatus writeMatrixValues(MatrixWriter *writer, const void *values, size_t count) {
+    if (writer == NULL || (values == NULL && count > 0)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (count > writer->expected - writer->written) {
+        printf("Error: More values written than the matrix holds.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    size_t bytes = count * writer->header.valueSize;
+    if (writer->failed || fwrite(values, 1, bytes, writer->file) != bytes) {
+        writer->failed = 1;
+        return MATRIX_ERROR_IO;
+    }
+    updateChecksum(&writer->checksum, values, bytes);
+    writer->written += count;
+    return MATRIX_SUCCESS;
+}
+
+// Function to finish a matrix file and free its writer
+// Accepts a writer
+// Returns MATRIX_SUCCESS, or an error status if any write failed or not every value was written.
+// The file is left without a valid header on error.
+MatrixStatus closeMatrixWriter(MatrixWriter *writer) {
+    if (writer == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixStatus status = MATRIX_SUCCESS;
+    if (writer->written != writer->expected) {
+        printf("Error: Matrix file closed after %zu of %zu values.\n", writer->written, writer->expected);
+        status = MATRIX_ERROR_SIZE_MISMATCH;
+    } else {
+        writer->header.checksum = finishChecksum(&writer->checksum);
+        if (writer->failed || fseek(writer->file, 0, SEEK_SET) != 0 ||
+            fwrite(&writer->header, sizeof(writer->header), 1, writer->file) != 1) {
+            status = MATRIX_ERROR_IO;
+        }
+    }
+    if (fclose(writer->file) != 0 && status == MATRIX_SUCCESS) {
+        status = MATRIX_ERROR_IO;
+    }
+    if (status == MATRIX_ERROR_IO) {
+        printf("Error: Could not write matrix file.\n");
+    }
+    free(writer);
+    return status;
+}
+
+// Function to write a view to a matrix file
+// Packed views are written straight from the matrix a contiguous run at a time; element storage is gathered
+// into packed values first.
+// Accepts the file path and a view pointer
+// Returns MATRIX_SUCCESS or an error status
+MatrixStatus saveMatrixView(const char *path, const MatrixView *view) {
+    if (view == NULL || view->block == NULL || view->rows <= 0 || view->cols <= 0) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixWriter *writer = openMatrixWriter(path, view->rows, view->cols, view->data_type, view->order);
+    if (writer == NULL) {
+        return MATRIX_ERROR_IO;
+    }
+
+    size_t lines = (size_t)((view->order == ROW_MAJOR) ? view->rows : view->cols);
+    size_t length = (size_t)((view->order == ROW_MAJOR) ? view->cols : view->rows);
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    size_t lineStride = (view->order == ROW_MAJOR) ? rowStride : colStride;
+    size_t step = (view->order == ROW_MAJOR) ? colStride : rowStride;
+    size_t size = fileValueSize(view->data_type);
+    const char *values = (const char *)viewValues(view);
+
+    MatrixStatus status = MATRIX_SUCCESS;
+    if (step == 1 && lineStride == length) {
+        status = writeMatrixValues(writer, values, lines * length);
+    } else if (step == 1) {
+        for (size_t i = 0; i < lines && status == MATRIX_SUCCESS; i++) {
+            status = writeMatrixValues(writer, values + i * lineStride * size, length);
+        }
+    } else {
+        size_t capacity = WRITE_BUFFER_BYTES / size;
+        char *buffer = (char *)malloc(capacity * size);
+        if (buffer == NULL) {
+            printf("Memory allocation failed for matrix writer\n");
+            status = MATRIX_ERROR_IO;
+        }
+        size_t filled = 0;
+        for (size_t i = 0; i < lines && status == MATRIX_SUCCESS; i++) {
+            for (size_t k = 0; k < length && status == MATRIX_SUCCESS; k++) {
+                memcpy(buffer + filled * size, values + (i * lineStride + k * step) * size, size);
+                if (++filled == capacity) {
+                    status = writeMatrixValues(writer, buffer, filled);
+                    filled = 0;
+                }
+            }
+        }
+        if (status == MATRIX_SUCCESS && filled > 0) {
+            status = writeMatrixValues(writer, buffer, filled);
+        }
+        free(buffer);
+    }
+
+    MatrixStatus closed = closeMatrixWriter(writer);
+    return (status != MATRIX_SUCCESS) ? status : closed;
+}
+
+// Function to write a matrix to a matrix file
+// Accepts the file path and a matrix pointer
+// Returns MATRIX_SUCCESS or an error status
+MatrixStatus saveMatrix(const char *path, const Matrix *mat) {
+    if (!isValid(mat)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView view = viewMatrix(mat);
+    return saveMatrixView(path, &view);
+}
+
+// MARK - Reading
+
+// Check a header against the size of its file
+// Returns 1 if the header describes a matrix that fits in the file, 0 otherwise
+static int validHeader(const MatrixFileHeader *header, size_t fileSize) {
+    if (memcmp(header->magic, MATRIX_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != MATRIX_FILE_VERSION || header->byteOrder != MATRIX_FILE_BYTE_ORDER) {
+        return 0;
+    }
+    if (header->dataType > (uint32_t)CHAR || header->order > (uint32_t)COLUMN_MAJOR ||
+        header->valueSize != fileValueSize((DataType)header->dataType)) {
+        return 0;
+    }
+    if (header->rows == 0 || header->cols == 0 || header->rows > INT_MAX || header->cols > INT_MAX) {
+        return 0;
+    }
+    if (header->alignment == 0 || (header->alignment & (header->alignment - 1)) != 0 ||
+        header->payloadOffset % header->alignment != 0 || header->payloadOffset < sizeof(MatrixFileHeader)) {
+        return 0;
+    }
+    uint64_t cells = (uint64_t)header->rows * header->cols;
+    if (cells > UINT64_MAX / header->valueSize || header->payloadSize != cells * header->valueSize) {
+        return 0;
+    }
+    return header->payloadOffset <= fileSize && header->payloadSize <= fileSize - header->payloadOffset;
+}
+
+// Function to map a matrix file into memory
+// Only the header is read; the values are read from disk as they are used.
+// Accepts the file path and a pointer to fill in
+// Returns MATRIX_SUCCESS, or an error status with 'mapped' cleared
+MatrixStatus mapMatrixFile(const char *path, MappedMatrix *mapped) {
+    if (path == NULL || mapped == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    memset(mapped, 0, sizeof(*mapped));
+
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) {
+        printf("Error: Could not open %s.\n", path);
+        return MATRIX_ERROR_IO;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        close(descriptor);
+        printf("Error: Could not open %s.\n", path);
+        return MATRIX_ERROR_IO;
+    }
+    size_t fileSize = (size_t)info.st_size;
+    if (fileSize < sizeof(MatrixFileHeader)) {
+        close(descriptor);
+        printf("Error: %s is not a matrix file.\n", path);
+        return MATRIX_ERROR_FORMAT;
+    }
+
+    // The mapping keeps the file open on its own, so the descriptor isn't needed past this point
+    void *mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Could not map %s.\n", path);
+        return MATRIX_ERROR_IO;
+    }
+    MatrixFileHeader header;
+    memcpy(&header, mapping, sizeof(header));
+    if (!validHeader(&header, fileSize)) {
+        munmap(mapping, fileSize);
+        printf("Error: %s is not a matrix file.\n", path);
+        return MATRIX_ERROR_FORMAT;
+    }
+
+    MatrixView *view = &mapped->view;
+    view->rows = (int)header.rows;
+    view->cols = (int)header.cols;
+    view->data_type = (DataType)header.dataType;
+    view->storage = PACKED_STORAGE;
+    view->order = (StorageOrder)header.order;
+    view->block = (char *)mapping + header.payloadOffset;
+    view->offset = 0;
+    view->ld = (view->order == ROW_MAJOR) ? view->cols : view->rows;
+    mapped->mapping = mapping;
+    mapped->mappingSize = fileSize;
+    mapped->checksum = header.checksum;
+    return MATRIX_SUCCESS;
+}
+
+// Function to check the values of a mapped matrix file against its checksum
+// This reads the whole file, so it is kept apart from mapping it.
+// Accepts a mapped matrix pointer
+// Returns MATRIX_SUCCESS, or MATRIX_ERROR_FORMAT if the values don't match the checksum
+MatrixStatus verifyMappedMatrix(const MappedMatrix *mapped) {
+    if (mapped == NULL || mapped->mapping == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    const MatrixView *view = &mapped->view;
+    Checksum checksum;
+    startChecksum(&checksum);
+    updateChecksum(&checksum, view->block, (size_t)view->rows * view->cols * fileValueSize(view->data_type));
+    if (finishChecksum(&checksum) != mapped->checksum) {
+        printf("Error: Matrix file checksum does not match.\n");
+        return MATRIX_ERROR_FORMAT;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// Function to unmap a mapped matrix file
+// Accepts a mapped matrix pointer. Its view can't be used afterwards.
+// Does not return
+void unmapMatrixFile(MappedMatrix *mapped) {
+    if (mapped == NULL || mapped->mapping == NULL) {
+        return;
+    }
+    munmap(mapped->mapping, mapped->mappingSize);
+    memset(mapped, 0, sizeof(*mapped));
+}
+
+// Function to read a matrix file into a new matrix
+// The file is mapped and its checksum checked before its values are copied out.
+// Accepts the file path
+// Returns a packed matrix in the file's order, or an invalid matrix on error
+Matrix loadMatrixFile(const char *path) {
+    MappedMatrix mapped;
+    if (mapMatrixFile(path, &mapped) != MATRIX_SUCCESS) {
+        return invalidMatrix();
+    }
+    if (verifyMappedMatrix(&mapped) != MATRIX_SUCCESS) {
+        unmapMatrixFile(&mapped);
+        return invalidMatrix();
+    }
+    Matrix mat = copyMatrixView(&mapped.view);
+    unmapMatrixFile(&mapped);
+    return mat;
+}
@@ -0,0 +1,52 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Matrix files hold a 64 byte header followed by every value of the matrix, packed and in its storage order.
+// The values start MATRIX_FILE_ALIGNMENT bytes into the file, so a mapped file can be read in place.
+#define MATRIX_FILE_ALIGNMENT 64
+
+// Struct for a matrix file mapped into memory
+// 'view' looks straight at the values in the file. It is read only: writing through it (as a destination,
+// for example) crashes the program. Pages are read from disk the first time they are touched.
+typedef struct {
+    MatrixView view;
+    void *mapping;
+    size_t mappingSize;
+    uint64_t checksum;
+} MappedMatrix;
+
+// A matrix file being written a few values at a time
+typedef struct MatrixWriter MatrixWriter;
+
+// Write a matrix or a view to a file
+MatrixStatus saveMatrix(const char *path, const Matrix *mat);
+MatrixStatus saveMatrixView(const char *path, const MatrixView *view);
+
+// Write a matrix file in pieces: open it, write every value in order (int, double or char arrays), and close it
+MatrixWriter *openMatrixWriter(const char *path, int rows, int cols, DataType data_type, StorageOrder order);
+MatrixStatus writeMatrixValues(MatrixWriter *writer, const void *values, size_t count);
+MatrixStatus closeMatrixWriter(MatrixWriter *writer);
+
+// Map a matrix file into memory without reading it, and check its values against the header's checksum
+MatrixStatus mapMatrixFile(const char *path, MappedMatrix *mapped);
+MatrixStatus verifyMappedMatrix(const MappedMatrix *mapped);
+
+// Unmap a mapped matrix file
+void unmapMatrixFile(MappedMatrix *mapped);
+
+// Read a matrix file into a new matrix of its own
+Matrix loadMatrixFile(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef MATRIX_FIXED_H
+#define MATRIX_FIXED_H
+
+#include <math.h>
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed size square matrices of doubles, from FixedMatrix2 up to FixedMatrix8, for geometry and transforms.
+// They are plain structs that live on the stack (or inside other structs), with v[row][col] in row major order,
+// and every function here is inline in this header. Nothing allocates, nothing checks a data type, and because
+// the size is a constant each loop is unrolled completely and vectorized with whatever instruction set the
+// calling code is compiled for (SSE2 by default, AVX with -mavx2 or -march=native).
+//
+// For each size N there is:
+//   FixedMatrixN fixedIdentityN(void)
+//   FixedMatrixN fixedMultiplyN(const FixedMatrixN *a, const FixedMatrixN *b)
+//   FixedMatrixN fixedTransposeN(const FixedMatrixN *a)
+//   FixedMatrixN fixedRotateN(const FixedMatrixN *a, Rotation rotation)     (clockwise, like rotateMatrixBy)
+//   double fixedDeterminantN(const FixedMatrixN *a)
+//   int fixedInverseN(const FixedMatrixN *a, FixedMatrixN *inverse)        (0 and untouched if a is singular)
+
+// Force the generic bodies into each typed function, so the size is a constant where the loops are
+#if defined(__GNUC__)
+#define FIXED_INLINE static inline __attribute__((always_inline))
+#define FIXED_UNROLL _Pragma("GCC unroll 8")
+#else
+#define FIXED_INLINE static inline
+#define FIXED_UNROLL
+#endif
+
+// MARK - Generic bodies
+// These work on 'n' x 'n' row major arrays. Only the typed functions below call them, always with a constant 'n'.
+
+// Function to multiply two fixed matrices
+// Each row of the result is built as a sum of rows of b, so the innermost loop runs along contiguous rows
+FIXED_INLINE void fixedMultiplyValues(int n, double *out, const double *a, const double *b) {
+    FIXED_UNROLL
+    for (int i = 0; i < n; i++) {
+        FIXED_UNROLL
+        for (int j = 0; j < n; j++) {
+            out[i * n + j] = a[i * n] * b[j];
+        }
+        FIXED_UNROLL
+        for (int k = 1; k < n; k++) {
+            FIXED_UNROLL
+            for (int j = 0; j < n; j++) {
+                out[i * n + j] += a[i * n + k] * b[k * n + j];
+            }
+        }
+    }
+}
+
+// Function to rotate a fixed matrix clockwise by some quarter turns, or (with 'transposed') transpose it
+FIXED_INLINE void fixedRearrangeValues(int n, double *out, const double *a, Rotation rotation, int transposed) {
+    FIXED_UNROLL
+    for (int r = 0; r < n; r++) {
+        FIXED_UNROLL
+        for (int c = 0; c < n; c++) {
+            double value;
+            if (transposed) {
+                value = a[c * n + r];
+            } else if (rotation == ROTATE_90) {
+                value = a[(n - 1 - c) * n + r];
+            } else if (rotation == ROTATE_180) {
+                value = a[(n - 1 - r) * n + (n - 1 - c)];
+            } else {
+                value = a[c * n + (n - 1 - r)];
+            }
+            out[r * n + c] = value;
+        }
+    }
+}
+
+// Function to eliminate below the diagonal of a fixed matrix with partial pivoting
+// Accepts the size, and the matrix as the first 'n' columns of 'n' rows 'width' values long, with anything
+// to the right of it (the identity, for an inverse) getting the same row operations. Every row operation
+// runs over the whole width, so each one is a single loop of constant length.
+// Returns the determinant, which is 0 (with the rows part way through) if some column had no non-zero pivot
+FIXED_INLINE double fixedEliminateValues(int n, int width, double *m) {
+    double determinant = 1.0;
+    for (int k = 0; k < n; k++) {
+        int pivot = k;
+        double largest = fabs(m[k * width + k]);
+        for (int r = k + 1; r < n; r++) {
+            if (fabs(m[r * width + k]) > largest) {
+                largest = fabs(m[r * width + k]);
+                pivot = r;
+            }
+        }
+        if (largest == 0.0) {
+            return 0.0;
+        }
+        if (pivot != k) {
+            determinant = -determinant;
+            FIXED_UNROLL
+            for (int c = 0; c < width; c++) {
+                double swap = m[k * width + c];
+                m[k * width + c] = m[pivot * width + c];
+                m[pivot * width + c] = swap;
+            }
+        }
+        determinant *= m[k * width + k];
+        double scale = 1.0 / m[k * width + k];
+        for (int r = k + 1; r < n; r++) {
+            double factor = m[r * width + k] * scale;
+            FIXED_UNROLL
+            for (int c = 0; c < width; c++) {
+                m[r * width + c] -= factor * m[k * width + c];
+            }
+        }
+    }
+    return determinant;
+}
+
+// Function to invert a fixed matrix by Gauss-Jordan elimination of the matrix with the identity beside it
+// Returns 1, or 0 with 'out' untouched if the matrix is singular
+FIXED_INLINE int fixedInvertValues(int n, double *out, const double *a) {
+    double m[8 * 16];
+    int width = 2 * n;
+    FIXED_UNROLL
+    for (int r = 0; r < n; r++) {
+        FIXED_UNROLL
+        for (int c = 0; c < n; c++) {
+            m[r * width + c] = a[r * n + c];
+            m[r * width + n + c] = (r == c) ? 1.0 : 0.0;
+        }
+    }
+    if (fixedEliminateValues(n, width, m) == 0.0) {
+        return 0;
+    }
+
+    // Back substitution, a row of the inverse at a time from the bottom up
+    for (int k = n - 1; k >= 0; k--) {
+        double scale = 1.0 / m[k * width + k];
+        FIXED_UNROLL
+        for (int c = n; c < width; c++) {
+            m[k * width + c] *= scale;
+        }
+        for (int r = 0; r < k; r++) {
+            double factor = m[r * width + k];
+            FIXED_UNROLL
+            for (int c = n; c < width; c++) {
+                m[r * width + c] -= factor * m[k * width + c];
+            }
+        }
+    }
+    FIXED_UNROLL
+    for (int r = 0; r < n; r++) {
+        FIXED_UNROLL
+        for (int c = 0; c < n; c++) {
+            out[r * n + c] = m[r * width + n + c];
+        }
+    }
+    return 1;
+}
+
+// Function to find the determinant of a fixed matrix
+// 2x2, 3x3 and 4x4 use the closed forms; anything bigger is eliminated
+FIXED_INLINE double fixedDeterminantValues(int n, const double *a) {
+    if (n == 2) {
+        return a[0] * a[3] - a[1] * a[2];
+    }
+    if (n == 3) {
+        return a[0] * (a[4] * a[8] - a[5] * a[7]) - a[1] * (a[3] * a[8] - a[5] * a[6]) +
+               a[2] * (a[3] * a[7] - a[4] * a[6]);
+    }
+    if (n == 4) {
+        double s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[6] - a[4] * a[2], s2 = a[0] * a[7] - a[4] * a[3];
+        double s3 = a[1] * a[6] - a[5] * a[2], s4 = a[1] * a[7] - a[5] * a[3], s5 = a[2] * a[7] - a[6] * a[3];
+        double c5 = a[10] * a[15] - a[14] * a[11], c4 = a[9] * a[15] - a[13] * a[11];
+        double c3 = a[9] * a[14] - a[13] * a[10], c2 = a[8] * a[15] - a[12] * a[11];
+        double c1 = a[8] * a[14] - a[12] * a[10], c0 = a[8] * a[13] - a[12] * a[9];
+        return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    }
+    double m[8 * 8];
+    FIXED_UNROLL
+    for (int i = 0; i < n * n; i++) {
+        m[i] = a[i];
+    }
+    return fixedEliminateValues(n, n, m);
+}
+
+// Function to invert a fixed matrix
+// 2x2, 3x3 and 4x4 divide the adjugate by the determinant; anything bigger goes through Gauss-Jordan
+// Returns 1, or 0 with 'out' untouched if the matrix is singular
+FIXED_INLINE int fixedInverseValues(int n, double *out, const double *a) {
+    if (n == 2) {
+        double determinant = a[0] * a[3] - a[1] * a[2];
+        if (determinant == 0.0) {
+            return 0;
+        }
+        double scale = 1.0 / determinant;
+        double inverse[4] = {a[3] * scale, -a[1] * scale, -a[2] * scale, a[0] * scale};
+        for (int i = 0; i < 4; i++) {
+            out[i] = inverse[i];
+        }
+        return 1;
+    }
+    if (n == 3) {
+        double adjugate[9] = {
+            a[4] * a[8] - a[5] * a[7], a[2] * a[7] - a[1] * a[8], a[1] * a[5] - a[2] * a[4],
+            a[5] * a[6] - a[3] * a[8], a[0] * a[8] - a[2] * a[6], a[2] * a[3] - a[0] * a[5],
+            a[3] * a[7] - a[4] * a[6], a[1] * a[6] - a[0] * a[7], a[0] * a[4] - a[1] * a[3]
+        };
+        double determinant = a[0] * adjugate[0] + a[1] * adjugate[3] + a[2] * adjugate[6];
+        if (determinant == 0.0) {
+            return 0;
+        }
+        double scale = 1.0 / determinant;
+        for (int i = 0; i < 9; i++) {
+            out[i] = adjugate[i] * scale;
+        }
+        return 1;
+    }
+    if (n == 4) {
+        double s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[6] - a[4] * a[2], s2 = a[0] * a[7] - a[4] * a[3];
+        double s3 = a[1] * a[6] - a[5] * a[2], s4 = a[1] * a[7] - a[5] * a[3], s5 = a[2] * a[7] - a[6] * a[3];
+        double c5 = a[10] * a[15] - a[14] * a[11], c4 = a[9] * a[15] - a[13] * a[11];
+        double c3 = a[9] * a[14] - a[13] * a[10], c2 = a[8] * a[15] - a[12] * a[11];
+        double c1 = a[8] * a[14] - a[12] * a[10], c0 = a[8] * a[13] - a[12] * a[9];
+        double determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        if (determinant == 0.0) {
+            return 0;
+        }
+        double adjugate[16] = {
+            a[5] * c5 - a[6] * c4 + a[7] * c3, -a[1] * c5 + a[2] * c4 - a[3] * c3,
+            a[13] * s5 - a[14] * s4 + a[15] * s3, -a[9] * s5 + a[10] * s4 - a[11] * s3,
+            -a[4] * c5 + a[6] * c2 - a[7] * c1, a[0] * c5 - a[2] * c2 + a[3] * c1,
+            -a[12] * s5 + a[14] * s2 - a[15] * s1, a[8] * s5 - a[10] * s2 + a[11] * s1,
+            a[4] * c4 - a[5] * c2 + a[7] * c0, -a[0] * c4 + a[1] * c2 - a[3] * c0,
+            a[12] * s4 - a[13] * s2 + a[15] * s0, -a[8] * s4 + a[9] * s2 - a[11] * s0,
+            -a[4] * c3 + a[5] * c1 - a[6] * c0, a[0] * c3 - a[1] * c1 + a[2] * c0,
+            -a[12] * s3 + a[13] * s1 - a[14] * s0, a[8] * s3 - a[9] * s1 + a[10] * s0
+        };
+        double scale = 1.0 / determinant;
+        for (int i = 0; i < 16; i++) {
+            out[i] = adjugate[i] * scale;
+        }
+        return 1;
+    }
+    return fixedInvertValues(n, out, a);
+}
+
+// MARK - Typed matrices
+
+// Declare FixedMatrixN and its functions for one size
+#define DEFINE_FIXED_MATRIX(N)                                                                    \
+    typedef struct {                                                                              \
+        double v[N][N];                                                                           \
+    } FixedMatrix##N;                                                                             \
+                                                                                                  \
+    static inline FixedMatrix##N fixedIdentity##N(void) {                                         \
+        FixedMatrix##N result = {{{0}}};                                                          \
+        for (int i = 0; i < N; i++) {                                                             \
+            result.v[i][i] = 1.0;                                                                 \
+        }                                                                                         \
+        return result;                                                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline FixedMatrix##N fixedMultiply##N(const FixedMatrix##N *a, const FixedMatrix##N *b) { \
+        FixedMatrix##N result;                                                                    \
+        fixedMultiplyValues(N, (double *)&result, (const double *)a, (const double *)b);                        \
+        return result;                                                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline FixedMatrix##N fixedTranspose##N(const FixedMatrix##N *a) {                     \
+        FixedMatrix##N result;                                                                    \
+        fixedRearrangeValues(N, (double *)&result, (const double *)a, ROTATE_90, 1);                      \
+        return result;                                                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline FixedMatrix##N fixedRotate##N(const FixedMatrix##N *a, Rotation rotation) {     \
+        FixedMatrix##N result;                                                                    \
+        fixedRearrangeValues(N, (double *)&result, (const double *)a, rotation, 0);                       \
+        return result;                                                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline double fixedDeterminant##N(const FixedMatrix##N *a) {                           \
+        return fixedDeterminantValues(N, (const double *)a);                                            \
+    }                                                                                             \
+                                                                                                  \
+    static inline int fixedInverse##N(const FixedMatrix##N *a, FixedMatrix##N *inverse) {         \
+        return fixedInverseValues(N, (double *)inverse, (const double *)a);                             \
+    }
+
+DEFINE_FIXED_MATRIX(2)
+DEFINE_FIXED_MATRIX(3)
+DEFINE_FIXED_MATRIX(4)
+DEFINE_FIXED_MATRIX(5)
+DEFINE_FIXED_MATRIX(6)
+DEFINE_FIXED_MATRIX(7)
+DEFINE_FIXED_MATRIX(8)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
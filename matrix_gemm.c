@@ -0,0 +1,383 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_internal.h"
+
+// MARK - Blocked GEMM
+// C = alpha * A * B + beta * C is worked out one block at a time so every operand is read from the closest cache that can hold it:
+//  * a GEMM_KC x GEMM_NC panel of B is packed once and stays in L3
+//  * a GEMM_MC x GEMM_KC block of A is packed once per B panel and stays in L2
+//  * a GEMM_KC x GEMM_NR sliver of that B panel stays in L1 while the microkernel sweeps A over it
+// Packing copies each block into the exact order the microkernel reads it, so however A and B are laid out
+// (either order, either storage type, or a view with gaps) the microkernel only ever sees contiguous memory.
+// The microkernel keeps a GEMM_MR x GEMM_NR tile of C in registers for the whole depth of the block.
+// Alpha is folded into the packing of A and beta into the first time each tile is written back to C,
+// so neither of them costs an extra pass over memory.
+// Microkernels come from the kernel table, so they use the best instruction set the CPU has.
+
+// Cache blocks, chosen for 8 byte doubles (ints use the same sizes and simply take half the room).
+// A KC x NR sliver of B is 8KB (L1), an MC x KC block of A is 192KB (L2), a KC x NC panel of B is 4MB (L3).
+#define GEMM_KC 256
+#define GEMM_MC 96
+#define GEMM_NC 2048
+
+// Smallest of two ints
+static int minInt(int a, int b) {
+    return (a < b) ? a : b;
+}
+
+// Round up to a whole number of 'unit's
+static int roundUp(int value, int unit) {
+    return ((value + unit - 1) / unit) * unit;
+}
+
+// Scratch space for one thread's share of a multiplication: one block of A and one panel of B
+typedef struct {
+    void *aPack;
+    void *bPack;
+} PackBuffers;
+
+// Bytes of A block and B panel packing needed for an m x n share of C with a shared dimension of p
+static void packBufferSizes(int m, int n, int p, size_t valueSize, size_t *aSize, size_t *bSize) {
+    int kcMax = minInt(GEMM_KC, p);
+    int mcMax = roundUp(minInt(GEMM_MC, m), GEMM_MR);
+    int ncMax = roundUp(minInt(GEMM_NC, n), GEMM_NR);
+    *aSize = (size_t)mcMax * kcMax * valueSize;
+    *bSize = (size_t)kcMax * ncMax * valueSize;
+}
+
+// A set of packing buffers, one per slab, kept between multiplications
+typedef struct {
+    PackBuffers *buffers;
+    int count;
+    size_t aSize, bSize;
+} PackSet;
+
+// Free a set of packing buffers, including ones that were only partly allocated
+static void freePackSet(PackSet *set) {
+    if (set->buffers != NULL) {
+        for (int i = 0; i < set->count; i++) {
+            alignedFree(set->buffers[i].aPack);
+            alignedFree(set->buffers[i].bPack);
+        }
+        free(set->buffers);
+    }
+    set->buffers = NULL;
+    set->count = 0;
+}
+
+// Allocate a set of 'count' packing buffers of the given sizes
+// Returns 1 on success and 0 if any allocation failed, in which case the set is left empty
+static int allocatePackSet(PackSet *set, int count, size_t aSize, size_t bSize) {
+    set->buffers = (PackBuffers *)calloc((size_t)count, sizeof(PackBuffers));
+    set->count = count;
+    set->aSize = aSize;
+    set->bSize = bSize;
+    if (set->buffers == NULL) {
+        set->count = 0;
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        set->buffers[i].aPack = alignedCalloc(aSize);
+        set->buffers[i].bPack = alignedCalloc(bSize);
+        if (set->buffers[i].aPack == NULL || set->buffers[i].bPack == NULL) {
+            freePackSet(set);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// The packing buffers of the last multiplication, waiting to be reused by the next one.
+// Repeated multiplications of the same shape (the usual case in an iterative loop) then allocate nothing.
+// Only one set is kept, so the most memory this holds on to is what the largest recent multiplication needed.
+static pthread_mutex_t spareLock = PTHREAD_MUTEX_INITIALIZER;
+static PackSet spareSet = {NULL, 0, 0, 0};
+
+// Get a set of at least 'count' packing buffers of at least the given sizes, reusing the spare set if it fits
+// Returns 1 on success and 0 if a new set was needed and couldn't be allocated
+static int takePackSet(PackSet *set, int count, size_t aSize, size_t bSize) {
+    pthread_mutex_lock(&spareLock);
+    *set = spareSet;
+    int fits = set->buffers != NULL && set->count >= count && set->aSize >= aSize && set->bSize >= bSize;
+    if (fits) {
+        spareSet.buffers = NULL;
+        spareSet.count = 0;
+    }
+    pthread_mutex_unlock(&spareLock);
+    return fits || allocatePackSet(set, count, aSize, bSize);
+}
+
+// Hand a set of packing buffers back to be reused, freeing whichever of it and the old spare is smaller
+static void givePackSet(PackSet *set) {
+    pthread_mutex_lock(&spareLock);
+    PackSet smaller = *set;
+    if (spareSet.buffers == NULL || (size_t)spareSet.count * (spareSet.aSize + spareSet.bSize) <
+                                        (size_t)set->count * (set->aSize + set->bSize)) {
+        smaller = spareSet;
+        spareSet = *set;
+    }
+    pthread_mutex_unlock(&spareLock);
+    freePackSet(&smaller);
+}
+
+// MARK - Doubles
+
+// Pack an mc x kc block of A, scaled by alpha, into slivers of GEMM_MR rows.
+// Each sliver holds its column 0, then its column 1 and so on, and a short last sliver is padded with zeros.
+static void packADoubles(double *pack, const double *a, size_t aRow, size_t aCol, int mc, int kc, double alpha) {
+    for (int i = 0; i < mc; i += GEMM_MR) {
+        int mr = minInt(GEMM_MR, mc - i);
+        for (int k = 0; k < kc; k++) {
+            for (int r = 0; r < mr; r++) {
+                pack[r] = alpha * a[(i + r) * aRow + k * aCol];
+            }
+            for (int r = mr; r < GEMM_MR; r++) {
+                pack[r] = 0.0;
+            }
+            pack += GEMM_MR;
+        }
+    }
+}
+
+// Pack a kc x nc panel of B into slivers of GEMM_NR columns.
+// Each sliver holds its row 0, then its row 1 and so on, and a short last sliver is padded with zeros.
+static void packBDoubles(double *pack, const double *b, size_t bRow, size_t bCol, int kc, int nc) {
+    for (int j = 0; j < nc; j += GEMM_NR) {
+        int nr = minInt(GEMM_NR, nc - j);
+        for (int k = 0; k < kc; k++) {
+            for (int c = 0; c < nr; c++) {
+                pack[c] = b[k * bRow + (j + c) * bCol];
+            }
+            for (int c = nr; c < GEMM_NR; c++) {
+                pack[c] = 0.0;
+            }
+            pack += GEMM_NR;
+        }
+    }
+}
+
+// Write an mr x nr tile into C as C = beta * C + tile, leaving out the zero padding of short slivers.
+// A beta of 0 overwrites C without reading it, the way BLAS does, so whatever C held before can't leak through.
+static void storeDoubles(double *cTile, const MultiplyStrides *st, const double *tile, int mr, int nr, double beta) {
+    for (int col = 0; col < nr; col++) {
+        for (int r = 0; r < mr; r++) {
+            double *value = &cTile[r * st->cRow + col * st->cCol];
+            if (beta == 1.0) {
+                *value += tile[col * GEMM_MR + r];
+            } else if (beta == 0.0) {
+                *value = tile[col * GEMM_MR + r];
+            } else {
+                *value = beta * *value + tile[col * GEMM_MR + r];
+            }
+        }
+    }
+}
+
+// Blocked GEMM for doubles on this thread, using one set of packing buffers
+static void blockedDoubles(double *c, const double *a, const double *b, const MultiplyStrides *st, int m, int n, int p,
+                           double alpha, double beta, const PackBuffers *buffers) {
+    double *aPack = (double *)buffers->aPack;
+    double *bPack = (double *)buffers->bPack;
+    const MatrixKernels *kernels = matrixKernels();
+    double tile[GEMM_MR * GEMM_NR];
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = minInt(GEMM_NC, n - jc);
+        for (int pc = 0; pc < p; pc += GEMM_KC) {
+            int kc = minInt(GEMM_KC, p - pc);
+            packBDoubles(bPack, b + pc * st->bRow + jc * st->bCol, st->bRow, st->bCol, kc, nc);
+
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = minInt(GEMM_MC, m - ic);
+                packADoubles(aPack, a + ic * st->aRow + pc * st->aCol, st->aRow, st->aCol, mc, kc, alpha);
+
+                for (int jr = 0; jr < nc; jr += GEMM_NR) {
+                    int nr = minInt(GEMM_NR, nc - jr);
+                    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                        int mr = minInt(GEMM_MR, mc - ir);
+                        kernels->gemmKernelDoubles(kc, aPack + (size_t)ir * kc, bPack + (size_t)jr * kc, tile);
+
+                        // Add the tile into C, scaling C by beta the first time round
+                        storeDoubles(c + (ic + ir) * st->cRow + (jc + jr) * st->cCol, st, tile, mr, nr,
+                                     (pc == 0) ? beta : 1.0);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// MARK - Ints
+
+// Pack an mc x kc block of A, scaled by alpha, into slivers of GEMM_MR rows, the same way as packADoubles
+static void packAInts(int *pack, const int *a, size_t aRow, size_t aCol, int mc, int kc, int alpha) {
+    for (int i = 0; i < mc; i += GEMM_MR) {
+        int mr = minInt(GEMM_MR, mc - i);
+        for (int k = 0; k < kc; k++) {
+            for (int r = 0; r < mr; r++) {
+                pack[r] = alpha * a[(i + r) * aRow + k * aCol];
+            }
+            for (int r = mr; r < GEMM_MR; r++) {
+                pack[r] = 0;
+            }
+            pack += GEMM_MR;
+        }
+    }
+}
+
+// Pack a kc x nc panel of B into slivers of GEMM_NR columns, the same way as packBDoubles
+static void packBInts(int *pack, const int *b, size_t bRow, size_t bCol, int kc, int nc) {
+    for (int j = 0; j < nc; j += GEMM_NR) {
+        int nr = minInt(GEMM_NR, nc - j);
+        for (int k = 0; k < kc; k++) {
+            for (int c = 0; c < nr; c++) {
+                pack[c] = b[k * bRow + (j + c) * bCol];
+            }
+            for (int c = nr; c < GEMM_NR; c++) {
+                pack[c] = 0;
+            }
+            pack += GEMM_NR;
+        }
+    }
+}
+
+// Write an mr x nr tile into C as C = beta * C + tile, the same way as storeDoubles
+static void storeInts(int *cTile, const MultiplyStrides *st, const int *tile, int mr, int nr, int beta) {
+    for (int col = 0; col < nr; col++) {
+        for (int r = 0; r < mr; r++) {
+            int *value = &cTile[r * st->cRow + col * st->cCol];
+            if (beta == 1) {
+                *value += tile[col * GEMM_MR + r];
+            } else if (beta == 0) {
+                *value = tile[col * GEMM_MR + r];
+            } else {
+                *value = beta * *value + tile[col * GEMM_MR + r];
+            }
+        }
+    }
+}
+
+// Blocked GEMM for ints on this thread, using one set of packing buffers
+static void blockedInts(int *c, const int *a, const int *b, const MultiplyStrides *st, int m, int n, int p,
+                        int alpha, int beta, const PackBuffers *buffers) {
+    int *aPack = (int *)buffers->aPack;
+    int *bPack = (int *)buffers->bPack;
+    const MatrixKernels *kernels = matrixKernels();
+    int tile[GEMM_MR * GEMM_NR];
+    for (int jc = 0; jc < n; jc += GEMM_NC) {
+        int nc = minInt(GEMM_NC, n - jc);
+        for (int pc = 0; pc < p; pc += GEMM_KC) {
+            int kc = minInt(GEMM_KC, p - pc);
+            packBInts(bPack, b + pc * st->bRow + jc * st->bCol, st->bRow, st->bCol, kc, nc);
+
+            for (int ic = 0; ic < m; ic += GEMM_MC) {
+                int mc = minInt(GEMM_MC, m - ic);
+                packAInts(aPack, a + ic * st->aRow + pc * st->aCol, st->aRow, st->aCol, mc, kc, alpha);
+
+                for (int jr = 0; jr < nc; jr += GEMM_NR) {
+                    int nr = minInt(GEMM_NR, nc - jr);
+                    for (int ir = 0; ir < mc; ir += GEMM_MR) {
+                        int mr = minInt(GEMM_MR, mc - ir);
+                        kernels->gemmKernelInts(kc, aPack + (size_t)ir * kc, bPack + (size_t)jr * kc, tile);
+
+                        // Add the tile into C, scaling C by beta the first time round
+                        storeInts(c + (ic + ir) * st->cRow + (jc + jr) * st->cCol, st, tile, mr, nr,
+                                  (pc == 0) ? beta : 1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// MARK - Threading
+// The threads split C into slabs along its longer side, GEMM_MR rows or GEMM_NR columns at a time,
+// and each one runs the whole blocked algorithm on its own slab with its own packing buffers.
+// A slab only needs the matching rows of A (or columns of B), and the slabs of C never overlap.
+
+// One multiplication shared between threads
+typedef struct {
+    DataType data_type;
+    void *c;
+    const void *a;
+    const void *b;
+    const MultiplyStrides *st;
+    int m, n, p;
+    double alpha, beta;
+    int splitRows;
+    int unit;
+    PackBuffers *buffers;
+} GemmJob;
+
+// Multiply one slab of C, from slab unit 'start' up to 'end'
+static void gemmRange(void *context, int task, size_t start, size_t end) {
+    const GemmJob *job = (const GemmJob *)context;
+    const MultiplyStrides *st = job->st;
+    int length = job->splitRows ? job->m : job->n;
+    int first = (int)start * job->unit;
+    int count = minInt((int)end * job->unit, length) - first;
+    if (count <= 0) {
+        return;
+    }
+
+    // Offsets of the slab into C, and into whichever of A or B it depends on
+    size_t cOffset = (size_t)first * (job->splitRows ? st->cRow : st->cCol);
+    size_t aOffset = job->splitRows ? (size_t)first * st->aRow : 0;
+    size_t bOffset = job->splitRows ? 0 : (size_t)first * st->bCol;
+    int m = job->splitRows ? count : job->m;
+    int n = job->splitRows ? job->n : count;
+
+    if (job->data_type == DOUBLE) {
+        blockedDoubles((double *)job->c + cOffset, (const double *)job->a + aOffset, (const double *)job->b + bOffset,
+                       st, m, n, job->p, job->alpha, job->beta, &job->buffers[task]);
+    } else {
+        blockedInts((int *)job->c + cOffset, (const int *)job->a + aOffset, (const int *)job->b + bOffset,
+                    st, m, n, job->p, (int)job->alpha, (int)job->beta, &job->buffers[task]);
+    }
+}
+
+// Shared body of gemmInts and gemmDoubles
+static int gemm(DataType data_type, void *c, const void *a, const void *b, const MultiplyStrides *st,
+                int m, int n, int p, double alpha, double beta) {
+    if (m <= 0 || n <= 0 || p <= 0) {
+        return 1;
+    }
+    GemmJob job = {data_type, c, a, b, st, m, n, p, alpha, beta, m >= n, (m >= n) ? GEMM_MR : GEMM_NR, NULL};
+
+    // Count the slab in register tiles, and give every thread at least PARALLEL_MIN_VOLUME multiply-adds
+    int length = job.splitRows ? m : n;
+    size_t units = (size_t)(length + job.unit - 1) / job.unit;
+    size_t unitVolume = (size_t)job.unit * (size_t)(job.splitRows ? n : m) * (size_t)p;
+    size_t grain = (PARALLEL_MIN_VOLUME + unitVolume - 1) / unitVolume;
+    int ranges = parallelRangeCount(units, grain);
+
+    // Every slab gets its own packing buffers, all found up front so a failure leaves C untouched
+    int slabLength = minInt((int)((units + ranges - 1) / ranges) * job.unit, length);
+    size_t valueSize = (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+    size_t aSize, bSize;
+    packBufferSizes(job.splitRows ? slabLength : m, job.splitRows ? n : slabLength, p, valueSize, &aSize, &bSize);
+    PackSet set;
+    if (!takePackSet(&set, ranges, aSize, bSize)) {
+        return 0;
+    }
+    job.buffers = set.buffers;
+    parallelRange(units, ranges, gemmRange, &job);
+    givePackSet(&set);
+    return 1;
+}
+
+// Blocked GEMM for doubles
+// Accepts the result, both operands, their strides, the dimensions and the scales
+// Returns 1 on success and 0 if the packing buffers couldn't be allocated
+int gemmDoubles(double *c, const double *a, const double *b, const MultiplyStrides *st, int m, int n, int p,
+                double alpha, double beta) {
+    return gemm(DOUBLE, c, a, b, st, m, n, p, alpha, beta);
+}
+
+// Blocked GEMM for ints
+// Accepts the result, both operands, their strides, the dimensions and the (whole number) scales
+// Returns 1 on success and 0 if the packing buffers couldn't be allocated
+int gemmInts(int *c, const int *a, const int *b, const MultiplyStrides *st, int m, int n, int p,
+             int alpha, int beta) {
+    return gemm(INT, c, a, b, st, m, n, p, alpha, beta);
+}
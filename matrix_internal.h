@@ -0,0 +1,136 @@
+#ifndef MATRIX_INTERNAL_H
+#define MATRIX_INTERNAL_H
+
+// Shared pieces of the library's translation units. This header is not part of the public API.
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Alignment of every matrix element block and scratch buffer, in bytes.
+// One cache line, which is also wide enough for any SIMD load we might want to do.
+#define MATRIX_ALIGNMENT 64
+
+// Allocate a zero-filled block of memory aligned to MATRIX_ALIGNMENT, and free it again.
+// alignedCalloc always uses the system allocator and is meant for scratch space, while matrixBlockCalloc uses the
+// allocator installed on this thread. alignedFree works for both, and returns a block to wherever it came from.
+void *alignedCalloc(size_t size);
+void *matrixBlockCalloc(size_t size);
+void alignedFree(void *ptr);
+
+// Address of the first value of a view, and the strides between neighbouring rows and columns of it,
+// counted in native values (so INT element storage steps by 2 ints per element)
+void *viewValues(const MatrixView *view);
+void viewValueStrides(const MatrixView *view, size_t *rowStride, size_t *colStride);
+
+// Strides of the three matricies of a multiplication, counted in native values
+typedef struct {
+    size_t aRow, aCol;
+    size_t bRow, bCol;
+    size_t cRow, cCol;
+} MultiplyStrides;
+
+// Register tile of the GEMM microkernels, in rows of A by columns of B.
+// Each step of a microkernel reads GEMM_MR values of A and GEMM_NR values of B
+// and does GEMM_MR * GEMM_NR multiply-adds with them.
+#define GEMM_MR 8
+#define GEMM_NR 4
+
+// Below this many multiply-adds (m * n * p) the cost of packing outweighs what blocking saves,
+// so multiplication uses plain loops instead of the blocked GEMM
+#define GEMM_MIN_VOLUME ((size_t)64 * 64 * 64)
+
+// Whether a double scale can be applied to INT values: a whole number in int range, so converting it is defined
+int isIntScale(double scale);
+
+// Blocked GEMM, C = alpha * A * B + beta * C, where A is m x p, B is p x n and C is m x n (none of them empty).
+// Any strides work, so views, either storage type and either storage order can be passed straight in.
+// A beta of 0 overwrites C without reading it.
+// Returns 1 on success and 0 if the packing buffers couldn't be allocated, in which case C is untouched
+int gemmInts(int *c, const int *a, const int *b, const MultiplyStrides *st, int m, int n, int p, int alpha, int beta);
+int gemmDoubles(double *c, const double *a, const double *b, const MultiplyStrides *st, int m, int n, int p,
+                double alpha, double beta);
+
+// Below these sizes work stays on the calling thread, because waking the thread pool would cost more than it saves.
+// Element-wise work is counted in values and multiplication in multiply-adds.
+#define PARALLEL_MIN_VALUES ((size_t)1 << 16)
+#define PARALLEL_MIN_VOLUME ((size_t)128 * 128 * 128)
+
+// Run body(context, task) for every task from 0 to tasks - 1 on the thread pool, and wait for them all
+void parallelFor(int tasks, void (*body)(void *context, int task), void *context);
+
+// Split [0, count) into contiguous ranges and run body on each of them on the thread pool.
+// parallelRangeCount picks how many ranges to use: at most one per thread, and none shorter than 'grain'.
+// Ranges are numbered from 0, so callers can hand each one its own scratch space.
+int parallelRangeCount(size_t count, size_t grain);
+void parallelRange(size_t count, int ranges, void (*body)(void *context, int task, size_t start, size_t end),
+                   void *context);
+
+// Matrices a batch multiplication works on at once, one per SIMD lane (a whole AVX-512 register of doubles)
+#define BATCH_LANES 8
+
+// What a summing kernel adds up for each value: the value itself, its magnitude or its square
+typedef enum {
+    SUM_TERMS_VALUES,
+    SUM_TERMS_MAGNITUDES,
+    SUM_TERMS_SQUARES
+} SumTerms;
+
+// A running sum, which is 'total + error' when it is compensated. Plain sums leave 'error' at 0.
+typedef struct {
+    double total;
+    double error;
+} CompensatedSum;
+
+// The arithmetic kernels for one instruction set
+// Ints are spaced 'step' apart (1 when packed, 2 inside MatrixElements) and all three runs share that step.
+// Doubles are always contiguous. The GEMM microkernels multiply a packed GEMM_MR sliver of A by a packed
+// GEMM_NR sliver of B 'kc' deep, and write the GEMM_MR x GEMM_NR result tile column by column.
+// The transpose kernels write out[r * outStride + c] = in[c * inStride + r] for every r < rows and c < cols,
+// turning the contiguous runs of 'in' into the lines of 'out'. Either stride may be negative.
+// The batch multiply kernels multiply BATCH_LANES m x p matrices by as many p x n ones at once, all interleaved:
+// value (i, j) of the matrix in lane l is at [(i * cols + j) * BATCH_LANES + l], so each lane is one SIMD lane.
+// The matrix-vector kernels read a matrix whose lines start 'lda' values apart and are contiguous along them.
+// gemvRows works along the lines, y[r] = alpha * (line r . x) + beta * y[r] for r < rows, reading 'count' values of
+// x, where a beta of 0 overwrites y without reading it. gemvColumns works across them, y[i] += line j [i] * x[j] for
+// every j < cols and i < count. x and y can't overlap the matrix.
+// The reduction kernels work in doubles whatever they read, and take a step for doubles too so that a diagonal can
+// be summed. sum adds the terms of 'count' values into 'sum', and extreme returns the position of the first largest
+// (or smallest) value or magnitude. The across kernels take one line of a matrix and fold value i of it into
+// totals[i] (and errors[i] when compensating), or into best[i], setting index[i] to 'line' whenever it wins.
+typedef struct {
+    InstructionSet isa;
+    void (*combineInts)(int *out, const int *a, const int *b, size_t count, size_t step, int subtract);
+    void (*combineDoubles)(double *out, const double *a, const double *b, size_t count, int subtract);
+    int (*equalInts)(const int *a, const int *b, size_t count, size_t step);
+    int (*equalDoubles)(const double *a, const double *b, size_t count);
+    void (*gemmKernelInts)(int kc, const int *a, const int *b, int *tile);
+    void (*gemmKernelDoubles)(int kc, const double *a, const double *b, double *tile);
+    void (*transposeInts)(int *out, ptrdiff_t outStride, const int *in, ptrdiff_t inStride, int rows, int cols);
+    void (*transposeDoubles)(double *out, ptrdiff_t outStride, const double *in, ptrdiff_t inStride, int rows,
+                             int cols);
+    void (*batchMultiplyInts)(int *c, const int *a, const int *b, int m, int n, int p);
+    void (*batchMultiplyDoubles)(double *c, const double *a, const double *b, int m, int n, int p);
+    void (*gemvRowsInts)(int *y, const int *a, size_t lda, const int *x, int rows, size_t count, int alpha, int beta);
+    void (*gemvRowsDoubles)(double *y, const double *a, size_t lda, const double *x, int rows, size_t count,
+                            double alpha, double beta);
+    void (*gemvColumnsInts)(int *y, const int *a, size_t lda, const int *x, int cols, size_t count);
+    void (*gemvColumnsDoubles)(double *y, const double *a, size_t lda, const double *x, int cols, size_t count);
+    void (*sumInts)(const int *a, size_t count, size_t step, SumTerms terms, int compensated, CompensatedSum *sum);
+    void (*sumDoubles)(const double *a, size_t count, size_t step, SumTerms terms, int compensated,
+                       CompensatedSum *sum);
+    size_t (*extremeInts)(const int *a, size_t count, size_t step, int largest, int magnitudes);
+    size_t (*extremeDoubles)(const double *a, size_t count, size_t step, int largest, int magnitudes);
+    void (*sumAcrossInts)(double *totals, double *errors, const int *a, size_t count, size_t step, SumTerms terms,
+                          int compensated);
+    void (*sumAcrossDoubles)(double *totals, double *errors, const double *a, size_t count, size_t step,
+                             SumTerms terms, int compensated);
+    void (*extremeAcrossInts)(double *best, size_t *index, const int *a, size_t count, size_t step, size_t line,
+                              int largest, int magnitudes);
+    void (*extremeAcrossDoubles)(double *best, size_t *index, const double *a, size_t count, size_t step,
+                                 size_t line, int largest, int magnitudes);
+} MatrixKernels;
+
+// The kernels in use, picked from the CPU (or MATRIX_ISA) the first time they are needed
+const MatrixKernels *matrixKernels(void);
+
+#endif
@@ -0,0 +1,488 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_lu.h"
+
+// MARK - LU factorization
+// The factorization is blocked and right-looking, like LAPACK's getrf. The matrix is copied into a packed row major
+// buffer and worked through LU_BLOCK columns at a time:
+//  * the panel of those columns, from the diagonal down, is factorized by splitting it in half recursively, picking
+//    the largest value left in each column as its pivot and swapping whole rows to bring it up
+//  * the block row to the right of the panel is solved with the panel's unit lower triangle, which makes it part of U
+//  * the rest of the matrix has the product of the panel and that block row taken off it, with the blocked GEMM
+// Nearly all of the work is in the last step, so a factorization runs at close to the speed of multiplication.
+// Solving goes the same way: the rows of the right hand sides are swapped to match, then they are worked out a
+// block at a time, each block taking the blocks already solved off with the GEMM before solving its own triangle.
+
+// Columns in each panel, which is also the depth of every trailing GEMM update
+#define LU_BLOCK 128
+
+// Panels are split in half until they are this narrow, and then factorized a column at a time
+#define LU_PANEL 16
+
+// Smallest of two ints
+static int minInt(int a, int b) {
+    return (a < b) ? a : b;
+}
+
+// The factorization returned in error states, which has no values
+static MatrixLU invalidLU(void) {
+    MatrixLU lu = {0, NULL, NULL, 0, 0};
+    return lu;
+}
+
+// View the values of a packed row major buffer as a matrix
+static MatrixView packedRowsView(double *values, int rows, int cols) {
+    MatrixView view;
+    view.rows = rows;
+    view.cols = cols;
+    view.data_type = DOUBLE;
+    view.storage = PACKED_STORAGE;
+    view.order = ROW_MAJOR;
+    view.block = values;
+    view.offset = 0;
+    view.ld = cols;
+    return view;
+}
+
+// Copy a view into a packed row major buffer with the same shape, whichever way the view is stored.
+// Transposing the transpose of a view copies it, and the transpose walks storage orders a tile at a time.
+static void copyViewToRows(double *values, const MatrixView *view) {
+    MatrixView rows = packedRowsView(values, view->rows, view->cols);
+    MatrixView transposed = transposeMatrixView(view);
+    transposeViewInto(&rows, &transposed);
+}
+
+// Copy a packed row major buffer into a view with the same shape
+static void copyRowsToView(const MatrixView *view, double *values) {
+    MatrixView rows = packedRowsView(values, view->rows, view->cols);
+    MatrixView transposed = transposeMatrixView(&rows);
+    transposeViewInto(view, &transposed);
+}
+
+// Swap two rows of 'count' doubles
+static void swapRows(double *restrict row1, double *restrict row2, int count) {
+    for (int c = 0; c < count; c++) {
+        double value = row1[c];
+        row1[c] = row2[c];
+        row2[c] = value;
+    }
+}
+
+// MARK - Triangles
+
+// A triangular solve with one diagonal block of a factorization, over a block of rows of right hand sides.
+// 'a' is the top left of the block and 'x' the first of its rows, and both have their rows a stride apart.
+// The lower triangle has a unit diagonal and the upper one divides by its own. Threads share out the columns of x.
+typedef struct {
+    const double *a;
+    size_t aStride;
+    double *x;
+    size_t xStride;
+    int rows;
+    int upper;
+} TriangleJob;
+
+// Solve columns 'start' up to 'end' of a triangle job.
+// Each row takes its multiples of the rows already solved off with one gemvColumns call, which reads those rows
+// four at a time with the best instruction set the CPU has.
+static void solveTriangleRange(void *context, int task, size_t start, size_t end) {
+    const TriangleJob *job = (const TriangleJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    (void)task;
+    double factors[LU_BLOCK];
+    size_t count = end - start;
+    for (int step = 0; step < job->rows; step++) {
+        int i = job->upper ? job->rows - 1 - step : step;
+        double *row = job->x + (size_t)i * job->xStride + start;
+        const double *coefficients = job->a + (size_t)i * job->aStride;
+
+        // Lower rows depend on the rows above them, upper rows on the rows below
+        int first = job->upper ? i + 1 : 0;
+        int solved = job->upper ? job->rows - i - 1 : i;
+        for (int p = 0; p < solved; p++) {
+            factors[p] = -coefficients[first + p];
+        }
+        kernels->gemvColumnsDoubles(row, job->x + (size_t)first * job->xStride + start, job->xStride, factors, solved,
+                                    count);
+        if (job->upper) {
+            double diagonal = coefficients[i];
+            for (size_t c = 0; c < count; c++) {
+                row[c] /= diagonal;
+            }
+        }
+    }
+}
+
+// Solve a block of 'rows' rows and 'cols' columns of right hand sides with a diagonal block of a factorization
+static void solveTriangle(const double *a, size_t aStride, double *x, size_t xStride, int rows, int cols, int upper) {
+    TriangleJob job = {a, aStride, x, xStride, rows, upper};
+    size_t grain = PARALLEL_MIN_VALUES / ((size_t)rows * rows / 2 + 1) + 1;
+    parallelRange((size_t)cols, parallelRangeCount((size_t)cols, grain), solveTriangleRange, &job);
+}
+
+// MARK - Factorizing
+
+// Factorize the 'width' columns from column k, from the diagonal down, one column at a time.
+// Pivot rows are swapped across the whole matrix, so the rows of L to the left move with them the way they would
+// if they had been swapped from the start, and the columns to the right are ready for the block row solve.
+static void factorColumns(MatrixLU *lu, int k, int width) {
+    int n = lu->n;
+    double *a = lu->values;
+    for (int j = k; j < k + width; j++) {
+        // The largest magnitude left in the column is the pivot, which keeps every multiplier at most 1
+        int pivot = j;
+        double largest = fabs(a[(size_t)j * n + j]);
+        for (int i = j + 1; i < n; i++) {
+            double magnitude = fabs(a[(size_t)i * n + j]);
+            if (magnitude > largest) {
+                largest = magnitude;
+                pivot = i;
+            }
+        }
+        lu->pivots[j] = pivot;
+        if (pivot != j) {
+            swapRows(a + (size_t)j * n, a + (size_t)pivot * n, n);
+            lu->swaps++;
+        }
+
+        // A zero pivot leaves nothing to divide by, but the rest of the factorization still goes ahead
+        const double *pivotRow = a + (size_t)j * n;
+        double diagonal = pivotRow[j];
+        if (diagonal == 0.0) {
+            lu->singular = 1;
+            continue;
+        }
+
+        // Work out the multipliers of L and take each one's multiple of the pivot row off the rest of the columns
+        for (int i = j + 1; i < n; i++) {
+            double *row = a + (size_t)i * n;
+            double multiplier = row[j] / diagonal;
+            row[j] = multiplier;
+            for (int c = j + 1; c < k + width; c++) {
+                row[c] -= multiplier * pivotRow[c];
+            }
+        }
+    }
+}
+
+// Factorize the 'width' columns from column k, from the diagonal down, like one step of the blocked factorization.
+// The columns are split in half: the left half is factorized, the right half is updated with it (a triangle solve
+// and a GEMM), and then the right half is factorized. Halving again down to LU_PANEL columns puts most of the
+// panel's work into the GEMM as well, rather than into a column at a time walk down every row.
+// Returns 1 on success and 0 if the GEMM packing buffers couldn't be allocated
+static int factorPanel(MatrixLU *lu, int k, int width) {
+    if (width <= LU_PANEL) {
+        factorColumns(lu, k, width);
+        return 1;
+    }
+    int n = lu->n;
+    int left = width / 2;
+    int right = width - left;
+    MultiplyStrides strides = {(size_t)n, 1, (size_t)n, 1, (size_t)n, 1};
+    double *diagonal = lu->values + (size_t)k * n + k;
+    if (!factorPanel(lu, k, left)) {
+        return 0;
+    }
+    solveTriangle(diagonal, (size_t)n, diagonal + left, (size_t)n, left, right, 0);
+    if (n - k - left > 0 && !gemmDoubles(diagonal + (size_t)left * n + left, diagonal + (size_t)left * n,
+                                         diagonal + left, &strides, n - k - left, right, left, -1.0, 1.0)) {
+        return 0;
+    }
+    return factorPanel(lu, k + left, right);
+}
+
+// Function to factorize a square DOUBLE view as P * view = L * U, with partial pivoting
+// Accepts a view in any layout, which is left as it is, and the factorization to fill in. A singular matrix still
+// factorizes, with 'singular' set, so its determinant can be worked out.
+// Returns MATRIX_SUCCESS, or an error status with the factorization untouched
+MatrixStatus factorizeLU(const MatrixView *view, MatrixLU *lu) {
+    if (!view || !view->block || !lu) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (view->rows <= 0 || view->rows != view->cols) {
+        printf("Error: Matrix must be square.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (view->data_type != DOUBLE) {
+        printf("Error: LU factorization only works on DOUBLE matrices.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+
+    MatrixLU result = invalidLU();
+    int n = view->rows;
+    result.n = n;
+    result.values = (double *)alignedCalloc((size_t)n * n * sizeof(double));
+    result.pivots = (int *)alignedCalloc((size_t)n * sizeof(int));
+    if (result.values == NULL || result.pivots == NULL) {
+        printf("Memory allocation failed for an LU factorization of %d x %d\n", n, n);
+        freeLU(&result);
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    copyViewToRows(result.values, view);
+
+    double *a = result.values;
+    MultiplyStrides strides = {(size_t)n, 1, (size_t)n, 1, (size_t)n, 1};
+    for (int k = 0; k < n; k += LU_BLOCK) {
+        int width = minInt(LU_BLOCK, n - k);
+        int rest = n - k - width;
+        if (!factorPanel(&result, k, width)) {
+            printf("Memory allocation failed for an LU factorization of %d x %d\n", n, n);
+            freeLU(&result);
+            return MATRIX_ERROR_NULL_POINTER;
+        }
+        if (rest == 0) {
+            break;
+        }
+
+        // U12 = L11^-1 * A12, then A22 -= L21 * U12
+        double *diagonal = a + (size_t)k * n + k;
+        solveTriangle(diagonal, (size_t)n, diagonal + width, (size_t)n, width, rest, 0);
+        if (!gemmDoubles(diagonal + (size_t)width * n + width, diagonal + (size_t)width * n, diagonal + width,
+                         &strides, rest, rest, width, -1.0, 1.0)) {
+            printf("Memory allocation failed for an LU factorization of %d x %d\n", n, n);
+            freeLU(&result);
+            return MATRIX_ERROR_NULL_POINTER;
+        }
+    }
+
+    *lu = result;
+    return MATRIX_SUCCESS;
+}
+
+// Detect an invalid factorization
+// Accepts a factorization pointer
+// Returns 1 if it holds a factorization, 0 otherwise
+int isValidLU(const MatrixLU *lu) {
+    return lu != NULL && lu->values != NULL && lu->pivots != NULL && lu->n > 0;
+}
+
+// MARK - Solving
+
+// Solve L * U * X = B in place, where the rows of B have already been swapped to match the pivots.
+// 'x' is n x cols, packed row major.
+// Returns 1 on success and 0 if the GEMM packing buffers couldn't be allocated
+static int substituteRows(const MatrixLU *lu, double *x, int cols) {
+    int n = lu->n;
+    const double *a = lu->values;
+    MultiplyStrides strides = {(size_t)n, 1, (size_t)cols, 1, (size_t)cols, 1};
+
+    // Forward through L: every block takes off what the blocks above it contribute, then solves its own triangle
+    for (int first = 0; first < n; first += LU_BLOCK) {
+        int rows = minInt(LU_BLOCK, n - first);
+        double *block = x + (size_t)first * cols;
+        if (first > 0 && !gemmDoubles(block, a + (size_t)first * n, x, &strides, rows, cols, first, -1.0, 1.0)) {
+            return 0;
+        }
+        solveTriangle(a + (size_t)first * n + first, (size_t)n, block, (size_t)cols, rows, cols, 0);
+    }
+
+    // Backward through U, the same way from the bottom up
+    for (int first = (n - 1) / LU_BLOCK * LU_BLOCK; first >= 0; first -= LU_BLOCK) {
+        int rows = minInt(LU_BLOCK, n - first);
+        int end = first + rows;
+        double *block = x + (size_t)first * cols;
+        if (end < n && !gemmDoubles(block, a + (size_t)first * n + end, x + (size_t)end * cols, &strides, rows, cols,
+                                    n - end, -1.0, 1.0)) {
+            return 0;
+        }
+        solveTriangle(a + (size_t)first * n + first, (size_t)n, block, (size_t)cols, rows, cols, 1);
+    }
+    return 1;
+}
+
+// Check a factorization can be used to solve, into a destination of n rows and 'cols' columns
+// Returns MATRIX_SUCCESS or the reason it can't
+static MatrixStatus checkSolve(const MatrixLU *lu, const MatrixView *dest, int cols) {
+    if (!isValidLU(lu) || !dest || !dest->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (dest->rows != lu->n || dest->cols != cols) {
+        printf("Error: Destination matrix dimensions do not match the result.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (dest->data_type != DOUBLE) {
+        printf("Error: Destination matrix data type does not match the result.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    if (lu->singular) {
+        printf("Error: Matrix is singular.\n");
+        return MATRIX_ERROR_SINGULAR;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// Function to solve A * X = B with the factorization of A, for every column of B at once
+// Accepts the factorization, and n x k DOUBLE views of B and X in any layout. X can be B, or overlap it.
+// Returns MATRIX_SUCCESS, or an error status with X untouched
+MatrixStatus solveLU(const MatrixLU *lu, const MatrixView *b, const MatrixView *x) {
+    if (!isValidLU(lu) || !b || !b->block) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (b->rows != lu->n || b->cols <= 0) {
+        printf("Error: Right hand sides must have as many rows as the matrix.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (b->data_type != DOUBLE) {
+        printf("Error: Data types of matrices do not match.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    MatrixStatus status = checkSolve(lu, x, b->cols);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // B is copied out before anything is written to X, which is why they can overlap
+    int n = lu->n;
+    int cols = b->cols;
+    double *rows = (double *)alignedCalloc((size_t)n * cols * sizeof(double));
+    if (rows == NULL) {
+        printf("Memory allocation failed for LU solve scratch space.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    copyViewToRows(rows, b);
+    for (int i = 0; i < n; i++) {
+        if (lu->pivots[i] != i) {
+            swapRows(rows + (size_t)i * cols, rows + (size_t)lu->pivots[i] * cols, cols);
+        }
+    }
+    if (!substituteRows(lu, rows, cols)) {
+        printf("Memory allocation failed for LU solve scratch space.\n");
+        alignedFree(rows);
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    copyRowsToView(x, rows);
+    alignedFree(rows);
+    return MATRIX_SUCCESS;
+}
+
+// Function to work out the determinant of a factorized matrix
+// Accepts the factorization
+// Returns the product of the diagonal of U, negated for an odd number of row swaps, or 0 for an invalid one
+double determinantLU(const MatrixLU *lu) {
+    if (!isValidLU(lu)) {
+        printf("Error: Null matrix or data.\n");
+        return 0.0;
+    }
+    double determinant = (lu->swaps % 2) ? -1.0 : 1.0;
+    for (int i = 0; i < lu->n; i++) {
+        determinant *= lu->values[(size_t)i * lu->n + i];
+    }
+    return determinant;
+}
+
+// Function to write the inverse of a factorized matrix into a view
+// Accepts the factorization and an n x n DOUBLE view in any layout
+// Returns MATRIX_SUCCESS, or an error status with the view untouched
+MatrixStatus inverseLU(const MatrixLU *lu, const MatrixView *dest) {
+    MatrixStatus status = checkSolve(lu, dest, isValidLU(lu) ? lu->n : 0);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    // The inverse solves A * X = I, and swapping the rows of I to match the pivots puts row i's 1 in the column of
+    // whichever row ended up at i
+    int n = lu->n;
+    double *rows = (double *)alignedCalloc((size_t)n * n * sizeof(double));
+    int *order = (int *)alignedCalloc((size_t)n * sizeof(int));
+    if (rows == NULL || order == NULL) {
+        printf("Memory allocation failed for LU inverse scratch space.\n");
+        alignedFree(rows);
+        alignedFree(order);
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    for (int i = 0; i < n; i++) {
+        order[i] = i;
+    }
+    for (int i = 0; i < n; i++) {
+        int swapped = order[i];
+        order[i] = order[lu->pivots[i]];
+        order[lu->pivots[i]] = swapped;
+    }
+    for (int i = 0; i < n; i++) {
+        rows[(size_t)i * n + order[i]] = 1.0;
+    }
+    alignedFree(order);
+    if (!substituteRows(lu, rows, n)) {
+        printf("Memory allocation failed for LU inverse scratch space.\n");
+        alignedFree(rows);
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    copyRowsToView(dest, rows);
+    alignedFree(rows);
+    return MATRIX_SUCCESS;
+}
+
+// Free a factorization made by factorizeLU
+// Accepts a factorization pointer
+// Does not return
+void freeLU(MatrixLU *lu) {
+    if (lu == NULL) {
+        return;
+    }
+    alignedFree(lu->values);
+    alignedFree(lu->pivots);
+    *lu = invalidLU();
+}
+
+// MARK - One call
+
+// Function to solve A * X = B without keeping the factorization
+// Accepts a square DOUBLE view of A, and n x k DOUBLE views of B and X in any layout. X can be B, or overlap it.
+// Returns MATRIX_SUCCESS, or an error status with X untouched
+MatrixStatus solveMatrixViews(const MatrixView *a, const MatrixView *b, const MatrixView *x) {
+    MatrixLU lu;
+    MatrixStatus status = factorizeLU(a, &lu);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    status = solveLU(&lu, b, x);
+    freeLU(&lu);
+    return status;
+}
+
+// Function to work out the determinant of a square DOUBLE view
+// Accepts the view and where the determinant goes
+// Returns MATRIX_SUCCESS, or an error status with the result untouched
+MatrixStatus determinantMatrixView(const MatrixView *view, double *result) {
+    if (!result) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixLU lu;
+    MatrixStatus status = factorizeLU(view, &lu);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    *result = determinantLU(&lu);
+    freeLU(&lu);
+    return MATRIX_SUCCESS;
+}
+
+// Function to create the inverse of a square DOUBLE matrix
+// Accepts a matrix pointer
+// Returns a new matrix stored the same way as the original, or an invalid matrix if it is singular or on error
+Matrix inverseMatrix(const Matrix *mat) {
+    if (!mat) {
+        printf("Error: Null matrix or data.\n");
+        return invalidMatrix();
+    }
+    MatrixView view = viewMatrix(mat);
+    MatrixLU lu;
+    if (factorizeLU(&view, &lu) != MATRIX_SUCCESS) {
+        return invalidMatrix();
+    }
+    Matrix inverse = createMatrixWithLayout(mat->rows, mat->cols, DOUBLE, mat->order, mat->storage);
+    MatrixView out = viewMatrix(&inverse);
+    if (!isValid(&inverse) || inverseLU(&lu, &out) != MATRIX_SUCCESS) {
+        freeMatrix(&inverse);
+        freeLU(&lu);
+        return invalidMatrix();
+    }
+    freeLU(&lu);
+    return inverse;
+}
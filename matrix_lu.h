@@ -0,0 +1,52 @@
+#ifndef MATRIX_LU_H
+#define MATRIX_LU_H
+
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Struct for the LU factorization of a square DOUBLE matrix with partial pivoting, P * A = L * U
+// 'values' holds L below the diagonal (its unit diagonal isn't stored) and U on and above it, n x n row major.
+// Step i of the factorization swapped row i with row 'pivots[i]', which is never above it. 'swaps' counts the steps
+// that swapped two different rows, and 'singular' is 1 if a pivot was exactly 0, in which case the factorization
+// is still complete but can't be used to solve anything.
+// A factorization doesn't refer to the matrix it came from, so it can be kept and reused for any number of solves.
+typedef struct {
+    int n;
+    double *values;
+    int *pivots;
+    int swaps;
+    int singular;
+} MatrixLU;
+
+// Factorize a square DOUBLE view, in any layout, into a new factorization
+MatrixStatus factorizeLU(const MatrixView *view, MatrixLU *lu);
+
+// Detect an invalid factorization
+int isValidLU(const MatrixLU *lu);
+
+// Solve A * X = B for X, for every column of B at once. B and X are n x k DOUBLE views in any layout, and X can be
+// B itself, or overlap it in any way.
+MatrixStatus solveLU(const MatrixLU *lu, const MatrixView *b, const MatrixView *x);
+
+// Determinant of the factorized matrix
+double determinantLU(const MatrixLU *lu);
+
+// Write the inverse of the factorized matrix into an n x n DOUBLE view
+MatrixStatus inverseLU(const MatrixLU *lu, const MatrixView *dest);
+
+// Free a factorization
+void freeLU(MatrixLU *lu);
+
+// Factorize and solve, work out a determinant, or invert, in one call
+MatrixStatus solveMatrixViews(const MatrixView *a, const MatrixView *b, const MatrixView *x);
+MatrixStatus determinantMatrixView(const MatrixView *view, double *result);
+Matrix inverseMatrix(const Matrix *mat);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,492 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_reduce.h"
+
+// MARK - Reductions
+// Every reduction reads the values straight from the view's block, a line at a time, through the reduction kernels,
+// so there is no element access, bounds check or copy per value. Sums and best values are kept in doubles, which
+// hold every int exactly.
+// A whole matrix is split into ranges of lines (or of values, when it is one contiguous run) for the thread pool.
+// Each range reduces to a partial result, and the partials are then combined pairwise, as a tree, in the same order
+// every time. Rows or columns reduce either along the view's own lines, one result per line, or across them, where
+// each line adds one value into every result. Across lines, the results are taken a cache sized block at a time.
+
+// Results a reduction across lines works out together, so that their running sums stay in cache
+#define REDUCE_BLOCK 1024
+
+// Scratch space for one block of those results: running totals and their errors, or best values and the runs they
+// came from
+#define REDUCE_BLOCK_SCRATCH (REDUCE_BLOCK * (2 * sizeof(double) + sizeof(size_t)))
+
+// Up to this many partial results live on the stack
+#define REDUCE_LOCAL_PARTIALS 16
+
+// How a view's values lie in memory: 'lines' runs of 'length' values, 'lineStride' values apart, where neighbouring
+// values of a run are 'step' apart
+typedef struct {
+    DataType data_type;
+    StorageOrder order;
+    const char *values;
+    size_t lines;
+    size_t length;
+    size_t lineStride;
+    size_t step;
+} ViewRuns;
+
+// Lay out the runs of a view
+static ViewRuns viewRuns(const MatrixView *view) {
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    ViewRuns runs;
+    runs.data_type = view->data_type;
+    runs.order = view->order;
+    runs.values = (const char *)viewValues(view);
+    runs.lines = (size_t)((view->order == ROW_MAJOR) ? view->rows : view->cols);
+    runs.length = (size_t)((view->order == ROW_MAJOR) ? view->cols : view->rows);
+    runs.lineStride = (view->order == ROW_MAJOR) ? rowStride : colStride;
+    runs.step = (view->order == ROW_MAJOR) ? colStride : rowStride;
+    return runs;
+}
+
+// Size in bytes of a single native value
+static size_t reduceValueSize(DataType data_type) {
+    return (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+}
+
+// Address of value 'k' of run 'line'
+static const char *runValue(const ViewRuns *runs, size_t line, size_t k) {
+    return runs->values + (line * runs->lineStride + k * runs->step) * reduceValueSize(runs->data_type);
+}
+
+// The value at an address, as a double
+static double readValue(DataType data_type, const char *value) {
+    return (data_type == DOUBLE) ? *(const double *)value : (double)*(const int *)value;
+}
+
+// Whether a reduction looks for a best value, rather than adding values up
+static int isExtremeReduction(Reduction reduction) {
+    return reduction == REDUCE_MIN || reduction == REDUCE_MAX || reduction == REDUCE_ARGMIN ||
+           reduction == REDUCE_ARGMAX || reduction == REDUCE_NORM_INF;
+}
+
+// Whether a reduction looks for the largest value (or magnitude) rather than the smallest
+static int seeksLargest(Reduction reduction) {
+    return reduction == REDUCE_MAX || reduction == REDUCE_ARGMAX || reduction == REDUCE_NORM_INF;
+}
+
+// What a summing reduction adds up
+static SumTerms reductionTerms(Reduction reduction) {
+    if (reduction == REDUCE_NORM_L1) {
+        return SUM_TERMS_MAGNITUDES;
+    }
+    return (reduction == REDUCE_NORM_L2) ? SUM_TERMS_SQUARES : SUM_TERMS_VALUES;
+}
+
+// Whether 'value' at 'index' beats 'best' at 'bestIndex', where ties go to the smaller index
+static int beatsBest(double value, size_t index, double best, size_t bestIndex, int largest) {
+    if (value == best) {
+        return index < bestIndex;
+    }
+    return largest ? value > best : value < best;
+}
+
+// Add one sum into another, keeping the rounding error of the addition
+static void mergeSums(CompensatedSum *into, const CompensatedSum *from) {
+    double sum = into->total + from->total;
+    double error = (fabs(into->total) >= fabs(from->total)) ? (into->total - sum) + from->total
+                                                            : (from->total - sum) + into->total;
+    into->total = sum;
+    into->error += from->error + error;
+}
+
+// The result a finished sum of 'count' values stands for
+static double finishSum(Reduction reduction, const CompensatedSum *sum, size_t count) {
+    double total = sum->total + sum->error;
+    if (reduction == REDUCE_MEAN) {
+        return total / (double)count;
+    }
+    return (reduction == REDUCE_NORM_L2) ? sqrt(total) : total;
+}
+
+// Add up 'count' values from 'values' with the kernel for their type
+static void sumRun(const MatrixKernels *kernels, DataType data_type, const char *values, size_t count, size_t step,
+                   SumTerms terms, int compensated, CompensatedSum *sum) {
+    if (data_type == DOUBLE) {
+        kernels->sumDoubles((const double *)values, count, step, terms, compensated, sum);
+    } else {
+        kernels->sumInts((const int *)values, count, step, terms, compensated, sum);
+    }
+}
+
+// Position of the best of 'count' values from 'values', found with the kernel for their type
+static size_t extremeRun(const MatrixKernels *kernels, DataType data_type, const char *values, size_t count,
+                         size_t step, int largest, int magnitudes) {
+    if (data_type == DOUBLE) {
+        return kernels->extremeDoubles((const double *)values, count, step, largest, magnitudes);
+    }
+    return kernels->extremeInts((const int *)values, count, step, largest, magnitudes);
+}
+
+// Whether the bytes of a vector's values overlap the values of a view
+static int vectorOverlapsView(const MatrixVector *vector, const MatrixView *view) {
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    size_t size = reduceValueSize(view->data_type);
+    const char *first = (const char *)viewValues(view);
+    const char *end = first + ((view->rows - 1) * rowStride + (view->cols - 1) * colStride + 1) * size;
+    const char *vectorFirst = (const char *)vector->values;
+    const char *vectorEnd = vectorFirst + (size_t)vector->length * reduceValueSize(vector->data_type);
+    return vectorFirst < end && first < vectorEnd;
+}
+
+// Check a view can be reduced into a result
+// Accepts the view and the place the result goes
+// Returns MATRIX_SUCCESS or the reason it can't
+static MatrixStatus checkReducedView(const MatrixView *view, const void *result) {
+    if (!view || !view->block || !result) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (view->rows <= 0 || view->cols <= 0) {
+        printf("Error: Invalid matrix dimensions.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (view->data_type != INT && view->data_type != DOUBLE) {
+        printf("Error: Reductions only work on INT or DOUBLE matrices.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    return MATRIX_SUCCESS;
+}
+
+// MARK - Whole matrices
+
+// What one range of a whole matrix reduces to: a sum, or the best value and its row major position
+typedef struct {
+    CompensatedSum sum;
+    double best;
+    size_t index;
+    int found;
+} ReducePartial;
+
+// One whole matrix reduction, shared between threads.
+// With 'singleRun' the items are values of the one run the view is stored as; otherwise they are its lines.
+typedef struct {
+    ViewRuns runs;
+    size_t cols;
+    Reduction reduction;
+    int compensated;
+    int singleRun;
+    ReducePartial *partials;
+} ReduceJob;
+
+// Row major position of the value 'position' values into the runs of a job, counting a whole run per line
+static size_t rowMajorIndex(const ReduceJob *job, size_t position) {
+    if (job->runs.order == ROW_MAJOR) {
+        return position;
+    }
+    return (position % job->runs.length) * job->cols + position / job->runs.length;
+}
+
+// Fold 'count' values of one run, starting 'position' values into the view, into a partial result
+static void reduceSegment(const ReduceJob *job, const char *values, size_t count, size_t position,
+                          ReducePartial *partial) {
+    const MatrixKernels *kernels = matrixKernels();
+    DataType data_type = job->runs.data_type;
+    if (!isExtremeReduction(job->reduction)) {
+        sumRun(kernels, data_type, values, count, job->runs.step, reductionTerms(job->reduction), job->compensated,
+               &partial->sum);
+        return;
+    }
+    int largest = seeksLargest(job->reduction);
+    int magnitudes = job->reduction == REDUCE_NORM_INF;
+    size_t at = extremeRun(kernels, data_type, values, count, job->runs.step, largest, magnitudes);
+    double value = readValue(data_type, values + at * job->runs.step * reduceValueSize(data_type));
+    value = magnitudes ? fabs(value) : value;
+    size_t index = rowMajorIndex(job, position + at);
+    if (!partial->found || beatsBest(value, index, partial->best, partial->index, largest)) {
+        partial->best = value;
+        partial->index = index;
+        partial->found = 1;
+    }
+}
+
+// Reduce items 'start' up to 'end' of a job into the partial result of this range
+static void reduceRange(void *context, int task, size_t start, size_t end) {
+    const ReduceJob *job = (const ReduceJob *)context;
+    ReducePartial partial = {{0.0, 0.0}, 0.0, 0, 0};
+    if (job->singleRun) {
+        // Stored by columns, the first best value in storage isn't always the first in row major order, so each
+        // column is searched on its own
+        int byColumns = job->runs.order != ROW_MAJOR && isExtremeReduction(job->reduction);
+        for (size_t first = start; first < end;) {
+            size_t last = byColumns ? (first / job->runs.length + 1) * job->runs.length : end;
+            last = (last < end) ? last : end;
+            reduceSegment(job, runValue(&job->runs, 0, first), last - first, first, &partial);
+            first = last;
+        }
+    } else {
+        for (size_t line = start; line < end; line++) {
+            reduceSegment(job, runValue(&job->runs, line, 0), job->runs.length, line * job->runs.length, &partial);
+        }
+    }
+    job->partials[task] = partial;
+}
+
+// Fold one partial result into another
+static void mergePartials(const ReduceJob *job, ReducePartial *into, const ReducePartial *from) {
+    if (!isExtremeReduction(job->reduction)) {
+        mergeSums(&into->sum, &from->sum);
+    } else if (from->found && (!into->found || beatsBest(from->best, from->index, into->best, into->index,
+                                                         seeksLargest(job->reduction)))) {
+        *into = *from;
+    }
+}
+
+// Function to reduce every value of a view to one number
+// Accepts a view of INT or DOUBLE values, the reduction, how to add up sums, and where the result goes.
+// ARGMIN and ARGMAX give the row major position (row * cols + col) of the first best value.
+// Returns MATRIX_SUCCESS, or an error status with the result untouched
+MatrixStatus reduceMatrixView(const MatrixView *view, Reduction reduction, Summation summation, double *result) {
+    MatrixStatus status = checkReducedView(view, result);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+
+    ReduceJob job;
+    job.runs = viewRuns(view);
+    job.cols = (size_t)view->cols;
+    job.reduction = reduction;
+    job.compensated = summation == SUMMATION_COMPENSATED;
+    job.singleRun = job.runs.step == 1 && job.runs.lineStride == job.runs.length;
+    size_t values = job.runs.lines * job.runs.length;
+    size_t items = job.singleRun ? values : job.runs.lines;
+    size_t grain = job.singleRun ? PARALLEL_MIN_VALUES
+                                 : (PARALLEL_MIN_VALUES + job.runs.length - 1) / job.runs.length;
+    int ranges = parallelRangeCount(items, grain);
+
+    // Every range leaves its partial result in its own slot
+    ReducePartial local[REDUCE_LOCAL_PARTIALS];
+    job.partials = local;
+    if (ranges > REDUCE_LOCAL_PARTIALS) {
+        job.partials = (ReducePartial *)alignedCalloc((size_t)ranges * sizeof(ReducePartial));
+        if (job.partials == NULL) {
+            printf("Memory allocation failed for reduction partial results.\n");
+            return MATRIX_ERROR_NULL_POINTER;
+        }
+    }
+    parallelRange(items, ranges, reduceRange, &job);
+    for (int width = 1; width < ranges; width *= 2) {
+        for (int i = 0; i + width < ranges; i += 2 * width) {
+            mergePartials(&job, &job.partials[i], &job.partials[i + width]);
+        }
+    }
+
+    ReducePartial total = job.partials[0];
+    if (job.partials != local) {
+        alignedFree(job.partials);
+    }
+    if (reduction == REDUCE_ARGMIN || reduction == REDUCE_ARGMAX) {
+        *result = (double)total.index;
+    } else if (isExtremeReduction(reduction)) {
+        *result = total.best;
+    } else {
+        *result = finishSum(reduction, &total.sum, values);
+    }
+    return MATRIX_SUCCESS;
+}
+
+// MARK - Rows and columns
+
+// One reduction of every row or every column, shared between threads by results.
+// With 'along' each result is one run of the view; otherwise every run adds one value into each result.
+typedef struct {
+    ViewRuns runs;
+    Reduction reduction;
+    int compensated;
+    int along;
+    char *results;
+    char *scratch;
+} LinesJob;
+
+// Store result 'i' of a lines job, a position for ARGMIN and ARGMAX and a double otherwise
+static void storeLineResult(const LinesJob *job, size_t i, double value, size_t index) {
+    if (job->reduction == REDUCE_ARGMIN || job->reduction == REDUCE_ARGMAX) {
+        ((int *)job->results)[i] = (int)index;
+    } else {
+        ((double *)job->results)[i] = value;
+    }
+}
+
+// Work out results 'start' up to 'end', one run each
+static void reduceAlongRange(void *context, int task, size_t start, size_t end) {
+    const LinesJob *job = (const LinesJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    (void)task;
+    DataType data_type = job->runs.data_type;
+    size_t length = job->runs.length;
+    size_t step = job->runs.step;
+    int largest = seeksLargest(job->reduction);
+    int magnitudes = job->reduction == REDUCE_NORM_INF;
+    for (size_t i = start; i < end; i++) {
+        const char *values = runValue(&job->runs, i, 0);
+        if (isExtremeReduction(job->reduction)) {
+            size_t at = extremeRun(kernels, data_type, values, length, step, largest, magnitudes);
+            double value = readValue(data_type, values + at * step * reduceValueSize(data_type));
+            storeLineResult(job, i, magnitudes ? fabs(value) : value, at);
+        } else {
+            CompensatedSum sum = {0.0, 0.0};
+            sumRun(kernels, data_type, values, length, step, reductionTerms(job->reduction), job->compensated, &sum);
+            storeLineResult(job, i, finishSum(job->reduction, &sum, length), 0);
+        }
+    }
+}
+
+// Work out results 'start' up to 'end' a block at a time, folding value i of every run into result i.
+// Each task works in its own REDUCE_BLOCK_SCRATCH bytes of the job's scratch space.
+static void reduceAcrossRange(void *context, int task, size_t start, size_t end) {
+    const LinesJob *job = (const LinesJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    DataType data_type = job->runs.data_type;
+    int extreme = isExtremeReduction(job->reduction);
+    int largest = seeksLargest(job->reduction);
+    int magnitudes = job->reduction == REDUCE_NORM_INF;
+    SumTerms terms = reductionTerms(job->reduction);
+
+    double *totals = (double *)(job->scratch + (size_t)task * REDUCE_BLOCK_SCRATCH);
+    double *errors = totals + REDUCE_BLOCK;
+    size_t *index = (size_t *)(errors + REDUCE_BLOCK);
+    for (size_t first = start; first < end; first += REDUCE_BLOCK) {
+        size_t count = (end - first < REDUCE_BLOCK) ? end - first : REDUCE_BLOCK;
+        for (size_t i = 0; i < count; i++) {
+            totals[i] = extreme ? (largest ? -INFINITY : INFINITY) : 0.0;
+            errors[i] = 0.0;
+            index[i] = 0;
+        }
+        for (size_t line = 0; line < job->runs.lines; line++) {
+            const char *values = runValue(&job->runs, line, first);
+            if (extreme && data_type == DOUBLE) {
+                kernels->extremeAcrossDoubles(totals, index, (const double *)values, count, job->runs.step, line,
+                                              largest, magnitudes);
+            } else if (extreme) {
+                kernels->extremeAcrossInts(totals, index, (const int *)values, count, job->runs.step, line, largest,
+                                           magnitudes);
+            } else if (data_type == DOUBLE) {
+                kernels->sumAcrossDoubles(totals, errors, (const double *)values, count, job->runs.step, terms,
+                                          job->compensated);
+            } else {
+                kernels->sumAcrossInts(totals, errors, (const int *)values, count, job->runs.step, terms,
+                                       job->compensated);
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            CompensatedSum sum = {totals[i], errors[i]};
+            storeLineResult(job, first + i, extreme ? totals[i] : finishSum(job->reduction, &sum, job->runs.lines),
+                            index[i]);
+        }
+    }
+}
+
+// Function to reduce each row or each column of a view
+// Accepts a view of INT or DOUBLE values, ROW for one result per row or COL for one per column, the reduction, how
+// to add up sums, and a result vector with one value per row or column that doesn't overlap the view. The vector
+// holds INT positions (the column for ROW, the row for COL) for ARGMIN and ARGMAX, and DOUBLE results otherwise.
+// Returns MATRIX_SUCCESS, or an error status with the result untouched
+MatrixStatus reduceMatrixViewLines(const MatrixView *view, RowOrCol lines, Reduction reduction, Summation summation,
+                                   const MatrixVector *result) {
+    MatrixStatus status = checkReducedView(view, result);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    if (!isValidVector(result)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (result->length != ((lines == ROW) ? view->rows : view->cols)) {
+        printf("Error: Destination matrix dimensions do not match the result.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (result->data_type != ((reduction == REDUCE_ARGMIN || reduction == REDUCE_ARGMAX) ? INT : DOUBLE)) {
+        printf("Error: Destination matrix data type does not match the result.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    if (vectorOverlapsView(result, view)) {
+        printf("Error: Destination can't overlap the matrix being reduced.\n");
+        return MATRIX_ERROR_ALIASING;
+    }
+
+    LinesJob job;
+    job.runs = viewRuns(view);
+    job.reduction = reduction;
+    job.compensated = summation == SUMMATION_COMPENSATED;
+    job.along = (lines == ROW) == (view->order == ROW_MAJOR);
+    job.results = (char *)result->values;
+    job.scratch = NULL;
+    size_t results = (size_t)result->length;
+    size_t valuesPerResult = job.along ? job.runs.length : job.runs.lines;
+    size_t grain = (PARALLEL_MIN_VALUES + valuesPerResult - 1) / valuesPerResult;
+    int ranges = parallelRangeCount(results, grain);
+
+    // Scratch space for reducing across lines is taken before any work starts, so running out leaves the result
+    // untouched
+    if (!job.along) {
+        job.scratch = (char *)alignedCalloc((size_t)ranges * REDUCE_BLOCK_SCRATCH);
+        if (job.scratch == NULL) {
+            printf("Memory allocation failed for reduction scratch space.\n");
+            return MATRIX_ERROR_NULL_POINTER;
+        }
+    }
+    parallelRange(results, ranges, job.along ? reduceAlongRange : reduceAcrossRange, &job);
+    alignedFree(job.scratch);
+    return MATRIX_SUCCESS;
+}
+
+// MARK - Norms and trace
+
+// Function to work out a norm of a view as a matrix
+// Accepts a view of INT or DOUBLE values, the norm, how to add up sums, and where the result goes
+// Returns MATRIX_SUCCESS, or an error status with the result untouched
+MatrixStatus matrixViewNorm(const MatrixView *view, MatrixNorm norm, Summation summation, double *result) {
+    MatrixStatus status = checkReducedView(view, result);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    if (norm == MATRIX_NORM_FROBENIUS) {
+        return reduceMatrixView(view, REDUCE_NORM_L2, summation, result);
+    }
+
+    // The one norm is the largest column of magnitude sums, and the infinity norm the largest row
+    RowOrCol lines = (norm == MATRIX_NORM_ONE) ? COL : ROW;
+    MatrixVector sums = {(lines == ROW) ? view->rows : view->cols, DOUBLE, NULL};
+    sums.values = alignedCalloc((size_t)sums.length * sizeof(double));
+    if (sums.values == NULL) {
+        printf("Memory allocation failed for norm scratch space.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    status = reduceMatrixViewLines(view, lines, REDUCE_NORM_L1, summation, &sums);
+    if (status == MATRIX_SUCCESS) {
+        MatrixView sumsView = vectorMatrixView(&sums);
+        status = reduceMatrixView(&sumsView, REDUCE_MAX, summation, result);
+    }
+    alignedFree(sums.values);
+    return status;
+}
+
+// Function to add up the main diagonal of a view
+// Accepts a view of INT or DOUBLE values, which doesn't need to be square, how to add up, and where the sum goes
+// Returns MATRIX_SUCCESS, or an error status with the result untouched
+MatrixStatus matrixViewTrace(const MatrixView *view, Summation summation, double *result) {
+    MatrixStatus status = checkReducedView(view, result);
+    if (status != MATRIX_SUCCESS) {
+        return status;
+    }
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    size_t count = (size_t)((view->rows < view->cols) ? view->rows : view->cols);
+    CompensatedSum sum = {0.0, 0.0};
+    sumRun(matrixKernels(), view->data_type, (const char *)viewValues(view), count, rowStride + colStride,
+           SUM_TERMS_VALUES, summation == SUMMATION_COMPENSATED, &sum);
+    *result = finishSum(REDUCE_SUM, &sum, count);
+    return MATRIX_SUCCESS;
+}
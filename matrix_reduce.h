@@ -0,0 +1,61 @@
+#ifndef MATRIX_REDUCE_H
+#define MATRIX_REDUCE_H
+
+#include "matrix.h"
+#include "matrix_vector.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Enum for what a reduction works out over a matrix, a row or a column.
+// The norms are of the values taken as one vector: L1 adds up magnitudes, L2 is the square root of the sum of
+// squares (the Frobenius norm of a whole matrix) and INF is the largest magnitude.
+// ARGMIN and ARGMAX give the position of the first smallest or largest value.
+typedef enum {
+    REDUCE_SUM,
+    REDUCE_MEAN,
+    REDUCE_MIN,
+    REDUCE_MAX,
+    REDUCE_ARGMIN,
+    REDUCE_ARGMAX,
+    REDUCE_NORM_L1,
+    REDUCE_NORM_L2,
+    REDUCE_NORM_INF
+} Reduction;
+
+// Enum for how sums are added up. COMPENSATED carries the rounding error of every addition along with the sum,
+// which keeps DOUBLE sums of millions of values accurate to the last few bits, for a little more work.
+typedef enum {
+    SUMMATION_FAST,
+    SUMMATION_COMPENSATED
+} Summation;
+
+// Enum for the norms of a matrix as an operator: ONE is the largest column sum of magnitudes, INF the largest row
+// sum, and FROBENIUS the square root of the sum of squares
+typedef enum {
+    MATRIX_NORM_ONE,
+    MATRIX_NORM_INF,
+    MATRIX_NORM_FROBENIUS
+} MatrixNorm;
+
+// Reduce every value of an INT or DOUBLE view to one double.
+// ARGMIN and ARGMAX give the position as row * cols + col, whichever order the view is stored in.
+MatrixStatus reduceMatrixView(const MatrixView *view, Reduction reduction, Summation summation, double *result);
+
+// Reduce each row (ROW, one result per row) or each column (COL, one per column) of an INT or DOUBLE view.
+// Results go into a DOUBLE vector, except for ARGMIN and ARGMAX which give the column (or row) in an INT vector.
+MatrixStatus reduceMatrixViewLines(const MatrixView *view, RowOrCol lines, Reduction reduction, Summation summation,
+                                   const MatrixVector *result);
+
+// Work out a norm of an INT or DOUBLE view as a matrix
+MatrixStatus matrixViewNorm(const MatrixView *view, MatrixNorm norm, Summation summation, double *result);
+
+// Add up the main diagonal of an INT or DOUBLE view, which doesn't need to be square
+MatrixStatus matrixViewTrace(const MatrixView *view, Summation summation, double *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1380 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_internal.h"
+
+// MARK - Arithmetic kernels
+// Every hot loop of the library comes in one version per instruction set, gathered into a MatrixKernels table.
+// The best table this CPU can run is picked once at startup, so a single build runs well everywhere.
+// Vector versions are compiled with a per-function target attribute rather than a global -m flag,
+// which keeps the rest of the library runnable on any x86-64 CPU.
+
+// The x86 kernels need GCC or Clang for the target attribute and __builtin_cpu_supports.
+// Anywhere else only the scalar kernels are built.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MATRIX_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+// The vector GEMM microkernels are written out for an 8 x 4 tile
+typedef char gemm_kernels_assume_8x4_tile[(GEMM_MR == 8 && GEMM_NR == 4) ? 1 : -1];
+
+// The batch multiplications and matrix-vector products are the same loops for every instruction set, because with
+// the lanes innermost the compiler vectorizes them by itself. Each version below only decides which instructions
+// it may use.
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE static inline
+#endif
+
+// Partial sums (or best values so far) a reduction along a run keeps, one per lane, for the same reason
+#define REDUCE_LANES 8
+
+// Partial sums each row of a matrix-vector product keeps, so that its dot product vectorizes without reordering
+// any single sum. Eight is one AVX-512 register of doubles.
+#define GEMV_LANES 8
+
+// Multiply BATCH_LANES interleaved pairs of matrices of ints. Ints wrap rather than overflow, like the vector adds.
+// Four columns of the result are worked out together, so four independent sums are in flight at once.
+KERNEL_INLINE void batchMultiplyIntsBody(int *restrict c, const int *restrict a, const int *restrict b, int m, int n,
+                                        int p) {
+    for (int i = 0; i < m; i++) {
+        int j = 0;
+        for (; j + 4 <= n; j += 4) {
+            unsigned int sum0[BATCH_LANES] = {0}, sum1[BATCH_LANES] = {0};
+            unsigned int sum2[BATCH_LANES] = {0}, sum3[BATCH_LANES] = {0};
+            for (int k = 0; k < p; k++) {
+                const int *x = a + ((size_t)i * p + k) * BATCH_LANES;
+                const int *y = b + ((size_t)k * n + j) * BATCH_LANES;
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    sum0[l] += (unsigned int)x[l] * (unsigned int)y[l];
+                    sum1[l] += (unsigned int)x[l] * (unsigned int)y[BATCH_LANES + l];
+                    sum2[l] += (unsigned int)x[l] * (unsigned int)y[2 * BATCH_LANES + l];
+                    sum3[l] += (unsigned int)x[l] * (unsigned int)y[3 * BATCH_LANES + l];
+                }
+            }
+            for (int l = 0; l < BATCH_LANES; l++) {
+                c[((size_t)i * n + j) * BATCH_LANES + l] = (int)sum0[l];
+                c[((size_t)i * n + j + 1) * BATCH_LANES + l] = (int)sum1[l];
+                c[((size_t)i * n + j + 2) * BATCH_LANES + l] = (int)sum2[l];
+                c[((size_t)i * n + j + 3) * BATCH_LANES + l] = (int)sum3[l];
+            }
+        }
+        for (; j < n; j++) {
+            unsigned int sum[BATCH_LANES] = {0};
+            for (int k = 0; k < p; k++) {
+                const int *x = a + ((size_t)i * p + k) * BATCH_LANES;
+                const int *y = b + ((size_t)k * n + j) * BATCH_LANES;
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    sum[l] += (unsigned int)x[l] * (unsigned int)y[l];
+                }
+            }
+            for (int l = 0; l < BATCH_LANES; l++) {
+                c[((size_t)i * n + j) * BATCH_LANES + l] = (int)sum[l];
+            }
+        }
+    }
+}
+
+// Multiply BATCH_LANES interleaved pairs of matrices of doubles.
+// Four columns of the result are worked out together, so four independent sums are in flight at once.
+KERNEL_INLINE void batchMultiplyDoublesBody(double *restrict c, const double *restrict a, const double *restrict b,
+                                           int m, int n, int p) {
+    for (int i = 0; i < m; i++) {
+        int j = 0;
+        for (; j + 4 <= n; j += 4) {
+            double sum0[BATCH_LANES] = {0}, sum1[BATCH_LANES] = {0};
+            double sum2[BATCH_LANES] = {0}, sum3[BATCH_LANES] = {0};
+            for (int k = 0; k < p; k++) {
+                const double *x = a + ((size_t)i * p + k) * BATCH_LANES;
+                const double *y = b + ((size_t)k * n + j) * BATCH_LANES;
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    sum0[l] += x[l] * y[l];
+                    sum1[l] += x[l] * y[BATCH_LANES + l];
+                    sum2[l] += x[l] * y[2 * BATCH_LANES + l];
+                    sum3[l] += x[l] * y[3 * BATCH_LANES + l];
+                }
+            }
+            for (int l = 0; l < BATCH_LANES; l++) {
+                c[((size_t)i * n + j) * BATCH_LANES + l] = sum0[l];
+                c[((size_t)i * n + j + 1) * BATCH_LANES + l] = sum1[l];
+                c[((size_t)i * n + j + 2) * BATCH_LANES + l] = sum2[l];
+                c[((size_t)i * n + j + 3) * BATCH_LANES + l] = sum3[l];
+            }
+        }
+        for (; j < n; j++) {
+            double sum[BATCH_LANES] = {0};
+            for (int k = 0; k < p; k++) {
+                const double *x = a + ((size_t)i * p + k) * BATCH_LANES;
+                const double *y = b + ((size_t)k * n + j) * BATCH_LANES;
+                for (int l = 0; l < BATCH_LANES; l++) {
+                    sum[l] += x[l] * y[l];
+                }
+            }
+            for (int l = 0; l < BATCH_LANES; l++) {
+                c[((size_t)i * n + j) * BATCH_LANES + l] = sum[l];
+            }
+        }
+    }
+}
+
+// Matrix-vector rows of ints, y[r] = alpha * (row r . x) + beta * y[r]. Ints wrap rather than overflow.
+// Four rows share each load of x, and each row keeps GEMV_LANES sums, so there are plenty of them in flight.
+KERNEL_INLINE void gemvRowsIntsBody(int *restrict y, const int *restrict a, size_t lda, const int *restrict x,
+                                    int rows, size_t count, int alpha, int beta) {
+    int r = 0;
+    for (; r < rows; r += 4) {
+        int block = (rows - r < 4) ? rows - r : 4;
+        const int *a0 = a + (size_t)r * lda;
+        const int *a1 = (block > 1) ? a0 + lda : a0;
+        const int *a2 = (block > 2) ? a1 + lda : a0;
+        const int *a3 = (block > 3) ? a2 + lda : a0;
+        unsigned int sum0[GEMV_LANES] = {0}, sum1[GEMV_LANES] = {0};
+        unsigned int sum2[GEMV_LANES] = {0}, sum3[GEMV_LANES] = {0};
+        size_t k = 0;
+        for (; k + GEMV_LANES <= count; k += GEMV_LANES) {
+            for (int l = 0; l < GEMV_LANES; l++) {
+                unsigned int value = (unsigned int)x[k + l];
+                sum0[l] += (unsigned int)a0[k + l] * value;
+                sum1[l] += (unsigned int)a1[k + l] * value;
+                sum2[l] += (unsigned int)a2[k + l] * value;
+                sum3[l] += (unsigned int)a3[k + l] * value;
+            }
+        }
+        unsigned int dots[4] = {0, 0, 0, 0};
+        for (; k < count; k++) {
+            unsigned int value = (unsigned int)x[k];
+            dots[0] += (unsigned int)a0[k] * value;
+            dots[1] += (unsigned int)a1[k] * value;
+            dots[2] += (unsigned int)a2[k] * value;
+            dots[3] += (unsigned int)a3[k] * value;
+        }
+        for (int l = 0; l < GEMV_LANES; l++) {
+            dots[0] += sum0[l];
+            dots[1] += sum1[l];
+            dots[2] += sum2[l];
+            dots[3] += sum3[l];
+        }
+        for (int b = 0; b < block; b++) {
+            unsigned int scaled = (unsigned int)alpha * dots[b];
+            y[r + b] = (int)((beta == 0) ? scaled : scaled + (unsigned int)beta * (unsigned int)y[r + b]);
+        }
+    }
+}
+
+// Matrix-vector rows of doubles, y[r] = alpha * (row r . x) + beta * y[r]
+KERNEL_INLINE void gemvRowsDoublesBody(double *restrict y, const double *restrict a, size_t lda,
+                                       const double *restrict x, int rows, size_t count, double alpha, double beta) {
+    int r = 0;
+    for (; r < rows; r += 4) {
+        int block = (rows - r < 4) ? rows - r : 4;
+        const double *a0 = a + (size_t)r * lda;
+        const double *a1 = (block > 1) ? a0 + lda : a0;
+        const double *a2 = (block > 2) ? a1 + lda : a0;
+        const double *a3 = (block > 3) ? a2 + lda : a0;
+        double sum0[GEMV_LANES] = {0}, sum1[GEMV_LANES] = {0};
+        double sum2[GEMV_LANES] = {0}, sum3[GEMV_LANES] = {0};
+        size_t k = 0;
+        for (; k + GEMV_LANES <= count; k += GEMV_LANES) {
+            for (int l = 0; l < GEMV_LANES; l++) {
+                double value = x[k + l];
+                sum0[l] += a0[k + l] * value;
+                sum1[l] += a1[k + l] * value;
+                sum2[l] += a2[k + l] * value;
+                sum3[l] += a3[k + l] * value;
+            }
+        }
+        double dots[4] = {0.0, 0.0, 0.0, 0.0};
+        for (int l = 0; l < GEMV_LANES; l++) {
+            dots[0] += sum0[l];
+            dots[1] += sum1[l];
+            dots[2] += sum2[l];
+            dots[3] += sum3[l];
+        }
+        for (; k < count; k++) {
+            double value = x[k];
+            dots[0] += a0[k] * value;
+            dots[1] += a1[k] * value;
+            dots[2] += a2[k] * value;
+            dots[3] += a3[k] * value;
+        }
+        for (int b = 0; b < block; b++) {
+            y[r + b] = (beta == 0.0) ? alpha * dots[b] : alpha * dots[b] + beta * y[r + b];
+        }
+    }
+}
+
+// Matrix-vector columns of ints, y[i] += column j [i] * x[j] over every column j. Ints wrap rather than overflow.
+// Four columns go into y at once, so y is read and written once for every four columns rather than every one.
+KERNEL_INLINE void gemvColumnsIntsBody(int *restrict y, const int *restrict a, size_t lda, const int *restrict x,
+                                       int cols, size_t count) {
+    int j = 0;
+    for (; j + 4 <= cols; j += 4) {
+        const int *a0 = a + (size_t)j * lda;
+        const int *a1 = a0 + lda;
+        const int *a2 = a1 + lda;
+        const int *a3 = a2 + lda;
+        unsigned int x0 = (unsigned int)x[j], x1 = (unsigned int)x[j + 1];
+        unsigned int x2 = (unsigned int)x[j + 2], x3 = (unsigned int)x[j + 3];
+        for (size_t i = 0; i < count; i++) {
+            unsigned int sum = (unsigned int)a0[i] * x0 + (unsigned int)a1[i] * x1 + (unsigned int)a2[i] * x2 +
+                               (unsigned int)a3[i] * x3;
+            y[i] = (int)((unsigned int)y[i] + sum);
+        }
+    }
+    for (; j < cols; j++) {
+        const int *column = a + (size_t)j * lda;
+        unsigned int value = (unsigned int)x[j];
+        for (size_t i = 0; i < count; i++) {
+            y[i] = (int)((unsigned int)y[i] + (unsigned int)column[i] * value);
+        }
+    }
+}
+
+// Matrix-vector columns of doubles, y[i] += column j [i] * x[j] over every column j
+KERNEL_INLINE void gemvColumnsDoublesBody(double *restrict y, const double *restrict a, size_t lda,
+                                          const double *restrict x, int cols, size_t count) {
+    int j = 0;
+    for (; j + 4 <= cols; j += 4) {
+        const double *a0 = a + (size_t)j * lda;
+        const double *a1 = a0 + lda;
+        const double *a2 = a1 + lda;
+        const double *a3 = a2 + lda;
+        double x0 = x[j], x1 = x[j + 1], x2 = x[j + 2], x3 = x[j + 3];
+        for (size_t i = 0; i < count; i++) {
+            y[i] += a0[i] * x0 + a1[i] * x1 + a2[i] * x2 + a3[i] * x3;
+        }
+    }
+    for (; j < cols; j++) {
+        const double *column = a + (size_t)j * lda;
+        double value = x[j];
+        for (size_t i = 0; i < count; i++) {
+            y[i] += column[i] * value;
+        }
+    }
+}
+
+// MARK - Reductions
+// Sums can be compensated (Neumaier's version of Kahan summation): each lane keeps the rounding error of its total
+// alongside it, and the errors are added back in at the end. Both are plain lane arrays, so this vectorizes too.
+// Best values are kept as doubles for ints as well, which holds every int exactly.
+
+// The term a sum adds for one value
+KERNEL_INLINE double sumTerm(double value, SumTerms terms) {
+    return (terms == SUM_TERMS_SQUARES) ? value * value : (terms == SUM_TERMS_MAGNITUDES) ? fabs(value) : value;
+}
+
+// Add a term to a total, keeping the rounding error of the addition in 'error' when compensating
+KERNEL_INLINE void sumAdd(double *total, double *error, double term, int compensated) {
+    double sum = *total + term;
+    if (compensated) {
+        *error += (fabs(*total) >= fabs(term)) ? (*total - sum) + term : (term - sum) + *total;
+    }
+    *total = sum;
+}
+
+// Whether 'value' beats 'best', as the largest (or smallest) so far
+KERNEL_INLINE int beats(double value, double best, int largest) {
+    return largest ? value > best : value < best;
+}
+
+// The bodies of the reduction kernels, written once for ints and once for doubles
+#define DEFINE_REDUCE_BODIES(name, type)                                                                           \
+    /* Sum 'count' values spaced 'step' apart into 'sum', each turned into a term first */                         \
+    KERNEL_INLINE void sumValues##name(const type *restrict a, size_t count, size_t step, SumTerms terms,           \
+                                       int compensated, CompensatedSum *sum) {                                      \
+        double totals[REDUCE_LANES] = {0}, errors[REDUCE_LANES] = {0};                                              \
+        size_t k = 0;                                                                                               \
+        for (; k + REDUCE_LANES <= count; k += REDUCE_LANES) {                                                      \
+            for (int l = 0; l < REDUCE_LANES; l++) {                                                                \
+                sumAdd(&totals[l], &errors[l], sumTerm((double)a[(k + l) * step], terms), compensated);             \
+            }                                                                                                       \
+        }                                                                                                           \
+        for (; k < count; k++) {                                                                                    \
+            sumAdd(&totals[0], &errors[0], sumTerm((double)a[k * step], terms), compensated);                       \
+        }                                                                                                           \
+        for (int l = 0; l < REDUCE_LANES; l++) {                                                                    \
+            sumAdd(&sum->total, &sum->error, totals[l], compensated);                                               \
+            sum->error += errors[l];                                                                                \
+        }                                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    /* Position of the largest (or smallest) of 'count' contiguous values or magnitudes. Ties go to the first. */  \
+    KERNEL_INLINE size_t extremeValues##name(const type *restrict a, size_t count, size_t step, int largest,        \
+                                             int magnitudes) {                                                      \
+        double best[REDUCE_LANES] = {0};                                                                            \
+        size_t index[REDUCE_LANES] = {0};                                                                           \
+        size_t lanes = (count < REDUCE_LANES) ? count : REDUCE_LANES;                                               \
+        for (size_t l = 0; l < lanes; l++) {                                                                        \
+            best[l] = magnitudes ? fabs((double)a[l * step]) : (double)a[l * step];                                 \
+            index[l] = l;                                                                                           \
+        }                                                                                                           \
+        size_t k = lanes;                                                                                           \
+        for (; lanes == REDUCE_LANES && k + REDUCE_LANES <= count; k += REDUCE_LANES) {                             \
+            for (int l = 0; l < REDUCE_LANES; l++) {                                                                \
+                double value = magnitudes ? fabs((double)a[(k + l) * step]) : (double)a[(k + l) * step];            \
+                int better = beats(value, best[l], largest);                                                        \
+                best[l] = better ? value : best[l];                                                                 \
+                index[l] = better ? k + l : index[l];                                                               \
+            }                                                                                                       \
+        }                                                                                                           \
+        size_t winner = 0;                                                                                          \
+        for (size_t l = 1; l < lanes; l++) {                                                                        \
+            if (beats(best[l], best[winner], largest) || (best[l] == best[winner] && index[l] < index[winner])) {   \
+                winner = l;                                                                                         \
+            }                                                                                                       \
+        }                                                                                                           \
+        double bestValue = best[winner];                                                                            \
+        size_t bestIndex = index[winner];                                                                           \
+        for (; k < count; k++) {                                                                                    \
+            double value = magnitudes ? fabs((double)a[k * step]) : (double)a[k * step];                            \
+            if (beats(value, bestValue, largest)) {                                                                 \
+                bestValue = value;                                                                                  \
+                bestIndex = k;                                                                                      \
+            }                                                                                                       \
+        }                                                                                                           \
+        return bestIndex;                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    /* Add the terms of 'count' contiguous values into as many totals (and errors when compensating) */            \
+    KERNEL_INLINE void sumAcross##name(double *restrict totals, double *restrict errors, const type *restrict a,    \
+                                       size_t count, size_t step, SumTerms terms, int compensated) {                \
+        size_t i = 0;                                                                                               \
+        for (; i + REDUCE_LANES <= count; i += REDUCE_LANES) {                                                      \
+            for (int l = 0; l < REDUCE_LANES; l++) {                                                                \
+                double term = sumTerm((double)a[(i + l) * step], terms);                                            \
+                if (compensated) {                                                                                  \
+                    sumAdd(&totals[i + l], &errors[i + l], term, 1);                                                \
+                } else {                                                                                            \
+                    totals[i + l] += term;                                                                          \
+                }                                                                                                   \
+            }                                                                                                       \
+        }                                                                                                           \
+        for (; i < count; i++) {                                                                                    \
+            double term = sumTerm((double)a[i * step], terms);                                                      \
+            if (compensated) {                                                                                      \
+                sumAdd(&totals[i], &errors[i], term, 1);                                                            \
+            } else {                                                                                                \
+                totals[i] += term;                                                                                  \
+            }                                                                                                       \
+        }                                                                                                           \
+    }                                                                                                               \
+                                                                                                                    \
+    /* Compare 'count' contiguous values (or magnitudes) with as many best values so far, and record 'line' as */  \
+    /* the index of every one that beats its best */                                                                \
+    KERNEL_INLINE void extremeAcross##name(double *restrict best, size_t *restrict index, const type *restrict a,   \
+                                           size_t count, size_t step, size_t line, int largest, int magnitudes) {   \
+        size_t i = 0;                                                                                               \
+        for (; i + REDUCE_LANES <= count; i += REDUCE_LANES) {                                                      \
+            for (int l = 0; l < REDUCE_LANES; l++) {                                                                \
+                double value = magnitudes ? fabs((double)a[(i + l) * step]) : (double)a[(i + l) * step];            \
+                int better = beats(value, best[i + l], largest);                                                    \
+                best[i + l] = better ? value : best[i + l];                                                         \
+                index[i + l] = better ? line : index[i + l];                                                        \
+            }                                                                                                       \
+        }                                                                                                           \
+        for (; i < count; i++) {                                                                                    \
+            double value = magnitudes ? fabs((double)a[i * step]) : (double)a[i * step];                            \
+            if (beats(value, best[i], largest)) {                                                                   \
+                best[i] = value;                                                                                    \
+                index[i] = line;                                                                                    \
+            }                                                                                                       \
+        }                                                                                                           \
+    }
+
+DEFINE_REDUCE_BODIES(Ints, int)
+DEFINE_REDUCE_BODIES(Doubles, double)
+
+// Every reduction kernel of one instruction set, each a wrapper that picks a specialised copy of its body.
+// The step, terms and flags are passed on as constants wherever that lets the loops vectorize.
+#define DEFINE_REDUCE_KERNELS(name, attributes)                                                                    \
+    DEFINE_REDUCE_KERNELS_OF(Ints, int, name, attributes)                                                            \
+    DEFINE_REDUCE_KERNELS_OF(Doubles, double, name, attributes)
+
+#define DEFINE_REDUCE_KERNELS_OF(kind, type, name, attributes)                                                     \
+    attributes static void sum##kind##name(const type *a, size_t count, size_t step, SumTerms terms,                \
+                                           int compensated, CompensatedSum *sum) {                                  \
+        if (step != 1) {                                                                                            \
+            sumValues##kind(a, count, step, terms, compensated, sum);                                               \
+        } else if (compensated) {                                                                                   \
+            sumValues##kind(a, count, 1, terms, 1, sum);                                                            \
+        } else if (terms == SUM_TERMS_VALUES) {                                                                     \
+            sumValues##kind(a, count, 1, SUM_TERMS_VALUES, 0, sum);                                                 \
+        } else if (terms == SUM_TERMS_MAGNITUDES) {                                                                 \
+            sumValues##kind(a, count, 1, SUM_TERMS_MAGNITUDES, 0, sum);                                             \
+        } else {                                                                                                    \
+            sumValues##kind(a, count, 1, SUM_TERMS_SQUARES, 0, sum);                                                \
+        }                                                                                                           \
+    }                                                                                                               \
+    attributes static size_t extreme##kind##name(const type *a, size_t count, size_t step, int largest,             \
+                                                 int magnitudes) {                                                  \
+        if (step != 1) {                                                                                            \
+            return extremeValues##kind(a, count, step, largest, magnitudes);                                        \
+        } else if (magnitudes) {                                                                                    \
+            return extremeValues##kind(a, count, 1, 1, 1);                                                          \
+        }                                                                                                           \
+        return largest ? extremeValues##kind(a, count, 1, 1, 0) : extremeValues##kind(a, count, 1, 0, 0);           \
+    }                                                                                                               \
+    attributes static void sumAcross##kind##name(double *totals, double *errors, const type *a, size_t count,       \
+                                                 size_t step, SumTerms terms, int compensated) {                    \
+        if (step != 1) {                                                                                            \
+            sumAcross##kind(totals, errors, a, count, step, terms, compensated);                                    \
+        } else if (compensated) {                                                                                   \
+            sumAcross##kind(totals, errors, a, count, 1, terms, 1);                                                 \
+        } else if (terms == SUM_TERMS_VALUES) {                                                                     \
+            sumAcross##kind(totals, errors, a, count, 1, SUM_TERMS_VALUES, 0);                                      \
+        } else if (terms == SUM_TERMS_MAGNITUDES) {                                                                 \
+            sumAcross##kind(totals, errors, a, count, 1, SUM_TERMS_MAGNITUDES, 0);                                  \
+        } else {                                                                                                    \
+            sumAcross##kind(totals, errors, a, count, 1, SUM_TERMS_SQUARES, 0);                                     \
+        }                                                                                                           \
+    }                                                                                                               \
+    attributes static void extremeAcross##kind##name(double *best, size_t *index, const type *a, size_t count,      \
+                                                     size_t step, size_t line, int largest, int magnitudes) {       \
+        if (step != 1) {                                                                                            \
+            extremeAcross##kind(best, index, a, count, step, line, largest, magnitudes);                            \
+        } else if (magnitudes) {                                                                                    \
+            extremeAcross##kind(best, index, a, count, 1, line, 1, 1);                                              \
+        } else if (largest) {                                                                                       \
+            extremeAcross##kind(best, index, a, count, 1, line, 1, 0);                                              \
+        } else {                                                                                                    \
+            extremeAcross##kind(best, index, a, count, 1, line, 0, 0);                                              \
+        }                                                                                                           \
+    }
+
+// MARK - Scalar
+
+// Add or subtract two runs of ints into a third
+static void combineIntsScalar(int *out, const int *a, const int *b, size_t count, size_t step, int subtract) {
+    if (subtract) {
+        for (size_t k = 0; k < count; k++) {
+            out[k * step] = a[k * step] - b[k * step];
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            out[k * step] = a[k * step] + b[k * step];
+        }
+    }
+}
+
+// Add or subtract two runs of doubles into a third
+static void combineDoublesScalar(double *out, const double *a, const double *b, size_t count, int subtract) {
+    if (subtract) {
+        for (size_t k = 0; k < count; k++) {
+            out[k] = a[k] - b[k];
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            out[k] = a[k] + b[k];
+        }
+    }
+}
+
+// Compare two runs of ints, returning 1 if they match and 0 as soon as they don't
+static int equalIntsScalar(const int *a, const int *b, size_t count, size_t step) {
+    for (size_t k = 0; k < count; k++) {
+        if (a[k * step] != b[k * step]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Compare two runs of doubles, returning 1 if they match and 0 as soon as they don't
+static int equalDoublesScalar(const double *a, const double *b, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        if (a[k] != b[k]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// GEMM microkernel for ints. The tile is a local array the compiler can keep in registers,
+// and is only written out, column by column, at the end.
+static void gemmKernelIntsScalar(int kc, const int *a, const int *b, int *tile) {
+    int sum[GEMM_MR][GEMM_NR] = {{0}};
+    for (int k = 0; k < kc; k++) {
+        for (int r = 0; r < GEMM_MR; r++) {
+            int scale = a[r];
+            for (int c = 0; c < GEMM_NR; c++) {
+                sum[r][c] += scale * b[c];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for (int c = 0; c < GEMM_NR; c++) {
+        for (int r = 0; r < GEMM_MR; r++) {
+            tile[c * GEMM_MR + r] = sum[r][c];
+        }
+    }
+}
+
+// GEMM microkernel for doubles
+static void gemmKernelDoublesScalar(int kc, const double *a, const double *b, double *tile) {
+    double sum[GEMM_MR][GEMM_NR] = {{0.0}};
+    for (int k = 0; k < kc; k++) {
+        for (int r = 0; r < GEMM_MR; r++) {
+            double scale = a[r];
+            for (int c = 0; c < GEMM_NR; c++) {
+                sum[r][c] += scale * b[c];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    for (int c = 0; c < GEMM_NR; c++) {
+        for (int r = 0; r < GEMM_MR; r++) {
+            tile[c * GEMM_MR + r] = sum[r][c];
+        }
+    }
+}
+
+// Transpose a rectangle of ints
+static void transposeIntsScalar(int *out, ptrdiff_t outStride, const int *in, ptrdiff_t inStride, int rows, int cols) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            out[r * outStride + c] = in[c * inStride + r];
+        }
+    }
+}
+
+// Transpose a rectangle of doubles
+static void transposeDoublesScalar(double *out, ptrdiff_t outStride, const double *in, ptrdiff_t inStride, int rows,
+                                   int cols) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            out[r * outStride + c] = in[c * inStride + r];
+        }
+    }
+}
+
+// Batch multiplications
+static void batchMultiplyIntsScalar(int *c, const int *a, const int *b, int m, int n, int p) {
+    batchMultiplyIntsBody(c, a, b, m, n, p);
+}
+
+static void batchMultiplyDoublesScalar(double *c, const double *a, const double *b, int m, int n, int p) {
+    batchMultiplyDoublesBody(c, a, b, m, n, p);
+}
+
+// Matrix-vector products
+static void gemvRowsIntsScalar(int *y, const int *a, size_t lda, const int *x, int rows, size_t count, int alpha,
+                               int beta) {
+    gemvRowsIntsBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+static void gemvRowsDoublesScalar(double *y, const double *a, size_t lda, const double *x, int rows, size_t count,
+                                  double alpha, double beta) {
+    gemvRowsDoublesBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+static void gemvColumnsIntsScalar(int *y, const int *a, size_t lda, const int *x, int cols, size_t count) {
+    gemvColumnsIntsBody(y, a, lda, x, cols, count);
+}
+
+static void gemvColumnsDoublesScalar(double *y, const double *a, size_t lda, const double *x, int cols,
+                                     size_t count) {
+    gemvColumnsDoublesBody(y, a, lda, x, cols, count);
+}
+
+// Reductions
+DEFINE_REDUCE_KERNELS(Scalar,)
+
+static const MatrixKernels scalarKernels = {
+    ISA_SCALAR,
+    combineIntsScalar,
+    combineDoublesScalar,
+    equalIntsScalar,
+    equalDoublesScalar,
+    gemmKernelIntsScalar,
+    gemmKernelDoublesScalar,
+    transposeIntsScalar,
+    transposeDoublesScalar,
+    batchMultiplyIntsScalar,
+    batchMultiplyDoublesScalar,
+    gemvRowsIntsScalar,
+    gemvRowsDoublesScalar,
+    gemvColumnsIntsScalar,
+    gemvColumnsDoublesScalar,
+    sumIntsScalar,
+    sumDoublesScalar,
+    extremeIntsScalar,
+    extremeDoublesScalar,
+    sumAcrossIntsScalar,
+    sumAcrossDoublesScalar,
+    extremeAcrossIntsScalar,
+    extremeAcrossDoublesScalar
+};
+
+#ifdef MATRIX_X86_KERNELS
+
+// The vector int kernels walk 'count * step' ints straight through, so with a step of 2 they also
+// add up (or compare, and then ignore) the unused half of each MatrixElement. That half belongs to the
+// same element, so nothing outside the run is touched, and vector adds wrap rather than overflow.
+// Whatever is left over after the last full vector is finished off by the scalar kernel.
+
+// The vector transposes swap square blocks of values in registers. The rows and columns left over
+// past the last full block are finished off by the scalar kernel.
+static void transposeIntEdges(int *out, ptrdiff_t outStride, const int *in, ptrdiff_t inStride, int rows, int cols,
+                              int fullRows, int fullCols) {
+    if (fullRows < rows) {
+        transposeIntsScalar(out + fullRows * outStride, outStride, in + fullRows, inStride, rows - fullRows, cols);
+    }
+    if (fullRows > 0 && fullCols < cols) {
+        transposeIntsScalar(out + fullCols, outStride, in + fullCols * inStride, inStride, fullRows, cols - fullCols);
+    }
+}
+
+static void transposeDoubleEdges(double *out, ptrdiff_t outStride, const double *in, ptrdiff_t inStride, int rows,
+                                 int cols, int fullRows, int fullCols) {
+    if (fullRows < rows) {
+        transposeDoublesScalar(out + fullRows * outStride, outStride, in + fullRows, inStride, rows - fullRows, cols);
+    }
+    if (fullRows > 0 && fullCols < cols) {
+        transposeDoublesScalar(out + fullCols, outStride, in + fullCols * inStride, inStride, fullRows,
+                               cols - fullCols);
+    }
+}
+
+// MARK - SSE2
+
+__attribute__((target("sse2")))
+static void combineIntsSse2(int *out, const int *a, const int *b, size_t count, size_t step, int subtract) {
+    size_t total = count * step;
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 4 <= total; k += 4) {
+            __m128i left = _mm_loadu_si128((const __m128i *)(a + k));
+            __m128i right = _mm_loadu_si128((const __m128i *)(b + k));
+            _mm_storeu_si128((__m128i *)(out + k), _mm_sub_epi32(left, right));
+        }
+    } else {
+        for (; k + 4 <= total; k += 4) {
+            __m128i left = _mm_loadu_si128((const __m128i *)(a + k));
+            __m128i right = _mm_loadu_si128((const __m128i *)(b + k));
+            _mm_storeu_si128((__m128i *)(out + k), _mm_add_epi32(left, right));
+        }
+    }
+    combineIntsScalar(out + k, a + k, b + k, count - k / step, step, subtract);
+}
+
+__attribute__((target("sse2")))
+static void combineDoublesSse2(double *out, const double *a, const double *b, size_t count, int subtract) {
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 2 <= count; k += 2) {
+            _mm_storeu_pd(out + k, _mm_sub_pd(_mm_loadu_pd(a + k), _mm_loadu_pd(b + k)));
+        }
+    } else {
+        for (; k + 2 <= count; k += 2) {
+            _mm_storeu_pd(out + k, _mm_add_pd(_mm_loadu_pd(a + k), _mm_loadu_pd(b + k)));
+        }
+    }
+    combineDoublesScalar(out + k, a + k, b + k, count - k, subtract);
+}
+
+__attribute__((target("sse2")))
+static int equalIntsSse2(const int *a, const int *b, size_t count, size_t step) {
+    // Only the lanes holding values count, one bit per lane
+    int lanes = (step == 1) ? 0xF : 0x5;
+    size_t total = count * step;
+    size_t k = 0;
+    for (; k + 4 <= total; k += 4) {
+        __m128i equal = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(a + k)),
+                                        _mm_loadu_si128((const __m128i *)(b + k)));
+        if ((_mm_movemask_ps(_mm_castsi128_ps(equal)) & lanes) != lanes) {
+            return 0;
+        }
+    }
+    return equalIntsScalar(a + k, b + k, count - k / step, step);
+}
+
+__attribute__((target("sse2")))
+static int equalDoublesSse2(const double *a, const double *b, size_t count) {
+    size_t k = 0;
+    for (; k + 2 <= count; k += 2) {
+        if (_mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(a + k), _mm_loadu_pd(b + k))) != 0x3) {
+            return 0;
+        }
+    }
+    return equalDoublesScalar(a + k, b + k, count - k);
+}
+
+// SSE2 has no 32 bit multiply, so ints use the scalar GEMM microkernel
+// The double microkernel keeps the whole 8 x 4 tile in the 16 SSE registers and reads A straight from memory,
+// which is why it uses aligned loads: packed slivers of A always start on a MATRIX_ALIGNMENT boundary
+__attribute__((target("sse2")))
+static void gemmKernelDoublesSse2(int kc, const double *a, const double *b, double *tile) {
+    __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd(), c02 = _mm_setzero_pd(), c03 = _mm_setzero_pd();
+    __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd(), c12 = _mm_setzero_pd(), c13 = _mm_setzero_pd();
+    __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd(), c22 = _mm_setzero_pd(), c23 = _mm_setzero_pd();
+    __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd(), c32 = _mm_setzero_pd(), c33 = _mm_setzero_pd();
+    for (int k = 0; k < kc; k++) {
+        __m128d scale = _mm_set1_pd(b[0]);
+        c00 = _mm_add_pd(c00, _mm_mul_pd(_mm_load_pd(a), scale));
+        c01 = _mm_add_pd(c01, _mm_mul_pd(_mm_load_pd(a + 2), scale));
+        c02 = _mm_add_pd(c02, _mm_mul_pd(_mm_load_pd(a + 4), scale));
+        c03 = _mm_add_pd(c03, _mm_mul_pd(_mm_load_pd(a + 6), scale));
+        scale = _mm_set1_pd(b[1]);
+        c10 = _mm_add_pd(c10, _mm_mul_pd(_mm_load_pd(a), scale));
+        c11 = _mm_add_pd(c11, _mm_mul_pd(_mm_load_pd(a + 2), scale));
+        c12 = _mm_add_pd(c12, _mm_mul_pd(_mm_load_pd(a + 4), scale));
+        c13 = _mm_add_pd(c13, _mm_mul_pd(_mm_load_pd(a + 6), scale));
+        scale = _mm_set1_pd(b[2]);
+        c20 = _mm_add_pd(c20, _mm_mul_pd(_mm_load_pd(a), scale));
+        c21 = _mm_add_pd(c21, _mm_mul_pd(_mm_load_pd(a + 2), scale));
+        c22 = _mm_add_pd(c22, _mm_mul_pd(_mm_load_pd(a + 4), scale));
+        c23 = _mm_add_pd(c23, _mm_mul_pd(_mm_load_pd(a + 6), scale));
+        scale = _mm_set1_pd(b[3]);
+        c30 = _mm_add_pd(c30, _mm_mul_pd(_mm_load_pd(a), scale));
+        c31 = _mm_add_pd(c31, _mm_mul_pd(_mm_load_pd(a + 2), scale));
+        c32 = _mm_add_pd(c32, _mm_mul_pd(_mm_load_pd(a + 4), scale));
+        c33 = _mm_add_pd(c33, _mm_mul_pd(_mm_load_pd(a + 6), scale));
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    _mm_storeu_pd(tile, c00);
+    _mm_storeu_pd(tile + 2, c01);
+    _mm_storeu_pd(tile + 4, c02);
+    _mm_storeu_pd(tile + 6, c03);
+    _mm_storeu_pd(tile + 8, c10);
+    _mm_storeu_pd(tile + 10, c11);
+    _mm_storeu_pd(tile + 12, c12);
+    _mm_storeu_pd(tile + 14, c13);
+    _mm_storeu_pd(tile + 16, c20);
+    _mm_storeu_pd(tile + 18, c21);
+    _mm_storeu_pd(tile + 20, c22);
+    _mm_storeu_pd(tile + 22, c23);
+    _mm_storeu_pd(tile + 24, c30);
+    _mm_storeu_pd(tile + 26, c31);
+    _mm_storeu_pd(tile + 28, c32);
+    _mm_storeu_pd(tile + 30, c33);
+}
+
+// Transpose ints 4x4 at a time: pair up the runs, then pair up the pairs
+__attribute__((target("sse2")))
+static void transposeIntsSse2(int *out, ptrdiff_t outStride, const int *in, ptrdiff_t inStride, int rows, int cols) {
+    int fullRows = rows & ~3;
+    int fullCols = cols & ~3;
+    for (int r = 0; r < fullRows; r += 4) {
+        for (int c = 0; c < fullCols; c += 4) {
+            const int *from = in + c * inStride + r;
+            __m128i a = _mm_loadu_si128((const __m128i *)from);
+            __m128i b = _mm_loadu_si128((const __m128i *)(from + inStride));
+            __m128i e = _mm_loadu_si128((const __m128i *)(from + 2 * inStride));
+            __m128i d = _mm_loadu_si128((const __m128i *)(from + 3 * inStride));
+            __m128i ab01 = _mm_unpacklo_epi32(a, b);
+            __m128i ab23 = _mm_unpackhi_epi32(a, b);
+            __m128i ed01 = _mm_unpacklo_epi32(e, d);
+            __m128i ed23 = _mm_unpackhi_epi32(e, d);
+            int *to = out + r * outStride + c;
+            _mm_storeu_si128((__m128i *)to, _mm_unpacklo_epi64(ab01, ed01));
+            _mm_storeu_si128((__m128i *)(to + outStride), _mm_unpackhi_epi64(ab01, ed01));
+            _mm_storeu_si128((__m128i *)(to + 2 * outStride), _mm_unpacklo_epi64(ab23, ed23));
+            _mm_storeu_si128((__m128i *)(to + 3 * outStride), _mm_unpackhi_epi64(ab23, ed23));
+        }
+    }
+    transposeIntEdges(out, outStride, in, inStride, rows, cols, fullRows, fullCols);
+}
+
+// Transpose doubles 2x2 at a time
+__attribute__((target("sse2")))
+static void transposeDoublesSse2(double *out, ptrdiff_t outStride, const double *in, ptrdiff_t inStride, int rows,
+                                 int cols) {
+    int fullRows = rows & ~1;
+    int fullCols = cols & ~1;
+    for (int r = 0; r < fullRows; r += 2) {
+        for (int c = 0; c < fullCols; c += 2) {
+            const double *from = in + c * inStride + r;
+            __m128d a = _mm_loadu_pd(from);
+            __m128d b = _mm_loadu_pd(from + inStride);
+            double *to = out + r * outStride + c;
+            _mm_storeu_pd(to, _mm_unpacklo_pd(a, b));
+            _mm_storeu_pd(to + outStride, _mm_unpackhi_pd(a, b));
+        }
+    }
+    transposeDoubleEdges(out, outStride, in, inStride, rows, cols, fullRows, fullCols);
+}
+
+// Batch multiplications, two doubles or four ints to a register
+__attribute__((target("sse2")))
+static void batchMultiplyIntsSse2(int *c, const int *a, const int *b, int m, int n, int p) {
+    batchMultiplyIntsBody(c, a, b, m, n, p);
+}
+
+__attribute__((target("sse2")))
+static void batchMultiplyDoublesSse2(double *c, const double *a, const double *b, int m, int n, int p) {
+    batchMultiplyDoublesBody(c, a, b, m, n, p);
+}
+
+// Matrix-vector products
+__attribute__((target("sse2")))
+static void gemvRowsIntsSse2(int *y, const int *a, size_t lda, const int *x, int rows, size_t count, int alpha,
+                             int beta) {
+    gemvRowsIntsBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+__attribute__((target("sse2")))
+static void gemvRowsDoublesSse2(double *y, const double *a, size_t lda, const double *x, int rows, size_t count,
+                                double alpha, double beta) {
+    gemvRowsDoublesBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+__attribute__((target("sse2")))
+static void gemvColumnsIntsSse2(int *y, const int *a, size_t lda, const int *x, int cols, size_t count) {
+    gemvColumnsIntsBody(y, a, lda, x, cols, count);
+}
+
+__attribute__((target("sse2")))
+static void gemvColumnsDoublesSse2(double *y, const double *a, size_t lda, const double *x, int cols,
+                                   size_t count) {
+    gemvColumnsDoublesBody(y, a, lda, x, cols, count);
+}
+
+// Reductions
+DEFINE_REDUCE_KERNELS(Sse2, __attribute__((target("sse2"))))
+
+static const MatrixKernels sse2Kernels = {
+    ISA_SSE2,
+    combineIntsSse2,
+    combineDoublesSse2,
+    equalIntsSse2,
+    equalDoublesSse2,
+    gemmKernelIntsScalar,
+    gemmKernelDoublesSse2,
+    transposeIntsSse2,
+    transposeDoublesSse2,
+    batchMultiplyIntsSse2,
+    batchMultiplyDoublesSse2,
+    gemvRowsIntsSse2,
+    gemvRowsDoublesSse2,
+    gemvColumnsIntsSse2,
+    gemvColumnsDoublesSse2,
+    sumIntsSse2,
+    sumDoublesSse2,
+    extremeIntsSse2,
+    extremeDoublesSse2,
+    sumAcrossIntsSse2,
+    sumAcrossDoublesSse2,
+    extremeAcrossIntsSse2,
+    extremeAcrossDoublesSse2
+};
+
+// MARK - AVX2
+
+__attribute__((target("avx2")))
+static void combineIntsAvx2(int *out, const int *a, const int *b, size_t count, size_t step, int subtract) {
+    size_t total = count * step;
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 8 <= total; k += 8) {
+            __m256i left = _mm256_loadu_si256((const __m256i *)(a + k));
+            __m256i right = _mm256_loadu_si256((const __m256i *)(b + k));
+            _mm256_storeu_si256((__m256i *)(out + k), _mm256_sub_epi32(left, right));
+        }
+    } else {
+        for (; k + 8 <= total; k += 8) {
+            __m256i left = _mm256_loadu_si256((const __m256i *)(a + k));
+            __m256i right = _mm256_loadu_si256((const __m256i *)(b + k));
+            _mm256_storeu_si256((__m256i *)(out + k), _mm256_add_epi32(left, right));
+        }
+    }
+    combineIntsScalar(out + k, a + k, b + k, count - k / step, step, subtract);
+}
+
+__attribute__((target("avx2")))
+static void combineDoublesAvx2(double *out, const double *a, const double *b, size_t count, int subtract) {
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 4 <= count; k += 4) {
+            _mm256_storeu_pd(out + k, _mm256_sub_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k)));
+        }
+    } else {
+        for (; k + 4 <= count; k += 4) {
+            _mm256_storeu_pd(out + k, _mm256_add_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k)));
+        }
+    }
+    combineDoublesScalar(out + k, a + k, b + k, count - k, subtract);
+}
+
+__attribute__((target("avx2")))
+static int equalIntsAvx2(const int *a, const int *b, size_t count, size_t step) {
+    int lanes = (step == 1) ? 0xFF : 0x55;
+    size_t total = count * step;
+    size_t k = 0;
+    for (; k + 8 <= total; k += 8) {
+        __m256i equal = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(a + k)),
+                                           _mm256_loadu_si256((const __m256i *)(b + k)));
+        if ((_mm256_movemask_ps(_mm256_castsi256_ps(equal)) & lanes) != lanes) {
+            return 0;
+        }
+    }
+    return equalIntsScalar(a + k, b + k, count - k / step, step);
+}
+
+__attribute__((target("avx2")))
+static int equalDoublesAvx2(const double *a, const double *b, size_t count) {
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m256d equal = _mm256_cmp_pd(_mm256_loadu_pd(a + k), _mm256_loadu_pd(b + k), _CMP_EQ_OQ);
+        if (_mm256_movemask_pd(equal) != 0xF) {
+            return 0;
+        }
+    }
+    return equalDoublesScalar(a + k, b + k, count - k);
+}
+
+// Each column of the int tile is one 8 lane vector
+__attribute__((target("avx2")))
+static void gemmKernelIntsAvx2(int kc, const int *a, const int *b, int *tile) {
+    __m256i c0 = _mm256_setzero_si256(), c1 = _mm256_setzero_si256();
+    __m256i c2 = _mm256_setzero_si256(), c3 = _mm256_setzero_si256();
+    for (int k = 0; k < kc; k++) {
+        __m256i column = _mm256_loadu_si256((const __m256i *)a);
+        c0 = _mm256_add_epi32(c0, _mm256_mullo_epi32(column, _mm256_set1_epi32(b[0])));
+        c1 = _mm256_add_epi32(c1, _mm256_mullo_epi32(column, _mm256_set1_epi32(b[1])));
+        c2 = _mm256_add_epi32(c2, _mm256_mullo_epi32(column, _mm256_set1_epi32(b[2])));
+        c3 = _mm256_add_epi32(c3, _mm256_mullo_epi32(column, _mm256_set1_epi32(b[3])));
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    _mm256_storeu_si256((__m256i *)tile, c0);
+    _mm256_storeu_si256((__m256i *)(tile + 8), c1);
+    _mm256_storeu_si256((__m256i *)(tile + 16), c2);
+    _mm256_storeu_si256((__m256i *)(tile + 24), c3);
+}
+
+// Each column of the double tile is two 4 lane vectors, which gives the 8 independent sums
+// needed to keep both FMA units busy
+__attribute__((target("avx2,fma")))
+static void gemmKernelDoublesAvx2(int kc, const double *a, const double *b, double *tile) {
+    __m256d c0lo = _mm256_setzero_pd(), c0hi = _mm256_setzero_pd();
+    __m256d c1lo = _mm256_setzero_pd(), c1hi = _mm256_setzero_pd();
+    __m256d c2lo = _mm256_setzero_pd(), c2hi = _mm256_setzero_pd();
+    __m256d c3lo = _mm256_setzero_pd(), c3hi = _mm256_setzero_pd();
+    for (int k = 0; k < kc; k++) {
+        __m256d lo = _mm256_loadu_pd(a);
+        __m256d hi = _mm256_loadu_pd(a + 4);
+        __m256d scale = _mm256_broadcast_sd(b);
+        c0lo = _mm256_fmadd_pd(lo, scale, c0lo);
+        c0hi = _mm256_fmadd_pd(hi, scale, c0hi);
+        scale = _mm256_broadcast_sd(b + 1);
+        c1lo = _mm256_fmadd_pd(lo, scale, c1lo);
+        c1hi = _mm256_fmadd_pd(hi, scale, c1hi);
+        scale = _mm256_broadcast_sd(b + 2);
+        c2lo = _mm256_fmadd_pd(lo, scale, c2lo);
+        c2hi = _mm256_fmadd_pd(hi, scale, c2hi);
+        scale = _mm256_broadcast_sd(b + 3);
+        c3lo = _mm256_fmadd_pd(lo, scale, c3lo);
+        c3hi = _mm256_fmadd_pd(hi, scale, c3hi);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    _mm256_storeu_pd(tile, c0lo);
+    _mm256_storeu_pd(tile + 4, c0hi);
+    _mm256_storeu_pd(tile + 8, c1lo);
+    _mm256_storeu_pd(tile + 12, c1hi);
+    _mm256_storeu_pd(tile + 16, c2lo);
+    _mm256_storeu_pd(tile + 20, c2hi);
+    _mm256_storeu_pd(tile + 24, c3lo);
+    _mm256_storeu_pd(tile + 28, c3hi);
+}
+
+// Transpose ints 8x8 at a time: interleave neighbouring runs, then pairs of them within each 128 bit half,
+// and finally swap the halves across
+__attribute__((target("avx2")))
+static void transposeIntsAvx2(int *out, ptrdiff_t outStride, const int *in, ptrdiff_t inStride, int rows, int cols) {
+    int fullRows = rows & ~7;
+    int fullCols = cols & ~7;
+    for (int r = 0; r < fullRows; r += 8) {
+        for (int c = 0; c < fullCols; c += 8) {
+            const int *from = in + c * inStride + r;
+            __m256i t[8], u[8];
+            for (int k = 0; k < 8; k += 2) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)(from + k * inStride));
+                __m256i b = _mm256_loadu_si256((const __m256i *)(from + (k + 1) * inStride));
+                t[k] = _mm256_unpacklo_epi32(a, b);
+                t[k + 1] = _mm256_unpackhi_epi32(a, b);
+            }
+            for (int k = 0; k < 8; k += 4) {
+                u[k] = _mm256_unpacklo_epi64(t[k], t[k + 2]);
+                u[k + 1] = _mm256_unpackhi_epi64(t[k], t[k + 2]);
+                u[k + 2] = _mm256_unpacklo_epi64(t[k + 1], t[k + 3]);
+                u[k + 3] = _mm256_unpackhi_epi64(t[k + 1], t[k + 3]);
+            }
+            int *to = out + r * outStride + c;
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_si256((__m256i *)(to + k * outStride), _mm256_permute2x128_si256(u[k], u[k + 4], 0x20));
+                _mm256_storeu_si256((__m256i *)(to + (k + 4) * outStride),
+                                    _mm256_permute2x128_si256(u[k], u[k + 4], 0x31));
+            }
+        }
+    }
+    transposeIntEdges(out, outStride, in, inStride, rows, cols, fullRows, fullCols);
+}
+
+// Transpose doubles 4x4 at a time
+__attribute__((target("avx2")))
+static void transposeDoublesAvx2(double *out, ptrdiff_t outStride, const double *in, ptrdiff_t inStride, int rows,
+                                 int cols) {
+    int fullRows = rows & ~3;
+    int fullCols = cols & ~3;
+    for (int r = 0; r < fullRows; r += 4) {
+        for (int c = 0; c < fullCols; c += 4) {
+            const double *from = in + c * inStride + r;
+            __m256d a = _mm256_loadu_pd(from);
+            __m256d b = _mm256_loadu_pd(from + inStride);
+            __m256d e = _mm256_loadu_pd(from + 2 * inStride);
+            __m256d d = _mm256_loadu_pd(from + 3 * inStride);
+            __m256d ab02 = _mm256_unpacklo_pd(a, b);
+            __m256d ab13 = _mm256_unpackhi_pd(a, b);
+            __m256d ed02 = _mm256_unpacklo_pd(e, d);
+            __m256d ed13 = _mm256_unpackhi_pd(e, d);
+            double *to = out + r * outStride + c;
+            _mm256_storeu_pd(to, _mm256_permute2f128_pd(ab02, ed02, 0x20));
+            _mm256_storeu_pd(to + outStride, _mm256_permute2f128_pd(ab13, ed13, 0x20));
+            _mm256_storeu_pd(to + 2 * outStride, _mm256_permute2f128_pd(ab02, ed02, 0x31));
+            _mm256_storeu_pd(to + 3 * outStride, _mm256_permute2f128_pd(ab13, ed13, 0x31));
+        }
+    }
+    transposeDoubleEdges(out, outStride, in, inStride, rows, cols, fullRows, fullCols);
+}
+
+// Batch multiplications, with all eight lanes of ints in one register and the doubles in two
+__attribute__((target("avx2")))
+static void batchMultiplyIntsAvx2(int *c, const int *a, const int *b, int m, int n, int p) {
+    batchMultiplyIntsBody(c, a, b, m, n, p);
+}
+
+__attribute__((target("avx2,fma")))
+static void batchMultiplyDoublesAvx2(double *c, const double *a, const double *b, int m, int n, int p) {
+    batchMultiplyDoublesBody(c, a, b, m, n, p);
+}
+
+// Matrix-vector products
+__attribute__((target("avx2")))
+static void gemvRowsIntsAvx2(int *y, const int *a, size_t lda, const int *x, int rows, size_t count, int alpha,
+                             int beta) {
+    gemvRowsIntsBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+__attribute__((target("avx2,fma")))
+static void gemvRowsDoublesAvx2(double *y, const double *a, size_t lda, const double *x, int rows, size_t count,
+                                double alpha, double beta) {
+    gemvRowsDoublesBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+__attribute__((target("avx2")))
+static void gemvColumnsIntsAvx2(int *y, const int *a, size_t lda, const int *x, int cols, size_t count) {
+    gemvColumnsIntsBody(y, a, lda, x, cols, count);
+}
+
+__attribute__((target("avx2,fma")))
+static void gemvColumnsDoublesAvx2(double *y, const double *a, size_t lda, const double *x, int cols,
+                                   size_t count) {
+    gemvColumnsDoublesBody(y, a, lda, x, cols, count);
+}
+
+// Reductions
+DEFINE_REDUCE_KERNELS(Avx2, __attribute__((target("avx2"))))
+
+static const MatrixKernels avx2Kernels = {
+    ISA_AVX2,
+    combineIntsAvx2,
+    combineDoublesAvx2,
+    equalIntsAvx2,
+    equalDoublesAvx2,
+    gemmKernelIntsAvx2,
+    gemmKernelDoublesAvx2,
+    transposeIntsAvx2,
+    transposeDoublesAvx2,
+    batchMultiplyIntsAvx2,
+    batchMultiplyDoublesAvx2,
+    gemvRowsIntsAvx2,
+    gemvRowsDoublesAvx2,
+    gemvColumnsIntsAvx2,
+    gemvColumnsDoublesAvx2,
+    sumIntsAvx2,
+    sumDoublesAvx2,
+    extremeIntsAvx2,
+    extremeDoublesAvx2,
+    sumAcrossIntsAvx2,
+    sumAcrossDoublesAvx2,
+    extremeAcrossIntsAvx2,
+    extremeAcrossDoublesAvx2
+};
+
+// MARK - AVX-512
+
+__attribute__((target("avx512f")))
+static void combineIntsAvx512(int *out, const int *a, const int *b, size_t count, size_t step, int subtract) {
+    size_t total = count * step;
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 16 <= total; k += 16) {
+            _mm512_storeu_si512(out + k, _mm512_sub_epi32(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k)));
+        }
+    } else {
+        for (; k + 16 <= total; k += 16) {
+            _mm512_storeu_si512(out + k, _mm512_add_epi32(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k)));
+        }
+    }
+    combineIntsScalar(out + k, a + k, b + k, count - k / step, step, subtract);
+}
+
+__attribute__((target("avx512f")))
+static void combineDoublesAvx512(double *out, const double *a, const double *b, size_t count, int subtract) {
+    size_t k = 0;
+    if (subtract) {
+        for (; k + 8 <= count; k += 8) {
+            _mm512_storeu_pd(out + k, _mm512_sub_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k)));
+        }
+    } else {
+        for (; k + 8 <= count; k += 8) {
+            _mm512_storeu_pd(out + k, _mm512_add_pd(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k)));
+        }
+    }
+    combineDoublesScalar(out + k, a + k, b + k, count - k, subtract);
+}
+
+__attribute__((target("avx512f")))
+static int equalIntsAvx512(const int *a, const int *b, size_t count, size_t step) {
+    __mmask16 lanes = (step == 1) ? 0xFFFF : 0x5555;
+    size_t total = count * step;
+    size_t k = 0;
+    for (; k + 16 <= total; k += 16) {
+        __mmask16 equal = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k));
+        if ((equal & lanes) != lanes) {
+            return 0;
+        }
+    }
+    return equalIntsScalar(a + k, b + k, count - k / step, step);
+}
+
+__attribute__((target("avx512f")))
+static int equalDoublesAvx512(const double *a, const double *b, size_t count) {
+    size_t k = 0;
+    for (; k + 8 <= count; k += 8) {
+        if (_mm512_cmp_pd_mask(_mm512_loadu_pd(a + k), _mm512_loadu_pd(b + k), _CMP_EQ_OQ) != 0xFF) {
+            return 0;
+        }
+    }
+    return equalDoublesScalar(a + k, b + k, count - k);
+}
+
+// Each column of the double tile is one 8 lane vector. That is only 4 sums, so even and odd steps
+// of k go into separate sums, which are added together at the end.
+__attribute__((target("avx512f")))
+static void gemmKernelDoublesAvx512(int kc, const double *a, const double *b, double *tile) {
+    __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd(), c3 = _mm512_setzero_pd();
+    __m512d d0 = _mm512_setzero_pd(), d1 = _mm512_setzero_pd(), d2 = _mm512_setzero_pd(), d3 = _mm512_setzero_pd();
+    int k = 0;
+    for (; k + 2 <= kc; k += 2) {
+        __m512d even = _mm512_loadu_pd(a);
+        __m512d odd = _mm512_loadu_pd(a + GEMM_MR);
+        c0 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[0]), c0);
+        c1 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[1]), c1);
+        c2 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[2]), c2);
+        c3 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[3]), c3);
+        d0 = _mm512_fmadd_pd(odd, _mm512_set1_pd(b[4]), d0);
+        d1 = _mm512_fmadd_pd(odd, _mm512_set1_pd(b[5]), d1);
+        d2 = _mm512_fmadd_pd(odd, _mm512_set1_pd(b[6]), d2);
+        d3 = _mm512_fmadd_pd(odd, _mm512_set1_pd(b[7]), d3);
+        a += 2 * GEMM_MR;
+        b += 2 * GEMM_NR;
+    }
+    if (k < kc) {
+        __m512d even = _mm512_loadu_pd(a);
+        c0 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[0]), c0);
+        c1 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[1]), c1);
+        c2 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[2]), c2);
+        c3 = _mm512_fmadd_pd(even, _mm512_set1_pd(b[3]), c3);
+    }
+    _mm512_storeu_pd(tile, _mm512_add_pd(c0, d0));
+    _mm512_storeu_pd(tile + 8, _mm512_add_pd(c1, d1));
+    _mm512_storeu_pd(tile + 16, _mm512_add_pd(c2, d2));
+    _mm512_storeu_pd(tile + 24, _mm512_add_pd(c3, d3));
+}
+
+// Batch multiplications of doubles fill one 512 bit register with all eight lanes
+__attribute__((target("avx512f")))
+static void batchMultiplyDoublesAvx512(double *c, const double *a, const double *b, int m, int n, int p) {
+    batchMultiplyDoublesBody(c, a, b, m, n, p);
+}
+
+// Matrix-vector products of doubles, with all of a row's partial sums in one register
+__attribute__((target("avx512f")))
+static void gemvRowsDoublesAvx512(double *y, const double *a, size_t lda, const double *x, int rows, size_t count,
+                                  double alpha, double beta) {
+    gemvRowsDoublesBody(y, a, lda, x, rows, count, alpha, beta);
+}
+
+__attribute__((target("avx512f")))
+static void gemvColumnsDoublesAvx512(double *y, const double *a, size_t lda, const double *x, int cols,
+                                     size_t count) {
+    gemvColumnsDoublesBody(y, a, lda, x, cols, count);
+}
+
+// Reductions
+DEFINE_REDUCE_KERNELS(Avx512, __attribute__((target("avx512f"))))
+
+// A column of the int tile only fills half a 512 bit register, so ints keep the AVX2 microkernel.
+// The same goes for the eight lanes of a batch multiplication of ints, and the partial sums of an int matrix-vector
+// product.
+// Transposes are bound by memory rather than shuffles, so they keep the AVX2 ones too.
+static const MatrixKernels avx512Kernels = {
+    ISA_AVX512,
+    combineIntsAvx512,
+    combineDoublesAvx512,
+    equalIntsAvx512,
+    equalDoublesAvx512,
+    gemmKernelIntsAvx2,
+    gemmKernelDoublesAvx512,
+    transposeIntsAvx2,
+    transposeDoublesAvx2,
+    batchMultiplyIntsAvx2,
+    batchMultiplyDoublesAvx512,
+    gemvRowsIntsAvx2,
+    gemvRowsDoublesAvx512,
+    gemvColumnsIntsAvx2,
+    gemvColumnsDoublesAvx512,
+    sumIntsAvx512,
+    sumDoublesAvx512,
+    extremeIntsAvx512,
+    extremeDoublesAvx512,
+    sumAcrossIntsAvx512,
+    sumAcrossDoublesAvx512,
+    extremeAcrossIntsAvx512,
+    extremeAcrossDoublesAvx512
+};
+
+#endif
+
+// MARK - Dispatch
+
+// The kernel table in use, NULL until the first time it is needed
+static const MatrixKernels *activeKernels = NULL;
+
+// Whether this CPU (and this build) can run an instruction set
+static int isaSupported(InstructionSet isa) {
+#ifdef MATRIX_X86_KERNELS
+    __builtin_cpu_init();
+    switch (isa) {
+        case ISA_SCALAR:
+            return 1;
+        case ISA_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case ISA_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case ISA_AVX512:
+            // The AVX-512 table borrows the AVX2 int microkernel
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+        default:
+            return 0;
+    }
+#else
+    return isa == ISA_SCALAR;
+#endif
+}
+
+// The kernel table for a supported instruction set
+static const MatrixKernels *kernelsFor(InstructionSet isa) {
+#ifdef MATRIX_X86_KERNELS
+    switch (isa) {
+        case ISA_SSE2:
+            return &sse2Kernels;
+        case ISA_AVX2:
+            return &avx2Kernels;
+        case ISA_AVX512:
+            return &avx512Kernels;
+        default:
+            break;
+    }
+#endif
+    (void)isa;
+    return &scalarKernels;
+}
+
+// The fastest instruction set this CPU supports
+static InstructionSet bestInstructionSet(void) {
+    if (isaSupported(ISA_AVX512)) {
+        return ISA_AVX512;
+    }
+    if (isaSupported(ISA_AVX2)) {
+        return ISA_AVX2;
+    }
+    if (isaSupported(ISA_SSE2)) {
+        return ISA_SSE2;
+    }
+    return ISA_SCALAR;
+}
+
+// The instruction set named by the MATRIX_ISA environment variable (scalar, sse2, avx2 or avx512)
+// Returns ISA_AUTO if it isn't set or isn't recognised
+static InstructionSet environmentInstructionSet(void) {
+    const char *name = getenv("MATRIX_ISA");
+    if (name == NULL) {
+        return ISA_AUTO;
+    }
+    if (strcmp(name, "scalar") == 0) {
+        return ISA_SCALAR;
+    }
+    if (strcmp(name, "sse2") == 0) {
+        return ISA_SSE2;
+    }
+    if (strcmp(name, "avx2") == 0) {
+        return ISA_AVX2;
+    }
+    if (strcmp(name, "avx512") == 0) {
+        return ISA_AVX512;
+    }
+    return ISA_AUTO;
+}
+
+// Get the kernels in use, picking them the first time through
+// MATRIX_ISA wins if it names an instruction set this CPU supports, otherwise the best one is used
+const MatrixKernels *matrixKernels(void) {
+    if (activeKernels == NULL) {
+        InstructionSet isa = environmentInstructionSet();
+        if (isa == ISA_AUTO || !isaSupported(isa)) {
+            isa = bestInstructionSet();
+        }
+        activeKernels = kernelsFor(isa);
+    }
+    return activeKernels;
+}
+
+// Pick the kernels while the program starts up, before anything could be using them
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+static void pickKernelsAtStartup(void) {
+    matrixKernels();
+}
+#endif
+
+// Choose the instruction set the arithmetic kernels use
+// Accepts an instruction set enum, where ISA_AUTO goes back to the best one the CPU supports
+// Returns 1 on success, and 0 if this CPU (or this build) can't run the instruction set
+int setInstructionSet(InstructionSet isa) {
+    if (isa == ISA_AUTO) {
+        activeKernels = kernelsFor(bestInstructionSet());
+        return 1;
+    }
+    if (!isaSupported(isa)) {
+        printf("Error: Instruction set is not supported on this CPU.\n");
+        return 0;
+    }
+    activeKernels = kernelsFor(isa);
+    return 1;
+}
+
+// Get the instruction set the arithmetic kernels are using
+// Accepts nothing
+// Returns an instruction set enum, which is never ISA_AUTO
+InstructionSet getInstructionSet(void) {
+    return matrixKernels()->isa;
+}
@@ -0,0 +1,1013 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_sparse.h"
+
+// MARK - Sparse matrices
+// CSR and CSC matrices are both "compressed": lines (rows for CSR, columns for CSC) of entries sorted by their
+// index along the line, with no cell stored twice. Most of the work below is written once for compressed
+// lines and used for both. Switching between CSR and CSC is a transpose of the compressed lines, done as a
+// counting sort, and COO is brought into compressed form with two counting sorts, so nothing ever needs a
+// comparison sort. Everything that walks the entries is shared between threads once there are enough of them.
+
+// Most bytes of private partial results the threads of one CSC or COO product may use between them.
+// Those formats scatter into the result, so each extra thread adds into a zeroed copy of its own.
+#define SPARSE_SCRATCH_BYTES ((size_t)64 << 20)
+
+// The compressed lines of a CSR or CSC matrix
+typedef struct {
+    int lines;
+    int length;
+    size_t *offsets;
+    int *indices;
+    void *values;
+} Compressed;
+
+// Size in bytes of a single sparse value
+static size_t sparseValueSize(DataType data_type) {
+    return (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+}
+
+// The sparse matrix returned in error states, which has no rows, columns or arrays
+static SparseMatrix invalidSparseMatrix(void) {
+    SparseMatrix sparse = {0, 0, INT, SPARSE_COO, 0, NULL, NULL, NULL, NULL};
+    return sparse;
+}
+
+// Detect an invalid sparse matrix
+// Accepts a sparse matrix pointer
+// Returns 1 if the sparse matrix has rows, columns and the arrays its format needs, 0 otherwise
+int isValidSparse(const SparseMatrix *sparse) {
+    if (sparse == NULL || sparse->rows <= 0 || sparse->cols <= 0 || sparse->indices == NULL ||
+        sparse->values == NULL) {
+        return 0;
+    }
+    if (sparse->format == SPARSE_COO) {
+        return sparse->rowIndices != NULL;
+    }
+    return sparse->offsets != NULL;
+}
+
+// Free the memory from a sparse matrix
+// Accepts a sparse matrix pointer
+// Does not return
+void freeSparseMatrix(SparseMatrix *sparse) {
+    if (sparse == NULL) {
+        return;
+    }
+    free(sparse->offsets);
+    free(sparse->indices);
+    free(sparse->rowIndices);
+    free(sparse->values);
+    *sparse = invalidSparseMatrix();
+}
+
+// Allocate the arrays of a sparse matrix with room for 'nnz' entries
+// Returns 1 on success and 0 if the allocation failed, in which case nothing is left allocated
+static int allocateSparse(SparseMatrix *sparse, int rows, int cols, DataType data_type, SparseFormat format,
+                          size_t nnz) {
+    *sparse = invalidSparseMatrix();
+    size_t entries = (nnz > 0) ? nnz : 1;
+    if (entries > SIZE_MAX / sizeof(double)) {
+        return 0;
+    }
+    sparse->rows = rows;
+    sparse->cols = cols;
+    sparse->data_type = data_type;
+    sparse->format = format;
+    sparse->nnz = nnz;
+    sparse->indices = (int *)malloc(entries * sizeof(int));
+    sparse->values = malloc(entries * sparseValueSize(data_type));
+    int allocated = sparse->indices != NULL && sparse->values != NULL;
+    if (format == SPARSE_COO) {
+        sparse->rowIndices = (int *)malloc(entries * sizeof(int));
+        allocated = allocated && sparse->rowIndices != NULL;
+    } else {
+        size_t lines = (size_t)((format == SPARSE_CSR) ? rows : cols);
+        sparse->offsets = (size_t *)malloc((lines + 1) * sizeof(size_t));
+        allocated = allocated && sparse->offsets != NULL;
+    }
+    if (!allocated) {
+        freeSparseMatrix(sparse);
+    }
+    return allocated;
+}
+
+// The compressed lines of a CSR or CSC matrix
+static Compressed compressedLines(const SparseMatrix *sparse) {
+    Compressed lines;
+    lines.lines = (sparse->format == SPARSE_CSR) ? sparse->rows : sparse->cols;
+    lines.length = (sparse->format == SPARSE_CSR) ? sparse->cols : sparse->rows;
+    lines.offsets = sparse->offsets;
+    lines.indices = sparse->indices;
+    lines.values = sparse->values;
+    return lines;
+}
+
+// How many ranges to split 'lines' lines holding 'work' units of work into, so no range is too small to share
+static int lineRanges(size_t lines, size_t work) {
+    size_t perLine = (lines > 0) ? work / lines + 1 : 1;
+    return parallelRangeCount(lines, PARALLEL_MIN_VALUES / perLine + 1);
+}
+
+// Copy value 'from' of one array to value 'to' of another
+static void copyValue(void *target, size_t to, const void *source, size_t from, DataType data_type) {
+    if (data_type == DOUBLE) {
+        ((double *)target)[to] = ((const double *)source)[from];
+    } else {
+        ((int *)target)[to] = ((const int *)source)[from];
+    }
+}
+
+// MARK - Counting sorts
+// Both sorts below count how many entries land in each target line, turn the counts into starting positions,
+// and then drop every entry into place. Each range of the source has its own counters, so the threads never
+// share one, and because the ranges are laid out in order the sort is stable.
+
+// Turn per-range counts into per-range starting positions, and fill in the target offsets
+// 'cursors' holds 'ranges' rows of 'lines' counts
+static void startCursors(size_t *cursors, int ranges, int lines, size_t *offsets) {
+    size_t position = 0;
+    for (int j = 0; j < lines; j++) {
+        offsets[j] = position;
+        for (int r = 0; r < ranges; r++) {
+            size_t count = cursors[(size_t)r * lines + j];
+            cursors[(size_t)r * lines + j] = position;
+            position += count;
+        }
+    }
+    offsets[lines] = position;
+}
+
+// Sorting needs a counter per range per target line, which isn't worth it when those far outnumber the entries
+static int sortRanges(int ranges, int lines, size_t nnz) {
+    return ((size_t)ranges * (size_t)lines > 4 * nnz) ? 1 : ranges;
+}
+
+// One transpose of compressed lines, shared between threads
+typedef struct {
+    const Compressed *source;
+    Compressed *target;
+    size_t *cursors;
+    DataType data_type;
+} TransposeJob;
+
+// Count the entries of source lines 'start' up to 'end' that land in each target line
+static void countTransposeRange(void *context, int task, size_t start, size_t end) {
+    const TransposeJob *job = (const TransposeJob *)context;
+    size_t *counts = job->cursors + (size_t)task * job->target->lines;
+    for (size_t i = start; i < end; i++) {
+        for (size_t e = job->source->offsets[i]; e < job->source->offsets[i + 1]; e++) {
+            counts[job->source->indices[e]]++;
+        }
+    }
+}
+
+// Drop the entries of source lines 'start' up to 'end' into their target lines
+static void scatterTransposeRange(void *context, int task, size_t start, size_t end) {
+    const TransposeJob *job = (const TransposeJob *)context;
+    size_t *cursors = job->cursors + (size_t)task * job->target->lines;
+    for (size_t i = start; i < end; i++) {
+        for (size_t e = job->source->offsets[i]; e < job->source->offsets[i + 1]; e++) {
+            size_t position = cursors[job->source->indices[e]]++;
+            job->target->indices[position] = (int)i;
+            copyValue(job->target->values, position, job->source->values, e, job->data_type);
+        }
+    }
+}
+
+// Transpose compressed lines into the arrays of 'target', whose lines are the source's length
+// The entries of each target line come out sorted, because the source lines are walked in order.
+// Returns 1 on success and 0 if the counters couldn't be allocated
+static int transposeCompressed(const Compressed *source, Compressed *target, DataType data_type) {
+    size_t nnz = source->offsets[source->lines];
+    int ranges = sortRanges(lineRanges((size_t)source->lines, nnz), target->lines, nnz);
+    size_t *cursors = (size_t *)calloc((size_t)ranges * target->lines + 1, sizeof(size_t));
+    if (cursors == NULL) {
+        return 0;
+    }
+    TransposeJob job = {source, target, cursors, data_type};
+    parallelRange((size_t)source->lines, ranges, countTransposeRange, &job);
+    startCursors(cursors, ranges, target->lines, target->offsets);
+    parallelRange((size_t)source->lines, ranges, scatterTransposeRange, &job);
+    free(cursors);
+    return 1;
+}
+
+// One sort of COO entries into lines, shared between threads
+typedef struct {
+    const int *keys;
+    const int *others;
+    const void *values;
+    Compressed *target;
+    size_t *cursors;
+    DataType data_type;
+} BucketJob;
+
+// Count the entries 'start' up to 'end' that land in each target line
+static void countBucketRange(void *context, int task, size_t start, size_t end) {
+    const BucketJob *job = (const BucketJob *)context;
+    size_t *counts = job->cursors + (size_t)task * job->target->lines;
+    for (size_t e = start; e < end; e++) {
+        counts[job->keys[e]]++;
+    }
+}
+
+// Drop the entries 'start' up to 'end' into their target lines
+static void scatterBucketRange(void *context, int task, size_t start, size_t end) {
+    const BucketJob *job = (const BucketJob *)context;
+    size_t *cursors = job->cursors + (size_t)task * job->target->lines;
+    for (size_t e = start; e < end; e++) {
+        size_t position = cursors[job->keys[e]]++;
+        job->target->indices[position] = job->others[e];
+        copyValue(job->target->values, position, job->values, e, job->data_type);
+    }
+}
+
+// Sort COO entries into the lines given by 'keys', keeping the 'others' index of each
+// The entries of each line are left in the order they came in.
+// Returns 1 on success and 0 if the counters couldn't be allocated
+static int bucketEntries(const int *keys, const int *others, const void *values, size_t nnz, Compressed *target,
+                         DataType data_type) {
+    int ranges = sortRanges(parallelRangeCount(nnz, PARALLEL_MIN_VALUES), target->lines, nnz);
+    size_t *cursors = (size_t *)calloc((size_t)ranges * target->lines + 1, sizeof(size_t));
+    if (cursors == NULL) {
+        return 0;
+    }
+    BucketJob job = {keys, others, values, target, cursors, data_type};
+    parallelRange(nnz, ranges, countBucketRange, &job);
+    startCursors(cursors, ranges, target->lines, target->offsets);
+    parallelRange(nnz, ranges, scatterBucketRange, &job);
+    free(cursors);
+    return 1;
+}
+
+// MARK - Merging lines
+// Adding two compressed matrices and folding repeated cells of a COO matrix together are both a walk along
+// sorted lines that merges equal indices. The walk runs twice: once to count each output line, and once,
+// after the counts have become offsets, to write it.
+
+// One merge of compressed lines, shared between threads
+// With no second operand the lines of the first just have their repeated indices added together.
+typedef struct {
+    const Compressed *first;
+    const Compressed *second;
+    Compressed *target;
+    DataType data_type;
+    int dropZeros;
+    int writing;
+} MergeJob;
+
+// Value 'e' of an array as a double, or as an int
+static double doubleAt(const void *values, size_t e) {
+    return ((const double *)values)[e];
+}
+
+static int intAt(const void *values, size_t e) {
+    return ((const int *)values)[e];
+}
+
+// Merge lines 'start' up to 'end', either counting the entries of each output line or writing them
+static void mergeRange(void *context, int task, size_t start, size_t end) {
+    const MergeJob *job = (const MergeJob *)context;
+    const Compressed *first = job->first;
+    const Compressed *second = job->second;
+    (void)task;
+
+    for (size_t i = start; i < end; i++) {
+        size_t a = first->offsets[i], aEnd = first->offsets[i + 1];
+        size_t b = 0, bEnd = 0;
+        if (second != NULL) {
+            b = second->offsets[i];
+            bEnd = second->offsets[i + 1];
+        }
+        size_t count = 0;
+        size_t position = job->writing ? job->target->offsets[i] : 0;
+
+        while (a < aEnd || b < bEnd) {
+            // The smallest index left on either side, and the sum of every value at it
+            int index;
+            if (b >= bEnd || (a < aEnd && first->indices[a] <= second->indices[b])) {
+                index = first->indices[a];
+            } else {
+                index = second->indices[b];
+            }
+            double doubleSum = 0.0;
+            int intSum = 0;
+            while (a < aEnd && first->indices[a] == index) {
+                if (job->data_type == DOUBLE) {
+                    doubleSum += doubleAt(first->values, a);
+                } else {
+                    intSum += intAt(first->values, a);
+                }
+                a++;
+            }
+            while (b < bEnd && second->indices[b] == index) {
+                if (job->data_type == DOUBLE) {
+                    doubleSum += doubleAt(second->values, b);
+                } else {
+                    intSum += intAt(second->values, b);
+                }
+                b++;
+            }
+
+            if (job->dropZeros && ((job->data_type == DOUBLE) ? doubleSum == 0.0 : intSum == 0)) {
+                continue;
+            }
+            if (job->writing) {
+                job->target->indices[position] = index;
+                if (job->data_type == DOUBLE) {
+                    ((double *)job->target->values)[position] = doubleSum;
+                } else {
+                    ((int *)job->target->values)[position] = intSum;
+                }
+                position++;
+            }
+            count++;
+        }
+        if (!job->writing) {
+            job->target->offsets[i + 1] = count;
+        }
+    }
+}
+
+// Merge the sorted lines of one or two compressed matrices of the same shape into a new sparse matrix
+// Returns 1 on success and 0 if the result couldn't be allocated
+static int mergeCompressed(const Compressed *first, const Compressed *second, SparseMatrix *result, int rows,
+                           int cols, DataType data_type, SparseFormat format, int dropZeros) {
+    // Count each output line into a scratch offsets array first, because the result can't be sized until then
+    size_t *offsets = (size_t *)malloc(((size_t)first->lines + 1) * sizeof(size_t));
+    if (offsets == NULL) {
+        return 0;
+    }
+    size_t work = first->offsets[first->lines] + ((second != NULL) ? second->offsets[second->lines] : 0);
+    int ranges = lineRanges((size_t)first->lines, work);
+    Compressed counted = {first->lines, first->length, offsets, NULL, NULL};
+    MergeJob job = {first, second, &counted, data_type, dropZeros, 0};
+    parallelRange((size_t)first->lines, ranges, mergeRange, &job);
+    offsets[0] = 0;
+    for (int i = 0; i < first->lines; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    if (!allocateSparse(result, rows, cols, data_type, format, offsets[first->lines])) {
+        free(offsets);
+        return 0;
+    }
+    free(result->offsets);
+    result->offsets = offsets;
+    Compressed target = compressedLines(result);
+    job.target = &target;
+    job.writing = 1;
+    parallelRange((size_t)first->lines, ranges, mergeRange, &job);
+    return 1;
+}
+
+// MARK - Creation and conversion
+
+// Function to create a COO sparse matrix from lists of entries
+// Accepts the dimensions, the data type (INT or DOUBLE), the number of entries, and for each entry its row, its
+// column and its value (an int or double array). The same cell may be listed more than once, and adds up.
+// Returns a sparse matrix that owns copies of the lists
+SparseMatrix createSparseMatrix(int rows, int cols, DataType data_type, size_t nnz,
+                                const int *rowIndices, const int *colIndices, const void *values) {
+    if (rows <= 0 || cols <= 0) {
+        printf("Error: Invalid matrix dimensions.\n");
+        return invalidSparseMatrix();
+    }
+    if (data_type != INT && data_type != DOUBLE) {
+        printf("Error: Sparse matrices only hold INT or DOUBLE values.\n");
+        return invalidSparseMatrix();
+    }
+    if (nnz > 0 && (rowIndices == NULL || colIndices == NULL || values == NULL)) {
+        printf("Error: Null matrix or data.\n");
+        return invalidSparseMatrix();
+    }
+
+    // An entry outside the matrix would be written outside the arrays later on, so this check is always on
+    for (size_t e = 0; e < nnz; e++) {
+        if (rowIndices[e] < 0 || rowIndices[e] >= rows || colIndices[e] < 0 || colIndices[e] >= cols) {
+            printf("Error: Index out of bounds\n");
+            return invalidSparseMatrix();
+        }
+    }
+
+    SparseMatrix sparse;
+    if (!allocateSparse(&sparse, rows, cols, data_type, SPARSE_COO, nnz)) {
+        printf("Memory allocation failed for sparse matrix with %zu entries\n", nnz);
+        return invalidSparseMatrix();
+    }
+    if (nnz > 0) {
+        memcpy(sparse.rowIndices, rowIndices, nnz * sizeof(int));
+        memcpy(sparse.indices, colIndices, nnz * sizeof(int));
+        memcpy(sparse.values, values, nnz * sparseValueSize(data_type));
+    }
+    return sparse;
+}
+
+// Copy a sparse matrix as it is
+static SparseMatrix copySparse(const SparseMatrix *sparse) {
+    SparseMatrix copy;
+    if (!allocateSparse(&copy, sparse->rows, sparse->cols, sparse->data_type, sparse->format, sparse->nnz)) {
+        return invalidSparseMatrix();
+    }
+    memcpy(copy.indices, sparse->indices, sparse->nnz * sizeof(int));
+    memcpy(copy.values, sparse->values, sparse->nnz * sparseValueSize(sparse->data_type));
+    if (sparse->format == SPARSE_COO) {
+        memcpy(copy.rowIndices, sparse->rowIndices, sparse->nnz * sizeof(int));
+    } else {
+        size_t lines = (size_t)((sparse->format == SPARSE_CSR) ? sparse->rows : sparse->cols);
+        memcpy(copy.offsets, sparse->offsets, (lines + 1) * sizeof(size_t));
+    }
+    return copy;
+}
+
+// Switch a CSR matrix to CSC or the other way round, which is a transpose of its compressed lines
+static SparseMatrix switchCompressed(const SparseMatrix *sparse, SparseFormat format) {
+    SparseMatrix result;
+    if (!allocateSparse(&result, sparse->rows, sparse->cols, sparse->data_type, format, sparse->nnz)) {
+        return invalidSparseMatrix();
+    }
+    Compressed source = compressedLines(sparse);
+    Compressed target = compressedLines(&result);
+    if (!transposeCompressed(&source, &target, sparse->data_type)) {
+        freeSparseMatrix(&result);
+        return invalidSparseMatrix();
+    }
+    return result;
+}
+
+// Bring a COO matrix into CSR or CSC, sorted and with repeated cells added together
+// The entries are sorted into lines of the other format first, and then transposed, which sorts them.
+static SparseMatrix compressCoordinates(const SparseMatrix *sparse, SparseFormat format) {
+    SparseFormat other = (format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR;
+    SparseMatrix bucketed, sorted;
+    if (!allocateSparse(&bucketed, sparse->rows, sparse->cols, sparse->data_type, other, sparse->nnz)) {
+        return invalidSparseMatrix();
+    }
+    Compressed lines = compressedLines(&bucketed);
+    const int *keys = (other == SPARSE_CSR) ? sparse->rowIndices : sparse->indices;
+    const int *others = (other == SPARSE_CSR) ? sparse->indices : sparse->rowIndices;
+    int done = bucketEntries(keys, others, sparse->values, sparse->nnz, &lines, sparse->data_type);
+    sorted = done ? switchCompressed(&bucketed, format) : invalidSparseMatrix();
+    freeSparseMatrix(&bucketed);
+    if (!isValidSparse(&sorted)) {
+        return invalidSparseMatrix();
+    }
+
+    // Repeated cells now sit next to each other, and only need adding together if there are any
+    Compressed sortedLines = compressedLines(&sorted);
+    int repeated = 0;
+    for (int i = 0; i < sortedLines.lines && !repeated; i++) {
+        for (size_t e = sortedLines.offsets[i] + 1; e < sortedLines.offsets[i + 1]; e++) {
+            if (sortedLines.indices[e] == sortedLines.indices[e - 1]) {
+                repeated = 1;
+                break;
+            }
+        }
+    }
+    if (!repeated) {
+        return sorted;
+    }
+    SparseMatrix merged;
+    if (!mergeCompressed(&sortedLines, NULL, &merged, sparse->rows, sparse->cols, sparse->data_type, format, 0)) {
+        merged = invalidSparseMatrix();
+    }
+    freeSparseMatrix(&sorted);
+    return merged;
+}
+
+// One expansion of compressed lines into coordinates, shared between threads
+typedef struct {
+    const Compressed *source;
+    int *lineIndices;
+} ExpandJob;
+
+// Write the line of every entry of lines 'start' up to 'end'
+static void expandRange(void *context, int task, size_t start, size_t end) {
+    const ExpandJob *job = (const ExpandJob *)context;
+    (void)task;
+    for (size_t i = start; i < end; i++) {
+        for (size_t e = job->source->offsets[i]; e < job->source->offsets[i + 1]; e++) {
+            job->lineIndices[e] = (int)i;
+        }
+    }
+}
+
+// Turn a CSR or CSC matrix into COO, keeping its order
+static SparseMatrix expandCompressed(const SparseMatrix *sparse) {
+    SparseMatrix result;
+    if (!allocateSparse(&result, sparse->rows, sparse->cols, sparse->data_type, SPARSE_COO, sparse->nnz)) {
+        return invalidSparseMatrix();
+    }
+    Compressed source = compressedLines(sparse);
+    int *lineIndices = (sparse->format == SPARSE_CSR) ? result.rowIndices : result.indices;
+    int *otherIndices = (sparse->format == SPARSE_CSR) ? result.indices : result.rowIndices;
+    memcpy(otherIndices, sparse->indices, sparse->nnz * sizeof(int));
+    memcpy(result.values, sparse->values, sparse->nnz * sparseValueSize(sparse->data_type));
+    ExpandJob job = {&source, lineIndices};
+    parallelRange((size_t)source.lines, lineRanges((size_t)source.lines, sparse->nnz), expandRange, &job);
+    return result;
+}
+
+// Function to convert a sparse matrix to another sparse format
+// Accepts a sparse matrix pointer and the format to convert to
+// Returns a new sparse matrix. CSR and CSC results are sorted, with repeated COO cells added together.
+SparseMatrix convertSparseFormat(const SparseMatrix *sparse, SparseFormat format) {
+    if (!isValidSparse(sparse)) {
+        printf("Error: Invalid sparse matrix.\n");
+        return invalidSparseMatrix();
+    }
+
+    SparseMatrix result;
+    if (sparse->format == format) {
+        result = copySparse(sparse);
+    } else if (sparse->format == SPARSE_COO) {
+        result = compressCoordinates(sparse, format);
+    } else if (format == SPARSE_COO) {
+        result = expandCompressed(sparse);
+    } else {
+        result = switchCompressed(sparse, format);
+    }
+    if (!isValidSparse(&result)) {
+        printf("Memory allocation failed for sparse matrix with %zu entries\n", sparse->nnz);
+    }
+    return result;
+}
+
+// One conversion of a dense matrix into compressed lines, shared between threads
+typedef struct {
+    const void *values;
+    size_t lineStride;
+    size_t stepStride;
+    DataType data_type;
+    Compressed *target;
+    int writing;
+} DenseJob;
+
+// Count the non-zero values of lines 'start' up to 'end', or write them out as entries
+static void denseRange(void *context, int task, size_t start, size_t end) {
+    const DenseJob *job = (const DenseJob *)context;
+    (void)task;
+    for (size_t i = start; i < end; i++) {
+        size_t count = 0;
+        size_t position = job->writing ? job->target->offsets[i] : 0;
+        for (int k = 0; k < job->target->length; k++) {
+            size_t from = i * job->lineStride + (size_t)k * job->stepStride;
+            int nonZero = (job->data_type == DOUBLE) ? doubleAt(job->values, from) != 0.0
+                                                     : intAt(job->values, from) != 0;
+            if (!nonZero) {
+                continue;
+            }
+            if (job->writing) {
+                job->target->indices[position] = k;
+                copyValue(job->target->values, position, job->values, from, job->data_type);
+                position++;
+            }
+            count++;
+        }
+        if (!job->writing) {
+            job->target->offsets[i + 1] = count;
+        }
+    }
+}
+
+// Function to convert a dense matrix into a sparse one, keeping only its non-zero values
+// Accepts an INT or DOUBLE matrix pointer and the sparse format to use
+// Returns a sparse matrix
+SparseMatrix denseToSparse(const Matrix *mat, SparseFormat format) {
+    if (!isValid(mat)) {
+        printf("Error: Invalid source matrix for copying.\n");
+        return invalidSparseMatrix();
+    }
+    if (mat->data_type != INT && mat->data_type != DOUBLE) {
+        printf("Error: Sparse matrices only hold INT or DOUBLE values.\n");
+        return invalidSparseMatrix();
+    }
+    if (format == SPARSE_COO) {
+        SparseMatrix compressed = denseToSparse(mat, SPARSE_CSR);
+        SparseMatrix coordinates = isValidSparse(&compressed) ? expandCompressed(&compressed) : invalidSparseMatrix();
+        freeSparseMatrix(&compressed);
+        return coordinates;
+    }
+
+    // Walk the dense matrix along the lines of the sparse format, whatever order it is stored in
+    MatrixView view = viewMatrix(mat);
+    size_t rowStride, colStride;
+    viewValueStrides(&view, &rowStride, &colStride);
+    size_t *offsets = (size_t *)malloc(((size_t)((format == SPARSE_CSR) ? mat->rows : mat->cols) + 1) *
+                                       sizeof(size_t));
+    if (offsets == NULL) {
+        printf("Memory allocation failed for sparse matrix\n");
+        return invalidSparseMatrix();
+    }
+    Compressed counted;
+    counted.lines = (format == SPARSE_CSR) ? mat->rows : mat->cols;
+    counted.length = (format == SPARSE_CSR) ? mat->cols : mat->rows;
+    counted.offsets = offsets;
+    DenseJob job;
+    job.values = viewValues(&view);
+    job.lineStride = (format == SPARSE_CSR) ? rowStride : colStride;
+    job.stepStride = (format == SPARSE_CSR) ? colStride : rowStride;
+    job.data_type = mat->data_type;
+    job.target = &counted;
+    job.writing = 0;
+    int ranges = lineRanges((size_t)counted.lines, (size_t)mat->rows * mat->cols);
+    parallelRange((size_t)counted.lines, ranges, denseRange, &job);
+    offsets[0] = 0;
+    for (int i = 0; i < counted.lines; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+
+    SparseMatrix sparse;
+    if (!allocateSparse(&sparse, mat->rows, mat->cols, mat->data_type, format, offsets[counted.lines])) {
+        free(offsets);
+        printf("Memory allocation failed for sparse matrix\n");
+        return invalidSparseMatrix();
+    }
+    free(sparse.offsets);
+    sparse.offsets = offsets;
+    Compressed target = compressedLines(&sparse);
+    job.target = &target;
+    job.writing = 1;
+    parallelRange((size_t)counted.lines, ranges, denseRange, &job);
+    return sparse;
+}
+
+// One conversion of compressed lines into a dense matrix, shared between threads
+typedef struct {
+    const Compressed *source;
+    void *values;
+    size_t lineStride;
+    size_t stepStride;
+    DataType data_type;
+} FillJob;
+
+// Write the entries of lines 'start' up to 'end' into the dense matrix
+static void fillRange(void *context, int task, size_t start, size_t end) {
+    const FillJob *job = (const FillJob *)context;
+    (void)task;
+    for (size_t i = start; i < end; i++) {
+        for (size_t e = job->source->offsets[i]; e < job->source->offsets[i + 1]; e++) {
+            size_t to = i * job->lineStride + (size_t)job->source->indices[e] * job->stepStride;
+            copyValue(job->values, to, job->source->values, e, job->data_type);
+        }
+    }
+}
+
+// Function to convert a sparse matrix into a dense one
+// Accepts a sparse matrix pointer
+// Returns a dense matrix in the default storage order, with zeros where there were no entries
+Matrix sparseToDense(const SparseMatrix *sparse) {
+    if (!isValidSparse(sparse)) {
+        printf("Error: Invalid sparse matrix.\n");
+        return invalidMatrix();
+    }
+    Matrix dense = createMatrix(sparse->rows, sparse->cols, sparse->data_type);
+    MatrixView view = viewMatrix(&dense);
+    size_t rowStride, colStride;
+    viewValueStrides(&view, &rowStride, &colStride);
+    void *values = viewValues(&view);
+
+    // COO may list a cell more than once, so its entries are added in one at a time
+    if (sparse->format == SPARSE_COO) {
+        for (size_t e = 0; e < sparse->nnz; e++) {
+            size_t to = (size_t)sparse->rowIndices[e] * rowStride + (size_t)sparse->indices[e] * colStride;
+            if (sparse->data_type == DOUBLE) {
+                ((double *)values)[to] += doubleAt(sparse->values, e);
+            } else {
+                ((int *)values)[to] += intAt(sparse->values, e);
+            }
+        }
+        return dense;
+    }
+
+    // Compressed lines never repeat a cell, so each thread can fill its own lines
+    Compressed source = compressedLines(sparse);
+    FillJob job;
+    job.source = &source;
+    job.values = values;
+    job.lineStride = (sparse->format == SPARSE_CSR) ? rowStride : colStride;
+    job.stepStride = (sparse->format == SPARSE_CSR) ? colStride : rowStride;
+    job.data_type = sparse->data_type;
+    parallelRange((size_t)source.lines, lineRanges((size_t)source.lines, sparse->nnz), fillRange, &job);
+    return dense;
+}
+
+// Function to get an element of a sparse matrix
+// Accepts a sparse matrix pointer, a row and a column
+// Returns the element, which is zero for a cell with no entry
+MatrixElement getSparseElement(const SparseMatrix *sparse, int row, int col) {
+    MatrixElement element = {0};
+    if (!isValidSparse(sparse)) {
+        printf("Error: Invalid sparse matrix.\n");
+        return element;
+    }
+    if (sparse->data_type == DOUBLE) {
+        element.double_val = 0.0;
+    }
+
+    // The offsets are only as long as the matrix, so this check is always on
+    if (row < 0 || row >= sparse->rows || col < 0 || col >= sparse->cols) {
+        printf("Error: Index out of bounds\n");
+        return element;
+    }
+
+    // COO is scanned, adding up every entry for the cell
+    if (sparse->format == SPARSE_COO) {
+        for (size_t e = 0; e < sparse->nnz; e++) {
+            if (sparse->rowIndices[e] == row && sparse->indices[e] == col) {
+                if (sparse->data_type == DOUBLE) {
+                    element.double_val += doubleAt(sparse->values, e);
+                } else {
+                    element.int_val += intAt(sparse->values, e);
+                }
+            }
+        }
+        return element;
+    }
+
+    // Compressed lines are sorted, so the cell is found with a binary search along its line
+    int line = (sparse->format == SPARSE_CSR) ? row : col;
+    int index = (sparse->format == SPARSE_CSR) ? col : row;
+    size_t low = sparse->offsets[line], high = sparse->offsets[line + 1];
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (sparse->indices[middle] < index) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low < sparse->offsets[line + 1] && sparse->indices[low] == index) {
+        if (sparse->data_type == DOUBLE) {
+            element.double_val = doubleAt(sparse->values, low);
+        } else {
+            element.int_val = intAt(sparse->values, low);
+        }
+    }
+    return element;
+}
+
+// MARK - Arithmetic
+
+// Function to transpose a sparse matrix
+// The compressed lines of a CSR matrix, read as columns, are its transpose in CSC, so a CSR (or CSC) transpose
+// is the same counting sort as switching formats. A COO transpose just swaps the row and column lists.
+// Accepts a sparse matrix pointer
+// Returns a new sparse matrix in the same format
+SparseMatrix transposeSparseMatrix(const SparseMatrix *sparse) {
+    if (!isValidSparse(sparse)) {
+        printf("Error: Invalid sparse matrix.\n");
+        return invalidSparseMatrix();
+    }
+    SparseMatrix result;
+    if (sparse->format == SPARSE_COO) {
+        result = copySparse(sparse);
+        if (isValidSparse(&result)) {
+            int *rowIndices = result.rowIndices;
+            result.rowIndices = result.indices;
+            result.indices = rowIndices;
+        }
+    } else {
+        // Reading the source the other way round makes switching formats produce the transpose
+        SparseMatrix flipped = *sparse;
+        flipped.rows = sparse->cols;
+        flipped.cols = sparse->rows;
+        flipped.format = (sparse->format == SPARSE_CSR) ? SPARSE_CSC : SPARSE_CSR;
+        result = switchCompressed(&flipped, sparse->format);
+    }
+    if (isValidSparse(&result)) {
+        result.rows = sparse->cols;
+        result.cols = sparse->rows;
+    } else {
+        printf("Memory allocation failed for sparse matrix with %zu entries\n", sparse->nnz);
+    }
+    return result;
+}
+
+// Function to add two sparse matrices
+// Accepts two sparse matrix pointers of the same size and data type, in any formats
+// Returns a new sparse matrix, in CSC if both operands are CSC and CSR otherwise. Cells that add up to zero
+// are left out.
+SparseMatrix addSparseMatrices(const SparseMatrix *sparse1, const SparseMatrix *sparse2) {
+    if (!isValidSparse(sparse1) || !isValidSparse(sparse2)) {
+        printf("Error: Invalid sparse matrix.\n");
+        return invalidSparseMatrix();
+    }
+    if (sparse1->rows != sparse2->rows || sparse1->cols != sparse2->cols) {
+        printf("Error: Matrices dimensions do not match.\n");
+        return invalidSparseMatrix();
+    }
+    if (sparse1->data_type != sparse2->data_type) {
+        printf("Error: Matrices data types do not match.\n");
+        return invalidSparseMatrix();
+    }
+
+    // Bring both operands into the same compressed format, converting only those that aren't already
+    SparseFormat format = (sparse1->format == SPARSE_CSC && sparse2->format == SPARSE_CSC) ? SPARSE_CSC : SPARSE_CSR;
+    SparseMatrix converted1 = invalidSparseMatrix(), converted2 = invalidSparseMatrix();
+    const SparseMatrix *operand1 = sparse1, *operand2 = sparse2;
+    if (sparse1->format != format) {
+        converted1 = convertSparseFormat(sparse1, format);
+        operand1 = &converted1;
+    }
+    if (sparse2->format != format) {
+        converted2 = convertSparseFormat(sparse2, format);
+        operand2 = &converted2;
+    }
+
+    SparseMatrix result = invalidSparseMatrix();
+    if (isValidSparse(operand1) && isValidSparse(operand2)) {
+        Compressed lines1 = compressedLines(operand1);
+        Compressed lines2 = compressedLines(operand2);
+        if (!mergeCompressed(&lines1, &lines2, &result, sparse1->rows, sparse1->cols, sparse1->data_type, format, 1)) {
+            printf("Memory allocation failed for sparse matrix\n");
+            result = invalidSparseMatrix();
+        }
+    }
+    freeSparseMatrix(&converted1);
+    freeSparseMatrix(&converted2);
+    return result;
+}
+
+// One sparse times dense product, C += A * B, shared between threads
+// B and C are dense with 'k' columns, reached through their strides. CSR rows each belong to one thread.
+// CSC columns and COO entries can land anywhere in C, so every thread but the first adds into its own
+// zeroed 'rows x k' scratch copy of C, and the copies are added into C at the end.
+typedef struct {
+    const SparseMatrix *sparse;
+    const void *b;
+    size_t bRow, bCol;
+    void *c;
+    size_t cRow, cCol;
+    int k;
+    void *scratch;
+} ProductJob;
+
+// Add a * (row j of B) into row i of an output
+static void addScaledRow(const ProductJob *job, void *out, size_t outRow, size_t outCol, int i, int j, size_t e) {
+    if (job->sparse->data_type == DOUBLE) {
+        double a = doubleAt(job->sparse->values, e);
+        const double *b = (const double *)job->b + (size_t)j * job->bRow;
+        double *c = (double *)out + (size_t)i * outRow;
+        for (int col = 0; col < job->k; col++) {
+            c[col * outCol] += a * b[col * job->bCol];
+        }
+    } else {
+        int a = intAt(job->sparse->values, e);
+        const int *b = (const int *)job->b + (size_t)j * job->bRow;
+        int *c = (int *)out + (size_t)i * outRow;
+        for (int col = 0; col < job->k; col++) {
+            c[col * outCol] += a * b[col * job->bCol];
+        }
+    }
+}
+
+// Multiply rows 'start' up to 'end' of a CSR matrix
+static void productRowsRange(void *context, int task, size_t start, size_t end) {
+    const ProductJob *job = (const ProductJob *)context;
+    const SparseMatrix *sparse = job->sparse;
+    (void)task;
+    for (size_t i = start; i < end; i++) {
+        for (size_t e = sparse->offsets[i]; e < sparse->offsets[i + 1]; e++) {
+            addScaledRow(job, job->c, job->cRow, job->cCol, (int)i, sparse->indices[e], e);
+        }
+    }
+}
+
+// Multiply columns (CSC) or entries (COO) 'start' up to 'end', scattering into this thread's output
+static void productScatterRange(void *context, int task, size_t start, size_t end) {
+    const ProductJob *job = (const ProductJob *)context;
+    const SparseMatrix *sparse = job->sparse;
+    void *out = job->c;
+    size_t outRow = job->cRow, outCol = job->cCol;
+    if (task > 0) {
+        size_t copySize = (size_t)sparse->rows * job->k * sparseValueSize(sparse->data_type);
+        out = (char *)job->scratch + (size_t)(task - 1) * copySize;
+        outRow = (size_t)job->k;
+        outCol = 1;
+    }
+
+    if (sparse->format == SPARSE_COO) {
+        for (size_t e = start; e < end; e++) {
+            addScaledRow(job, out, outRow, outCol, sparse->rowIndices[e], sparse->indices[e], e);
+        }
+        return;
+    }
+    for (size_t j = start; j < end; j++) {
+        for (size_t e = sparse->offsets[j]; e < sparse->offsets[j + 1]; e++) {
+            addScaledRow(job, out, outRow, outCol, sparse->indices[e], (int)j, e);
+        }
+    }
+}
+
+// One adding up of scratch copies, shared between threads
+typedef struct {
+    const ProductJob *product;
+    int copies;
+} ReduceJob;
+
+// Add every scratch copy's rows 'start' up to 'end' into C
+static void reduceRange(void *context, int task, size_t start, size_t end) {
+    const ReduceJob *job = (const ReduceJob *)context;
+    const ProductJob *product = job->product;
+    DataType data_type = product->sparse->data_type;
+    size_t copyValues = (size_t)product->sparse->rows * product->k;
+    (void)task;
+    for (int t = 0; t < job->copies; t++) {
+        for (size_t i = start; i < end; i++) {
+            for (int col = 0; col < product->k; col++) {
+                size_t from = (size_t)t * copyValues + i * product->k + col;
+                size_t to = i * product->cRow + (size_t)col * product->cCol;
+                if (data_type == DOUBLE) {
+                    ((double *)product->c)[to] += doubleAt(product->scratch, from);
+                } else {
+                    ((int *)product->c)[to] += intAt(product->scratch, from);
+                }
+            }
+        }
+    }
+}
+
+// Work out C += A * B for a sparse A, sharing the work between threads
+static void sparseProduct(ProductJob *job) {
+    const SparseMatrix *sparse = job->sparse;
+    size_t work = sparse->nnz * (size_t)job->k;
+    if (sparse->format == SPARSE_CSR) {
+        parallelRange((size_t)sparse->rows, lineRanges((size_t)sparse->rows, work), productRowsRange, job);
+        return;
+    }
+
+    // Each extra thread needs a whole scratch copy of C, so there are only as many threads as copies that fit
+    size_t count = (sparse->format == SPARSE_CSC) ? (size_t)sparse->cols : sparse->nnz;
+    int ranges = (sparse->format == SPARSE_CSC) ? lineRanges(count, work)
+                                                : parallelRangeCount(count, PARALLEL_MIN_VALUES / job->k + 1);
+    size_t copySize = (size_t)sparse->rows * job->k * sparseValueSize(sparse->data_type);
+    if (ranges > 1 && copySize > 0 && (size_t)(ranges - 1) > SPARSE_SCRATCH_BYTES / copySize) {
+        ranges = (int)(SPARSE_SCRATCH_BYTES / copySize) + 1;
+    }
+    job->scratch = (ranges > 1) ? calloc((size_t)(ranges - 1), copySize) : NULL;
+    if (job->scratch == NULL) {
+        ranges = 1;
+    }
+    parallelRange(count, ranges, productScatterRange, job);
+    if (ranges > 1) {
+        ReduceJob reduce = {job, ranges - 1};
+        parallelRange((size_t)sparse->rows, lineRanges((size_t)sparse->rows, (size_t)(ranges - 1) * sparse->rows * job->k),
+                      reduceRange, &reduce);
+        free(job->scratch);
+    }
+}
+
+// Function to multiply a sparse matrix by a dense vector, y = A * x
+// Accepts a sparse matrix pointer, x with one value per column of A and y with one value per row of A,
+// both arrays of A's data type (int or double). Whatever y held is overwritten.
+// Returns MATRIX_SUCCESS or an error status
+MatrixStatus sparseMultiplyVector(const SparseMatrix *sparse, const void *x, void *y) {
+    if (!isValidSparse(sparse) || x == NULL || y == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    memset(y, 0, (size_t)sparse->rows * sparseValueSize(sparse->data_type));
+    ProductJob job = {sparse, x, 1, 0, y, 1, 0, 1, NULL};
+    sparseProduct(&job);
+    return MATRIX_SUCCESS;
+}
+
+// Function to multiply a sparse matrix by a dense matrix
+// Accepts a sparse matrix pointer and a dense matrix pointer of the same data type, in any layout
+// Returns a dense matrix with the dense operand's layout
+Matrix sparseMultiplyDense(const SparseMatrix *sparse, const Matrix *dense) {
+    if (!isValidSparse(sparse) || !isValid(dense)) {
+        printf("Error: Null matrix or data.\n");
+        printf("Returning empty matrix to indicate error state.\n");
+        return invalidMatrix();
+    }
+    if (sparse->cols != dense->rows) {
+        printf("Error: Matrix dimensions do not allow multiplication (cols of mat1 must equal rows of mat2).\n");
+        printf("Returning empty matrix to indicate error state.\n");
+        return invalidMatrix();
+    }
+    if (sparse->data_type != dense->data_type) {
+        printf("Error: Data types of matrices do not match.\n");
+        printf("Returning empty matrix to indicate error state.\n");
+        return invalidMatrix();
+    }
+
+    Matrix result = createMatrixWithLayout(sparse->rows, dense->cols, dense->data_type, dense->order, dense->storage);
+    MatrixView b = viewMatrix(dense);
+    MatrixView c = viewMatrix(&result);
+    ProductJob job;
+    job.sparse = sparse;
+    job.b = viewValues(&b);
+    viewValueStrides(&b, &job.bRow, &job.bCol);
+    job.c = viewValues(&c);
+    viewValueStrides(&c, &job.cRow, &job.cCol);
+    job.k = dense->cols;
+    job.scratch = NULL;
+    sparseProduct(&job);
+    return result;
+}
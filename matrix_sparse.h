@@ -0,0 +1,75 @@
+#ifndef MATRIX_SPARSE_H
+#define MATRIX_SPARSE_H
+
+#include <stddef.h>
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Enum for how the entries of a sparse matrix are kept
+// SPARSE_CSR (compressed sparse row) keeps the entries row by row, sorted by column within each row.
+// SPARSE_CSC (compressed sparse column) keeps them column by column, sorted by row within each column.
+// SPARSE_COO (coordinate) keeps a row, column and value per entry in any order, and may hold the same cell
+// more than once, in which case the values add up. It is the easy format to build a matrix in.
+typedef enum {
+    SPARSE_CSR,
+    SPARSE_CSC,
+    SPARSE_COO
+} SparseFormat;
+
+// Struct for a sparse matrix of INT or DOUBLE values, which only stores its 'nnz' entries
+// For CSR, entry e of row i is at offsets[i] <= e < offsets[i + 1], and its column is indices[e].
+// For CSC, entry e of column j is at offsets[j] <= e < offsets[j + 1], and its row is indices[e].
+// For COO, entry e is at row rowIndices[e], column indices[e], and there are no offsets.
+// 'values' holds nnz ints or doubles, depending on the data type.
+typedef struct {
+    int rows;
+    int cols;
+    DataType data_type;
+    SparseFormat format;
+    size_t nnz;
+    size_t *offsets;
+    int *indices;
+    int *rowIndices;
+    void *values;
+} SparseMatrix;
+
+// Create a COO sparse matrix from a copy of 'nnz' rows, columns and values (ints or doubles)
+SparseMatrix createSparseMatrix(int rows, int cols, DataType data_type, size_t nnz,
+                                const int *rowIndices, const int *colIndices, const void *values);
+
+// Detect an invalid sparse matrix
+int isValidSparse(const SparseMatrix *sparse);
+
+// Convert between dense and sparse
+SparseMatrix denseToSparse(const Matrix *mat, SparseFormat format);
+Matrix sparseToDense(const SparseMatrix *sparse);
+
+// Convert a sparse matrix to another sparse format
+SparseMatrix convertSparseFormat(const SparseMatrix *sparse, SparseFormat format);
+
+// Get an element of a sparse matrix
+MatrixElement getSparseElement(const SparseMatrix *sparse, int row, int col);
+
+// Transpose a sparse matrix, keeping its format
+SparseMatrix transposeSparseMatrix(const SparseMatrix *sparse);
+
+// Add two sparse matrices
+SparseMatrix addSparseMatrices(const SparseMatrix *sparse1, const SparseMatrix *sparse2);
+
+// Multiply a sparse matrix by a dense vector, y = A * x
+MatrixStatus sparseMultiplyVector(const SparseMatrix *sparse, const void *x, void *y);
+
+// Multiply a sparse matrix by a dense matrix
+Matrix sparseMultiplyDense(const SparseMatrix *sparse, const Matrix *dense);
+
+// Free the memory from a sparse matrix
+void freeSparseMatrix(SparseMatrix *sparse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1297 @@
+// write lives behind POSIX, which -std=c99 hides unless we ask for it
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+#include "matrix_text.h"
+
+// MARK - Matrix text
+// Matrices are written as text into one large buffer, which is handed to the sink whenever it fills up, so a
+// sink sees a handful of big writes instead of one call per value. Values are formatted by hand: ints with a
+// two digits at a time table, and doubles from their exact binary value with 128 bit integer arithmetic, which
+// gives the same digits printf does (rounding ties to even) without parsing a format string for every value.
+// The few doubles that don't fit that arithmetic (infinities, NaNs, and magnitudes far from 1) go to snprintf.
+
+// How much text is gathered before it is handed to the sink
+#define TEXT_BUFFER_BYTES ((size_t)64 << 10)
+
+// Room one value may need: a sign, 309 integer digits, a point and TEXT_MAX_PRECISION digits, with some to spare
+#define TEXT_VALUE_BYTES 384
+
+// Widest power of ten the exact arithmetic uses, which keeps a 53 bit mantissa times it within 128 bits
+#define EXACT_MAX_POWER 22
+
+// Text waiting to be handed to a sink
+typedef struct {
+    char buffer[TEXT_BUFFER_BYTES];
+    size_t used;
+    TextSink sink;
+    int failed;
+} TextWriter;
+
+// Every pair of decimal digits, so integers are written two digits per division
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Hand the buffered text to the sink
+static void flushText(TextWriter *writer) {
+    if (writer->used > 0 && !writer->failed) {
+        if (writer->sink.write(writer->sink.context, writer->buffer, writer->used) != writer->used) {
+            writer->failed = 1;
+        }
+    }
+    writer->used = 0;
+}
+
+// Make sure there is room for one more value in the buffer, and return where it goes
+static char *reserveText(TextWriter *writer) {
+    if (writer->used + TEXT_VALUE_BYTES > TEXT_BUFFER_BYTES) {
+        flushText(writer);
+    }
+    return writer->buffer + writer->used;
+}
+
+// Write the digits of an unsigned integer
+// Returns how many characters were written
+static size_t formatUnsigned(char *out, uint64_t value) {
+    char digits[20];
+    size_t start = sizeof(digits);
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        digits[--start] = DIGIT_PAIRS[pair + 1];
+        digits[--start] = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10) {
+        digits[--start] = DIGIT_PAIRS[value * 2 + 1];
+        digits[--start] = DIGIT_PAIRS[value * 2];
+    } else {
+        digits[--start] = (char)('0' + value);
+    }
+    memcpy(out, digits + start, sizeof(digits) - start);
+    return sizeof(digits) - start;
+}
+
+// Write an int
+// Returns how many characters were written
+static size_t formatInt(char *out, int value) {
+    if (value < 0) {
+        out[0] = '-';
+        return 1 + formatUnsigned(out + 1, (uint64_t)(-(int64_t)value));
+    }
+    return formatUnsigned(out, (uint64_t)value);
+}
+
+// Write a double with snprintf, for the values the exact arithmetic can't handle
+// A negative precision asks for the fewest significant digits that read back as the same double. A normal
+// double that reads back from fewer than 15 digits comes out of "%.15g" with just those, once its trailing
+// zeros are dropped, so only subnormals (which have fewer bits of precision) need to try fewer.
+// Returns how many characters were written
+static size_t formatDoubleFallback(char *out, double value, int precision) {
+    if (precision >= 0) {
+        return (size_t)snprintf(out, TEXT_VALUE_BYTES, "%.*f", precision, value);
+    }
+    int written = 0;
+    int subnormal = (value != 0.0 && value < DBL_MIN && value > -DBL_MIN);
+    for (int digits = subnormal ? 1 : 15; digits <= 17; digits++) {
+        written = snprintf(out, TEXT_VALUE_BYTES, "%.*g", digits, value);
+        if (value != value || strtod(out, NULL) == value) {
+            break;
+        }
+    }
+    return (size_t)written;
+}
+
+#ifdef __SIZEOF_INT128__
+
+typedef unsigned __int128 Wide;
+
+// Powers of ten that fit in 64 bits
+static const uint64_t POWERS_OF_TEN[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+    10000000000000000000ull
+};
+
+// 10 to the power 'power', for powers up to EXACT_MAX_POWER
+static Wide wideTen(int power) {
+    if (power < 20) {
+        return POWERS_OF_TEN[power];
+    }
+    return (Wide)POWERS_OF_TEN[19] * POWERS_OF_TEN[power - 19];
+}
+
+// Write the digits of a 128 bit unsigned integer
+// Returns how many characters were written
+static size_t formatWide(char *out, Wide value) {
+    if (value <= UINT64_MAX) {
+        return formatUnsigned(out, (uint64_t)value);
+    }
+    // Anything wider is split into its top digits and exactly 19 more
+    Wide chunk = POWERS_OF_TEN[19];
+    size_t length = formatWide(out, value / chunk);
+    uint64_t low = (uint64_t)(value % chunk);
+    for (int i = 18; i >= 0; i--) {
+        out[length + i] = (char)('0' + low % 10);
+        low /= 10;
+    }
+    return length + 19;
+}
+
+// Write 'scaled' / 10^precision, with exactly 'precision' digits after the decimal point
+// Returns how many characters were written
+static size_t formatScaled(char *out, Wide scaled, int precision, int negative) {
+    size_t length = 0;
+    if (negative) {
+        out[length++] = '-';
+    }
+    char digits[48];
+    size_t count = formatWide(digits, scaled);
+    if (precision == 0) {
+        memcpy(out + length, digits, count);
+        return length + count;
+    }
+
+    // Numbers below 1 get a leading zero, and zeros after the point up to their first digit
+    if (count <= (size_t)precision) {
+        out[length++] = '0';
+        out[length++] = '.';
+        memset(out + length, '0', (size_t)precision - count);
+        length += (size_t)precision - count;
+        memcpy(out + length, digits, count);
+        return length + count;
+    }
+    size_t whole = count - (size_t)precision;
+    memcpy(out + length, digits, whole);
+    length += whole;
+    out[length++] = '.';
+    memcpy(out + length, digits + whole, (size_t)precision);
+    return length + (size_t)precision;
+}
+
+// Round mantissa * 2^exponent * 10^power to the nearest integer, ties to even, for a negative exponent
+static Wide roundScaled(uint64_t mantissa, int exponent, int power) {
+    Wide product = (Wide)mantissa * wideTen(power);
+    int shift = -exponent;
+    if (shift >= 128) {
+        // The product is below 2^127, so it is less than half of 2^shift and rounds to zero
+        return 0;
+    }
+    Wide quotient = product >> shift;
+    Wide remainder = product - (quotient << shift);
+    Wide half = (Wide)1 << (shift - 1);
+    if (remainder > half || (remainder == half && (quotient & 1))) {
+        quotient++;
+    }
+    return quotient;
+}
+
+// Write a finite double with 'precision' digits after the point, or the fewest that read back as the same double
+// Returns how many characters were written, or 0 if the value is out of the exact arithmetic's reach
+static size_t formatDoubleExact(char *out, double value, int precision) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int negative = (int)(bits >> 63);
+    int biased = (int)((bits >> 52) & 0x7ff);
+    uint64_t mantissa = bits & ((1ull << 52) - 1);
+    if (biased == 0x7ff || precision > EXACT_MAX_POWER) {
+        return 0;
+    }
+    int exponent = (biased == 0) ? -1074 : biased - 1075;
+    if (biased != 0) {
+        mantissa |= 1ull << 52;
+    }
+
+    // Whole numbers are exact as they are, so their digits are all there is to write either way
+    if (exponent >= 0) {
+        if (exponent > 74) {
+            return 0;
+        }
+        int places = (precision > 0) ? precision : 0;
+        Wide whole = (Wide)mantissa << exponent;
+        if (whole > ~(Wide)0 / wideTen(places)) {
+            return 0;
+        }
+        return formatScaled(out, whole * wideTen(places), places, negative);
+    }
+    if (precision >= 0) {
+        return formatScaled(out, roundScaled(mantissa, exponent, precision), precision, negative);
+    }
+
+    // The shortest text is the first number of places whose nearest decimal reads back as this double: one
+    // that lies within half a gap of it either side (a quarter below a power of two, where the gap below
+    // halves). Counted in 2^(exponent - 1) / 10^power, the decimal is scaled << (shift + 1) and the double
+    // is 2 * mantissa * 10^power, both of which fit in 128 bits while the shift stays under 63.
+    int shift = -exponent;
+    if (shift > 62) {
+        return 0;
+    }
+    int halvedBelow = (mantissa == (1ull << 52) && biased > 1);
+    for (int power = 0; power <= EXACT_MAX_POWER; power++) {
+        Wide scaled = roundScaled(mantissa, exponent, power);
+        if (scaled > UINT64_MAX) {
+            return 0;
+        }
+        Wide ten = wideTen(power);
+        Wide decimal = scaled << (shift + 1);
+        Wide target = (Wide)mantissa * ten * 2;
+        Wide distance;
+        if (decimal >= target) {
+            distance = decimal - target;
+        } else {
+            distance = target - decimal;
+            if (halvedBelow) {
+                distance = (distance > ten) ? ten + 1 : distance * 2;
+            }
+        }
+        if (distance < ten || (distance == ten && (mantissa & 1) == 0)) {
+            return formatScaled(out, scaled, power, negative);
+        }
+    }
+    return 0;
+}
+
+#else
+
+// Without 128 bit integers every double goes through snprintf
+static size_t formatDoubleExact(char *out, double value, int precision) {
+    (void)out;
+    (void)value;
+    (void)precision;
+    return 0;
+}
+
+#endif
+
+// Write a double
+// Returns how many characters were written
+static size_t formatDouble(char *out, double value, int precision) {
+    size_t length = formatDoubleExact(out, value, precision);
+    return (length > 0) ? length : formatDoubleFallback(out, value, precision);
+}
+
+// Write a char, quoted if CSV needs it to be
+// Returns how many characters were written
+static size_t formatChar(char *out, char value, TextDialect dialect) {
+    if (dialect == TEXT_CSV && (value == ',' || value == '"' || value == '\n' || value == '\r')) {
+        size_t length = 0;
+        out[length++] = '"';
+        out[length++] = value;
+        if (value == '"') {
+            out[length++] = '"';
+        }
+        out[length++] = '"';
+        return length;
+    }
+    out[0] = value;
+    return 1;
+}
+
+// Function to write a view as text
+// Rows are written top to bottom, each ending in a line break, whatever order the view is stored in.
+// Accepts a view pointer, the text format (precision is clamped to TEXT_MAX_PRECISION) and a sink
+// Returns MATRIX_SUCCESS, or an error status if the view is missing or the sink stopped taking text
+MatrixStatus writeMatrixViewText(const MatrixView *view, TextFormat format, TextSink sink) {
+    if (view == NULL || sink.write == NULL || (view->block == NULL && view->rows > 0 && view->cols > 0)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    if (view->data_type != INT && view->data_type != DOUBLE && view->data_type != CHAR) {
+        printf("Error: Unknown data type\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    if (view->rows <= 0 || view->cols <= 0) {
+        return MATRIX_SUCCESS;
+    }
+    int precision = format.precision;
+    if (precision > TEXT_MAX_PRECISION) {
+        precision = TEXT_MAX_PRECISION;
+    } else if (precision < TEXT_SHORTEST) {
+        precision = TEXT_SHORTEST;
+    }
+    char separator = (format.dialect == TEXT_CSV) ? ',' : '\t';
+    int trailing = (format.dialect == TEXT_PRINT);
+
+    TextWriter *writer = (TextWriter *)malloc(sizeof(TextWriter));
+    if (writer == NULL) {
+        printf("Memory allocation failed for matrix text\n");
+        return MATRIX_ERROR_IO;
+    }
+    writer->used = 0;
+    writer->sink = sink;
+    writer->failed = 0;
+
+    size_t rowStride, colStride;
+    viewValueStrides(view, &rowStride, &colStride);
+    const char *values = (const char *)viewValues(view);
+    for (int r = 0; r < view->rows && !writer->failed; r++) {
+        for (int c = 0; c < view->cols; c++) {
+            char *out = reserveText(writer);
+            size_t index = (size_t)r * rowStride + (size_t)c * colStride;
+            size_t length;
+            switch (view->data_type) {
+                case INT:
+                    length = formatInt(out, ((const int *)values)[index]);
+                    break;
+                case DOUBLE:
+                    length = formatDouble(out, ((const double *)values)[index], precision);
+                    break;
+                default:
+                    length = formatChar(out, values[index], format.dialect);
+                    break;
+            }
+            if (trailing || c + 1 < view->cols) {
+                out[length++] = separator;
+            }
+            writer->used += length;
+        }
+        writer->buffer[writer->used++] = '\n';
+    }
+    flushText(writer);
+
+    MatrixStatus status = writer->failed ? MATRIX_ERROR_IO : MATRIX_SUCCESS;
+    free(writer);
+    return status;
+}
+
+// Function to write a matrix as text
+// Accepts a matrix pointer, the text format and a sink
+// Returns MATRIX_SUCCESS or an error status
+MatrixStatus writeMatrixText(const Matrix *mat, TextFormat format, TextSink sink) {
+    if (mat == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView view = viewMatrix(mat);
+    return writeMatrixViewText(&view, format, sink);
+}
+
+// MARK - Sinks
+
+// Hand text to a stdio stream
+static size_t writeToFile(void *context, const char *text, size_t size) {
+    return fwrite(text, 1, size, (FILE *)context);
+}
+
+// Function to make a sink that writes to a stdio stream
+// Text written this way stays in order with anything else printed to the same stream.
+// Accepts the stream
+// Returns the sink
+TextSink fileTextSink(FILE *file) {
+    TextSink sink = {writeToFile, file};
+    return sink;
+}
+
+// Hand text to a file descriptor, as many writes as it takes
+static size_t writeToDescriptor(void *context, const char *text, size_t size) {
+    int descriptor = (int)(intptr_t)context;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t written = write(descriptor, text + done, size - done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            break;
+        }
+        done += (size_t)written;
+    }
+    return done;
+}
+
+// Function to make a sink that writes to a file descriptor
+// Accepts the descriptor
+// Returns the sink
+TextSink descriptorTextSink(int descriptor) {
+    TextSink sink = {writeToDescriptor, (void *)(intptr_t)descriptor};
+    return sink;
+}
+
+// A string that grows as text is written to it
+typedef struct {
+    char *text;
+    size_t length;
+    size_t capacity;
+} TextString;
+
+// Append text to a growing string, doubling its capacity when it runs out
+static size_t writeToString(void *context, const char *text, size_t size) {
+    TextString *string = (TextString *)context;
+    if (string->length + size + 1 > string->capacity) {
+        size_t capacity = (string->capacity > 0) ? string->capacity : TEXT_BUFFER_BYTES;
+        while (string->length + size + 1 > capacity) {
+            capacity *= 2;
+        }
+        char *grown = (char *)realloc(string->text, capacity);
+        if (grown == NULL) {
+            return 0;
+        }
+        string->text = grown;
+        string->capacity = capacity;
+    }
+    memcpy(string->text + string->length, text, size);
+    string->length += size;
+    return size;
+}
+
+// Function to write a view as text into a new string
+// Accepts a view pointer, the text format, and optionally where to put the string's length
+// Returns a null terminated string the caller frees, or NULL on error
+char *matrixViewToText(const MatrixView *view, TextFormat format, size_t *length) {
+    TextString string = {NULL, 0, 0};
+    TextSink sink = {writeToString, &string};
+    if (writeMatrixViewText(view, format, sink) != MATRIX_SUCCESS) {
+        free(string.text);
+        return NULL;
+    }
+
+    // The string always keeps room for its terminator, but an empty view never allocated one
+    if (string.text == NULL) {
+        string.text = (char *)malloc(1);
+        if (string.text == NULL) {
+            return NULL;
+        }
+    }
+    string.text[string.length] = '\0';
+    if (length != NULL) {
+        *length = string.length;
+    }
+    return string.text;
+}
+
+// MARK - Reading text
+// Text is read a large chunk at a time, and each chunk is cut after its last complete line and parsed in two
+// passes that are shared between threads: every range of the chunk first counts the lines that start in it,
+// so each line knows which row (or entry) it is, and then parses them straight into place. Blank lines are
+// skipped. Numbers are parsed by hand; a double with up to 19 significant digits and a power of ten up to 22
+// is exact in one multiply or divide, and anything else goes to strtod.
+
+// How much text is read before it is parsed
+#define READ_CHUNK_BYTES ((size_t)16 << 20)
+
+// Fewest bytes of text each thread parses
+#define READ_MIN_BYTES ((size_t)1 << 20)
+
+// Longest number strtod is handed
+#define READ_NUMBER_BYTES 128
+
+// Rows a text matrix starts with room for, doubling whenever it fills up
+#define READ_FIRST_ROWS 1024
+
+// What to do with each line of a text file
+// 'parse' gets each non-blank line along with its place among them, and returns 0 if it can't be parsed.
+// 'prepare' is told how many lines there will be once the coming chunk is parsed, and returns 0 if that
+// can't be made room for.
+typedef struct {
+    int (*parse)(void *context, const char *line, const char *end, size_t index);
+    int (*prepare)(void *context, size_t lines);
+    void *context;
+} LineHandler;
+
+// Powers of ten that doubles hold exactly
+static const double EXACT_POWERS[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Whether a character is space between values. A tab only is when it isn't the separator.
+static int isBlank(char c, char separator) {
+    return c == ' ' || c == '\r' || (c == '\t' && separator != '\t');
+}
+
+// Step over the space before or after a value
+static const char *skipBlanks(const char *p, const char *end, char separator) {
+    while (p < end && isBlank(*p, separator)) {
+        p++;
+    }
+    return p;
+}
+
+// Whether a line has nothing on it but space
+static int isBlankLine(const char *line, const char *end) {
+    for (const char *p = line; p < end; p++) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Parse an int that takes up all of text up to 'end'
+// Returns 1 on success, 0 if it isn't an int
+static int parseIntToken(const char *p, const char *end, int *value) {
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == end) {
+        return 0;
+    }
+    int64_t magnitude = 0;
+    for (; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        magnitude = magnitude * 10 + (*p - '0');
+        if (magnitude > (int64_t)INT_MAX + 1) {
+            return 0;
+        }
+    }
+    if (!negative && magnitude > INT_MAX) {
+        return 0;
+    }
+    *value = (int)(negative ? -magnitude : magnitude);
+    return 1;
+}
+
+// Parse a double that takes up all of text up to 'end' with strtod
+// Returns 1 on success, 0 if it isn't a double
+static int parseDoubleSlowly(const char *p, const char *end, double *value) {
+    char number[READ_NUMBER_BYTES];
+    size_t length = (size_t)(end - p);
+    if (length == 0 || length >= sizeof(number)) {
+        return 0;
+    }
+    memcpy(number, p, length);
+    number[length] = '\0';
+    char *stop;
+    *value = strtod(number, &stop);
+    return stop == number + length;
+}
+
+// Parse a double that takes up all of text up to 'end'
+// Returns 1 on success, 0 if it isn't a double
+static int parseDoubleToken(const char *start, const char *end, double *value) {
+    const char *p = start;
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    // Gather up to 19 significant digits, and the power of ten that places them
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0, seen = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++, seen++) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits += (mantissa > 0);
+        } else {
+            exponent++;
+            digits++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, seen++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits += (mantissa > 0);
+                exponent--;
+            } else {
+                digits++;
+            }
+        }
+    }
+    if (seen > 0 && p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        int exponentNegative = 0;
+        if (q < end && (*q == '-' || *q == '+')) {
+            exponentNegative = (*q == '-');
+            q++;
+        }
+        int written = 0;
+        if (q == end) {
+            return 0;
+        }
+        for (; q < end && *q >= '0' && *q <= '9'; q++) {
+            if (written < 100000) {
+                written = written * 10 + (*q - '0');
+            }
+        }
+        exponent += exponentNegative ? -written : written;
+        p = q;
+    }
+
+    // Anything the fast path can't take exactly, including "inf" and "nan", goes to strtod
+    if (seen == 0 || p != end || digits > 19 || mantissa > (1ull << 53) || exponent < -22 || exponent > 22) {
+        return parseDoubleSlowly(start, end, value);
+    }
+    double result = (double)mantissa;
+    result = (exponent < 0) ? result / EXACT_POWERS[-exponent] : result * EXACT_POWERS[exponent];
+    *value = negative ? -result : result;
+    return 1;
+}
+
+// Parse one value of a data type, which runs up to the separator, space or the end of the line
+// CHAR values are a single character, which CSV may quote (doubling a quote inside), and keep any space.
+// Returns where the value ends, or NULL if it can't be parsed
+static const char *parseValue(const char *p, const char *end, char separator, DataType data_type, void *out) {
+    if (data_type == CHAR) {
+        if (separator == ',' && p + 2 < end && p[0] == '"') {
+            if (p[1] == '"' && p + 3 < end && p[2] == '"' && p[3] == '"') {
+                *(char *)out = '"';
+                return p + 4;
+            }
+            if (p[2] == '"' && p[1] != '"') {
+                *(char *)out = p[1];
+                return p + 3;
+            }
+        }
+        if (p < end && *p != separator) {
+            *(char *)out = *p;
+            return p + 1;
+        }
+        return NULL;
+    }
+
+    const char *token = p;
+    while (p < end && *p != separator && !isBlank(*p, separator)) {
+        p++;
+    }
+    int parsed = (data_type == DOUBLE) ? parseDoubleToken(token, p, (double *)out)
+                                       : parseIntToken(token, p, (int *)out);
+    return parsed ? p : NULL;
+}
+
+// One chunk of lines, parsed between threads
+typedef struct {
+    const char *text;
+    size_t size;
+    size_t firstIndex;
+    size_t *counts;
+    size_t *failures;
+    const LineHandler *handler;
+    int parsing;
+} ChunkJob;
+
+// Count, or parse, the non-blank lines that start between 'start' and 'end' of a chunk
+static void chunkRange(void *context, int task, size_t start, size_t end) {
+    ChunkJob *job = (ChunkJob *)context;
+    const char *chunkEnd = job->text + job->size;
+    const char *p = job->text;
+    if (start > 0) {
+        p = (const char *)memchr(job->text + start - 1, '\n', job->size - (start - 1)) + 1;
+    }
+
+    size_t index = job->parsing ? job->counts[task] : 0;
+    while (p < job->text + end) {
+        const char *lineEnd = (const char *)memchr(p, '\n', (size_t)(chunkEnd - p));
+        if (!isBlankLine(p, lineEnd)) {
+            if (job->parsing && job->failures[task] == SIZE_MAX &&
+                !job->handler->parse(job->handler->context, p, lineEnd, index)) {
+                job->failures[task] = index;
+            }
+            index++;
+        }
+        p = lineEnd + 1;
+    }
+    if (!job->parsing) {
+        job->counts[task] = index;
+    }
+}
+
+// Parse a chunk of complete lines, the first of which is line 'firstIndex'
+// Returns how many non-blank lines there were, or SIZE_MAX on error
+static size_t parseChunk(const char *text, size_t size, size_t firstIndex, const LineHandler *handler) {
+    int ranges = parallelRangeCount(size, READ_MIN_BYTES);
+    size_t *counts = (size_t *)malloc(2 * (size_t)ranges * sizeof(size_t));
+    if (counts == NULL) {
+        printf("Memory allocation failed for matrix text\n");
+        return SIZE_MAX;
+    }
+    ChunkJob job = {text, size, firstIndex, counts, counts + ranges, handler, 0};
+    parallelRange(size, ranges, chunkRange, &job);
+
+    // Each range's count becomes the place of its first line
+    size_t index = firstIndex;
+    for (int t = 0; t < ranges; t++) {
+        size_t count = counts[t];
+        counts[t] = index;
+        job.failures[t] = SIZE_MAX;
+        index += count;
+    }
+    size_t lines = index - firstIndex;
+    if (handler->prepare != NULL && !handler->prepare(handler->context, index)) {
+        free(counts);
+        return SIZE_MAX;
+    }
+    job.parsing = 1;
+    parallelRange(size, ranges, chunkRange, &job);
+
+    for (int t = 0; t < ranges; t++) {
+        if (job.failures[t] != SIZE_MAX) {
+            printf("Error: Could not parse line %zu of matrix text.\n", job.failures[t] + 1);
+            lines = SIZE_MAX;
+            break;
+        }
+    }
+    free(counts);
+    return lines;
+}
+
+// Read the rest of a file a chunk at a time, handing every non-blank line to a handler
+// Returns how many lines there were, or SIZE_MAX on error
+static size_t readLines(FILE *file, const LineHandler *handler) {
+    size_t capacity = READ_CHUNK_BYTES;
+    char *buffer = (char *)malloc(capacity + 1);
+    if (buffer == NULL) {
+        printf("Memory allocation failed for matrix text\n");
+        return SIZE_MAX;
+    }
+
+    size_t held = 0, lines = 0;
+    for (;;) {
+        held += fread(buffer + held, 1, capacity - held, file);
+        if (ferror(file)) {
+            printf("Error: Could not read matrix text.\n");
+            lines = SIZE_MAX;
+            break;
+        }
+        int finished = (held < capacity);
+
+        // Parse up to the last line break, or everything once the file has ended
+        size_t size = held;
+        if (finished) {
+            if (held > 0 && buffer[held - 1] != '\n') {
+                buffer[held++] = '\n';
+                size = held;
+            }
+        } else {
+            while (size > 0 && buffer[size - 1] != '\n') {
+                size--;
+            }
+            if (size == 0) {
+                // A line longer than the buffer, so make the buffer longer
+                char *grown = (char *)realloc(buffer, 2 * capacity + 1);
+                if (grown == NULL) {
+                    printf("Memory allocation failed for matrix text\n");
+                    lines = SIZE_MAX;
+                    break;
+                }
+                buffer = grown;
+                capacity *= 2;
+                continue;
+            }
+        }
+
+        if (size > 0) {
+            size_t parsed = parseChunk(buffer, size, lines, handler);
+            if (parsed == SIZE_MAX) {
+                lines = SIZE_MAX;
+                break;
+            }
+            lines += parsed;
+        }
+        memmove(buffer, buffer + size, held - size);
+        held -= size;
+        if (finished) {
+            break;
+        }
+    }
+    free(buffer);
+    return lines;
+}
+
+// A dense matrix being read from delimited text, one row per line, into a packed row major matrix
+typedef struct {
+    Matrix mat;
+    int cols;
+    char separator;
+    size_t valueSize;
+    int firstRow;
+} DenseText;
+
+// Parse a line of delimited text into row 'index'. A separator after the last value is allowed.
+static int parseDenseLine(void *context, const char *line, const char *end, size_t index) {
+    const DenseText *text = (const DenseText *)context;
+    char *row = (char *)text->mat.block + (index + (size_t)text->firstRow) * text->cols * text->valueSize;
+    int keepsSpace = (text->mat.data_type == CHAR);
+    const char *p = line;
+    for (int c = 0; c < text->cols; c++) {
+        if (!keepsSpace) {
+            p = skipBlanks(p, end, text->separator);
+        }
+        p = parseValue(p, end, text->separator, text->mat.data_type, row + (size_t)c * text->valueSize);
+        if (p == NULL) {
+            return 0;
+        }
+        if (!keepsSpace) {
+            p = skipBlanks(p, end, text->separator);
+        }
+        if (c + 1 < text->cols) {
+            if (p >= end || *p != text->separator) {
+                return 0;
+            }
+            p++;
+        }
+    }
+    if (p < end && *p == text->separator) {
+        p++;
+    }
+    return isBlankLine(p, end);
+}
+
+// Whether a first line that doesn't parse is a header: none of its fields may be a value on its own. Numbers count
+// as values whatever type is being read, so a row of INT text with a stray decimal isn't mistaken for a header,
+// and for CHAR every field of a single character does.
+static int isHeaderLine(const char *line, const char *end, char separator, DataType data_type) {
+    const char *p = line;
+    while (p <= end) {
+        const char *fieldEnd = p;
+        while (fieldEnd < end && *fieldEnd != separator) {
+            fieldEnd++;
+        }
+        const char *token = skipBlanks(p, fieldEnd, separator);
+        const char *tokenEnd = fieldEnd;
+        while (tokenEnd > token && isBlank(tokenEnd[-1], separator)) {
+            tokenEnd--;
+        }
+        char character;
+        double number;
+        if (data_type == CHAR) {
+            if (token < tokenEnd && parseValue(p, fieldEnd, separator, CHAR, &character) == fieldEnd) {
+                return 0;
+            }
+        } else if (parseDoubleToken(token, tokenEnd, &number)) {
+            return 0;
+        }
+        p = fieldEnd + 1;
+    }
+    return 1;
+}
+
+// Make room for every row of the coming chunk, doubling the rows each time it fills up
+static int prepareDenseRows(void *context, size_t lines) {
+    DenseText *text = (DenseText *)context;
+    size_t rows = lines + (size_t)text->firstRow;
+    if (rows > INT_MAX) {
+        printf("Error: Matrix text has too many rows.\n");
+        return 0;
+    }
+    if (rows <= (size_t)text->mat.rows) {
+        return 1;
+    }
+    size_t grown = 2 * (size_t)text->mat.rows;
+    grown = (grown < rows) ? rows : (grown > INT_MAX) ? INT_MAX : grown;
+    resizeMatrix(&text->mat, (int)grown, text->cols);
+    return text->mat.rows == (int)grown;
+}
+
+// Count the values on a line of delimited text
+static int countFields(const char *line, const char *end, char separator) {
+    int fields = 1;
+    for (const char *p = line; p < end; p++) {
+        // A quoted separator (or a doubled quote) is one value, not a separator
+        if (separator == ',' && *p == '"') {
+            if (p + 3 < end && p[1] == '"' && p[2] == '"' && p[3] == '"') {
+                p += 3;
+                continue;
+            }
+            if (p + 2 < end && p[2] == '"') {
+                p += 2;
+                continue;
+            }
+        }
+        if (*p == separator) {
+            fields++;
+        }
+    }
+    // printMatrix ends every row in a separator, which doesn't start another value
+    const char *last = end;
+    while (last > line && last[-1] == '\r') {
+        last--;
+    }
+    if (last > line && last[-1] == separator && fields > 1) {
+        fields--;
+    }
+    return fields;
+}
+
+// Function to read a dense matrix from delimited text, one row per line
+// The first line sets the number of columns. If it doesn't parse, it is skipped as a header when none of its fields
+// is a value (see isHeaderLine), and is an error otherwise.
+// Lines are parsed in chunks, shared between threads, into a matrix that doubles its rows as it fills.
+// Accepts a stream, the dialect (TEXT_CSV, or TEXT_TSV and TEXT_PRINT for tabs) and the data type to read
+// Returns a packed row major matrix, or an invalid matrix on error
+Matrix readMatrixText(FILE *file, TextDialect dialect, DataType data_type) {
+    if (file == NULL) {
+        printf("Error: Null matrix or data.\n");
+        return invalidMatrix();
+    }
+    if (data_type != INT && data_type != DOUBLE && data_type != CHAR) {
+        printf("Error: Unknown data type\n");
+        return invalidMatrix();
+    }
+
+    // The first line is read on its own, because the columns (and whether it is a header) depend on it
+    char *first = NULL;
+    size_t firstCapacity = 0;
+    ssize_t firstLength;
+    do {
+        firstLength = getline(&first, &firstCapacity, file);
+    } while (firstLength >= 0 && isBlankLine(first, first + firstLength));
+    if (firstLength < 0) {
+        free(first);
+        printf("Error: Matrix text has no rows.\n");
+        return invalidMatrix();
+    }
+    const char *firstEnd = first + firstLength;
+    if (firstLength > 0 && firstEnd[-1] == '\n') {
+        firstEnd--;
+    }
+
+    DenseText text;
+    text.separator = (dialect == TEXT_CSV) ? ',' : '\t';
+    text.cols = countFields(first, firstEnd, text.separator);
+    text.valueSize = (data_type == DOUBLE) ? sizeof(double) : (data_type == INT) ? sizeof(int) : sizeof(char);
+    text.mat = createMatrixWithLayout(READ_FIRST_ROWS, text.cols, data_type, ROW_MAJOR, PACKED_STORAGE);
+    text.firstRow = 0;
+    if (parseDenseLine(&text, first, firstEnd, 0)) {
+        text.firstRow = 1;
+    } else if (!isHeaderLine(first, firstEnd, text.separator, data_type)) {
+        printf("Error: Could not parse line 1 of matrix text.\n");
+        free(first);
+        freeMatrix(&text.mat);
+        return invalidMatrix();
+    }
+    free(first);
+
+    LineHandler handler = {parseDenseLine, prepareDenseRows, &text};
+    size_t lines = readLines(file, &handler);
+    size_t rows = lines + (size_t)text.firstRow;
+    if (lines == SIZE_MAX || rows == 0) {
+        if (lines != SIZE_MAX) {
+            printf("Error: Matrix text has no rows.\n");
+        }
+        freeMatrix(&text.mat);
+        return invalidMatrix();
+    }
+    if ((int)rows < text.mat.rows) {
+        resizeMatrix(&text.mat, (int)rows, text.cols);
+    }
+    return text.mat;
+}
+
+// Function to read a dense matrix from a file of delimited text
+// Accepts the file path, the dialect and the data type to read
+// Returns a packed row major matrix, or an invalid matrix on error
+Matrix loadMatrixText(const char *path, TextDialect dialect, DataType data_type) {
+    FILE *file = (path != NULL) ? fopen(path, "rb") : NULL;
+    if (file == NULL) {
+        printf("Error: Could not open %s.\n", (path != NULL) ? path : "(null)");
+        return invalidMatrix();
+    }
+    Matrix mat = readMatrixText(file, dialect, data_type);
+    fclose(file);
+    return mat;
+}
+
+// MARK - Matrix Market
+// Matrix Market files start with a banner naming the format (coordinate or array), the field (integer, real,
+// double or pattern) and the symmetry (general, symmetric or skew-symmetric), then comment lines starting
+// with '%', then a line of sizes. Coordinate files list one-based "row column value" entries. Array files list
+// values in column major order, only the lower triangle for symmetric ones (and without the diagonal for
+// skew-symmetric ones). Complex and hermitian files aren't supported.
+
+// What a Matrix Market banner and size line say
+typedef struct {
+    int coordinate;
+    int pattern;
+    int symmetric;
+    int skew;
+    DataType data_type;
+    int rows;
+    int cols;
+    size_t entries;
+} MarketHeader;
+
+// Lower case a word of a banner in place
+static void lowerWord(char *word) {
+    for (; *word != '\0'; word++) {
+        if (*word >= 'A' && *word <= 'Z') {
+            *word = (char)(*word - 'A' + 'a');
+        }
+    }
+}
+
+// Read a Matrix Market banner, comments and size line
+// Returns 1 on success, 0 if the file isn't one this library reads
+static int readMarketHeader(FILE *file, MarketHeader *header) {
+    char *line = NULL;
+    size_t capacity = 0;
+    int valid = 0;
+    char banner[32], object[32], format[32], field[32], symmetry[32];
+    if (getline(&line, &capacity, file) < 0 ||
+        sscanf(line, "%31s %31s %31s %31s %31s", banner, object, format, field, symmetry) != 5) {
+        printf("Error: Not a Matrix Market file.\n");
+        free(line);
+        return 0;
+    }
+    lowerWord(banner);
+    lowerWord(object);
+    lowerWord(format);
+    lowerWord(field);
+    lowerWord(symmetry);
+
+    header->coordinate = (strcmp(format, "coordinate") == 0);
+    header->pattern = (strcmp(field, "pattern") == 0);
+    header->symmetric = (strcmp(symmetry, "symmetric") == 0);
+    header->skew = (strcmp(symmetry, "skew-symmetric") == 0);
+    header->data_type = (strcmp(field, "real") == 0 || strcmp(field, "double") == 0) ? DOUBLE : INT;
+    if (strcmp(banner, "%%matrixmarket") != 0 || strcmp(object, "matrix") != 0 ||
+        (!header->coordinate && strcmp(format, "array") != 0)) {
+        printf("Error: Not a Matrix Market file.\n");
+    } else if ((header->data_type == INT && !header->pattern && strcmp(field, "integer") != 0) ||
+               (header->pattern && !header->coordinate) ||
+               (!header->symmetric && !header->skew && strcmp(symmetry, "general") != 0)) {
+        printf("Error: Matrix Market %s %s %s matrices are not supported.\n", format, field, symmetry);
+    } else {
+        // Comments run up to the size line
+        ssize_t length = getline(&line, &capacity, file);
+        while (length >= 0 && (line[0] == '%' || isBlankLine(line, line + length))) {
+            length = getline(&line, &capacity, file);
+        }
+        int read = 0;
+        if (length >= 0) {
+            read = header->coordinate ? sscanf(line, "%d %d %zu", &header->rows, &header->cols, &header->entries)
+                                      : sscanf(line, "%d %d", &header->rows, &header->cols);
+        }
+        valid = (read == (header->coordinate ? 3 : 2) && header->rows > 0 && header->cols > 0);
+        if (valid && !header->coordinate) {
+            size_t rows = (size_t)header->rows, cols = (size_t)header->cols;
+            if (header->symmetric || header->skew) {
+                valid = (rows == cols);
+                header->entries = header->skew ? rows * (rows - 1) / 2 : rows * (rows + 1) / 2;
+            } else {
+                header->entries = rows * cols;
+            }
+        }
+        if (!valid) {
+            printf("Error: Matrix Market size line is missing or invalid.\n");
+        }
+    }
+    free(line);
+    return valid;
+}
+
+// Matrix Market entries being read, into COO arrays or a list of array values
+typedef struct {
+    const MarketHeader *header;
+    int *rowIndices;
+    int *colIndices;
+    void *values;
+    size_t valueSize;
+} MarketEntries;
+
+// Parse the entry on a line of a Matrix Market file
+static int parseMarketLine(void *context, const char *line, const char *end, size_t index) {
+    const MarketEntries *entries = (const MarketEntries *)context;
+    const MarketHeader *header = entries->header;
+    if (index >= header->entries) {
+        return 0;
+    }
+    const char *p = skipBlanks(line, end, ' ');
+    if (header->coordinate) {
+        int position[2];
+        for (int k = 0; k < 2; k++) {
+            // Pattern entries end at their column, every other index is followed by more
+            p = parseValue(p, end, ' ', INT, &position[k]);
+            int last = header->pattern && k == 1;
+            if (p == NULL || (!last && (p == end || !isBlank(*p, ' '))) || position[k] < 1 ||
+                position[k] > ((k == 0) ? header->rows : header->cols)) {
+                return 0;
+            }
+            p = skipBlanks(p, end, ' ');
+        }
+        entries->rowIndices[index] = position[0] - 1;
+        entries->colIndices[index] = position[1] - 1;
+        if (header->pattern) {
+            ((int *)entries->values)[index] = 1;
+            return isBlankLine(p, end);
+        }
+    }
+    p = parseValue(p, end, ' ', header->data_type, (char *)entries->values + index * entries->valueSize);
+    return p != NULL && isBlankLine(p, end);
+}
+
+// Read every entry of a Matrix Market file after its header
+// Returns 1 on success, 0 if there were too few or too many, or one couldn't be parsed
+static int readMarketEntries(FILE *file, MarketEntries *entries) {
+    LineHandler handler = {parseMarketLine, NULL, entries};
+    size_t lines = readLines(file, &handler);
+    if (lines == SIZE_MAX) {
+        return 0;
+    }
+    if (lines != entries->header->entries) {
+        printf("Error: Matrix Market file has %zu entries instead of %zu.\n", lines, entries->header->entries);
+        return 0;
+    }
+    return 1;
+}
+
+// Read the values of an array file into a new column major matrix, filling in the upper triangle of symmetric ones
+static Matrix readMarketArray(FILE *file, const MarketHeader *header) {
+    Matrix mat = createMatrixWithLayout(header->rows, header->cols, header->data_type, COLUMN_MAJOR, PACKED_STORAGE);
+    size_t valueSize = (header->data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+
+    // A general array lists every value in exactly the order a packed column major matrix keeps them
+    int general = !header->symmetric && !header->skew;
+    void *values = general ? mat.block : malloc((header->entries > 0 ? header->entries : 1) * valueSize);
+    MarketEntries entries = {header, NULL, NULL, values, valueSize};
+    if (values == NULL || !readMarketEntries(file, &entries)) {
+        if (!general) {
+            free(values);
+        }
+        freeMatrix(&mat);
+        return invalidMatrix();
+    }
+    if (general) {
+        return mat;
+    }
+
+    // Column j of the triangle runs down from the diagonal (or just below it for skew-symmetric matrices)
+    size_t e = 0;
+    int n = header->rows;
+    for (int j = 0; j < n; j++) {
+        for (int i = header->skew ? j + 1 : j; i < n; i++, e++) {
+            if (header->data_type == DOUBLE) {
+                double value = ((double *)values)[e];
+                setDoubleElement(&mat, i, j, value);
+                setDoubleElement(&mat, j, i, header->skew ? -value : value);
+            } else {
+                int value = ((int *)values)[e];
+                setIntElement(&mat, i, j, value);
+                setIntElement(&mat, j, i, header->skew ? -value : value);
+            }
+        }
+    }
+    free(values);
+    return mat;
+}
+
+// Read the entries of a coordinate file into a new COO sparse matrix, mirroring those of symmetric ones
+static SparseMatrix readMarketCoordinates(FILE *file, const MarketHeader *header) {
+    SparseMatrix invalid = {0, 0, INT, SPARSE_COO, 0, NULL, NULL, NULL, NULL};
+    int mirrored = header->symmetric || header->skew;
+    size_t room = (mirrored ? 2 * header->entries : header->entries) + 1;
+    size_t valueSize = (header->data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+    MarketEntries entries = {header, (int *)malloc(room * sizeof(int)), (int *)malloc(room * sizeof(int)),
+                             malloc(room * valueSize), valueSize};
+    if (entries.rowIndices == NULL || entries.colIndices == NULL || entries.values == NULL ||
+        !readMarketEntries(file, &entries)) {
+        if (entries.rowIndices == NULL || entries.colIndices == NULL || entries.values == NULL) {
+            printf("Memory allocation failed for sparse matrix with %zu entries\n", header->entries);
+        }
+        free(entries.rowIndices);
+        free(entries.colIndices);
+        free(entries.values);
+        return invalid;
+    }
+
+    // Symmetric files only list one triangle, so every entry off the diagonal is also listed mirrored
+    size_t nnz = header->entries;
+    if (mirrored) {
+        for (size_t e = 0; e < header->entries; e++) {
+            if (entries.rowIndices[e] == entries.colIndices[e]) {
+                continue;
+            }
+            entries.rowIndices[nnz] = entries.colIndices[e];
+            entries.colIndices[nnz] = entries.rowIndices[e];
+            if (header->data_type == DOUBLE) {
+                double value = ((double *)entries.values)[e];
+                ((double *)entries.values)[nnz] = header->skew ? -value : value;
+            } else {
+                int value = ((int *)entries.values)[e];
+                ((int *)entries.values)[nnz] = header->skew ? -value : value;
+            }
+            nnz++;
+        }
+    }
+
+    // The arrays become the matrix's own, which frees them like any other
+    SparseMatrix sparse = {header->rows, header->cols, header->data_type, SPARSE_COO, nnz, NULL,
+                           entries.colIndices, entries.rowIndices, entries.values};
+    return sparse;
+}
+
+// Function to read a Matrix Market file into a sparse matrix
+// Accepts a stream
+// Returns a COO sparse matrix (INT for integer and pattern files, DOUBLE for real ones), or an invalid one
+SparseMatrix readSparseMatrixMarket(FILE *file) {
+    SparseMatrix invalid = {0, 0, INT, SPARSE_COO, 0, NULL, NULL, NULL, NULL};
+    MarketHeader header;
+    if (file == NULL || !readMarketHeader(file, &header)) {
+        return invalid;
+    }
+    if (header.coordinate) {
+        return readMarketCoordinates(file, &header);
+    }
+    Matrix dense = readMarketArray(file, &header);
+    if (!isValid(&dense)) {
+        return invalid;
+    }
+    SparseMatrix sparse = denseToSparse(&dense, SPARSE_COO);
+    freeMatrix(&dense);
+    return sparse;
+}
+
+// Function to read a Matrix Market file into a dense matrix
+// Accepts a stream
+// Returns a matrix (INT for integer and pattern files, DOUBLE for real ones), or an invalid matrix on error.
+// Array files come back packed in column major order, exactly as they were listed.
+Matrix readMatrixMarket(FILE *file) {
+    MarketHeader header;
+    if (file == NULL || !readMarketHeader(file, &header)) {
+        return invalidMatrix();
+    }
+    if (!header.coordinate) {
+        return readMarketArray(file, &header);
+    }
+    SparseMatrix sparse = readMarketCoordinates(file, &header);
+    if (!isValidSparse(&sparse)) {
+        return invalidMatrix();
+    }
+    Matrix dense = sparseToDense(&sparse);
+    freeSparseMatrix(&sparse);
+    return dense;
+}
+
+// Function to read a Matrix Market file at a path into a sparse matrix
+// Accepts the file path
+// Returns a COO sparse matrix, or an invalid one on error
+SparseMatrix loadSparseMatrixMarket(const char *path) {
+    FILE *file = (path != NULL) ? fopen(path, "rb") : NULL;
+    if (file == NULL) {
+        SparseMatrix invalid = {0, 0, INT, SPARSE_COO, 0, NULL, NULL, NULL, NULL};
+        printf("Error: Could not open %s.\n", (path != NULL) ? path : "(null)");
+        return invalid;
+    }
+    SparseMatrix sparse = readSparseMatrixMarket(file);
+    fclose(file);
+    return sparse;
+}
+
+// Function to read a Matrix Market file at a path into a dense matrix
+// Accepts the file path
+// Returns a matrix, or an invalid matrix on error
+Matrix loadMatrixMarket(const char *path) {
+    FILE *file = (path != NULL) ? fopen(path, "rb") : NULL;
+    if (file == NULL) {
+        printf("Error: Could not open %s.\n", (path != NULL) ? path : "(null)");
+        return invalidMatrix();
+    }
+    Matrix mat = readMatrixMarket(file);
+    fclose(file);
+    return mat;
+}
@@ -0,0 +1,69 @@
+#ifndef MATRIX_TEXT_H
+#define MATRIX_TEXT_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "matrix.h"
+#include "matrix_sparse.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Enum for how the values of each row are separated
+// TEXT_PRINT is printMatrix's layout: a tab after every value, including the last one of each row.
+// TEXT_TSV separates values with tabs and TEXT_CSV with commas, with nothing after the last value.
+// CSV puts CHAR values that are commas, quotes or line breaks in quotes, doubling any quote inside.
+typedef enum {
+    TEXT_PRINT,
+    TEXT_TSV,
+    TEXT_CSV
+} TextDialect;
+
+// Precision that writes each double with the fewest digits that still read back as exactly the same double
+#define TEXT_SHORTEST -1
+
+// Most digits after the decimal point a fixed precision may ask for
+#define TEXT_MAX_PRECISION 30
+
+// Struct for how a matrix is written as text
+// 'precision' is how many digits doubles get after the decimal point (printMatrix uses 6), or TEXT_SHORTEST
+typedef struct {
+    TextDialect dialect;
+    int precision;
+} TextFormat;
+
+// Struct for where matrix text goes
+// 'write' is handed the text a large buffer at a time, and returns how many bytes it took.
+// Taking fewer than it was given stops the writing with an error.
+typedef struct {
+    size_t (*write)(void *context, const char *text, size_t size);
+    void *context;
+} TextSink;
+
+// Sinks that write to a stdio stream or to a file descriptor
+TextSink fileTextSink(FILE *file);
+TextSink descriptorTextSink(int descriptor);
+
+// Write a matrix or a view as text to a sink
+MatrixStatus writeMatrixText(const Matrix *mat, TextFormat format, TextSink sink);
+MatrixStatus writeMatrixViewText(const MatrixView *view, TextFormat format, TextSink sink);
+
+// Write a view as text into a new string, which the caller frees
+char *matrixViewToText(const MatrixView *view, TextFormat format, size_t *length);
+
+// Read a dense matrix from delimited text (TEXT_CSV, or TEXT_TSV and TEXT_PRINT for tabs), one row per line
+Matrix readMatrixText(FILE *file, TextDialect dialect, DataType data_type);
+Matrix loadMatrixText(const char *path, TextDialect dialect, DataType data_type);
+
+// Read a Matrix Market (.mtx) file into a sparse or dense matrix
+SparseMatrix readSparseMatrixMarket(FILE *file);
+SparseMatrix loadSparseMatrixMarket(const char *path);
+Matrix readMatrixMarket(FILE *file);
+Matrix loadMatrixMarket(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
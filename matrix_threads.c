@@ -0,0 +1,235 @@
+// sysconf lives behind POSIX, which -std=c99 hides unless we ask for it
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "matrix_internal.h"
+
+// MARK - Thread pool
+// One pool of worker threads is started the first time there is enough work to share, and then kept for the
+// life of the program, so a parallel operation only costs a wake-up instead of creating threads.
+// The calling thread works alongside the pool, which means 'threadCount' threads share each job
+// and only threadCount - 1 workers are ever started.
+// Only one job runs on the pool at a time. If the pool is already busy (another thread is using it, or a job
+// calls back into the library) the new job simply runs on the calling thread, so nothing can deadlock.
+
+// One parallel job: 'tasks' calls of 'body', handed out one at a time
+typedef struct {
+    void (*body)(void *context, int task);
+    void *context;
+    int tasks;
+    int nextTask;
+    int finishedTasks;
+} PoolJob;
+
+// Held by whoever owns the pool for a job (or is resizing it)
+static pthread_mutex_t poolOwner = PTHREAD_MUTEX_INITIALIZER;
+
+// Guards everything below
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t jobPosted = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t jobFinished = PTHREAD_COND_INITIALIZER;
+static PoolJob *currentJob = NULL;
+static unsigned long jobNumber = 0;
+static int stopWorkers = 0;
+
+// Workers that are running, and how many threads jobs should use (0 until it has been chosen)
+static pthread_t *workers = NULL;
+static int workerCount = 0;
+static int threadCount = 0;
+
+// Run tasks of a job until there are none left to hand out. Called with poolLock held, returns with it held.
+static void runTasks(PoolJob *job) {
+    while (job->nextTask < job->tasks) {
+        int task = job->nextTask++;
+        pthread_mutex_unlock(&poolLock);
+        job->body(job->context, task);
+        pthread_mutex_lock(&poolLock);
+        job->finishedTasks++;
+        if (job->finishedTasks == job->tasks) {
+            pthread_cond_broadcast(&jobFinished);
+        }
+    }
+}
+
+// Body of every worker thread: sleep until a new job is posted, help with it, repeat
+static void *workerMain(void *unused) {
+    (void)unused;
+    unsigned long seenJob = 0;
+    pthread_mutex_lock(&poolLock);
+    seenJob = jobNumber;
+    for (;;) {
+        while (!stopWorkers && jobNumber == seenJob) {
+            pthread_cond_wait(&jobPosted, &poolLock);
+        }
+        if (stopWorkers) {
+            break;
+        }
+        seenJob = jobNumber;
+        if (currentJob != NULL) {
+            runTasks(currentJob);
+        }
+    }
+    pthread_mutex_unlock(&poolLock);
+    return NULL;
+}
+
+// The default thread count: MATRIX_THREADS if it is set to a positive number, otherwise one per online CPU
+static int defaultThreadCount(void) {
+    const char *setting = getenv("MATRIX_THREADS");
+    if (setting != NULL) {
+        int threads = atoi(setting);
+        if (threads > 0) {
+            return threads;
+        }
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (int)cpus : 1;
+}
+
+// Start the workers if they aren't running yet. Called with poolOwner held.
+// If some threads can't be started, jobs just share the ones that did start.
+static void startWorkers(void) {
+    int threads = getThreadCount();
+    if (workers != NULL || threads <= 1) {
+        return;
+    }
+    workers = (pthread_t *)malloc((size_t)(threads - 1) * sizeof(pthread_t));
+    if (workers == NULL) {
+        return;
+    }
+    while (workerCount < threads - 1) {
+        if (pthread_create(&workers[workerCount], NULL, workerMain, NULL) != 0) {
+            break;
+        }
+        workerCount++;
+    }
+}
+
+// Stop and join every worker. Called with poolOwner held.
+static void stopAllWorkers(void) {
+    pthread_mutex_lock(&poolLock);
+    stopWorkers = 1;
+    pthread_cond_broadcast(&jobPosted);
+    pthread_mutex_unlock(&poolLock);
+
+    for (int i = 0; i < workerCount; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    workers = NULL;
+    workerCount = 0;
+
+    pthread_mutex_lock(&poolLock);
+    stopWorkers = 0;
+    pthread_mutex_unlock(&poolLock);
+}
+
+// Run body(context, task) for every task from 0 to tasks - 1, sharing them between the pool and this thread
+// Returns once every task has finished
+void parallelFor(int tasks, void (*body)(void *context, int task), void *context) {
+    // Nothing to share, or the pool is busy: do it all here
+    if (tasks <= 1 || pthread_mutex_trylock(&poolOwner) != 0) {
+        for (int task = 0; task < tasks; task++) {
+            body(context, task);
+        }
+        return;
+    }
+
+    startWorkers();
+    PoolJob job = {body, context, tasks, 0, 0};
+
+    // Post the job, work on it too, then wait for the stragglers
+    pthread_mutex_lock(&poolLock);
+    if (workerCount > 0) {
+        currentJob = &job;
+        jobNumber++;
+        pthread_cond_broadcast(&jobPosted);
+    }
+    runTasks(&job);
+    while (job.finishedTasks < job.tasks) {
+        pthread_cond_wait(&jobFinished, &poolLock);
+    }
+    currentJob = NULL;
+    pthread_mutex_unlock(&poolLock);
+
+    pthread_mutex_unlock(&poolOwner);
+}
+
+// A range split, passed through parallelFor to the range body
+typedef struct {
+    void (*body)(void *context, int task, size_t start, size_t end);
+    void *context;
+    size_t count;
+    size_t chunk;
+} RangeJob;
+
+// Run one range of a parallelRange
+static void rangeTask(void *context, int task) {
+    RangeJob *job = (RangeJob *)context;
+    size_t start = (size_t)task * job->chunk;
+    size_t end = (start + job->chunk < job->count) ? start + job->chunk : job->count;
+    job->body(job->context, task, start, end);
+}
+
+// How many ranges parallelRange splits 'count' units of work into
+// There is at most one range per thread, and no range is shorter than 'grain' units
+int parallelRangeCount(size_t count, size_t grain) {
+    if (grain == 0) {
+        grain = 1;
+    }
+    size_t ranges = count / grain;
+    size_t threads = (size_t)getThreadCount();
+    if (ranges > threads) {
+        ranges = threads;
+    }
+    if (ranges < 1) {
+        ranges = 1;
+    }
+
+    // Every range must end up with some work once the count is divided evenly
+    size_t chunk = (count + ranges - 1) / ranges;
+    if (chunk > 0) {
+        ranges = (count + chunk - 1) / chunk;
+    }
+    return (ranges < 1) ? 1 : (int)ranges;
+}
+
+// Run body over [0, count) split into 'ranges' contiguous ranges (from parallelRangeCount), numbered from 0
+// Returns once every range has finished
+void parallelRange(size_t count, int ranges, void (*body)(void *context, int task, size_t start, size_t end),
+                   void *context) {
+    if (ranges <= 1) {
+        body(context, 0, 0, count);
+        return;
+    }
+    RangeJob job = {body, context, count, (count + ranges - 1) / ranges};
+    parallelFor(ranges, rangeTask, &job);
+}
+
+// Set how many threads the library may use
+// Accepts a thread count, where 0 (or less) goes back to the default
+// Does not return
+void setThreadCount(int threads) {
+    // Wait for any running job, then replace the pool. New workers start with the next big enough job.
+    pthread_mutex_lock(&poolOwner);
+    stopAllWorkers();
+    pthread_mutex_lock(&poolLock);
+    threadCount = (threads > 0) ? threads : defaultThreadCount();
+    pthread_mutex_unlock(&poolLock);
+    pthread_mutex_unlock(&poolOwner);
+}
+
+// Get how many threads the library may use
+// Accepts nothing
+// Returns the thread count, including the calling thread
+int getThreadCount(void) {
+    pthread_mutex_lock(&poolLock);
+    if (threadCount == 0) {
+        threadCount = defaultThreadCount();
+    }
+    int threads = threadCount;
+    pthread_mutex_unlock(&poolLock);
+    return threads;
+}
@@ -0,0 +1,287 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "matrix_internal.h"
+#include "matrix_vector.h"
+
+// MARK - Vectors
+// A matrix-vector product does one multiply-add per value of the matrix, so it is bound by how fast the matrix can
+// be streamed in, and the only thing that matters is reading it once, in order, with full vectors.
+// The multiplied matrix (after any transpose) is walked along its own contiguous lines. Stored row by row, each
+// value of y is a dot product of one line with x. Stored column by column, each line is scaled by its value of x
+// and added into y, a block of y at a time so that block stays in cache while every line goes past it.
+// Either way the rows of y are shared out between threads, and each thread streams its own part of the matrix.
+
+// Values of y a columnwise product updates at once, which is 16KB of doubles and fits in any L1 cache
+#define GEMV_BLOCK 2048
+
+// Size in bytes of a single vector value
+static size_t vectorValueSize(DataType data_type) {
+    return (data_type == DOUBLE) ? sizeof(double) : sizeof(int);
+}
+
+// The vector returned in error states, which has no values
+static MatrixVector invalidVector(void) {
+    MatrixVector vector = {0, INT, NULL};
+    return vector;
+}
+
+// Function to create a vector
+// Accepts its length and data type (INT or DOUBLE)
+// Returns a zero filled vector, or an invalid vector on error
+MatrixVector createVector(int length, DataType data_type) {
+    if (length <= 0) {
+        printf("Error: Invalid matrix dimensions.\n");
+        return invalidVector();
+    }
+    if (data_type != INT && data_type != DOUBLE) {
+        printf("Error: Vectors only hold INT or DOUBLE values.\n");
+        return invalidVector();
+    }
+
+    MatrixVector vector;
+    vector.length = length;
+    vector.data_type = data_type;
+    vector.values = matrixBlockCalloc((size_t)length * vectorValueSize(data_type));
+    if (vector.values == NULL) {
+        printf("Memory allocation failed for a vector of %d values\n", length);
+        return invalidVector();
+    }
+    return vector;
+}
+
+// Detect an invalid vector
+// Accepts a vector pointer
+// Returns 1 if the vector has values, 0 otherwise
+int isValidVector(const MatrixVector *vector) {
+    return vector != NULL && vector->values != NULL && vector->length > 0;
+}
+
+// Function to view a vector as a matrix with a single column
+// Accepts a vector pointer
+// Returns a length x 1 view of it, which is empty if the vector is invalid
+MatrixView vectorMatrixView(const MatrixVector *vector) {
+    MatrixView view;
+    view.rows = 0;
+    view.cols = 0;
+    view.data_type = (vector != NULL) ? vector->data_type : INT;
+    view.storage = PACKED_STORAGE;
+    view.order = COLUMN_MAJOR;
+    view.block = NULL;
+    view.offset = 0;
+    view.ld = 1;
+    if (!isValidVector(vector)) {
+        printf("Error: Null matrix or data.\n");
+        return view;
+    }
+    view.rows = vector->length;
+    view.cols = 1;
+    view.block = vector->values;
+    view.ld = vector->length;
+    return view;
+}
+
+// Free a vector made by createVector
+// Accepts a vector pointer
+// Does not return
+void freeVector(MatrixVector *vector) {
+    if (vector == NULL) {
+        return;
+    }
+    alignedFree(vector->values);
+    *vector = invalidVector();
+}
+
+// MARK - Matrix-vector products
+
+// One matrix-vector product, shared between threads by rows of y.
+// 'a' is the first value of the multiplied matrix, whose rows are 'rowStride' and columns 'colStride' values apart.
+// INT products only start once alpha and beta have passed isIntScale, so they can be converted to int freely.
+typedef struct {
+    DataType data_type;
+    const char *a;
+    size_t rowStride;
+    size_t colStride;
+    int cols;
+    const char *x;
+    char *y;
+    double alpha;
+    double beta;
+} GemvJob;
+
+// Multiply rows 'start' up to 'end' when each row is contiguous, one dot product per value of y
+static void gemvRowsRange(void *context, int task, size_t start, size_t end) {
+    const GemvJob *job = (const GemvJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    (void)task;
+    if (job->data_type == DOUBLE) {
+        kernels->gemvRowsDoubles((double *)job->y + start, (const double *)job->a + start * job->rowStride,
+                                 job->rowStride, (const double *)job->x, (int)(end - start), (size_t)job->cols,
+                                 job->alpha, job->beta);
+    } else {
+        kernels->gemvRowsInts((int *)job->y + start, (const int *)job->a + start * job->rowStride, job->rowStride,
+                              (const int *)job->x, (int)(end - start), (size_t)job->cols, (int)job->alpha,
+                              (int)job->beta);
+    }
+}
+
+// Multiply rows 'start' up to 'end' when each column is contiguous, a block of y at a time.
+// Here x has already been scaled by alpha, so each block is only scaled by beta before the columns are added in.
+static void gemvColumnsRange(void *context, int task, size_t start, size_t end) {
+    const GemvJob *job = (const GemvJob *)context;
+    const MatrixKernels *kernels = matrixKernels();
+    (void)task;
+    for (size_t first = start; first < end; first += GEMV_BLOCK) {
+        size_t count = (end - first < GEMV_BLOCK) ? end - first : GEMV_BLOCK;
+        if (job->data_type == DOUBLE) {
+            double *y = (double *)job->y + first;
+            for (size_t i = 0; i < count; i++) {
+                y[i] = (job->beta == 0.0) ? 0.0 : job->beta * y[i];
+            }
+            kernels->gemvColumnsDoubles(y, (const double *)job->a + first, job->colStride, (const double *)job->x,
+                                        job->cols, count);
+        } else {
+            int *y = (int *)job->y + first;
+            unsigned int beta = (unsigned int)(int)job->beta;
+            for (size_t i = 0; i < count; i++) {
+                y[i] = (int)(beta * (unsigned int)y[i]);
+            }
+            kernels->gemvColumnsInts(y, (const int *)job->a + first, job->colStride, (const int *)job->x, job->cols,
+                                     count);
+        }
+    }
+}
+
+// Multiply rows 'start' up to 'end' one value at a time, for INT element storage where neither rows nor columns
+// are contiguous ints
+static void gemvStridedRange(void *context, int task, size_t start, size_t end) {
+    const GemvJob *job = (const GemvJob *)context;
+    (void)task;
+    const int *a = (const int *)job->a;
+    const int *x = (const int *)job->x;
+    int *y = (int *)job->y;
+    unsigned int alpha = (unsigned int)(int)job->alpha;
+    unsigned int beta = (unsigned int)(int)job->beta;
+    for (size_t i = start; i < end; i++) {
+        unsigned int sum = 0;
+        for (int k = 0; k < job->cols; k++) {
+            sum += (unsigned int)a[i * job->rowStride + k * job->colStride] * (unsigned int)x[k];
+        }
+        y[i] = (int)((beta == 0) ? alpha * sum : alpha * sum + beta * (unsigned int)y[i]);
+    }
+}
+
+// Whether two ranges of bytes have any in common
+static int bytesOverlap(const char *first1, const char *end1, const char *first2, const char *end2) {
+    return first1 < end2 && first2 < end1;
+}
+
+// Function to work out y = alpha * op(view) * x + beta * y, where op() optionally transposes the view
+// The transpose is read straight from the view and never stored, and a beta of 0 ignores what y held.
+// Accepts the transpose flag, alpha, a view, the vector x, beta, and a vector y that overlaps neither the view nor
+// x. The view and both vectors must have the same data type, INT or DOUBLE, and INT needs whole number scales.
+// Returns MATRIX_SUCCESS, or an error status with y untouched
+MatrixStatus gemvMatrixViews(Transpose transpose, double alpha, const MatrixView *view, const MatrixVector *x,
+                             double beta, const MatrixVector *y) {
+    if (!view || !view->block || !isValidVector(x) || !isValidVector(y)) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView op = (transpose == TRANSPOSE) ? transposeMatrixView(view) : *view;
+    if (op.cols != x->length) {
+        printf("Error: Matrix dimensions do not allow multiplication (cols of mat1 must equal rows of mat2).\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (op.rows != y->length) {
+        printf("Error: Destination matrix dimensions do not match the result.\n");
+        return MATRIX_ERROR_SIZE_MISMATCH;
+    }
+    if (op.data_type != x->data_type || op.data_type != y->data_type) {
+        printf("Error: Data types of matrices do not match.\n");
+        return MATRIX_ERROR_TYPE_MISMATCH;
+    }
+    if (op.data_type == CHAR) {
+        printf("Error: Multiplication not supported for CHAR type matrices.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+    if (op.data_type == INT && (!isIntScale(alpha) || !isIntScale(beta))) {
+        printf("Error: INT matrices can only be scaled by whole numbers.\n");
+        return MATRIX_ERROR_UNSUPPORTED_TYPE;
+    }
+
+    // Every value of y needs a whole row of the matrix and all of x, so it can't be written over either
+    GemvJob job;
+    job.data_type = op.data_type;
+    job.a = (const char *)viewValues(&op);
+    viewValueStrides(&op, &job.rowStride, &job.colStride);
+    job.cols = op.cols;
+    job.x = (const char *)x->values;
+    job.y = (char *)y->values;
+    job.alpha = alpha;
+    job.beta = beta;
+    size_t size = vectorValueSize(op.data_type);
+    const char *aEnd = job.a + ((op.rows - 1) * job.rowStride + (op.cols - 1) * job.colStride + 1) * size;
+    const char *xEnd = job.x + (size_t)x->length * size;
+    const char *yEnd = job.y + (size_t)y->length * size;
+    if (bytesOverlap(job.y, yEnd, job.a, aEnd) || bytesOverlap(job.y, yEnd, job.x, xEnd)) {
+        printf("Error: Destination matrix can't be an operand of a multiplication.\n");
+        return MATRIX_ERROR_ALIASING;
+    }
+
+    size_t rows = (size_t)op.rows;
+    size_t grain = (PARALLEL_MIN_VALUES + (size_t)op.cols - 1) / (size_t)op.cols;
+    int ranges = parallelRangeCount(rows, grain);
+    if (job.colStride == 1) {
+        parallelRange(rows, ranges, gemvRowsRange, &job);
+        return MATRIX_SUCCESS;
+    }
+    if (job.rowStride != 1) {
+        parallelRange(rows, ranges, gemvStridedRange, &job);
+        return MATRIX_SUCCESS;
+    }
+
+    // Columnwise, alpha is folded into a copy of x, so it costs one multiply per column rather than per value
+    void *scaled = NULL;
+    if (alpha != 1.0) {
+        scaled = alignedCalloc((size_t)x->length * size);
+        if (scaled == NULL) {
+            printf("Memory allocation failed for matrix-vector scratch space.\n");
+            return MATRIX_ERROR_NULL_POINTER;
+        }
+        // On the INT path alpha has passed isIntScale above, so converting it is defined
+        int intAlpha = op.data_type == INT ? (int)alpha : 0;
+        for (int k = 0; k < x->length; k++) {
+            if (op.data_type == DOUBLE) {
+                ((double *)scaled)[k] = alpha * ((const double *)x->values)[k];
+            } else {
+                ((int *)scaled)[k] = (int)((unsigned int)intAlpha * (unsigned int)((const int *)x->values)[k]);
+            }
+        }
+        job.x = (const char *)scaled;
+    }
+    parallelRange(rows, ranges, gemvColumnsRange, &job);
+    alignedFree(scaled);
+    return MATRIX_SUCCESS;
+}
+
+// Function to work out y = alpha * op(mat) * x + beta * y
+// Accepts the transpose flag, alpha, a matrix, the vector x, beta, and a vector y that overlaps neither
+// Returns MATRIX_SUCCESS, or an error status with y untouched
+MatrixStatus gemvMatrices(Transpose transpose, double alpha, const Matrix *mat, const MatrixVector *x, double beta,
+                          const MatrixVector *y) {
+    if (!mat) {
+        printf("Error: Null matrix or data.\n");
+        return MATRIX_ERROR_NULL_POINTER;
+    }
+    MatrixView view = viewMatrix(mat);
+    return gemvMatrixViews(transpose, alpha, &view, x, beta, y);
+}
+
+// Function to work out y = alpha * x * view + beta * y, multiplying a row vector by a view
+// Accepts alpha, the vector x, a view, beta, and a vector y that overlaps neither
+// Returns MATRIX_SUCCESS, or an error status with y untouched
+MatrixStatus gevmMatrixViews(double alpha, const MatrixVector *x, const MatrixView *view, double beta,
+                             const MatrixVector *y) {
+    // x * view is the transpose of view' * x, and for vectors the transpose changes nothing
+    return gemvMatrixViews(TRANSPOSE, alpha, view, x, beta, y);
+}
@@ -0,0 +1,47 @@
+#ifndef MATRIX_VECTOR_H
+#define MATRIX_VECTOR_H
+
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Struct for a vector of INT or DOUBLE values, stored contiguously in one aligned buffer
+// createVector makes a vector that owns its buffer. A vector can also be filled in by hand over any run of packed
+// values, in which case it must not be passed to freeVector.
+typedef struct {
+    int length;
+    DataType data_type;
+    void *values;
+} MatrixVector;
+
+// Create a zero filled INT or DOUBLE vector
+MatrixVector createVector(int length, DataType data_type);
+
+// Detect an invalid vector
+int isValidVector(const MatrixVector *vector);
+
+// View a vector as a single column, without copying
+MatrixView vectorMatrixView(const MatrixVector *vector);
+
+// Matrix-vector multiply, y = alpha * op(mat) * x + beta * y, where op() optionally transposes the matrix without
+// copying it. With TRANSPOSE this is also the vector-matrix product y = alpha * x * mat + beta * y.
+// y can't overlap the matrix or x, and a beta of 0 ignores what y held.
+MatrixStatus gemvMatrices(Transpose transpose, double alpha, const Matrix *mat, const MatrixVector *x, double beta,
+                          const MatrixVector *y);
+MatrixStatus gemvMatrixViews(Transpose transpose, double alpha, const MatrixView *view, const MatrixVector *x,
+                             double beta, const MatrixVector *y);
+
+// Vector-matrix multiply, y = alpha * x * view + beta * y
+MatrixStatus gevmMatrixViews(double alpha, const MatrixVector *x, const MatrixView *view, double beta,
+                             const MatrixVector *y);
+
+// Free a vector made by createVector
+void freeVector(MatrixVector *vector);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,7 +20,7 @@ extern char test_details[1024];
 #define mu_assert(message, test) do { \
     if (!(test)) { \
         sprintf(test_details + strlen(test_details), "FAIL: %s - %s\n", __func__, message); \
-        return "fail"; \
+        return (char *)"fail"; \
     } \
 } while (0)
 
@@ -1,5 +1,15 @@
 #include "minunit.h"
 #include "matrix.h"
+#include "matrix_batch.h"
+#include "matrix_expr.h"
+#include "matrix_file.h"
+#include "matrix_fixed.h"
+#include "matrix_lu.h"
+#include "matrix_reduce.h"
+#include "matrix_sparse.h"
+#include "matrix_text.h"
+#include "matrix_vector.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -7,6 +17,19 @@ int tests_run = 0;
 int tests_failed = 0;
 char test_details[1024] = {0}; // Buffer to store test results
 
+// The makefile links the tests with malloc wrapped (-Wl,--wrap=malloc), so a test can make every allocation of at
+// least 'failingMallocSize' bytes fail, and check that running out of memory is reported and changes nothing
+void *__real_malloc(size_t size);
+
+static size_t failingMallocSize = 0;
+
+void *__wrap_malloc(size_t size) {
+    if (failingMallocSize > 0 && size >= failingMallocSize) {
+        return NULL;
+    }
+    return __real_malloc(size);
+}
+
 // Test matrix creation
 // Doubles
 static char * test_create_double_matrix() {
@@ -92,6 +115,236 @@ static char * test_create_char_matrix() {
     return NULL;
 }
 
+// Contiguous storage
+static char * test_create_matrix_contiguous() {
+    // Intro output
+    const char *functionName = "Create Matrix - Contiguous Storage";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given (nothing)
+
+    // When
+    // Create a 4x4 matrix
+    Matrix mat = createMatrix(4, 4, DOUBLE);
+
+    // Then
+    // The first element should be cache line aligned
+    mu_assert("TEST FAILED: element block is not 64 byte aligned", ((size_t)mat.data[0] % 64) == 0);
+
+    // Every row should start right where the previous one ends
+    for (int i = 1; i < 4; i++) {
+        mu_assert("TEST FAILED: rows are not back to back in memory", mat.data[i] == mat.data[i - 1] + 4);
+    }
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Packed storage
+static char * test_create_packed_matrix() {
+    // Intro output
+    const char *functionName = "Create Matrix - Packed";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given (nothing)
+
+    // When
+    // Create a packed 3x4 CHAR matrix and put a letter in every cell
+    Matrix mat = createPackedMatrix(3, 4, CHAR);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            setCharElement(&mat, r, c, (char)('a' + r * 4 + c));
+        }
+    }
+
+    // Then
+    printf("Created matrix:\n");
+    printMatrix(mat);
+
+    // Check row and column numbers and storage
+    mu_assert("TEST FAILED: mat.rows != 3", mat.rows == 3);
+    mu_assert("TEST FAILED: mat.cols != 4", mat.cols == 4);
+    mu_assert("TEST FAILED: matrix should be packed", mat.storage == PACKED_STORAGE);
+    mu_assert("TEST FAILED: packed matrix should be valid", isValid(&mat));
+
+    // Every char should take up exactly one byte of the buffer
+    char *buffer = getCharBuffer(&mat);
+    mu_assert("TEST FAILED: packed CHAR matrix should have a char buffer", buffer != NULL);
+    mu_assert("TEST FAILED: packed CHAR matrix should not have an int buffer", getIntBuffer(&mat) == NULL);
+    for (int i = 0; i < 12; i++) {
+        mu_assert("TEST FAILED: buffer does not hold one byte per cell", buffer[i] >= 'a' && buffer[i] <= 'l');
+    }
+
+    // The MatrixElement interface should still work on top of it
+    mu_assert("TEST FAILED: cell 2,3 should be l", getMatrixElement(mat, 2, 3).char_val == 'l');
+
+    // cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Typed accessors
+static char * test_typed_accessors_packed_matrix() {
+    // Intro output
+    const char *functionName = "Typed Accessors - Packed INT";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a packed 2x3 INT matrix
+    Matrix mat = createPackedMatrix(2, 3, INT);
+
+    // When
+    // Set a cell through each interface
+    setIntElement(&mat, 0, 1, 7);
+    MatrixElement element = {.int_val = -3};
+    setMatrixElement(&mat, 1, 2, element);
+
+    // Then
+    printf("Matrix after setting elements:\n");
+    printMatrix(mat);
+
+    // Both interfaces should see both values
+    mu_assert("TEST FAILED: cell 0,1 should be 7", getIntElement(&mat, 0, 1) == 7);
+    mu_assert("TEST FAILED: cell 0,1 should be 7 through getMatrixElement", getMatrixElement(mat, 0, 1).int_val == 7);
+    mu_assert("TEST FAILED: cell 1,2 should be -3", getIntElement(&mat, 1, 2) == -3);
+    mu_assert("TEST FAILED: cell 1,2 should read as -3.0", getDoubleElement(&mat, 1, 2) == -3.0);
+    mu_assert("TEST FAILED: untouched cell should be 0", getIntElement(&mat, 1, 0) == 0);
+
+    // cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Inline accessors
+static char * test_inline_accessors_matrix() {
+    // Intro output
+    const char *functionName = "Inline Accessors - Every Layout";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // 4 x 6 matrices of every type, order and storage type, and a view of the middle of each
+    DataType types[3] = {INT, DOUBLE, CHAR};
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    StorageType storages[2] = {ELEMENT_STORAGE, PACKED_STORAGE};
+    int allMatch = 1;
+    for (int k = 0; k < 12; k++) {
+        DataType type = types[k % 3];
+        Matrix mat = createMatrixWithLayout(4, 6, type, orders[k / 3 % 2], storages[k / 6]);
+        MatrixView view = createMatrixView(&mat, 1, 3, 2, 5);
+
+        // When
+        // Every cell is written inline, through the checked accessors for packed matrices and the plain ones otherwise
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 6; c++) {
+                if (type == INT) {
+                    *(storages[k / 6] == PACKED_STORAGE ? intElementAtChecked(&mat, r, c) : intElementAt(&mat, r, c)) =
+                        r * 10 + c;
+                } else if (type == DOUBLE) {
+                    *(storages[k / 6] == PACKED_STORAGE ? doubleElementAtChecked(&mat, r, c)
+                                                        : doubleElementAt(&mat, r, c)) = r * 10 + c + 0.5;
+                } else {
+                    *(storages[k / 6] == PACKED_STORAGE ? charElementAtChecked(&mat, r, c)
+                                                        : charElementAt(&mat, r, c)) = (char)('A' + r * 6 + c);
+                }
+            }
+        }
+
+        // Then
+        // The library's own accessors see the same values, and so does the view, at its own coordinates
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 6; c++) {
+                if (type == INT) {
+                    allMatch &= getIntElement(&mat, r, c) == r * 10 + c;
+                } else if (type == DOUBLE) {
+                    allMatch &= getDoubleElement(&mat, r, c) == r * 10 + c + 0.5;
+                } else {
+                    allMatch &= getCharElement(&mat, r, c) == (char)('A' + r * 6 + c);
+                }
+            }
+        }
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 4; c++) {
+                if (type == INT) {
+                    allMatch &= *viewIntElementAt(&view, r, c) == (r + 1) * 10 + c + 2;
+                    allMatch &= viewIntElementAtChecked(&view, r, c) == viewIntElementAt(&view, r, c);
+                } else if (type == DOUBLE) {
+                    allMatch &= *viewDoubleElementAt(&view, r, c) == (r + 1) * 10 + c + 2.5;
+                    allMatch &= viewDoubleElementAtChecked(&view, r, c) == viewDoubleElementAt(&view, r, c);
+                } else {
+                    allMatch &= *viewCharElementAt(&view, r, c) == (char)('A' + (r + 1) * 6 + c + 2);
+                    allMatch &= viewCharElementAtChecked(&view, r, c) == viewCharElementAt(&view, r, c);
+                }
+            }
+        }
+
+        // Cleanup
+        freeMatrix(&mat);
+    }
+    mu_assert("TEST FAILED: Inline accessors should match the library's accessors in every layout", allMatch);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Storage order conversion
+static char * test_convert_matrix_order() {
+    // Intro output
+    const char *functionName = "Convert Matrix Order";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a row major 3x5 INT matrix filled with ints
+    Matrix mat = createMatrixWithLayout(3, 5, INT, ROW_MAJOR, ELEMENT_STORAGE);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 5; c++) {
+            setIntElement(&mat, r, c, r * 5 + c);
+        }
+    }
+
+    printf("Initial matrix:\n");
+    printMatrix(mat);
+
+    // When
+    // Convert it to column major
+    convertMatrixOrder(&mat, COLUMN_MAJOR);
+
+    // Then
+    printf("Matrix after conversion:\n");
+    printMatrix(mat);
+
+    // The matrix should look the same from the outside
+    mu_assert("TEST FAILED: matrix should be column major", mat.order == COLUMN_MAJOR);
+    mu_assert("TEST FAILED: mat.rows != 3", mat.rows == 3);
+    mu_assert("TEST FAILED: mat.cols != 5", mat.cols == 5);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 5; c++) {
+            mu_assert("TEST FAILED: element changed during conversion", getIntElement(&mat, r, c) == r * 5 + c);
+        }
+    }
+
+    // But each column should now be contiguous, with 'data' pointing at columns
+    mu_assert("TEST FAILED: data[4] should be column 4", mat.data[4][2].int_val == 14);
+    mu_assert("TEST FAILED: columns are not back to back in memory", mat.data[1] == mat.data[0] + 3);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 // Test multiple operations. Matrix creation, element creation, and element setting
 static char * test_matrix_operations() {
     // Intro output
@@ -152,7 +405,7 @@ static char * test_set_row() {
 
     // Check if all elements in the first row are set correctly
     for (int i = 0; i < mat.cols; i++) {
-        mu_assert("Error: Element not set correctly in row", mat.data[0][i].int_val == 5);
+        mu_assert("Error: Element not set correctly in row", getIntElement(&mat, 0, i) == 5);
     }
 
     // Clean up
@@ -187,7 +440,7 @@ static char* test_set_column() {
 
     // Check if all elements in the second column are set correctly
     for (int i = 0; i < mat.rows; i++) {
-        mu_assert("Error: Element not set correctly in column", mat.data[i][1].int_val == 10);
+        mu_assert("Error: Element not set correctly in column", getIntElement(&mat, i, 1) == 10);
     }
 
     // Clean up
@@ -198,6 +451,100 @@ static char* test_set_column() {
     return NULL;
 }
 
+// Bulk rows and columns
+static char* test_row_and_column_values() {
+    // Intro output
+    const char *functionName = "Rows and Columns - Bulk Copies";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // 5 x 7 matrices of every type, order and storage type
+    DataType types[3] = {INT, DOUBLE, CHAR};
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    StorageType storages[2] = {ELEMENT_STORAGE, PACKED_STORAGE};
+    int allMatch = 1;
+    for (int k = 0; k < 12; k++) {
+        DataType type = types[k % 3];
+        Matrix mat = createMatrixWithLayout(5, 7, type, orders[k / 3 % 2], storages[k / 6]);
+        int ints[7] = {0};
+        double doubles[7] = {0};
+        char chars[7] = {0};
+        void *values = (type == INT) ? (void *)ints : (type == DOUBLE) ? (void *)doubles : (void *)chars;
+        MatrixElement elements[7];
+
+        // When
+        // Row 3 is set from native values and column 4 from elements, then both are read back both ways
+        for (int i = 0; i < 7; i++) {
+            ints[i] = i * 11 - 20;
+            doubles[i] = i * 1.5 - 4.0;
+            chars[i] = (char)('a' + i);
+        }
+        allMatch &= setRowOrColumnValues(&mat, ROW, 3, values, 7) == MATRIX_SUCCESS;
+        for (int i = 0; i < 5; i++) {
+            elements[i].double_val = 0.0;
+            if (type == INT) {
+                elements[i].int_val = 100 + i;
+            } else if (type == DOUBLE) {
+                elements[i].double_val = 0.25 * i;
+            } else {
+                elements[i].char_val = (char)('V' + i);
+            }
+        }
+        setRowOrColumn(&mat, 4, COL, elements, 5);
+        MatrixElement *row = getRowOrColumn(&mat, ROW, 3);
+        MatrixElement column[5];
+        allMatch &= row != NULL && getRowOrColumnInto(&mat, COL, 4, column, 5) == MATRIX_SUCCESS;
+        for (int i = 0; row != NULL && i < 7; i++) {
+            MatrixElement expected = (i == 4) ? elements[3] : getMatrixElement(mat, 3, i);
+            allMatch &= memcmp(&row[i], &expected, sizeof(MatrixElement)) == 0;
+        }
+        for (int i = 0; i < 5; i++) {
+            MatrixElement expected = getMatrixElement(mat, i, 4);
+            allMatch &= memcmp(&column[i], &expected, sizeof(MatrixElement)) == 0;
+        }
+        allMatch &= getRowOrColumnValues(&mat, COL, 4, values, 7) == MATRIX_SUCCESS;
+        for (int i = 0; i < 5; i++) {
+            allMatch &= (type == INT) ? ints[i] == 100 + i
+                      : (type == DOUBLE) ? doubles[i] == 0.25 * i : chars[i] == (char)('V' + i);
+        }
+        allMatch &= getRowOrColumnValues(&mat, ROW, 3, values, 7) == MATRIX_SUCCESS;
+        for (int i = 0; i < 7; i++) {
+            double expected = (i == 4) ? ((type == INT) ? 103 : (type == DOUBLE) ? 0.75 : 'Y')
+                            : ((type == INT) ? i * 11 - 20 : (type == DOUBLE) ? i * 1.5 - 4.0 : 'a' + i);
+            allMatch &= ((type == INT) ? ints[i] : (type == DOUBLE) ? doubles[i] : chars[i]) == expected;
+        }
+
+        // Cleanup
+        free(row);
+        freeMatrix(&mat);
+    }
+
+    // Then
+    mu_assert("TEST FAILED: Bulk row and column copies should match element access in every layout", allMatch);
+
+    // Given
+    Matrix mat = createPackedMatrix(3, 4, DOUBLE);
+    double values[4] = {0};
+
+    // Then
+    mu_assert("TEST FAILED: Too small a buffer should be refused",
+              getRowOrColumnValues(&mat, ROW, 0, values, 3) == MATRIX_ERROR_SIZE_MISMATCH);
+    // Indices are only checked when the library is built with bounds checking
+    #ifdef ENABLE_BOUNDS_CHECK
+    mu_assert("TEST FAILED: Out of range index should be refused",
+              setRowOrColumnValues(&mat, COL, 4, values, 4) == MATRIX_ERROR_SIZE_MISMATCH);
+    #endif
+    mu_assert("TEST FAILED: Null buffer should be refused",
+              getRowOrColumnInto(&mat, COL, 0, NULL, 3) == MATRIX_ERROR_NULL_POINTER);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 // Test matrix subset operations
 // Complete matrix
 static char * test_create_matrix_subset_complete() {
@@ -285,6 +632,166 @@ static char * test_create_matrix_subset_single_element() {
 
 // Test matrix resize operations
 // Increase size
+static char * test_create_matrix_view() {
+    // Intro output
+    const char *functionName = "Create Matrix View";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 4x5 INT matrix filled with ints
+    Matrix mat = createMatrix(4, 5, INT);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 5; c++) {
+            setIntElement(&mat, r, c, r * 5 + c);
+        }
+    }
+
+    // When
+    // View rows 1-3 and columns 2-3, and then a view inside that view
+    MatrixView view = createMatrixView(&mat, 1, 3, 2, 3);
+    MatrixView inner = createSubView(&view, 1, 2, 1, 1);
+
+    // Then
+    printf("View of rows 1-3, columns 2-3:\n");
+    printMatrixView(&view);
+
+    // The view should look at the matrix's own block rather than a copy
+    mu_assert("TEST FAILED: view has the wrong dimensions", view.rows == 3 && view.cols == 2);
+    mu_assert("TEST FAILED: view should share the matrix's block", view.block == mat.block);
+    mu_assert("TEST FAILED: view element (0,0) should be 7", getViewElement(&view, 0, 0).int_val == 7);
+    mu_assert("TEST FAILED: view element (2,1) should be 18", getViewElement(&view, 2, 1).int_val == 18);
+    mu_assert("TEST FAILED: inner view has the wrong dimensions", inner.rows == 2 && inner.cols == 1);
+    mu_assert("TEST FAILED: inner view element (1,0) should be 18", getViewElement(&inner, 1, 0).int_val == 18);
+
+    // Writes to the matrix should show through the view
+    setIntElement(&mat, 2, 2, 99);
+    mu_assert("TEST FAILED: view did not see the write", getViewElement(&view, 1, 0).int_val == 99);
+
+    // Copying the view should give a matrix of its own
+    Matrix copy = copyMatrixView(&view);
+    mu_assert("TEST FAILED: copy has the wrong dimensions", copy.rows == 3 && copy.cols == 2);
+    mu_assert("TEST FAILED: copy should not share the matrix's block", copy.block != mat.block);
+    mu_assert("TEST FAILED: copy element (1,0) should be 99", getIntElement(&copy, 1, 0) == 99);
+    mu_assert("TEST FAILED: copy element (2,1) should be 18", getIntElement(&copy, 2, 1) == 18);
+
+    // A range outside the matrix should give an empty view
+    MatrixView bad = createMatrixView(&mat, 2, 4, 0, 1);
+    mu_assert("TEST FAILED: out of range view should be empty", bad.block == NULL && bad.rows == 0);
+
+    // Cleanup
+    freeMatrix(&copy);
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_adding_and_multiplying_matrix_views() {
+    // Intro output
+    const char *functionName = "Adding and Multiplying Matrix Views";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A row major 4x4 INT matrix, and a column major packed 4x4 INT matrix holding the same values
+    Matrix mat1 = createMatrix(4, 4, INT);
+    Matrix mat2 = createMatrixWithLayout(4, 4, INT, COLUMN_MAJOR, PACKED_STORAGE);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            setIntElement(&mat1, r, c, r * 4 + c);
+            setIntElement(&mat2, r, c, r * 4 + c);
+        }
+    }
+
+    // When
+    // Take the bottom right 2x2 of each, and the top left 2x3 and 3x2 of the first
+    MatrixView view1 = createMatrixView(&mat1, 2, 3, 2, 3);
+    MatrixView view2 = createMatrixView(&mat2, 2, 3, 2, 3);
+    MatrixView wide = createMatrixView(&mat1, 0, 1, 0, 2);
+    MatrixView tall = createMatrixView(&mat2, 0, 2, 0, 1);
+    Matrix sum = addMatrixViews(&view1, &view2);
+    Matrix difference = subtractMatrixViews(&view1, &view2);
+    Matrix product = multiplyMatrixViews(&wide, &tall);
+
+    // Then
+    printf("Sum of the views:\n");
+    printMatrix(sum);
+    printf("Product of the views:\n");
+    printMatrix(product);
+
+    // [10 11; 14 15] + itself, and nothing left after subtracting
+    mu_assert("TEST FAILED: sum has the wrong dimensions", sum.rows == 2 && sum.cols == 2);
+    mu_assert("TEST FAILED: sum (0,0) should be 20", getIntElement(&sum, 0, 0) == 20);
+    mu_assert("TEST FAILED: sum (0,1) should be 22", getIntElement(&sum, 0, 1) == 22);
+    mu_assert("TEST FAILED: sum (1,0) should be 28", getIntElement(&sum, 1, 0) == 28);
+    mu_assert("TEST FAILED: sum (1,1) should be 30", getIntElement(&sum, 1, 1) == 30);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 2; c++) {
+            mu_assert("TEST FAILED: difference should be all zeros", getIntElement(&difference, r, c) == 0);
+        }
+    }
+
+    // [0 1 2; 4 5 6] * [0 1; 4 5; 8 9] = [20 23; 68 83]
+    mu_assert("TEST FAILED: product has the wrong dimensions", product.rows == 2 && product.cols == 2);
+    mu_assert("TEST FAILED: product (0,0) should be 20", getIntElement(&product, 0, 0) == 20);
+    mu_assert("TEST FAILED: product (0,1) should be 23", getIntElement(&product, 0, 1) == 23);
+    mu_assert("TEST FAILED: product (1,0) should be 68", getIntElement(&product, 1, 0) == 68);
+    mu_assert("TEST FAILED: product (1,1) should be 83", getIntElement(&product, 1, 1) == 83);
+
+    // Cleanup
+    freeMatrix(&sum);
+    freeMatrix(&difference);
+    freeMatrix(&product);
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_sameness_matrix_views() {
+    // Intro output
+    const char *functionName = "Sameness Matrix Views";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 4x4 DOUBLE matrix where the top left and bottom right 2x2 hold the same values
+    Matrix mat = createMatrixWithLayout(4, 4, DOUBLE, COLUMN_MAJOR, ELEMENT_STORAGE);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            setDoubleElement(&mat, r, c, (r % 2) + (c % 2) * 0.5);
+        }
+    }
+    Matrix rowMajor = deepCopyMatrix(&mat);
+    convertMatrixOrder(&rowMajor, ROW_MAJOR);
+
+    // When
+    MatrixView topLeft = createMatrixView(&mat, 0, 1, 0, 1);
+    MatrixView topLeftAgain = createMatrixView(&mat, 0, 1, 0, 1);
+    MatrixView bottomRight = createMatrixView(&mat, 2, 3, 2, 3);
+    MatrixView bottomLeft = createMatrixView(&rowMajor, 2, 3, 0, 1);
+    MatrixView topRight = createMatrixView(&mat, 0, 1, 1, 2);
+
+    // Then
+    mu_assert("TEST FAILED: views of the same cells should be INSTANCE",
+              checkViewSameness(&topLeft, &topLeftAgain) == INSTANCE);
+    mu_assert("TEST FAILED: views of matching cells should be ELEMENT",
+              checkViewSameness(&topLeft, &bottomRight) == ELEMENT);
+    mu_assert("TEST FAILED: views in different orders with matching cells should be ELEMENT",
+              checkViewSameness(&topLeft, &bottomLeft) == ELEMENT);
+    mu_assert("TEST FAILED: views of different cells should be NEITHER",
+              checkViewSameness(&topLeft, &topRight) == NEITHER);
+
+    // Cleanup
+    freeMatrix(&mat);
+    freeMatrix(&rowMajor);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 static char * test_resize_matrix_increase() {
     // Intro output
     const char *functionName = "Resize Matrix - Increase";
@@ -363,6 +870,51 @@ static char * test_resize_matrix_decrease() {
     return NULL;
 }
 
+// Resize keeps storage contiguous
+static char * test_resize_matrix_contiguous() {
+    // Intro output
+    const char *functionName = "Resize Matrix - Contiguous Storage";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix and fill it with data
+    Matrix mat = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat.data[r][c].int_val = r * 3 + c + 1;
+        }
+    }
+
+    printf("Initial matrix:\n");
+    printMatrix(mat);
+
+    // When
+    // Grow the matrix to 5x5
+    resizeMatrix(&mat, 5, 5);
+
+    // Then
+    printf("Matrix after resizing:\n");
+    printMatrix(mat);
+
+    // Rows should still be back to back in one block
+    for (int i = 1; i < 5; i++) {
+        mu_assert("TEST FAILED: rows are not back to back in memory", mat.data[i] == mat.data[i - 1] + 5);
+    }
+
+    // Old values should be kept and new cells should be zero
+    mu_assert("TEST FAILED: cell 2,2 should be 9", mat.data[2][2].int_val == 9);
+    mu_assert("TEST FAILED: cell 0,1 should be 2", mat.data[0][1].int_val == 2);
+    mu_assert("TEST FAILED: cell 4,4 should be 0", mat.data[4][4].int_val == 0);
+    mu_assert("TEST FAILED: cell 0,4 should be 0", mat.data[0][4].int_val == 0);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 // Resize to zero
 static char * test_resize_matrix_to_zero() {
     // Intro output
@@ -564,26 +1116,113 @@ static char * test_adding_double_matrix() {
     return NULL;
 }
 
-// Invalid Data Types
-static char * test_adding_invalid_data_matrix() {
+// Packed and element storage mixed
+static char * test_adding_packed_matrix() {
     // Intro output
-    const char *functionName = "Add Matrix - Invalid Data Types";
+    const char *functionName = "Add Matrix - Packed and Element Storage";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 4x4 matrix filled with doubles
-    Matrix mat1 = createMatrix(4, 4, DOUBLE);
-    for (int r = 0; r < 4; r++) {
-        for (int c = 0; c < 4; c++) {
-            mat1.data[r][c].double_val = (double)r * 4 + c;
+    // Create a packed 3x2 INT matrix and an element storage 3x2 INT matrix
+    Matrix mat1 = createPackedMatrix(3, 2, INT);
+    Matrix mat2 = createMatrix(3, 2, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 2; c++) {
+            setIntElement(&mat1, r, c, r * 2 + c);
+            setIntElement(&mat2, r, c, 100);
         }
     }
 
     printf("Initial matrix 1:\n");
     printMatrix(mat1);
+    printf("Initial matrix 2:\n");
+    printMatrix(mat2);
 
-    // Create a 4x4 matrix filled with Ints
-    Matrix mat2 = createMatrix(4, 4, INT);
+    // When
+    // Add the two matricies together
+    Matrix matResult = addMatrices(&mat1, &mat2);
+
+    // Then
+    printf("Resulting matrix after addition:\n");
+    printMatrix(matResult);
+
+    // The result should be stored like the first matrix
+    mu_assert("TEST FAILED: result should be packed", matResult.storage == PACKED_STORAGE);
+    mu_assert("TEST FAILED: cell 0,0 should be 100", getIntElement(&matResult, 0, 0) == 100);
+    mu_assert("TEST FAILED: cell 2,1 should be 105", getIntElement(&matResult, 2, 1) == 105);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+    freeMatrix(&matResult);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Different storage orders
+static char * test_adding_mixed_order_matrix() {
+    // Intro output
+    const char *functionName = "Add Matrix - Mixed Storage Orders";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a row major and a column major 40x35 DOUBLE matrix, big enough to span several tiles
+    Matrix mat1 = createMatrixWithLayout(40, 35, DOUBLE, ROW_MAJOR, PACKED_STORAGE);
+    Matrix mat2 = createMatrixWithLayout(40, 35, DOUBLE, COLUMN_MAJOR, ELEMENT_STORAGE);
+    for (int r = 0; r < 40; r++) {
+        for (int c = 0; c < 35; c++) {
+            setDoubleElement(&mat1, r, c, r * 100.0 + c);
+            setDoubleElement(&mat2, r, c, 0.5);
+        }
+    }
+
+    // When
+    // Add the two matricies together
+    Matrix matResult = addMatrices(&mat1, &mat2);
+
+    // Then
+    // The result should follow the first matrix's layout and hold the right sums
+    mu_assert("TEST FAILED: result should be row major", matResult.order == ROW_MAJOR);
+    mu_assert("TEST FAILED: matrix should have 40 rows", matResult.rows == 40);
+    mu_assert("TEST FAILED: matrix should have 35 columns", matResult.cols == 35);
+    for (int r = 0; r < 40; r++) {
+        for (int c = 0; c < 35; c++) {
+            mu_assert("TEST FAILED: wrong sum", getDoubleElement(&matResult, r, c) == r * 100.0 + c + 0.5);
+        }
+    }
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+    freeMatrix(&matResult);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Invalid Data Types
+static char * test_adding_invalid_data_matrix() {
+    // Intro output
+    const char *functionName = "Add Matrix - Invalid Data Types";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 4x4 matrix filled with doubles
+    Matrix mat1 = createMatrix(4, 4, DOUBLE);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            mat1.data[r][c].double_val = (double)r * 4 + c;
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat1);
+
+    // Create a 4x4 matrix filled with Ints
+    Matrix mat2 = createMatrix(4, 4, INT);
     for (int r = 0; r < 4; r++) {
         for (int c = 0; c < 4; c++) {
             mat2.data[r][c].int_val = r * 4 + c;
@@ -990,6 +1629,330 @@ static char * test_multiplying_double_matrix() {
     return NULL;
 }
 
+// Packed, non-square
+static char * test_multiplying_packed_matrix() {
+    // Intro output
+    const char *functionName = "Multiply Matrix - Packed Non-Square";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a packed 2x3 matrix and a packed 3x2 matrix of doubles
+    Matrix mat1 = createPackedMatrix(2, 3, DOUBLE);
+    Matrix mat2 = createPackedMatrix(3, 2, DOUBLE);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 3; c++) {
+            setDoubleElement(&mat1, r, c, r * 3 + c + 1);
+            setDoubleElement(&mat2, c, r, r * 3 + c + 1);
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat1);
+    printf("Initial matrix 2:\n");
+    printMatrix(mat2);
+
+    // When
+    // Multipy them together
+    Matrix matResult = multiplyMatrices(&mat1, &mat2);
+
+    // Then
+    printf("Resulting matrix after multiplication:\n");
+    printMatrix(matResult);
+
+    // Check row and column numbers
+    mu_assert("TEST FAILED: matrix should have 2 rows", matResult.rows == 2);
+    mu_assert("TEST FAILED: matrix should have 2 columns", matResult.cols == 2);
+
+    // [1 2 3; 4 5 6] times its own transpose is [14 32; 32 77]
+    mu_assert("TEST FAILED: cell 0,0 should be 14", getDoubleElement(&matResult, 0, 0) == 14.0);
+    mu_assert("TEST FAILED: cell 0,1 should be 32", getDoubleElement(&matResult, 0, 1) == 32.0);
+    mu_assert("TEST FAILED: cell 1,0 should be 32", getDoubleElement(&matResult, 1, 0) == 32.0);
+    mu_assert("TEST FAILED: cell 1,1 should be 77", getDoubleElement(&matResult, 1, 1) == 77.0);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+    freeMatrix(&matResult);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Every combination of storage orders
+static char * test_multiplying_mixed_order_matrix() {
+    // Intro output
+    const char *functionName = "Multiply Matrix - Mixed Storage Orders";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    for (int first = 0; first < 2; first++) {
+        for (int second = 0; second < 2; second++) {
+            // Given
+            // Create a 2x3 matrix and a 3x2 matrix of ints in the chosen orders
+            Matrix mat1 = createMatrixWithLayout(2, 3, INT, orders[first], ELEMENT_STORAGE);
+            Matrix mat2 = createMatrixWithLayout(3, 2, INT, orders[second], PACKED_STORAGE);
+            for (int r = 0; r < 2; r++) {
+                for (int c = 0; c < 3; c++) {
+                    setIntElement(&mat1, r, c, r * 3 + c + 1);
+                    setIntElement(&mat2, c, r, r * 3 + c + 1);
+                }
+            }
+
+            // When
+            // Multipy them together
+            Matrix matResult = multiplyMatrices(&mat1, &mat2);
+
+            // Then
+            printf("Result for orders %d and %d:\n", first, second);
+            printMatrix(matResult);
+
+            // [1 2 3; 4 5 6] times its own transpose is [14 32; 32 77]
+            mu_assert("TEST FAILED: cell 0,0 should be 14", getIntElement(&matResult, 0, 0) == 14);
+            mu_assert("TEST FAILED: cell 0,1 should be 32", getIntElement(&matResult, 0, 1) == 32);
+            mu_assert("TEST FAILED: cell 1,0 should be 32", getIntElement(&matResult, 1, 0) == 32);
+            mu_assert("TEST FAILED: cell 1,1 should be 77", getIntElement(&matResult, 1, 1) == 77);
+
+            // Cleanup
+            freeMatrix(&mat1);
+            freeMatrix(&mat2);
+            freeMatrix(&matResult);
+        }
+    }
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Large enough to go through the blocked multiplication
+static char * test_multiplying_large_matrix() {
+    // Intro output
+    const char *functionName = "Multiply Matrix - Large Blocked";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Sizes that are not multiples of any tile size, so every edge case of the blocking is hit.
+    // The shared dimension is bigger than one depth block too.
+    int m = 101, p = 300, n = 75;
+
+    // A row major element INT matrix, and a column major packed INT matrix
+    Matrix intA = createMatrixWithLayout(m, p, INT, ROW_MAJOR, ELEMENT_STORAGE);
+    Matrix intB = createMatrixWithLayout(p, n, INT, COLUMN_MAJOR, PACKED_STORAGE);
+
+    // And the same values again as DOUBLE, the other way round
+    Matrix doubleA = createMatrixWithLayout(m, p, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+    Matrix doubleB = createMatrixWithLayout(p, n, DOUBLE, ROW_MAJOR, ELEMENT_STORAGE);
+
+    for (int r = 0; r < m; r++) {
+        for (int c = 0; c < p; c++) {
+            setIntElement(&intA, r, c, (r * 7 + c * 3) % 11 - 5);
+            setDoubleElement(&doubleA, r, c, (r * 7 + c * 3) % 11 - 5);
+        }
+    }
+    for (int r = 0; r < p; r++) {
+        for (int c = 0; c < n; c++) {
+            setIntElement(&intB, r, c, (r * 5 + c * 2) % 13 - 6);
+            setDoubleElement(&doubleB, r, c, (r * 5 + c * 2) % 13 - 6);
+        }
+    }
+
+    // When
+    Matrix intResult = multiplyMatrices(&intA, &intB);
+    Matrix doubleResult = multiplyMatrices(&doubleA, &doubleB);
+
+    // Then
+    mu_assert("TEST FAILED: INT result has the wrong dimensions", intResult.rows == m && intResult.cols == n);
+    mu_assert("TEST FAILED: DOUBLE result has the wrong dimensions", doubleResult.rows == m && doubleResult.cols == n);
+
+    // Check every element against a plain dot product. These are small whole numbers, so doubles are exact too.
+    for (int r = 0; r < m; r++) {
+        for (int c = 0; c < n; c++) {
+            int expected = 0;
+            for (int k = 0; k < p; k++) {
+                expected += ((r * 7 + k * 3) % 11 - 5) * ((k * 5 + c * 2) % 13 - 6);
+            }
+            mu_assert("TEST FAILED: INT element is wrong", getIntElement(&intResult, r, c) == expected);
+            mu_assert("TEST FAILED: DOUBLE element is wrong", getDoubleElement(&doubleResult, r, c) == expected);
+        }
+    }
+
+    // Cleanup
+    freeMatrix(&intA);
+    freeMatrix(&intB);
+    freeMatrix(&doubleA);
+    freeMatrix(&doubleB);
+    freeMatrix(&intResult);
+    freeMatrix(&doubleResult);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Every instruction set the CPU supports should give the same answers
+static char * test_instruction_sets_matrix() {
+    // Intro output
+    const char *functionName = "Instruction Set Kernels";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Odd sizes, so every kernel has a partial vector left over, in both storage types.
+    // Large enough to reach the GEMM microkernels as well.
+    int size = 67;
+    Matrix intElement = createMatrixWithStorage(size, size, INT, ELEMENT_STORAGE);
+    Matrix intPacked = createMatrixWithStorage(size, size, INT, PACKED_STORAGE);
+    Matrix doubleElement = createMatrixWithStorage(size, size, DOUBLE, ELEMENT_STORAGE);
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) {
+            setIntElement(&intElement, r, c, (r * 3 + c) % 17 - 8);
+            setIntElement(&intPacked, r, c, (r + c * 5) % 19 - 9);
+            setDoubleElement(&doubleElement, r, c, ((r * 3 + c) % 17 - 8) * 0.5);
+        }
+    }
+
+    // Reference answers from the scalar kernels
+    mu_assert("TEST FAILED: scalar kernels should always be available", setInstructionSet(ISA_SCALAR) == 1);
+    mu_assert("TEST FAILED: scalar kernels should be in use", getInstructionSet() == ISA_SCALAR);
+    Matrix intSum = addMatrices(&intElement, &intElement);
+    Matrix intPackedSum = addMatrices(&intPacked, &intPacked);
+    Matrix intDifference = subtractMatrices(&intPacked, &intElement);
+    Matrix intProduct = multiplyMatrices(&intElement, &intPacked);
+    Matrix doubleSum = addMatrices(&doubleElement, &doubleElement);
+    Matrix doubleProduct = multiplyMatrices(&doubleElement, &doubleElement);
+
+    // When
+    // Run the same operations on each instruction set this CPU supports
+    InstructionSet sets[] = {ISA_SSE2, ISA_AVX2, ISA_AVX512};
+    for (int i = 0; i < 3; i++) {
+        if (!setInstructionSet(sets[i])) {
+            printf("Instruction set %d not supported here, skipping it\n", sets[i]);
+            continue;
+        }
+        printf("Checking instruction set %d\n", sets[i]);
+        Matrix sum = addMatrices(&intElement, &intElement);
+        Matrix packedSum = addMatrices(&intPacked, &intPacked);
+        Matrix difference = subtractMatrices(&intPacked, &intElement);
+        Matrix product = multiplyMatrices(&intElement, &intPacked);
+        Matrix dSum = addMatrices(&doubleElement, &doubleElement);
+        Matrix dProduct = multiplyMatrices(&doubleElement, &doubleElement);
+
+        // Then
+        mu_assert("TEST FAILED: INT sum differs from scalar", checkMatrixSameness(&sum, &intSum) == ELEMENT);
+        mu_assert("TEST FAILED: packed INT sum differs from scalar",
+                  checkMatrixSameness(&packedSum, &intPackedSum) == ELEMENT);
+        mu_assert("TEST FAILED: INT difference differs from scalar",
+                  checkMatrixSameness(&difference, &intDifference) == ELEMENT);
+        mu_assert("TEST FAILED: INT product differs from scalar", checkMatrixSameness(&product, &intProduct) == ELEMENT);
+        mu_assert("TEST FAILED: DOUBLE sum differs from scalar", checkMatrixSameness(&dSum, &doubleSum) == ELEMENT);
+
+        // Halves of small whole numbers are exact, so even a fused multiply-add gives the same doubles
+        mu_assert("TEST FAILED: DOUBLE product differs from scalar",
+                  checkMatrixSameness(&dProduct, &doubleProduct) == ELEMENT);
+
+        // A single changed value, right at the end where the partial vectors are, should be noticed
+        setIntElement(&sum, size - 1, size - 1, getIntElement(&sum, size - 1, size - 1) + 1);
+        setIntElement(&packedSum, size - 1, size - 2, 1000);
+        setDoubleElement(&dSum, size - 1, size - 1, -1.0);
+        mu_assert("TEST FAILED: changed INT element not noticed", checkMatrixSameness(&sum, &intSum) == NEITHER);
+        mu_assert("TEST FAILED: changed packed INT element not noticed",
+                  checkMatrixSameness(&packedSum, &intPackedSum) == NEITHER);
+        mu_assert("TEST FAILED: changed DOUBLE element not noticed", checkMatrixSameness(&dSum, &doubleSum) == NEITHER);
+
+        freeMatrix(&sum);
+        freeMatrix(&packedSum);
+        freeMatrix(&difference);
+        freeMatrix(&product);
+        freeMatrix(&dSum);
+        freeMatrix(&dProduct);
+    }
+
+    // Cleanup
+    setInstructionSet(ISA_AUTO);
+    freeMatrix(&intElement);
+    freeMatrix(&intPacked);
+    freeMatrix(&doubleElement);
+    freeMatrix(&intSum);
+    freeMatrix(&intPackedSum);
+    freeMatrix(&intDifference);
+    freeMatrix(&intProduct);
+    freeMatrix(&doubleSum);
+    freeMatrix(&doubleProduct);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Big operations shared between threads should match the same operations on one thread
+static char * test_thread_pool_matrix() {
+    // Intro output
+    const char *functionName = "Thread Pool Operations";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Matrices big enough that every operation is split between threads,
+    // one row major INT, one column major INT, and one packed DOUBLE
+    int size = 512;
+    Matrix rowInts = createMatrixWithLayout(size, size, INT, ROW_MAJOR, ELEMENT_STORAGE);
+    Matrix colInts = createMatrixWithLayout(size, size, INT, COLUMN_MAJOR, ELEMENT_STORAGE);
+    Matrix doubles = createMatrixWithStorage(size, size, DOUBLE, PACKED_STORAGE);
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) {
+            setIntElement(&rowInts, r, c, (r * 7 + c) % 23 - 11);
+            setIntElement(&colInts, r, c, (r + c * 3) % 29 - 14);
+            setDoubleElement(&doubles, r, c, ((r * 5 + c) % 13 - 6) * 0.25);
+        }
+    }
+
+    // Reference answers on a single thread
+    setThreadCount(1);
+    mu_assert("TEST FAILED: thread count should be 1", getThreadCount() == 1);
+    Matrix sum = addMatrices(&rowInts, &rowInts);
+    Matrix mixedDifference = subtractMatrices(&rowInts, &colInts);
+    Matrix product = multiplyMatrices(&doubles, &doubles);
+
+    // When
+    // The same operations shared between 4 threads
+    setThreadCount(4);
+    mu_assert("TEST FAILED: thread count should be 4", getThreadCount() == 4);
+    Matrix threadedSum = addMatrices(&rowInts, &rowInts);
+    Matrix threadedDifference = subtractMatrices(&rowInts, &colInts);
+    Matrix threadedProduct = multiplyMatrices(&doubles, &doubles);
+    Matrix threadedCopy = deepCopyMatrix(&colInts);
+
+    // Then
+    mu_assert("TEST FAILED: threaded sum differs", checkMatrixSameness(&threadedSum, &sum) == ELEMENT);
+    mu_assert("TEST FAILED: threaded mixed order difference differs",
+              checkMatrixSameness(&threadedDifference, &mixedDifference) == ELEMENT);
+    mu_assert("TEST FAILED: threaded product differs", checkMatrixSameness(&threadedProduct, &product) == ELEMENT);
+    mu_assert("TEST FAILED: threaded copy differs", checkMatrixSameness(&threadedCopy, &colInts) == ELEMENT);
+
+    // A difference in the very last value, which belongs to the last thread, should still be found
+    setIntElement(&threadedCopy, size - 1, size - 1, 1000);
+    mu_assert("TEST FAILED: threaded sameness missed a difference",
+              checkMatrixSameness(&threadedCopy, &colInts) == NEITHER);
+    mu_assert("TEST FAILED: threaded mixed order sameness missed a difference",
+              checkMatrixSameness(&threadedCopy, &rowInts) == NEITHER);
+
+    // Cleanup
+    setThreadCount(0);
+    freeMatrix(&rowInts);
+    freeMatrix(&colInts);
+    freeMatrix(&doubles);
+    freeMatrix(&sum);
+    freeMatrix(&mixedDifference);
+    freeMatrix(&product);
+    freeMatrix(&threadedSum);
+    freeMatrix(&threadedDifference);
+    freeMatrix(&threadedProduct);
+    freeMatrix(&threadedCopy);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 // Invalid Data Type
 static char * test_multiplying_invalid_data_matrix() {
     // Intro output
@@ -1221,6 +2184,44 @@ static char * test_deep_copy_char_matrix() {
     return NULL;
 }
 
+// Copies do not share storage
+static char * test_deep_copy_independent_matrix() {
+    // Intro output
+    const char *functionName = "Deep Copy - Independent Storage";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat.data[r][c].int_val = r * 3 + c;
+        }
+    }
+
+    // When
+    // Deep copy the Matrix, then change the original
+    Matrix deepCopy = deepCopyMatrix(&mat);
+    mat.data[1][1].int_val = 100;
+
+    // Then
+    printf("Resulting matrix after DEEP COPY:\n");
+    printMatrix(deepCopy);
+
+    // The copy should have its own block and keep the old value
+    mu_assert("TEST FAILED: copy shares storage with the original", deepCopy.block != mat.block);
+    mu_assert("TEST FAILED: Cell 1,1 should have value 4", deepCopy.data[1][1].int_val == 4);
+    mu_assert("TEST FAILED: Cell 2,2 should have value 8", deepCopy.data[2][2].int_val == 8);
+
+    // Cleanup
+    freeMatrix(&mat);
+    freeMatrix(&deepCopy);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
 // Invalid Data
 static char * test_deep_copy_invalid_matrix() {
     // Intro output
@@ -1254,238 +2255,2356 @@ static char * test_deep_copy_invalid_matrix() {
     return NULL;
 }
 
-// Matrix Same-ness Tests
-// Instance-wise 
-static char * test_sameness_instance_matrix() {
+// Into Variants
+// Results written into existing matricies, including in place
+static char * test_into_arithmetic_matrix() {
     // Intro output
-    const char *functionName = "Sameness - Instance";
+    const char *functionName = "Into Variants - Arithmetic";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 3x3 matrix filled with INTs
+    // Two INT matrices, plus DOUBLE operands big enough for the blocked multiplication
     Matrix mat1 = createMatrix(3, 3, INT);
+    Matrix mat2 = createMatrix(3, 3, INT);
     for (int r = 0; r < 3; r++) {
         for (int c = 0; c < 3; c++) {
-            mat1.data[r][c].int_val = r * 3 + c;
+            setIntElement(&mat1, r, c, r * 3 + c);
+            setIntElement(&mat2, r, c, 10 - c);
+        }
+    }
+    int size = 80;
+    Matrix left = createMatrixWithStorage(size, size, DOUBLE, PACKED_STORAGE);
+    Matrix right = createMatrixWithLayout(size, size, DOUBLE, COLUMN_MAJOR, ELEMENT_STORAGE);
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) {
+            setDoubleElement(&left, r, c, ((r * 3 + c) % 11 - 5) * 0.5);
+            setDoubleElement(&right, r, c, ((r + c * 7) % 13 - 6) * 0.25);
         }
     }
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat1);
+    // When
+    // Results go into reused destinations, one of them stored differently from the operands
+    Matrix sum = addMatrices(&mat1, &mat2);
+    Matrix difference = subtractMatrices(&mat1, &mat2);
+    Matrix dest = createMatrixWithLayout(3, 3, INT, COLUMN_MAJOR, PACKED_STORAGE);
+    Matrix product = multiplyMatrices(&left, &right);
+    Matrix productDest = createMatrixWithLayout(size, size, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
 
-    // Make a copy
-    Matrix mat2 = mat1;
+    // Then
+    mu_assert("TEST FAILED: add into should succeed", addMatricesInto(&dest, &mat1, &mat2) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: add into result differs", checkMatrixSameness(&dest, &sum) == ELEMENT);
+    mu_assert("TEST FAILED: subtract into should succeed",
+              subtractMatricesInto(&dest, &mat1, &mat2) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: subtract into result differs", checkMatrixSameness(&dest, &difference) == ELEMENT);
+
+    // A second multiplication into the same destination must not add onto the first
+    for (int i = 0; i < 2; i++) {
+        mu_assert("TEST FAILED: multiply into should succeed",
+                  multiplyMatricesInto(&productDest, &left, &right) == MATRIX_SUCCESS);
+        mu_assert("TEST FAILED: multiply into result differs", checkMatrixSameness(&productDest, &product) == ELEMENT);
+    }
 
-    printf("Initial matrix 2:\n");
-    printMatrix(mat2);
+    // In place: mat1 = mat1 + mat2, then mat1 = mat1 - mat2 gets the original back
+    Matrix original = deepCopyMatrix(&mat1);
+    mu_assert("TEST FAILED: in place add should succeed", addMatricesInto(&mat1, &mat1, &mat2) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: in place add result differs", checkMatrixSameness(&mat1, &sum) == ELEMENT);
+    mu_assert("TEST FAILED: in place subtract should succeed",
+              subtractMatricesInto(&mat1, &mat1, &mat2) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: in place subtract result differs", checkMatrixSameness(&mat1, &original) == ELEMENT);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+    freeMatrix(&left);
+    freeMatrix(&right);
+    freeMatrix(&sum);
+    freeMatrix(&difference);
+    freeMatrix(&dest);
+    freeMatrix(&product);
+    freeMatrix(&productDest);
+    freeMatrix(&original);
 
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
 
-    // When
-    // Compare both matricies
-    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+// Destinations that don't fit are rejected and left alone
+static char * test_into_invalid_matrix() {
+    // Intro output
+    const char *functionName = "Into Variants - Invalid";
+    printf("*** TEST START: %s ***\n", functionName);
 
-    // Then
-    // Should be the same instance
-    mu_assert("TEST FAILED: Matricies should be same instance.", checkSame = INSTANCE);
+    // Given
+    Matrix mat1 = createMatrix(2, 2, INT);
+    Matrix mat2 = createMatrix(2, 2, INT);
+    Matrix chars = createMatrix(2, 2, CHAR);
+    Matrix wrongSize = createMatrix(3, 2, INT);
+    Matrix wrongType = createMatrix(2, 2, DOUBLE);
+    Matrix invalid = invalidMatrix();
+    setIntElement(&mat1, 0, 0, 1);
+    setIntElement(&mat2, 0, 0, 2);
+    setIntElement(&wrongSize, 0, 0, 5);
+
+    // When / Then
+    mu_assert("TEST FAILED: wrong sized destination should be rejected",
+              addMatricesInto(&wrongSize, &mat1, &mat2) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: rejected destination should be untouched", getIntElement(&wrongSize, 0, 0) == 5);
+    mu_assert("TEST FAILED: wrong typed destination should be rejected",
+              multiplyMatricesInto(&wrongType, &mat1, &mat2) == MATRIX_ERROR_TYPE_MISMATCH);
+    mu_assert("TEST FAILED: mismatched operands should be rejected",
+              subtractMatricesInto(&mat1, &mat1, &wrongType) == MATRIX_ERROR_TYPE_MISMATCH);
+    mu_assert("TEST FAILED: CHAR addition should be rejected",
+              addMatricesInto(&chars, &chars, &chars) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: invalid destination should be rejected",
+              copyMatrixInto(&invalid, &mat1) == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: NULL operand should be rejected",
+              addMatricesInto(&mat1, NULL, &mat2) == MATRIX_ERROR_NULL_POINTER);
+
+    // A multiplication can't write over its own operands
+    mu_assert("TEST FAILED: multiplying in place should be rejected",
+              multiplyMatricesInto(&mat1, &mat1, &mat2) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: rejected multiply should leave the operand alone", getIntElement(&mat1, 0, 0) == 1);
 
-    // Cleanup (both matricies same)
+    // Cleanup
     freeMatrix(&mat1);
+    freeMatrix(&mat2);
+    freeMatrix(&chars);
+    freeMatrix(&wrongSize);
+    freeMatrix(&wrongType);
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
     return NULL;
 }
 
-// Element-wise 
-static char * test_sameness_element_matrix() {
+// Copies into matricies stored every way
+static char * test_copy_into_matrix() {
     // Intro output
-    const char *functionName = "Sameness - Element";
+    const char *functionName = "Into Variants - Copy";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 3x3 matrix filled with INTs
-    Matrix mat1 = createMatrix(3, 3, INT);
-    for (int r = 0; r < 3; r++) {
-        for (int c = 0; c < 3; c++) {
-            mat1.data[r][c].int_val = r * 3 + c;
+    // A row major INT matrix and a destination of each storage type and order
+    Matrix source = createMatrix(5, 7, INT);
+    for (int r = 0; r < 5; r++) {
+        for (int c = 0; c < 7; c++) {
+            setIntElement(&source, r, c, r * 100 + c);
         }
     }
+    Matrix dests[4];
+    dests[0] = createMatrixWithLayout(5, 7, INT, ROW_MAJOR, ELEMENT_STORAGE);
+    dests[1] = createMatrixWithLayout(5, 7, INT, ROW_MAJOR, PACKED_STORAGE);
+    dests[2] = createMatrixWithLayout(5, 7, INT, COLUMN_MAJOR, ELEMENT_STORAGE);
+    dests[3] = createMatrixWithLayout(5, 7, INT, COLUMN_MAJOR, PACKED_STORAGE);
+
+    // When / Then
+    for (int i = 0; i < 4; i++) {
+        mu_assert("TEST FAILED: copy into should succeed", copyMatrixInto(&dests[i], &source) == MATRIX_SUCCESS);
+        mu_assert("TEST FAILED: copy into result differs", checkMatrixSameness(&dests[i], &source) == ELEMENT);
+    }
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat1);
+    // Copying a matrix onto itself has nothing to do
+    mu_assert("TEST FAILED: self copy should succeed", copyMatrixInto(&source, &source) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: self copy should leave the matrix alone", getIntElement(&source, 4, 6) == 406);
 
-    // Make a copy
-    Matrix mat2 = deepCopyMatrix(&mat1);
+    // Cleanup
+    freeMatrix(&source);
+    for (int i = 0; i < 4; i++) {
+        freeMatrix(&dests[i]);
+    }
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// General multiply with scales and transposes, checked against a plain triple loop
+static char * test_gemm_matrix() {
+    // Intro output
+    const char *functionName = "General Multiply - Scales and Transposes";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Sizes on both sides of the blocked GEMM threshold. Every value is a multiple of 0.25,
+    // so the sums are exact whatever order they are added in.
+    int sizes[2][3] = {{5, 7, 3}, {70, 90, 80}};
+    for (int s = 0; s < 2; s++) {
+        int m = sizes[s][0], n = sizes[s][1], p = sizes[s][2];
+        for (int t = 0; t < 4; t++) {
+            Transpose transpose1 = (t & 1) ? TRANSPOSE : NO_TRANSPOSE;
+            Transpose transpose2 = (t & 2) ? TRANSPOSE : NO_TRANSPOSE;
+
+            // Operands are stored already transposed when they will be used transposed
+            Matrix a = (transpose1 == TRANSPOSE) ? createMatrix(p, m, DOUBLE) : createMatrix(m, p, DOUBLE);
+            Matrix b = (transpose2 == TRANSPOSE) ? createMatrixWithLayout(n, p, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE)
+                                                 : createMatrixWithLayout(p, n, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+            Matrix c = createMatrixWithStorage(m, n, DOUBLE, PACKED_STORAGE);
+            Matrix expected = createMatrix(m, n, DOUBLE);
+            for (int i = 0; i < m; i++) {
+                for (int k = 0; k < p; k++) {
+                    double value = ((i * 3 + k) % 9 - 4) * 0.25;
+                    if (transpose1 == TRANSPOSE) {
+                        setDoubleElement(&a, k, i, value);
+                    } else {
+                        setDoubleElement(&a, i, k, value);
+                    }
+                }
+            }
+            for (int k = 0; k < p; k++) {
+                for (int j = 0; j < n; j++) {
+                    double value = ((k + j * 5) % 7 - 3) * 0.5;
+                    if (transpose2 == TRANSPOSE) {
+                        setDoubleElement(&b, j, k, value);
+                    } else {
+                        setDoubleElement(&b, k, j, value);
+                    }
+                }
+            }
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) {
+                    setDoubleElement(&c, i, j, (i - j) * 0.5);
+                }
+            }
+
+            // The plain triple loop answer of 2.5 * op(a) * op(b) - 0.5 * c
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < n; j++) {
+                    double sum = 0.0;
+                    for (int k = 0; k < p; k++) {
+                        sum += ((i * 3 + k) % 9 - 4) * 0.25 * (((k + j * 5) % 7 - 3) * 0.5);
+                    }
+                    setDoubleElement(&expected, i, j, 2.5 * sum - 0.5 * ((i - j) * 0.5));
+                }
+            }
+
+            // When
+            MatrixStatus status = gemmMatrices(transpose1, transpose2, 2.5, &a, &b, -0.5, &c);
+
+            // Then
+            mu_assert("TEST FAILED: general multiply should succeed", status == MATRIX_SUCCESS);
+            mu_assert("TEST FAILED: general multiply result differs", checkMatrixSameness(&c, &expected) == ELEMENT);
+
+            // Cleanup
+            freeMatrix(&a);
+            freeMatrix(&b);
+            freeMatrix(&c);
+            freeMatrix(&expected);
+        }
+    }
+
+    // A transposed view reads the same cells with rows and columns swapped
+    Matrix ints = createMatrix(2, 3, INT);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 3; c++) {
+            setIntElement(&ints, r, c, r * 10 + c);
+        }
+    }
+    MatrixView view = viewMatrix(&ints);
+    MatrixView transposed = transposeMatrixView(&view);
+    mu_assert("TEST FAILED: transposed view should be 3x2", transposed.rows == 3 && transposed.cols == 2);
+    mu_assert("TEST FAILED: transposed view reads the wrong cell", getViewElement(&transposed, 2, 1).int_val == 12);
+
+    // INT: ints * ints^T scaled by 3 and added onto twice the destination
+    Matrix square = createMatrix(2, 2, INT);
+    setIntElement(&square, 0, 0, 1);
+    setIntElement(&square, 1, 1, 1);
+    mu_assert("TEST FAILED: INT general multiply should succeed",
+              gemmMatrices(NO_TRANSPOSE, TRANSPOSE, 3.0, &ints, &ints, 2.0, &square) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: INT general multiply result differs",
+              getIntElement(&square, 0, 0) == 3 * 5 + 2 && getIntElement(&square, 0, 1) == 3 * 35 &&
+              getIntElement(&square, 1, 1) == 3 * 365 + 2);
+
+    // INT matrices can't take fractional scales, and the destination can't be an operand
+    mu_assert("TEST FAILED: fractional INT scale should be rejected",
+              gemmMatrices(NO_TRANSPOSE, TRANSPOSE, 0.5, &ints, &ints, 0.0, &square) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: NaN INT scale should be rejected",
+              gemmMatrices(NO_TRANSPOSE, TRANSPOSE, NAN, &ints, &ints, 0.0, &square) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: infinite INT scale should be rejected",
+              gemmMatrices(NO_TRANSPOSE, TRANSPOSE, 1.0, &ints, &ints, INFINITY, &square) ==
+                  MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: INT scale out of int range should be rejected",
+              gemmMatrices(NO_TRANSPOSE, TRANSPOSE, 1e12, &ints, &ints, 0.0, &square) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: multiplying into an operand should be rejected",
+              gemmMatrices(NO_TRANSPOSE, NO_TRANSPOSE, 1.0, &square, &square, 0.0, &square) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: untransposed shapes should be rejected",
+              gemmMatrices(NO_TRANSPOSE, NO_TRANSPOSE, 1.0, &ints, &ints, 0.0, &square) == MATRIX_ERROR_SIZE_MISMATCH);
+
+    // Cleanup
+    freeMatrix(&ints);
+    freeMatrix(&square);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Allocators
+// Counts the calls made to a counting allocator, which otherwise uses the system allocator
+static int countedAllocations = 0;
+static int countedReleases = 0;
+
+static void *countingAllocate(void *context, size_t size) {
+    (void)context;
+    countedAllocations++;
+    return malloc(size);
+}
+
+static void countingRelease(void *context, void *ptr, size_t size) {
+    (void)context;
+    (void)size;
+    countedReleases++;
+    free(ptr);
+}
+
+// Matrices come from the installed allocator, and go back to it even after another is installed
+static char * test_custom_allocator_matrix() {
+    // Intro output
+    const char *functionName = "Allocators - Custom";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    MatrixAllocator counting = {countingAllocate, countingRelease, NULL};
+    countedAllocations = 0;
+    countedReleases = 0;
+
+    // When
+    setMatrixAllocator(&counting);
+    Matrix mat = createMatrix(4, 4, INT);
+    Matrix packed = createPackedMatrix(3, 5, DOUBLE);
+    resizeMatrix(&mat, 6, 6);
+    setMatrixAllocator(NULL);
+    Matrix system = createMatrix(2, 2, INT);
+
+    // Then
+    mu_assert("TEST FAILED: allocator should be back to the system one", getMatrixAllocator().allocate == NULL);
+    mu_assert("TEST FAILED: custom allocator should have made 3 blocks", countedAllocations == 3);
+    mu_assert("TEST FAILED: resize should have released the old block", countedReleases == 1);
+    setIntElement(&mat, 5, 5, 7);
+    mu_assert("TEST FAILED: resized matrix should work", getIntElement(&mat, 5, 5) == 7);
+
+    // Cleanup
+    freeMatrix(&mat);
+    freeMatrix(&packed);
+    freeMatrix(&system);
+    mu_assert("TEST FAILED: freeing should release to the custom allocator", countedReleases == 3);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// An arena reuses the same memory after a reset, and a pool recycles blocks of the same shape
+static char * test_arena_and_pool_allocators_matrix() {
+    // Intro output
+    const char *functionName = "Allocators - Arena and Pool";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    MatrixArena *arena = createMatrixArena(4096);
+    MatrixPool *pool = createMatrixPool(0);
+    MatrixAllocator arenaAllocator = matrixArenaAllocator(arena);
+    MatrixAllocator poolAllocator = matrixPoolAllocator(pool);
+    mu_assert("TEST FAILED: arena and pool should be created", arena != NULL && pool != NULL);
+
+    // When
+    // Three rounds of the same scratch matrices in the arena, more than one chunk's worth. The first reset merges
+    // the chunks into one, so the later rounds bump through that chunk alone, from the same addresses each time.
+    // Nothing is asserted until the system allocator is back, so a failure doesn't leave the arena installed.
+    setMatrixAllocator(&arenaAllocator);
+    void *blocks[3][2];
+    int roundsValid = 1;
+    double firstValue = -1.0, lastValue = -1.0;
+    for (int round = 0; round < 3; round++) {
+        Matrix small = createMatrix(8, 8, DOUBLE);
+        Matrix big = createMatrix(32, 32, DOUBLE);
+        roundsValid &= isValid(&small) && isValid(&big);
+        blocks[round][0] = small.block;
+        blocks[round][1] = big.block;
+        if (round == 2) {
+            // The previous round's values were released with the arena, and the block comes back zeroed
+            firstValue = getDoubleElement(&big, 31, 31);
+            setDoubleElement(&big, 31, 31, 2.5);
+            lastValue = getDoubleElement(&big, 31, 31);
+        } else {
+            setDoubleElement(&big, 31, 31, 1.5);
+        }
+        resetMatrixArena(arena);
+    }
+
+    // A pool hands a freed block to the next matrix of the same shape
+    setMatrixAllocator(&poolAllocator);
+    Matrix pooled = createMatrix(10, 10, INT);
+    setIntElement(&pooled, 3, 3, 9);
+    void *block = pooled.block;
+    freeMatrix(&pooled);
+    Matrix recycled = createMatrix(10, 10, INT);
+    setMatrixAllocator(NULL);
+
+    // Then
+    mu_assert("TEST FAILED: allocator should be back to the system one", getMatrixAllocator().allocate == NULL);
+    mu_assert("TEST FAILED: arena matrices should be valid", roundsValid);
+    mu_assert("TEST FAILED: second round should allocate no new chunks",
+              blocks[2][0] == blocks[1][0] && blocks[2][1] == blocks[1][1]);
+    mu_assert("TEST FAILED: arena memory should come back zeroed", firstValue == 0.0);
+    mu_assert("TEST FAILED: arena matrix should hold values", lastValue == 2.5);
+    mu_assert("TEST FAILED: pool should recycle the freed block", recycled.block == block);
+    mu_assert("TEST FAILED: recycled block should come back zeroed", getIntElement(&recycled, 3, 3) == 0);
+
+    // Cleanup
+    freeMatrix(&recycled);
+    freeMatrixPool(pool);
+    freeMatrixArena(arena);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Sparse
+static char * test_sparse_conversions_matrix() {
+    // Intro output
+    const char *functionName = "Sparse - Conversions";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 4x5 matrix in COO, listed out of order and with cell (2, 1) given twice
+    int rows[] = {3, 0, 2, 1, 2, 0};
+    int cols[] = {4, 2, 1, 0, 1, 0};
+    double values[] = {6.0, 2.0, 1.5, 3.0, 2.5, 1.0};
+    SparseMatrix coo = createSparseMatrix(4, 5, DOUBLE, 6, rows, cols, values);
+
+    // When
+    SparseMatrix csr = convertSparseFormat(&coo, SPARSE_CSR);
+    SparseMatrix csc = convertSparseFormat(&csr, SPARSE_CSC);
+    SparseMatrix back = convertSparseFormat(&csc, SPARSE_COO);
+    Matrix dense = sparseToDense(&coo);
+    Matrix columnDense = createMatrixWithLayout(4, 5, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+    copyMatrixInto(&columnDense, &dense);
+    SparseMatrix fromDense = denseToSparse(&columnDense, SPARSE_CSR);
+
+    // Then
+    mu_assert("TEST FAILED: conversions should be valid", isValidSparse(&csr) && isValidSparse(&csc) &&
+              isValidSparse(&back) && isValidSparse(&fromDense));
+    mu_assert("TEST FAILED: repeated cells should be added together", csr.nnz == 5 && csc.nnz == 5);
+    mu_assert("TEST FAILED: CSR rows should be sorted", csr.offsets[1] == 2 && csr.indices[0] == 0 &&
+              csr.indices[1] == 2);
+    mu_assert("TEST FAILED: repeated cell should add up", getSparseElement(&csc, 2, 1).double_val == 4.0);
+    mu_assert("TEST FAILED: missing cell should be zero", getSparseElement(&csr, 3, 3).double_val == 0.0);
+    mu_assert("TEST FAILED: null sparse matrix should read as zero", getSparseElement(NULL, 0, 0).int_val == 0);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 5; c++) {
+            double expected = getDoubleElement(&dense, r, c);
+            mu_assert("TEST FAILED: every format should hold the same values",
+                      getSparseElement(&csr, r, c).double_val == expected &&
+                      getSparseElement(&csc, r, c).double_val == expected &&
+                      getSparseElement(&back, r, c).double_val == expected &&
+                      getSparseElement(&fromDense, r, c).double_val == expected);
+        }
+    }
+    mu_assert("TEST FAILED: dense round trip should match", fromDense.nnz == csr.nnz);
+
+    // Cleanup
+    freeSparseMatrix(&coo);
+    freeSparseMatrix(&csr);
+    freeSparseMatrix(&csc);
+    freeSparseMatrix(&back);
+    freeSparseMatrix(&fromDense);
+    freeMatrix(&dense);
+    freeMatrix(&columnDense);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_sparse_arithmetic_matrix() {
+    // Intro output
+    const char *functionName = "Sparse - Arithmetic";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 3x4 INT matrix and its negated first row
+    int rows[] = {0, 0, 1, 2, 2};
+    int cols[] = {1, 3, 2, 0, 3};
+    int values[] = {2, -1, 4, 5, 3};
+    int negRows[] = {0, 0};
+    int negCols[] = {1, 3};
+    int negValues[] = {-2, 1};
+    SparseMatrix coo = createSparseMatrix(3, 4, INT, 5, rows, cols, values);
+    SparseMatrix negated = createSparseMatrix(3, 4, INT, 2, negRows, negCols, negValues);
+    Matrix dense = sparseToDense(&coo);
+    Matrix other = createMatrixWithLayout(4, 2, INT, COLUMN_MAJOR, ELEMENT_STORAGE);
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 2; c++) {
+            setIntElement(&other, r, c, r * 2 + c + 1);
+        }
+    }
+    int x[] = {1, 2, 3, 4};
+
+    // When
+    Matrix expected = multiplyMatrices(&dense, &other);
+    Matrix products[3];
+    int ys[3][3];
+    SparseFormat formats[] = {SPARSE_CSR, SPARSE_CSC, SPARSE_COO};
+    for (int f = 0; f < 3; f++) {
+        SparseMatrix sparse = convertSparseFormat(&coo, formats[f]);
+        products[f] = sparseMultiplyDense(&sparse, &other);
+        mu_assert("TEST FAILED: SpMV should succeed", sparseMultiplyVector(&sparse, x, ys[f]) == MATRIX_SUCCESS);
+        freeSparseMatrix(&sparse);
+    }
+    SparseMatrix sum = addSparseMatrices(&coo, &negated);
+    SparseMatrix transposed = transposeSparseMatrix(&coo);
+    SparseMatrix csr = convertSparseFormat(&coo, SPARSE_CSR);
+    SparseMatrix csrTransposed = transposeSparseMatrix(&csr);
+    SparseMatrix mismatched = addSparseMatrices(&coo, &transposed);
+
+    // Then
+    for (int f = 0; f < 3; f++) {
+        mu_assert("TEST FAILED: SpMV should match", ys[f][0] == 0 && ys[f][1] == 12 && ys[f][2] == 17);
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 2; c++) {
+                mu_assert("TEST FAILED: SpMM should match dense multiply",
+                          getIntElement(&products[f], r, c) == getIntElement(&expected, r, c));
+            }
+        }
+        freeMatrix(&products[f]);
+    }
+    mu_assert("TEST FAILED: cancelled cells should be left out", sum.format == SPARSE_CSR && sum.nnz == 3 &&
+              sum.offsets[1] == 0);
+    mu_assert("TEST FAILED: transposes should swap dimensions", transposed.rows == 4 && transposed.cols == 3 &&
+              csrTransposed.rows == 4 && csrTransposed.cols == 3 && csrTransposed.format == SPARSE_CSR);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            int value = getIntElement(&dense, r, c);
+            mu_assert("TEST FAILED: transposes should match",
+                      getSparseElement(&transposed, c, r).int_val == value &&
+                      getSparseElement(&csrTransposed, c, r).int_val == value);
+        }
+    }
+    mu_assert("TEST FAILED: mismatched add should be invalid", !isValidSparse(&mismatched));
+
+    // Cleanup
+    freeSparseMatrix(&coo);
+    freeSparseMatrix(&negated);
+    freeSparseMatrix(&sum);
+    freeSparseMatrix(&transposed);
+    freeSparseMatrix(&csr);
+    freeSparseMatrix(&csrTransposed);
+    freeMatrix(&dense);
+    freeMatrix(&other);
+    freeMatrix(&expected);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_sparse_large_matrix() {
+    // Intro output
+    const char *functionName = "Sparse - Large";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 200000x200000 banded matrix with 3 entries a row, enough to be shared between threads
+    int n = 200000;
+    size_t nnz = (size_t)n * 3;
+    int *rows = (int *)malloc(nnz * sizeof(int));
+    int *cols = (int *)malloc(nnz * sizeof(int));
+    double *values = (double *)malloc(nnz * sizeof(double));
+    double *x = (double *)malloc((size_t)n * sizeof(double));
+    double *y = (double *)malloc((size_t)n * sizeof(double));
+    double *yt = (double *)malloc((size_t)n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            size_t e = (size_t)i * 3 + k;
+            rows[e] = i;
+            cols[e] = (i + k * 7919) % n;
+            values[e] = (double)(k + 1);
+        }
+        x[i] = (double)(i % 10);
+    }
+    SparseMatrix coo = createSparseMatrix(n, n, DOUBLE, nnz, rows, cols, values);
+
+    // When
+    SparseMatrix csc = convertSparseFormat(&coo, SPARSE_CSC);
+    SparseMatrix transposed = transposeSparseMatrix(&csc);
+    SparseMatrix csr = convertSparseFormat(&transposed, SPARSE_CSR);
+    MatrixStatus status = sparseMultiplyVector(&csc, x, y);
+    SparseMatrix back = transposeSparseMatrix(&csr);
+    MatrixStatus statusBack = sparseMultiplyVector(&back, x, yt);
+
+    // Then
+    mu_assert("TEST FAILED: large products should succeed", status == MATRIX_SUCCESS && statusBack == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: large conversions should keep every entry", csc.nnz == nnz && back.nnz == nnz);
+    int matches = 1;
+    for (int i = 0; i < n && matches; i++) {
+        double expected = 0.0;
+        for (int k = 0; k < 3; k++) {
+            expected += (double)(k + 1) * x[(i + k * 7919) % n];
+        }
+        matches = (y[i] == expected && yt[i] == expected);
+    }
+    mu_assert("TEST FAILED: large SpMV should match", matches);
+
+    // Cleanup
+    freeSparseMatrix(&coo);
+    freeSparseMatrix(&csc);
+    freeSparseMatrix(&transposed);
+    freeSparseMatrix(&csr);
+    freeSparseMatrix(&back);
+    free(rows);
+    free(cols);
+    free(values);
+    free(x);
+    free(y);
+    free(yt);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Matrix Files
+static char * test_matrix_file_round_trip() {
+    // Intro output
+    const char *functionName = "Matrix Files - Round Trip";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // An INT matrix in element storage, and a column major DOUBLE matrix whose inner 3x2 view gets saved
+    Matrix ints = createMatrixWithLayout(3, 4, INT, ROW_MAJOR, ELEMENT_STORAGE);
+    Matrix doubles = createMatrixWithLayout(5, 4, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+    for (int r = 0; r < 5; r++) {
+        for (int c = 0; c < 4; c++) {
+            if (r < 3) {
+                setIntElement(&ints, r, c, r * 10 + c);
+            }
+            setDoubleElement(&doubles, r, c, r + c * 0.5);
+        }
+    }
+    MatrixView inner = createMatrixView(&doubles, 1, 3, 1, 2);
+
+    // When
+    MatrixStatus savedInts = saveMatrix("test_matrix_ints.bin", &ints);
+    MatrixStatus savedInner = saveMatrixView("test_matrix_inner.bin", &inner);
+    MappedMatrix mappedInts, mappedInner;
+    MatrixStatus mapInts = mapMatrixFile("test_matrix_ints.bin", &mappedInts);
+    MatrixStatus mapInner = mapMatrixFile("test_matrix_inner.bin", &mappedInner);
+    Matrix loaded = loadMatrixFile("test_matrix_inner.bin");
+
+    // Then
+    mu_assert("TEST FAILED: matrices should save", savedInts == MATRIX_SUCCESS && savedInner == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: files should map", mapInts == MATRIX_SUCCESS && mapInner == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: checksums should match", verifyMappedMatrix(&mappedInts) == MATRIX_SUCCESS &&
+              verifyMappedMatrix(&mappedInner) == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: mapped values should be aligned",
+              (uintptr_t)mappedInts.view.block % MATRIX_FILE_ALIGNMENT == 0);
+    mu_assert("TEST FAILED: mapped view should keep its layout", mappedInner.view.rows == 3 &&
+              mappedInner.view.cols == 2 && mappedInner.view.order == COLUMN_MAJOR &&
+              mappedInner.view.storage == PACKED_STORAGE);
+    MatrixView intsView = viewMatrix(&ints);
+    mu_assert("TEST FAILED: mapped matrix should match", checkViewSameness(&mappedInts.view, &intsView) == ELEMENT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            mu_assert("TEST FAILED: mapped INT values should match",
+                      getViewElement(&mappedInts.view, r, c).int_val == r * 10 + c);
+        }
+        for (int c = 0; c < 2; c++) {
+            double expected = (r + 1) + (c + 1) * 0.5;
+            mu_assert("TEST FAILED: mapped view values should match",
+                      getViewElement(&mappedInner.view, r, c).double_val == expected);
+            mu_assert("TEST FAILED: loaded values should match", getDoubleElement(&loaded, r, c) == expected);
+        }
+    }
+
+    // Cleanup
+    unmapMatrixFile(&mappedInts);
+    unmapMatrixFile(&mappedInner);
+    freeMatrix(&ints);
+    freeMatrix(&doubles);
+    freeMatrix(&loaded);
+    remove("test_matrix_ints.bin");
+    remove("test_matrix_inner.bin");
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_file_writer_and_errors() {
+    // Intro output
+    const char *functionName = "Matrix Files - Writer and Errors";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 2x3 CHAR matrix written in two pieces, and a writer that stops early
+    char first[] = {'a', 'b', 'c', 'd'};
+    char second[] = {'e', 'f'};
+    MatrixWriter *writer = openMatrixWriter("test_matrix_chars.bin", 2, 3, CHAR, ROW_MAJOR);
+    MatrixWriter *shortWriter = openMatrixWriter("test_matrix_short.bin", 2, 2, INT, ROW_MAJOR);
+    int one = 1;
+
+    // When
+    MatrixStatus wroteFirst = writeMatrixValues(writer, first, 4);
+    MatrixStatus wroteTooMany = writeMatrixValues(writer, first, 4);
+    MatrixStatus wroteSecond = writeMatrixValues(writer, second, 2);
+    MatrixStatus closed = closeMatrixWriter(writer);
+    writeMatrixValues(shortWriter, &one, 1);
+    MatrixStatus closedShort = closeMatrixWriter(shortWriter);
+    Matrix chars = loadMatrixFile("test_matrix_chars.bin");
+
+    // Then
+    mu_assert("TEST FAILED: pieces should be written", wroteFirst == MATRIX_SUCCESS && wroteSecond == MATRIX_SUCCESS &&
+              closed == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: writing past the end should fail", wroteTooMany == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: closing early should fail", closedShort == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: pieces should load in order", getCharElement(&chars, 0, 0) == 'a' &&
+              getCharElement(&chars, 1, 0) == 'd' && getCharElement(&chars, 1, 2) == 'f');
+
+    // When
+    // An unfinished file, a missing file, and a file with one value changed on disk
+    MappedMatrix mapped;
+    MatrixStatus mapShort = mapMatrixFile("test_matrix_short.bin", &mapped);
+    MatrixStatus mapMissing = mapMatrixFile("test_matrix_missing.bin", &mapped);
+    FILE *file = fopen("test_matrix_chars.bin", "r+b");
+    fseek(file, MATRIX_FILE_ALIGNMENT + 5, SEEK_SET);
+    fputc('z', file);
+    fclose(file);
+    MatrixStatus mapChanged = mapMatrixFile("test_matrix_chars.bin", &mapped);
+    MatrixStatus verifyChanged = verifyMappedMatrix(&mapped);
+    Matrix changed = loadMatrixFile("test_matrix_chars.bin");
+
+    // Then
+    mu_assert("TEST FAILED: unfinished file should be refused", mapShort == MATRIX_ERROR_FORMAT);
+    mu_assert("TEST FAILED: missing file should fail", mapMissing == MATRIX_ERROR_IO);
+    mu_assert("TEST FAILED: changed file should still map", mapChanged == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: changed file should fail its checksum", verifyChanged == MATRIX_ERROR_FORMAT);
+    mu_assert("TEST FAILED: changed file should not load", !isValid(&changed));
+
+    // Cleanup
+    unmapMatrixFile(&mapped);
+    freeMatrix(&chars);
+    freeMatrix(&changed);
+    remove("test_matrix_chars.bin");
+    remove("test_matrix_short.bin");
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Matrix Text
+// A sink that takes nothing, to check that a failed write is reported
+static size_t refuseText(void *context, const char *text, size_t size) {
+    (void)context;
+    (void)text;
+    (void)size;
+    return 0;
+}
+
+static char * test_matrix_text() {
+    // Intro output
+    const char *functionName = "Matrix Text";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A column major DOUBLE matrix, an INT matrix, and a CHAR matrix holding characters CSV has to quote
+    Matrix doubles = createMatrixWithLayout(2, 3, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+    double values[2][3] = {{0.1, -2.5, 1e21}, {0.30000000000000004, -0.0, 1.0 / 3.0}};
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 3; c++) {
+            setDoubleElement(&doubles, r, c, values[r][c]);
+        }
+    }
+    Matrix ints = createMatrix(1, 3, INT);
+    setIntElement(&ints, 0, 0, -2147483647 - 1);
+    setIntElement(&ints, 0, 1, 0);
+    setIntElement(&ints, 0, 2, 42);
+    Matrix chars = createMatrix(1, 3, CHAR);
+    setCharElement(&chars, 0, 0, 'a');
+    setCharElement(&chars, 0, 1, ',');
+    setCharElement(&chars, 0, 2, '"');
+    MatrixView doublesView = viewMatrix(&doubles);
+    MatrixView intsView = viewMatrix(&ints);
+    MatrixView charsView = viewMatrix(&chars);
+
+    // When
+    TextFormat shortest = {TEXT_CSV, TEXT_SHORTEST};
+    TextFormat fixed = {TEXT_TSV, 2};
+    TextFormat printed = {TEXT_PRINT, 6};
+    size_t length = 0;
+    char *shortestText = matrixViewToText(&doublesView, shortest, &length);
+    char *fixedText = matrixViewToText(&doublesView, fixed, NULL);
+    char *intsText = matrixViewToText(&intsView, printed, NULL);
+    char *charsText = matrixViewToText(&charsView, shortest, NULL);
+    TextSink refusing = {refuseText, NULL};
+    MatrixStatus refused = writeMatrixText(&ints, printed, refusing);
+
+    // Then
+    mu_assert("TEST FAILED: shortest doubles should read back exactly",
+              strcmp(shortestText, "0.1,-2.5,1000000000000000000000\n"
+                                   "0.30000000000000004,-0,0.3333333333333333\n") == 0);
+    mu_assert("TEST FAILED: length should be reported", length == strlen(shortestText));
+    mu_assert("TEST FAILED: fixed precision should round like printf",
+              strcmp(fixedText, "0.10\t-2.50\t1000000000000000000000.00\n0.30\t-0.00\t0.33\n") == 0);
+    mu_assert("TEST FAILED: print layout should end every value in a tab",
+              strcmp(intsText, "-2147483648\t0\t42\t\n") == 0);
+    mu_assert("TEST FAILED: CSV should quote commas and quotes", strcmp(charsText, "a,\",\",\"\"\"\"\n") == 0);
+    mu_assert("TEST FAILED: a refusing sink should be an error", refused == MATRIX_ERROR_IO);
+
+    // When
+    // The same text through a stdio stream, read back
+    FILE *file = tmpfile();
+    MatrixStatus written = writeMatrixText(&doubles, fixed, fileTextSink(file));
+    char readBack[128] = {0};
+    rewind(file);
+    size_t readLength = fread(readBack, 1, sizeof(readBack) - 1, file);
+    fclose(file);
+
+    // Then
+    mu_assert("TEST FAILED: stream sink should get the same text", written == MATRIX_SUCCESS &&
+              readLength == strlen(fixedText) && strcmp(readBack, fixedText) == 0);
+
+    // Cleanup
+    free(shortestText);
+    free(fixedText);
+    free(intsText);
+    free(charsText);
+    freeMatrix(&doubles);
+    freeMatrix(&ints);
+    freeMatrix(&chars);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Write text to a temporary stream and rewind it, ready to be read back
+static FILE *textStream(const char *text) {
+    FILE *file = tmpfile();
+    fputs(text, file);
+    rewind(file);
+    return file;
+}
+
+static char * test_read_matrix_text() {
+    // Intro output
+    const char *functionName = "Matrix Text - Reading";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // CSV with a header, CRLF line breaks and a blank line, printMatrix output, quoted CHAR values, a ragged row, and
+    // a malformed first row, which has numbers in it and so isn't a header
+    FILE *csv = textStream("a,b,c\r\n1.5, -2e3 ,0.1\r\n\r\n3,4,5e-1\r\n");
+    FILE *printed = textStream("1\t2\t3\t\n-4\t5\t6\t");
+    FILE *chars = textStream("x,\",\",\"\"\"\"\n");
+    FILE *ragged = textStream("1,2\n3\n");
+    FILE *malformed = textStream("1,2x,3\n4,5,6\n");
+
+    // When
+    Matrix doubles = readMatrixText(csv, TEXT_CSV, DOUBLE);
+    Matrix ints = readMatrixText(printed, TEXT_PRINT, INT);
+    Matrix quoted = readMatrixText(chars, TEXT_CSV, CHAR);
+    Matrix broken = readMatrixText(ragged, TEXT_CSV, INT);
+    Matrix badFirst = readMatrixText(malformed, TEXT_CSV, DOUBLE);
+
+    // Then
+    mu_assert("TEST FAILED: CSV should skip its header", doubles.rows == 2 && doubles.cols == 3);
+    mu_assert("TEST FAILED: CSV values should parse", getDoubleElement(&doubles, 0, 0) == 1.5 &&
+              getDoubleElement(&doubles, 0, 1) == -2000.0 && getDoubleElement(&doubles, 0, 2) == 0.1 &&
+              getDoubleElement(&doubles, 1, 2) == 0.5);
+    mu_assert("TEST FAILED: printMatrix output should read back", ints.rows == 2 && ints.cols == 3 &&
+              getIntElement(&ints, 1, 0) == -4 && getIntElement(&ints, 1, 2) == 6);
+    mu_assert("TEST FAILED: quoted CHAR values should read back", quoted.cols == 3 &&
+              getCharElement(&quoted, 0, 0) == 'x' && getCharElement(&quoted, 0, 1) == ',' &&
+              getCharElement(&quoted, 0, 2) == '"');
+    mu_assert("TEST FAILED: a ragged row should be an error", !isValid(&broken));
+    mu_assert("TEST FAILED: a malformed first row should be an error, not a header", !isValid(&badFirst));
+
+    // When
+    // Enough rows of shortest doubles written out to need several doublings and several threads' worth of text
+    Matrix big = createPackedMatrix(20000, 8, DOUBLE);
+    for (int r = 0; r < 20000; r++) {
+        for (int c = 0; c < 8; c++) {
+            setDoubleElement(&big, r, c, (r * 8 + c) / 7.0 - 3000.0);
+        }
+    }
+    FILE *file = tmpfile();
+    TextFormat format = {TEXT_TSV, TEXT_SHORTEST};
+    writeMatrixText(&big, format, fileTextSink(file));
+    rewind(file);
+    Matrix readBack = readMatrixText(file, TEXT_TSV, DOUBLE);
+
+    // Then
+    mu_assert("TEST FAILED: big matrix should read back", readBack.rows == 20000 && readBack.cols == 8);
+    MatrixView bigView = viewMatrix(&big);
+    MatrixView readBackView = viewMatrix(&readBack);
+    mu_assert("TEST FAILED: big matrix should read back exactly", checkViewSameness(&bigView, &readBackView) == ELEMENT);
+
+    // Cleanup
+    fclose(csv);
+    fclose(printed);
+    fclose(chars);
+    fclose(ragged);
+    fclose(malformed);
+    fclose(file);
+    freeMatrix(&doubles);
+    freeMatrix(&ints);
+    freeMatrix(&quoted);
+    freeMatrix(&big);
+    freeMatrix(&readBack);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_read_matrix_market() {
+    // Intro output
+    const char *functionName = "Matrix Text - Matrix Market";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A general real coordinate file, a symmetric pattern file, a skew-symmetric integer array and a short file
+    FILE *general = textStream("%%MatrixMarket matrix coordinate real general\n% a comment\n3 4 3\n"
+                               "1 1 1.5\n3 4 -2\n2 2 1e-3\n");
+    FILE *pattern = textStream("%%MatrixMarket matrix coordinate pattern symmetric\n3 3 2\n2 1\n3 3\n");
+    FILE *skew = textStream("%%MatrixMarket matrix array integer skew-symmetric\n3 3\n4\n5\n6\n");
+    FILE *truncated = textStream("%%MatrixMarket matrix coordinate real general\n2 2 3\n1 1 1\n2 2 2\n");
+
+    // When
+    SparseMatrix coordinates = readSparseMatrixMarket(general);
+    Matrix symmetric = readMatrixMarket(pattern);
+    Matrix skewed = readMatrixMarket(skew);
+    SparseMatrix missing = readSparseMatrixMarket(truncated);
+
+    // Then
+    mu_assert("TEST FAILED: coordinate file should read", coordinates.format == SPARSE_COO && coordinates.nnz == 3 &&
+              coordinates.rows == 3 && coordinates.cols == 4 && coordinates.data_type == DOUBLE);
+    mu_assert("TEST FAILED: coordinate values should read", getSparseElement(&coordinates, 0, 0).double_val == 1.5 &&
+              getSparseElement(&coordinates, 2, 3).double_val == -2.0 &&
+              getSparseElement(&coordinates, 1, 1).double_val == 1e-3);
+    mu_assert("TEST FAILED: symmetric pattern should be mirrored", symmetric.data_type == INT &&
+              getIntElement(&symmetric, 1, 0) == 1 && getIntElement(&symmetric, 0, 1) == 1 &&
+              getIntElement(&symmetric, 2, 2) == 1 && getIntElement(&symmetric, 0, 0) == 0);
+    mu_assert("TEST FAILED: skew-symmetric array should be mirrored negated", skewed.order == COLUMN_MAJOR &&
+              getIntElement(&skewed, 1, 0) == 4 && getIntElement(&skewed, 0, 1) == -4 &&
+              getIntElement(&skewed, 2, 1) == 6 && getIntElement(&skewed, 1, 2) == -6 &&
+              getIntElement(&skewed, 2, 2) == 0);
+    mu_assert("TEST FAILED: too few entries should be an error", !isValidSparse(&missing));
+
+    // Cleanup
+    fclose(general);
+    fclose(pattern);
+    fclose(skew);
+    fclose(truncated);
+    freeSparseMatrix(&coordinates);
+    freeMatrix(&symmetric);
+    freeMatrix(&skewed);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Matrix Same-ness Tests
+// Instance-wise 
+static char * test_sameness_instance_matrix() {
+    // Intro output
+    const char *functionName = "Sameness - Instance";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat1 = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat1.data[r][c].int_val = r * 3 + c;
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat1);
+
+    // Make a copy
+    Matrix mat2 = mat1;
+
+    printf("Initial matrix 2:\n");
+    printMatrix(mat2);
+
+
+    // When
+    // Compare both matricies
+    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+
+    // Then
+    // Should be the same instance
+    mu_assert("TEST FAILED: Matricies should be same instance.", checkSame = INSTANCE);
+
+    // Cleanup (both matricies same)
+    freeMatrix(&mat1);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Element-wise 
+static char * test_sameness_element_matrix() {
+    // Intro output
+    const char *functionName = "Sameness - Element";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat1 = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat1.data[r][c].int_val = r * 3 + c;
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat1);
+
+    // Make a copy
+    Matrix mat2 = deepCopyMatrix(&mat1);
+
+    printf("Initial matrix 2:\n");
+    printMatrix(mat2);
+
+
+    // When
+    // Compare both matricies
+    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+
+    // Then
+    // Should be the same element-wise
+    mu_assert("TEST FAILED: Matricies should be element-wise same.", checkSame = ELEMENT);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Element-wise across storage types
+static char * test_sameness_packed_matrix() {
+    // Intro output
+    const char *functionName = "Sameness - Packed vs Element Storage";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create the same 3x3 INT matrix with both storage types
+    Matrix mat1 = createMatrix(3, 3, INT);
+    Matrix mat2 = createPackedMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            setIntElement(&mat1, r, c, r * 3 + c);
+            setIntElement(&mat2, r, c, r * 3 + c);
+        }
+    }
+
+    // When
+    // Compare them, then change one cell and compare again
+    Sameness before = checkMatrixSameness(&mat1, &mat2);
+    setIntElement(&mat2, 2, 2, 42);
+    Sameness after = checkMatrixSameness(&mat1, &mat2);
+
+    // Then
+    mu_assert("TEST FAILED: Matricies should be element-wise same.", before == ELEMENT);
+    mu_assert("TEST FAILED: Matricies should not be the same.", after == NEITHER);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Neither
+static char * test_sameness_neither_matrix() {
+    // Intro output
+    const char *functionName = "Sameness - Neither";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat1 = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat1.data[r][c].int_val = r * 3 + c;
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat1);
+
+    // Make another
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat2 = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            mat2.data[r][c].int_val = r * 3 + c + 1;
+        }
+    }
+
+    printf("Initial matrix 2:\n");
+    printMatrix(mat2);
+
+
+    // When
+    // Compare both matricies
+    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+
+    // Then
+    // Should not be the same either way
+    mu_assert("TEST FAILED: Matricies should not be the same.", checkSame == NEITHER);
+
+    // Cleanup
+    freeMatrix(&mat1);
+    freeMatrix(&mat2);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Test Matrix Rotation
+// Non-Square
+static char * test_rotate_nonsquare_matrix() {
+    // Intro output
+    const char *functionName = "Rotation - Non-Square";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x4 matrix filled with INTs
+    Matrix mat = createMatrix(3, 4, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            mat.data[r][c].int_val = r * 4 + c;
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat);
+
+    // When
+    // Rotate it 90*
+    RotationStatus status = rotateMatrix(&mat);
+
+    // Then
+    // Should error not square
+    mu_assert("TEST FAILED: Should return not square error.", status == ERROR_NOT_SQUARE);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Invalid Data
+static char * test_rotate_invalid_matrix() {
+    // Intro output
+    const char *functionName = "Rotation - Invalid Data";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create an invalid matrix
+    Matrix mat = invalidMatrix();
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat);
+
+    // When
+    // Rotate it 90*
+    RotationStatus status = rotateMatrix(&mat);
+
+    // Then
+    // Should error null pointer
+    mu_assert("TEST FAILED: Should return invalid data error.", status == ERROR_NULL_POINTER);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Valid INT Data
+static char * test_rotate_valid_int_matrix() {
+    // Intro output
+    const char *functionName = "Rotation - Valid INT";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x3 matrix filled with INTs
+    Matrix mat = createMatrix(3, 3, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            setIntElement(&mat, r, c, r * 3 + c);
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat);
+
+    // When
+    // Rotate it 90*
+    RotationStatus status = rotateMatrix(&mat);
+
+    // Then
+    printf("Post Rotation:\n");
+    printMatrix(mat);
+
+    // Should succeed
+    mu_assert("TEST FAILED: Should return invalid data error.", status == SUCCESS);
+
+    // Check a few random cells
+    mu_assert("TEST FAILED: Cell 0,0 should have value 6", getIntElement(&mat, 0, 0) == 6);
+    mu_assert("TEST FAILED: Cell 1,1 should have value 4", getIntElement(&mat, 1, 1) == 4); // This element doesn't move
+    mu_assert("TEST FAILED: Cell 0,2 should have value 0", getIntElement(&mat, 0, 2) == 0);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Valid column major data
+static char * test_rotate_column_major_matrix() {
+    // Intro output
+    const char *functionName = "Rotation - Column Major";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a column major 3x3 matrix filled with INTs
+    Matrix mat = createMatrixWithLayout(3, 3, INT, COLUMN_MAJOR, PACKED_STORAGE);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            setIntElement(&mat, r, c, r * 3 + c);
+        }
+    }
+
+    printf("Initial matrix 1:\n");
+    printMatrix(mat);
+
+    // When
+    // Rotate it 90*
+    RotationStatus status = rotateMatrix(&mat);
+
+    // Then
+    printf("Post Rotation:\n");
+    printMatrix(mat);
+
+    // Should succeed, with the same result as a row major matrix
+    mu_assert("TEST FAILED: Should return success.", status == SUCCESS);
+    mu_assert("TEST FAILED: Cell 0,0 should have value 6", getIntElement(&mat, 0, 0) == 6);
+    mu_assert("TEST FAILED: Cell 0,2 should have value 0", getIntElement(&mat, 0, 2) == 0);
+    mu_assert("TEST FAILED: Cell 2,0 should have value 8", getIntElement(&mat, 2, 0) == 8);
+    mu_assert("TEST FAILED: Cell 1,2 should have value 1", getIntElement(&mat, 1, 2) == 1);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Half turn of a non-square matrix
+static char * test_rotate_half_turn_matrix() {
+    // Intro output
+    const char *functionName = "Rotation - Half Turn";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Create a 3x4 matrix filled with INTs
+    Matrix mat = createMatrix(3, 4, INT);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            setIntElement(&mat, r, c, r * 4 + c);
+        }
+    }
+
+    // When
+    // Turn it 180* in place
+    RotationStatus status = rotateMatrixBy(&mat, ROTATE_180);
+
+    // Then
+    // A half turn keeps the shape, so it works on any matrix
+    mu_assert("TEST FAILED: Should return success.", status == SUCCESS);
+    mu_assert("TEST FAILED: Shape should not change", mat.rows == 3 && mat.cols == 4);
+    mu_assert("TEST FAILED: Cell 0,0 should have value 11", getIntElement(&mat, 0, 0) == 11);
+    mu_assert("TEST FAILED: Cell 2,3 should have value 0", getIntElement(&mat, 2, 3) == 0);
+    mu_assert("TEST FAILED: Cell 1,0 should have value 7", getIntElement(&mat, 1, 0) == 7);
+    mu_assert("TEST FAILED: Quarter turns should still need a square matrix",
+              rotateMatrixBy(&mat, ROTATE_270) == ERROR_NOT_SQUARE);
+
+    // Cleanup
+    freeMatrix(&mat);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Rotations and transposes into new matrices and views, checked cell by cell
+static char * test_rotated_and_transposed_copies() {
+    // Intro output
+    const char *functionName = "Rotation - Copies and Transposes";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 2x3 matrix, and a large one with odd sides so the tiles don't divide it evenly and threads share the work
+    Matrix small = createPackedMatrix(2, 3, INT);
+    for (int r = 0; r < 2; r++) {
+        for (int c = 0; c < 3; c++) {
+            setIntElement(&small, r, c, r * 3 + c + 1);
+        }
+    }
+    int n = 517;
+    Matrix big = createMatrix(n, n, DOUBLE);
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            setDoubleElement(&big, r, c, r * 1000.0 + c);
+        }
+    }
+
+    // When
+    // [1 2 3; 4 5 6] turned a quarter clockwise is [4 1; 5 2; 6 3], and transposed is [1 4; 2 5; 3 6]
+    Matrix clockwise = createRotatedMatrix(&small, ROTATE_90);
+    Matrix transposed = createTransposedMatrix(&small);
+    Matrix counterclockwise = createMatrixWithLayout(3, 2, INT, COLUMN_MAJOR, ELEMENT_STORAGE);
+    MatrixView smallView = viewMatrix(&small);
+    MatrixView counterView = viewMatrix(&counterclockwise);
+    MatrixStatus status = rotateViewInto(&counterView, &smallView, ROTATE_270);
+
+    // Then
+    mu_assert("TEST FAILED: Clockwise copy should be 3x2", clockwise.rows == 3 && clockwise.cols == 2);
+    mu_assert("TEST FAILED: Clockwise copy is wrong", getIntElement(&clockwise, 0, 0) == 4 &&
+              getIntElement(&clockwise, 0, 1) == 1 && getIntElement(&clockwise, 2, 0) == 6 &&
+              getIntElement(&clockwise, 2, 1) == 3);
+    mu_assert("TEST FAILED: Transpose is wrong", transposed.rows == 3 && getIntElement(&transposed, 0, 1) == 4 &&
+              getIntElement(&transposed, 2, 0) == 3 && getIntElement(&transposed, 1, 1) == 5);
+    mu_assert("TEST FAILED: Rotating into a view should succeed", status == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: Counterclockwise copy is wrong", getIntElement(&counterclockwise, 0, 0) == 3 &&
+              getIntElement(&counterclockwise, 0, 1) == 6 && getIntElement(&counterclockwise, 2, 0) == 1 &&
+              getIntElement(&counterclockwise, 2, 1) == 4);
+    mu_assert("TEST FAILED: Wrong destination size should be refused",
+              rotateViewInto(&counterView, &smallView, ROTATE_180) == MATRIX_ERROR_SIZE_MISMATCH);
+    MatrixView insideClockwise = createMatrixView(&clockwise, 0, 1, 0, 1);
+    mu_assert("TEST FAILED: Rotating a matrix into itself should be refused",
+              transposeViewInto(&insideClockwise, &insideClockwise) == MATRIX_ERROR_ALIASING);
+
+    // When
+    // Turn the large matrix a quarter in place, and compare with a rotated copy and with where each cell should be
+    Matrix bigCopy = createRotatedMatrix(&big, ROTATE_90);
+    RotationStatus turned = rotateMatrixBy(&big, ROTATE_90);
+    MatrixView bigView = viewMatrix(&big);
+    MatrixView bigCopyView = viewMatrix(&bigCopy);
+
+    // Then
+    mu_assert("TEST FAILED: Large rotation should succeed", turned == SUCCESS);
+    mu_assert("TEST FAILED: In place and copied rotations should match",
+              checkViewSameness(&bigView, &bigCopyView) == ELEMENT);
+    int moved = 1;
+    for (int r = 0; r < n && moved; r++) {
+        for (int c = 0; c < n; c++) {
+            if (getDoubleElement(&big, r, c) != (n - 1 - c) * 1000.0 + r) {
+                moved = 0;
+                break;
+            }
+        }
+    }
+    mu_assert("TEST FAILED: Every cell of the large matrix should have turned", moved);
+
+    // When
+    // Three more quarter turns counterclockwise make a full turn back, and so do two half turns
+    rotateMatrixBy(&big, ROTATE_270);
+    rotateMatrixBy(&bigCopy, ROTATE_270);
+    rotateMatrixBy(&bigCopy, ROTATE_180);
+    rotateMatrixBy(&bigCopy, ROTATE_180);
+
+    // Then
+    mu_assert("TEST FAILED: Turning back should restore the matrix", getDoubleElement(&big, 3, 500) == 3500.0 &&
+              checkViewSameness(&bigView, &bigCopyView) == ELEMENT);
+
+    // Cleanup
+    freeMatrix(&small);
+    freeMatrix(&big);
+    freeMatrix(&clockwise);
+    freeMatrix(&transposed);
+    freeMatrix(&counterclockwise);
+    freeMatrix(&bigCopy);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_expr() {
+    // Intro output
+    const char *functionName = "Expressions - Fused Evaluation";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // Three large double matrices with odd sides, so chunks end partway along lines and threads share the work
+    int n = 513;
+    Matrix a = createPackedMatrix(n, n, DOUBLE);
+    Matrix b = createPackedMatrix(n, n, DOUBLE);
+    Matrix c = createMatrix(n, n, DOUBLE);
+    for (int r = 0; r < n; r++) {
+        for (int col = 0; col < n; col++) {
+            setDoubleElement(&a, r, col, r * 0.5 + col);
+            setDoubleElement(&b, r, col, col * 0.25 - r);
+            setDoubleElement(&c, r, col, (r + col) % 7);
+        }
+    }
+    MatrixView aView = viewMatrix(&a);
+    MatrixView bView = viewMatrix(&b);
+    MatrixView cView = viewMatrix(&c);
 
-    printf("Initial matrix 2:\n");
-    printMatrix(mat2);
+    // When
+    // (a + b) - c in one pass, and the same with two separate operations
+    MatrixExpr *expr = createMatrixExpr();
+    int aNode = exprInput(expr, &aView);
+    int bNode = exprInput(expr, &bView);
+    int sum = exprAdd(expr, aNode, bNode);
+    int difference = exprSubtract(expr, sum, exprInput(expr, &cView));
+    Matrix fused = createMatrixFromExpr(expr, difference);
+    Matrix added = addMatrices(&a, &b);
+    Matrix chained = subtractMatrices(&added, &c);
+    MatrixView fusedView = viewMatrix(&fused);
+    MatrixView chainedView = viewMatrix(&chained);
 
+    // Then
+    mu_assert("TEST FAILED: Fused result should be a valid matrix", isValid(&fused));
+    mu_assert("TEST FAILED: Fused and chained results should match",
+              checkViewSameness(&fusedView, &chainedView) == ELEMENT);
 
     // When
-    // Compare both matricies
-    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+    // Write (a - b) / 2 into a column major view with gaps, and then max(a, 0) * a back over a itself
+    Matrix wide = createMatrixWithLayout(n + 3, n + 1, DOUBLE, COLUMN_MAJOR, PACKED_STORAGE);
+    MatrixView inside = createMatrixView(&wide, 2, n + 1, 1, n);
+    int half = exprDivide(expr, exprSubtract(expr, aNode, bNode), exprScalar(expr, 2.0));
+    MatrixStatus halfStatus = evaluateMatrixExpr(expr, half, &inside);
+    int squared = exprMultiply(expr, exprMax(expr, aNode, exprScalar(expr, 0.0)), aNode);
+    MatrixStatus squaredStatus = evaluateMatrixExpr(expr, squared, &aView);
 
     // Then
-    // Should be the same element-wise
-    mu_assert("TEST FAILED: Matricies should be element-wise same.", checkSame = ELEMENT);
+    mu_assert("TEST FAILED: Evaluating into a view should succeed", halfStatus == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: Evaluating over an input should succeed", squaredStatus == MATRIX_SUCCESS);
+    int right = 1;
+    for (int r = 0; r < n && right; r++) {
+        for (int col = 0; col < n; col++) {
+            double x = r * 0.5 + col;
+            double y = col * 0.25 - r;
+            if (getDoubleElement(&wide, r + 2, col + 1) != (x - y) / 2 || getDoubleElement(&a, r, col) != x * x) {
+                right = 0;
+                break;
+            }
+        }
+    }
+    mu_assert("TEST FAILED: Every value of the view and of the overwritten input should be right", right);
+    mu_assert("TEST FAILED: Cells around the view should be untouched",
+              getDoubleElement(&wide, 0, 0) == 0.0 && getDoubleElement(&wide, n + 2, n) == 0.0);
+
+    // When
+    // An INT expression with scalars: max(-|x - 3|, -2) * 2 + min(x, 1) over [-1 0 1; 2 3 4] in element storage
+    Matrix ints = createMatrix(2, 3, INT);
+    for (int k = 0; k < 6; k++) {
+        setIntElement(&ints, k / 3, k % 3, k - 1);
+    }
+    MatrixView intsView = viewMatrix(&ints);
+    MatrixExpr *intExpr = createMatrixExpr();
+    int x = exprInput(intExpr, &intsView);
+    int distance = exprNegate(intExpr, exprAbs(intExpr, exprSubtract(intExpr, x, exprScalar(intExpr, 3))));
+    int clamped = exprMax(intExpr, distance, exprScalar(intExpr, -2));
+    int total = exprAdd(intExpr, exprMultiply(intExpr, clamped, exprScalar(intExpr, 2)),
+                        exprMin(intExpr, x, exprScalar(intExpr, 1)));
+    Matrix intResult = createMatrixFromExpr(intExpr, total);
+
+    // Then
+    int expected[6] = {-5, -4, -3, -1, 1, -1};
+    int intsRight = isValid(&intResult);
+    for (int k = 0; k < 6 && intsRight; k++) {
+        intsRight = getIntElement(&intResult, k / 3, k % 3) == expected[k];
+    }
+    mu_assert("TEST FAILED: INT expression values are wrong", intsRight);
 
     // Cleanup
-    freeMatrix(&mat1);
-    freeMatrix(&mat2);
+    freeMatrixExpr(expr);
+    freeMatrixExpr(intExpr);
+    freeMatrix(&a);
+    freeMatrix(&b);
+    freeMatrix(&c);
+    freeMatrix(&fused);
+    freeMatrix(&added);
+    freeMatrix(&chained);
+    freeMatrix(&wide);
+    freeMatrix(&ints);
+    freeMatrix(&intResult);
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
     return NULL;
 }
 
-// Neither
-static char * test_sameness_neither_matrix() {
+static char * test_matrix_expr_errors() {
     // Intro output
-    const char *functionName = "Sameness - Neither";
+    const char *functionName = "Expressions - Invalid Expressions";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 3x3 matrix filled with INTs
-    Matrix mat1 = createMatrix(3, 3, INT);
-    for (int r = 0; r < 3; r++) {
-        for (int c = 0; c < 3; c++) {
-            mat1.data[r][c].int_val = r * 3 + c;
+    Matrix square = createMatrix(4, 4, INT);
+    Matrix other = createMatrix(3, 4, INT);
+    Matrix letters = createMatrix(4, 4, CHAR);
+    MatrixView squareView = viewMatrix(&square);
+    MatrixView otherView = viewMatrix(&other);
+    MatrixView lettersView = viewMatrix(&letters);
+    MatrixView transposed = transposeMatrixView(&squareView);
+
+    // When
+    MatrixExpr *mismatched = createMatrixExpr();
+    int first = exprInput(mismatched, &squareView);
+    int second = exprInput(mismatched, &otherView);
+    MatrixExpr *dividing = createMatrixExpr();
+    int quotient = exprDivide(dividing, exprInput(dividing, &squareView), exprScalar(dividing, 2));
+    MatrixExpr *fractional = createMatrixExpr();
+    int scaled = exprMultiply(fractional, exprInput(fractional, &squareView), exprScalar(fractional, 0.5));
+    MatrixExpr *plain = createMatrixExpr();
+    int input = exprInput(plain, &squareView);
+
+    // Then
+    mu_assert("TEST FAILED: Matching input should be accepted", first == 0);
+    mu_assert("TEST FAILED: Input of another size should be refused", second == -1);
+    mu_assert("TEST FAILED: Size mismatch should be reported on evaluation",
+              evaluateMatrixExpr(mismatched, first, &squareView) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: INT division should be refused",
+              evaluateMatrixExpr(dividing, quotient, &squareView) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: Fractional INT scalar should be refused",
+              evaluateMatrixExpr(fractional, scaled, &squareView) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: Missing operand should be refused", exprAdd(plain, input, 7) == -1);
+    mu_assert("TEST FAILED: CHAR input should be refused", exprInput(plain, &lettersView) == -1);
+    MatrixExpr *chars = createMatrixExpr();
+    mu_assert("TEST FAILED: CHAR destination should be refused",
+              evaluateMatrixExpr(chars, exprScalar(chars, 1), &lettersView) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    MatrixExpr *aliased = createMatrixExpr();
+    int flipped = exprNegate(aliased, exprInput(aliased, &transposed));
+    mu_assert("TEST FAILED: Destination overlapping a differently viewed input should be refused",
+              evaluateMatrixExpr(aliased, flipped, &squareView) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: Null expression should be refused",
+              evaluateMatrixExpr(NULL, 0, &squareView) == MATRIX_ERROR_NULL_POINTER);
+    Matrix broken = createMatrixFromExpr(dividing, quotient);
+    mu_assert("TEST FAILED: Result of a broken expression should be invalid", !isValid(&broken));
+
+    // Scratch space that can't be allocated is reported before anything is written
+    Matrix sum = createPackedMatrix(4, 4, DOUBLE);
+    MatrixView sumView = viewMatrix(&sum);
+    setDoubleElement(&sum, 3, 3, -7.0);
+    MatrixExpr *adding = createMatrixExpr();
+    int added = exprAdd(adding, exprInput(adding, &sumView), exprScalar(adding, 1));
+    failingMallocSize = 1024;
+    MatrixStatus outOfMemory = evaluateMatrixExpr(adding, added, &sumView);
+    failingMallocSize = 0;
+    mu_assert("TEST FAILED: Failed scratch allocation should be reported", outOfMemory == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: Failed evaluation should leave the destination untouched",
+              getDoubleElement(&sum, 3, 3) == -7.0 && getDoubleElement(&sum, 0, 0) == 0.0);
+
+    // Cleanup
+    freeMatrixExpr(mismatched);
+    freeMatrixExpr(dividing);
+    freeMatrixExpr(fractional);
+    freeMatrixExpr(plain);
+    freeMatrixExpr(chars);
+    freeMatrixExpr(aliased);
+    freeMatrixExpr(adding);
+    freeMatrix(&square);
+    freeMatrix(&other);
+    freeMatrix(&letters);
+    freeMatrix(&broken);
+    freeMatrix(&sum);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_fixed_matrix() {
+    // Intro output
+    const char *functionName = "Fixed Size - Small Matrix Kernels";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A 3x3 with a known determinant, and 4x4 and 8x8 ones that are well away from singular
+    FixedMatrix3 a3 = {{{2, 0, 1}, {1, 3, 2}, {1, 1, 2}}};
+    FixedMatrix4 a4 = fixedIdentity4();
+    FixedMatrix8 a8 = fixedIdentity8();
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            a8.v[r][c] += ((r * 5 + c * 3) % 7) * 0.25;
+            if (r < 4 && c < 4) {
+                a4.v[r][c] += ((r * 3 + c) % 5) * 0.5;
+            }
         }
     }
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat1);
+    // When
+    FixedMatrix3 inverse3;
+    FixedMatrix4 inverse4;
+    FixedMatrix8 inverse8;
+    int inverted = fixedInverse3(&a3, &inverse3) && fixedInverse4(&a4, &inverse4) && fixedInverse8(&a8, &inverse8);
+    FixedMatrix3 identity3 = fixedMultiply3(&a3, &inverse3);
+    FixedMatrix4 identity4 = fixedMultiply4(&inverse4, &a4);
+    FixedMatrix8 identity8 = fixedMultiply8(&a8, &inverse8);
 
-    // Make another
-    // Create a 3x3 matrix filled with INTs
-    Matrix mat2 = createMatrix(3, 3, INT);
-    for (int r = 0; r < 3; r++) {
-        for (int c = 0; c < 3; c++) {
-            mat2.data[r][c].int_val = r * 3 + c + 1;
+    // Then
+    // The 3x3 determinant is 2 * (6 - 2) - 0 * (2 - 2) + 1 * (1 - 3) = 6
+    mu_assert("TEST FAILED: Matrices should be invertible", inverted);
+    mu_assert("TEST FAILED: 3x3 determinant is wrong", fixedDeterminant3(&a3) == 6.0);
+
+    double worst = 0.0;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            double expected = (r == c) ? 1.0 : 0.0;
+            double errors[3] = {(r < 3 && c < 3) ? identity3.v[r][c] - expected : 0.0,
+                                (r < 4 && c < 4) ? identity4.v[r][c] - expected : 0.0, identity8.v[r][c] - expected};
+            for (int k = 0; k < 3; k++) {
+                worst = (fabs(errors[k]) > worst) ? fabs(errors[k]) : worst;
+            }
         }
     }
+    mu_assert("TEST FAILED: A matrix times its inverse should be the identity", worst < 1e-12);
 
-    printf("Initial matrix 2:\n");
-    printMatrix(mat2);
+    // When
+    // An 8x8 determinant found by elimination should be the reciprocal of its inverse's, and a 4x4 closed form
+    // should match the same matrix inside an 8x8 with ones down the rest of the diagonal
+    FixedMatrix8 padded = fixedIdentity8();
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            padded.v[r][c] = a4.v[r][c];
+        }
+    }
+    double product = fixedDeterminant8(&a8) * fixedDeterminant8(&inverse8);
 
+    // Then
+    mu_assert("TEST FAILED: Determinants of a matrix and its inverse should multiply to 1", fabs(product - 1.0) < 1e-9);
+    mu_assert("TEST FAILED: Closed form and eliminated determinants should agree",
+              fabs(fixedDeterminant4(&a4) - fixedDeterminant8(&padded)) < 1e-9);
 
     // When
-    // Compare both matricies
-    Sameness checkSame = checkMatrixSameness(&mat1, &mat2);
+    // Rotate and transpose a 5x5 and compare with the library's own rotated copies
+    FixedMatrix5 a5;
+    Matrix mat5 = createPackedMatrix(5, 5, DOUBLE);
+    for (int r = 0; r < 5; r++) {
+        for (int c = 0; c < 5; c++) {
+            a5.v[r][c] = r * 5 + c;
+            setDoubleElement(&mat5, r, c, r * 5 + c);
+        }
+    }
+    int rotationsMatch = 1;
+    for (int turn = ROTATE_90; turn <= ROTATE_270; turn++) {
+        FixedMatrix5 rotated = fixedRotate5(&a5, (Rotation)turn);
+        Matrix expected = createRotatedMatrix(&mat5, (Rotation)turn);
+        for (int r = 0; r < 5; r++) {
+            for (int c = 0; c < 5; c++) {
+                rotationsMatch &= rotated.v[r][c] == getDoubleElement(&expected, r, c);
+            }
+        }
+        freeMatrix(&expected);
+    }
+    FixedMatrix5 transposed = fixedTranspose5(&a5);
+    FixedMatrix2 singular = {{{1, 2}, {2, 4}}};
+    FixedMatrix2 untouched = fixedIdentity2();
 
     // Then
-    // Should not be the same either way
-    mu_assert("TEST FAILED: Matricies should not be the same.", checkSame == NEITHER);
+    mu_assert("TEST FAILED: Fixed rotations should match rotated copies", rotationsMatch);
+    mu_assert("TEST FAILED: Transpose is wrong", transposed.v[1][3] == 16.0 && transposed.v[4][0] == 4.0);
+    mu_assert("TEST FAILED: Singular matrix should not be inverted",
+              fixedInverse2(&singular, &untouched) == 0 && untouched.v[0][0] == 1.0 && untouched.v[0][1] == 0.0);
+    FixedMatrix6 zero = {{{0}}};
+    FixedMatrix6 zeroInverse;
+    mu_assert("TEST FAILED: Singular 6x6 should not be inverted",
+              fixedInverse6(&zero, &zeroInverse) == 0 && fixedDeterminant6(&zero) == 0.0);
 
     // Cleanup
-    freeMatrix(&mat1);
-    freeMatrix(&mat2);
+    freeMatrix(&mat5);
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
     return NULL;
 }
 
-// Test Matrix Rotation
-// Non-Square
-static char * test_rotate_nonsquare_matrix() {
+// Batches
+static char * test_matrix_batch() {
     // Intro output
-    const char *functionName = "Rotation - Non-Square";
+    const char *functionName = "Batches - Add, Subtract and Multiply";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 3x4 matrix filled with INTs
-    Matrix mat = createMatrix(3, 4, INT);
-    for (int r = 0; r < 3; r++) {
-        for (int c = 0; c < 4; c++) {
-            mat.data[r][c].int_val = r * 4 + c;
+    // 11 matrices, which is one full group of lanes and a part filled one, with a column major operand
+    int count = 11;
+    MatrixBatch ints1 = createMatrixBatch(count, 3, 4, INT, ROW_MAJOR);
+    MatrixBatch ints2 = createMatrixBatch(count, 4, 5, INT, COLUMN_MAJOR);
+    MatrixBatch intProducts = createMatrixBatch(count, 3, 5, INT, ROW_MAJOR);
+    MatrixBatch doubles1 = createMatrixBatch(count, 3, 3, DOUBLE, COLUMN_MAJOR);
+    MatrixBatch doubles2 = createMatrixBatch(count, 3, 3, DOUBLE, ROW_MAJOR);
+    MatrixBatch doubleProducts = createMatrixBatch(count, 3, 3, DOUBLE, ROW_MAJOR);
+    MatrixBatch sums = createMatrixBatch(count, 3, 3, DOUBLE, ROW_MAJOR);
+    MatrixBatch differences = createMatrixBatch(count, 3, 3, DOUBLE, COLUMN_MAJOR);
+    for (int t = 0; t < count; t++) {
+        for (int r = 0; r < 4; r++) {
+            for (int c = 0; c < 5; c++) {
+                int *values1 = (int *)ints1.values + t * ints1.stride;
+                int *values2 = (int *)ints2.values + t * ints2.stride;
+                if (r < 3 && c < 4) {
+                    values1[r * 4 + c] = (t * 7 + r * 3 + c) % 11 - 5;
+                }
+                values2[c * 4 + r] = (t * 5 + r + c * 2) % 9 - 4;
+                if (r < 3 && c < 3) {
+                    ((double *)doubles1.values)[t * doubles1.stride + c * 3 + r] = (t + r * 2 + c) % 5 - 2.0;
+                    ((double *)doubles2.values)[t * doubles2.stride + r * 3 + c] = (t * 3 + r + c) % 7 * 0.5;
+                }
+            }
         }
     }
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat);
+    // When
+    MatrixStatus statuses[4] = {multiplyMatrixBatches(&intProducts, &ints1, &ints2),
+                                multiplyMatrixBatches(&doubleProducts, &doubles1, &doubles2),
+                                addMatrixBatches(&sums, &doubles1, &doubles2),
+                                subtractMatrixBatches(&differences, &doubles1, &doubles2)};
+
+    // Then
+    // Every matrix should match the library working on it alone
+    mu_assert("TEST FAILED: Batch operations should succeed",
+              statuses[0] == MATRIX_SUCCESS && statuses[1] == MATRIX_SUCCESS && statuses[2] == MATRIX_SUCCESS &&
+                  statuses[3] == MATRIX_SUCCESS);
+    int allMatch = 1;
+    for (int t = 0; t < count; t++) {
+        MatrixView views[8] = {batchMatrixView(&ints1, t),     batchMatrixView(&ints2, t),
+                               batchMatrixView(&intProducts, t), batchMatrixView(&doubles1, t),
+                               batchMatrixView(&doubles2, t),  batchMatrixView(&doubleProducts, t),
+                               batchMatrixView(&sums, t),      batchMatrixView(&differences, t)};
+        Matrix expected[4] = {multiplyMatrixViews(&views[0], &views[1]), multiplyMatrixViews(&views[3], &views[4]),
+                              addMatrixViews(&views[3], &views[4]), subtractMatrixViews(&views[3], &views[4])};
+        for (int k = 0; k < 4; k++) {
+            MatrixView result = viewMatrix(&expected[k]);
+            allMatch &= checkViewSameness(&result, &views[(k == 0) ? 2 : k + 4]) == ELEMENT;
+            freeMatrix(&expected[k]);
+        }
+    }
+    mu_assert("TEST FAILED: Batch results should match one matrix at a time", allMatch);
 
     // When
-    // Rotate it 90*
-    RotationStatus status = rotateMatrix(&mat);
+    // Add in place, with the destination being the first operand
+    double before = ((double *)sums.values)[4 * sums.stride + 5];
+    MatrixStatus inPlace = addMatrixBatches(&sums, &sums, &doubles2);
 
     // Then
-    // Should error not square
-    mu_assert("TEST FAILED: Should return not square error.", status == ERROR_NOT_SQUARE);
+    mu_assert("TEST FAILED: In place addition should succeed", inPlace == MATRIX_SUCCESS);
+    mu_assert("TEST FAILED: In place addition is wrong",
+              ((double *)sums.values)[4 * sums.stride + 5] ==
+                  before + ((double *)doubles2.values)[4 * doubles2.stride + 5]);
+
+    // Cleanup
+    freeMatrixBatch(&ints1);
+    freeMatrixBatch(&ints2);
+    freeMatrixBatch(&intProducts);
+    freeMatrixBatch(&doubles1);
+    freeMatrixBatch(&doubles2);
+    freeMatrixBatch(&doubleProducts);
+    freeMatrixBatch(&sums);
+    freeMatrixBatch(&differences);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_batch_errors() {
+    // Intro output
+    const char *functionName = "Batches - Invalid Batches";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    MatrixBatch a = createMatrixBatch(4, 2, 2, DOUBLE, ROW_MAJOR);
+    MatrixBatch b = createMatrixBatch(4, 2, 2, DOUBLE, ROW_MAJOR);
+    MatrixBatch fewer = createMatrixBatch(3, 2, 2, DOUBLE, ROW_MAJOR);
+    MatrixBatch ints = createMatrixBatch(4, 2, 2, INT, ROW_MAJOR);
+    MatrixBatch columns = createMatrixBatch(4, 2, 2, DOUBLE, COLUMN_MAJOR);
+    MatrixBatch reread = columns;
+    reread.order = ROW_MAJOR;
+
+    // When
+    MatrixBatch chars = createMatrixBatch(4, 2, 2, CHAR, ROW_MAJOR);
+    MatrixBatch empty = createMatrixBatch(0, 2, 2, DOUBLE, ROW_MAJOR);
+    MatrixView outside = batchMatrixView(&a, 4);
+
+    // Then
+    mu_assert("TEST FAILED: CHAR and empty batches should be invalid", !isValidBatch(&chars) && !isValidBatch(&empty));
+    mu_assert("TEST FAILED: View past the end should be empty", outside.rows == 0 && outside.block == NULL);
+    mu_assert("TEST FAILED: Null batch should be refused",
+              addMatrixBatches(&a, NULL, &b) == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: Different counts should be refused",
+              addMatrixBatches(&a, &fewer, &b) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: Different types should be refused",
+              subtractMatrixBatches(&a, &ints, &b) == MATRIX_ERROR_TYPE_MISMATCH);
+    mu_assert("TEST FAILED: Multiplying into an operand should be refused",
+              multiplyMatrixBatches(&a, &a, &b) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: Adding into an operand stored differently should be refused",
+              addMatrixBatches(&reread, &columns, &b) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: Mixed orders should still be added",
+              addMatrixBatches(&columns, &a, &b) == MATRIX_SUCCESS && addMatrixBatches(&a, &columns, &b) == MATRIX_SUCCESS);
+
+    // Scratch space that can't be allocated is reported before anything is written
+    MatrixBatch identities = createMatrixBatch(8, 4, 4, DOUBLE, ROW_MAJOR);
+    MatrixBatch products = createMatrixBatch(8, 4, 4, DOUBLE, ROW_MAJOR);
+    for (int t = 0; t < 8; t++) {
+        for (int i = 0; i < 4; i++) {
+            ((double *)identities.values)[(size_t)t * identities.stride + (size_t)i * identities.ld + i] = 1.0;
+        }
+        ((double *)products.values)[(size_t)t * products.stride] = -7.0;
+    }
+    failingMallocSize = 1024;
+    MatrixStatus outOfMemory = multiplyMatrixBatches(&products, &identities, &identities);
+    failingMallocSize = 0;
+    mu_assert("TEST FAILED: Failed scratch allocation should be reported", outOfMemory == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: Failed multiplication should leave the destination untouched",
+              ((double *)products.values)[0] == -7.0 && ((double *)products.values)[7 * products.stride] == -7.0);
+    mu_assert("TEST FAILED: Multiplication should work once memory is back",
+              multiplyMatrixBatches(&products, &identities, &identities) == MATRIX_SUCCESS &&
+              ((double *)products.values)[7 * products.stride] == 1.0);
+
+    // Cleanup
+    freeMatrixBatch(&a);
+    freeMatrixBatch(&b);
+    freeMatrixBatch(&fewer);
+    freeMatrixBatch(&ints);
+    freeMatrixBatch(&columns);
+    freeMatrixBatch(&identities);
+    freeMatrixBatch(&products);
+    mu_assert("TEST FAILED: Freed batch should be invalid", !isValidBatch(&a));
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Vectors
+static char * test_matrix_vector() {
+    // Intro output
+    const char *functionName = "Vectors - Matrix-Vector Products";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // 7 x 13 matrices in every layout, which leaves a part filled group of rows and of partial sums
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    Matrix doubles[2];
+    Matrix ints[3];
+    for (int k = 0; k < 3; k++) {
+        ints[k] = createMatrixWithLayout(7, 13, INT, orders[k % 2], (k < 2) ? PACKED_STORAGE : ELEMENT_STORAGE);
+        if (k < 2) {
+            doubles[k] = createMatrixWithLayout(7, 13, DOUBLE, orders[k], PACKED_STORAGE);
+        }
+        for (int r = 0; r < 7; r++) {
+            for (int c = 0; c < 13; c++) {
+                setIntElement(&ints[k], r, c, (r * 13 + c * 5) % 11 - 5);
+                if (k < 2) {
+                    setDoubleElement(&doubles[k], r, c, ((r * 3 + c * 7) % 9 - 4) * 0.5);
+                }
+            }
+        }
+    }
+    MatrixVector x = createVector(13, DOUBLE);
+    MatrixVector xInts = createVector(13, INT);
+    MatrixVector y = createVector(7, DOUBLE);
+    MatrixVector yInts = createVector(7, INT);
+    MatrixVector z = createVector(13, DOUBLE);
+    for (int k = 0; k < 13; k++) {
+        ((double *)x.values)[k] = k % 4 - 1.5;
+        ((int *)xInts.values)[k] = k % 5 - 2;
+    }
+    MatrixView xView = vectorMatrixView(&x);
+    MatrixView xIntsView = vectorMatrixView(&xInts);
+
+    // When
+    // y = 2 * A * x + 3 * y starting from y = 1, which should be 2 * (A * x) + 3 for every layout
+    int allMatch = 1;
+    for (int k = 0; k < 2; k++) {
+        MatrixView view = viewMatrix(&doubles[k]);
+        Matrix expected = multiplyMatrixViews(&view, &xView);
+        for (int i = 0; i < 7; i++) {
+            ((double *)y.values)[i] = 1.0;
+        }
+        allMatch &= gemvMatrices(NO_TRANSPOSE, 2.0, &doubles[k], &x, 3.0, &y) == MATRIX_SUCCESS;
+        for (int i = 0; i < 7; i++) {
+            allMatch &= ((double *)y.values)[i] == 2.0 * getDoubleElement(&expected, i, 0) + 3.0;
+        }
+        freeMatrix(&expected);
+    }
+    for (int k = 0; k < 3; k++) {
+        MatrixView view = viewMatrix(&ints[k]);
+        Matrix expected = multiplyMatrixViews(&view, &xIntsView);
+        for (int i = 0; i < 7; i++) {
+            ((int *)yInts.values)[i] = 100;
+        }
+        allMatch &= gemvMatrices(NO_TRANSPOSE, -1.0, &ints[k], &xInts, 0.0, &yInts) == MATRIX_SUCCESS;
+        for (int i = 0; i < 7; i++) {
+            allMatch &= ((int *)yInts.values)[i] == -getIntElement(&expected, i, 0);
+        }
+        freeMatrix(&expected);
+    }
+
+    // Then
+    mu_assert("TEST FAILED: Matrix-vector products should match multiplying by a one column matrix", allMatch);
+
+    // When
+    // A transposed product of a row major matrix runs along its columns, and should match a vector-matrix product
+    MatrixView rows = viewMatrix(&doubles[0]);
+    MatrixView columns = viewMatrix(&doubles[1]);
+    MatrixVector w = createVector(7, DOUBLE);
+    for (int i = 0; i < 7; i++) {
+        ((double *)w.values)[i] = i - 3.0;
+    }
+    MatrixStatus transposed = gemvMatrixViews(TRANSPOSE, 1.0, &rows, &w, 0.0, &z);
+    MatrixView wView = vectorMatrixView(&w);
+    MatrixView wRow = transposeMatrixView(&wView);
+    Matrix expected = multiplyMatrixViews(&wRow, &columns);
+    int transposedMatch = transposed == MATRIX_SUCCESS;
+    for (int k = 0; k < 13; k++) {
+        transposedMatch &= ((double *)z.values)[k] == getDoubleElement(&expected, 0, k);
+    }
+    MatrixStatus leftSide = gevmMatrixViews(1.0, &w, &columns, 1.0, &z);
+    for (int k = 0; k < 13; k++) {
+        transposedMatch &= ((double *)z.values)[k] == 2.0 * getDoubleElement(&expected, 0, k);
+    }
+
+    // Then
+    mu_assert("TEST FAILED: Transposed and vector-matrix products are wrong", leftSide == MATRIX_SUCCESS && transposedMatch);
+
+    // Cleanup
+    freeMatrix(&expected);
+    for (int k = 0; k < 3; k++) {
+        freeMatrix(&ints[k]);
+        if (k < 2) {
+            freeMatrix(&doubles[k]);
+        }
+    }
+    freeVector(&x);
+    freeVector(&xInts);
+    freeVector(&y);
+    freeVector(&yInts);
+    freeVector(&z);
+    freeVector(&w);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_vector_errors() {
+    // Intro output
+    const char *functionName = "Vectors - Invalid Products";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    Matrix mat = createPackedMatrix(3, 4, DOUBLE);
+    MatrixVector x = createVector(4, DOUBLE);
+    MatrixVector y = createVector(3, DOUBLE);
+    MatrixVector ints = createVector(3, INT);
+    MatrixVector inMatrix = {3, DOUBLE, mat.block};
+    Matrix intMat = createPackedMatrix(3, 4, INT);
+    MatrixVector intX = createVector(4, INT);
+
+    // When
+    MatrixVector chars = createVector(3, CHAR);
+    MatrixVector empty = createVector(0, DOUBLE);
+    MatrixView view = viewMatrix(&mat);
+
+    // Then
+    mu_assert("TEST FAILED: CHAR and empty vectors should be invalid", !isValidVector(&chars) && !isValidVector(&empty));
+    mu_assert("TEST FAILED: Null vector should be refused",
+              gemvMatrices(NO_TRANSPOSE, 1.0, &mat, NULL, 0.0, &y) == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: Wrong length of x should be refused",
+              gemvMatrices(TRANSPOSE, 1.0, &mat, &x, 0.0, &y) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: Wrong length of y should be refused",
+              gevmMatrixViews(1.0, &y, &view, 0.0, &y) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: Different types should be refused",
+              gemvMatrices(NO_TRANSPOSE, 1.0, &mat, &x, 0.0, &ints) == MATRIX_ERROR_TYPE_MISMATCH);
+    mu_assert("TEST FAILED: Writing over the matrix should be refused",
+              gemvMatrices(NO_TRANSPOSE, 1.0, &mat, &x, 0.0, &inMatrix) == MATRIX_ERROR_ALIASING);
+    mu_assert("TEST FAILED: Fractional INT scale should be refused",
+              gemvMatrices(NO_TRANSPOSE, 0.5, &intMat, &intX, 0.0, &ints) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: NaN INT scale should be refused",
+              gemvMatrices(NO_TRANSPOSE, NAN, &intMat, &intX, 0.0, &ints) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: Infinite INT scale should be refused",
+              gemvMatrices(NO_TRANSPOSE, 1.0, &intMat, &intX, -INFINITY, &ints) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: INT scale out of int range should be refused",
+              gemvMatrices(NO_TRANSPOSE, 1e12, &intMat, &intX, 0.0, &ints) == MATRIX_ERROR_UNSUPPORTED_TYPE);
 
     // Cleanup
     freeMatrix(&mat);
+    freeMatrix(&intMat);
+    freeVector(&intX);
+    freeVector(&x);
+    freeVector(&y);
+    freeVector(&ints);
+    mu_assert("TEST FAILED: Freed vector should be invalid", !isValidVector(&x));
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
     return NULL;
 }
 
-// Invalid Data
-static char * test_rotate_invalid_matrix() {
+// Reductions
+static char * test_matrix_reduce() {
     // Intro output
-    const char *functionName = "Rotation - Invalid Data";
+    const char *functionName = "Reductions - Sums, Extremes, Norms and Trace";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create an invalid matrix
-    Matrix mat = invalidMatrix();
+    // 37 x 23 matrices in every layout, which leaves part filled lanes, with repeated values for ARGMIN and ARGMAX
+    // to break ties on. Halves add up exactly in any order, so every layout should give exactly the same answers.
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    Matrix mats[5];
+    for (int k = 0; k < 5; k++) {
+        mats[k] = createMatrixWithLayout(37, 23, (k < 3) ? INT : DOUBLE, orders[k % 2],
+                                         (k == 2) ? ELEMENT_STORAGE : PACKED_STORAGE);
+        for (int r = 0; r < 37; r++) {
+            for (int c = 0; c < 23; c++) {
+                int value = (r * 7 + c * 3) % 19 - 9;
+                if (k < 3) {
+                    setIntElement(&mats[k], r, c, value);
+                } else {
+                    setDoubleElement(&mats[k], r, c, value * 0.5);
+                }
+            }
+        }
+    }
+    Reduction reductions[9] = {REDUCE_SUM, REDUCE_MEAN, REDUCE_MIN, REDUCE_MAX, REDUCE_ARGMIN, REDUCE_ARGMAX,
+                               REDUCE_NORM_L1, REDUCE_NORM_L2, REDUCE_NORM_INF};
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat);
+    // When
+    // Every reduction of the whole matrix, and of every row and column, checked against a loop over the elements
+    int allMatch = 1;
+    for (int k = 0; k < 5; k++) {
+        MatrixView view = viewMatrix(&mats[k]);
+        double scale = (k < 3) ? 1.0 : 0.5;
+        for (int n = 0; n < 9; n++) {
+            Reduction reduction = reductions[n];
+            int arg = reduction == REDUCE_ARGMIN || reduction == REDUCE_ARGMAX;
+            MatrixVector rowResults = createVector(37, arg ? INT : DOUBLE);
+            MatrixVector colResults = createVector(23, arg ? INT : DOUBLE);
+            double result = -1.0;
+            allMatch &= reduceMatrixView(&view, reduction, n % 2 ? SUMMATION_COMPENSATED : SUMMATION_FAST,
+                                         &result) == MATRIX_SUCCESS;
+            allMatch &= reduceMatrixViewLines(&view, ROW, reduction, SUMMATION_FAST, &rowResults) == MATRIX_SUCCESS;
+            allMatch &= reduceMatrixViewLines(&view, COL, reduction, SUMMATION_COMPENSATED, &colResults) ==
+                        MATRIX_SUCCESS;
+            for (int line = -1; line < 37 + 23; line++) {
+                // Line -1 is the whole matrix, then every row, then every column
+                int first = (line < 0) ? 0 : (line < 37) ? line * 23 : line - 37;
+                int count = (line < 0) ? 37 * 23 : (line < 37) ? 23 : 37;
+                int gap = (line < 0 || line < 37) ? 1 : 23;
+                double total = 0.0, best = 0.0;
+                int bestAt = 0;
+                for (int i = 0; i < count; i++) {
+                    int at = first + i * gap;
+                    double value = (double)((at / 23 * 7 + at % 23 * 3) % 19 - 9) * scale;
+                    double term = (reduction == REDUCE_NORM_L2) ? value * value
+                                : (reduction == REDUCE_NORM_L1 || reduction == REDUCE_NORM_INF) ? fabs(value) : value;
+                    int largest = reduction == REDUCE_MAX || reduction == REDUCE_ARGMAX || reduction == REDUCE_NORM_INF;
+                    if (i == 0 || (largest ? term > best : term < best)) {
+                        best = term;
+                        bestAt = i;
+                    }
+                    total += term;
+                }
+                double expected = (reduction == REDUCE_MEAN) ? total / count
+                                : (reduction == REDUCE_NORM_L2) ? sqrt(total)
+                                : (reduction == REDUCE_SUM || reduction == REDUCE_NORM_L1) ? total
+                                : arg ? (double)bestAt : best;
+                double actual = (line < 0) ? result
+                              : arg ? (double)((line < 37) ? ((int *)rowResults.values)[line]
+                                                           : ((int *)colResults.values)[line - 37])
+                              : (line < 37) ? ((double *)rowResults.values)[line]
+                                            : ((double *)colResults.values)[line - 37];
+                allMatch &= actual == expected;
+            }
+            freeVector(&rowResults);
+            freeVector(&colResults);
+        }
+    }
+
+    // Then
+    mu_assert("TEST FAILED: Reductions should match a loop over the elements in every layout", allMatch);
 
     // When
-    // Rotate it 90*
-    RotationStatus status = rotateMatrix(&mat);
+    // Norms and trace of the column major DOUBLE matrix, and of its transpose
+    MatrixView doublesView = viewMatrix(&mats[4]);
+    MatrixView transposed = transposeMatrixView(&doublesView);
+    double one = 0.0, inf = 0.0, frobenius = 0.0, oneOfTranspose = 0.0, trace = 0.0, traceOfTranspose = 0.0;
+    double frobeniusCheck = 0.0;
+    int normsOk = matrixViewNorm(&doublesView, MATRIX_NORM_ONE, SUMMATION_FAST, &one) == MATRIX_SUCCESS;
+    normsOk &= matrixViewNorm(&doublesView, MATRIX_NORM_INF, SUMMATION_FAST, &inf) == MATRIX_SUCCESS;
+    normsOk &= matrixViewNorm(&doublesView, MATRIX_NORM_FROBENIUS, SUMMATION_FAST, &frobenius) == MATRIX_SUCCESS;
+    normsOk &= matrixViewNorm(&transposed, MATRIX_NORM_ONE, SUMMATION_FAST, &oneOfTranspose) == MATRIX_SUCCESS;
+    normsOk &= matrixViewTrace(&doublesView, SUMMATION_FAST, &trace) == MATRIX_SUCCESS;
+    normsOk &= matrixViewTrace(&transposed, SUMMATION_COMPENSATED, &traceOfTranspose) == MATRIX_SUCCESS;
+    normsOk &= reduceMatrixView(&doublesView, REDUCE_NORM_L2, SUMMATION_FAST, &frobeniusCheck) == MATRIX_SUCCESS;
+    double oneCheck = 0.0, infCheck = 0.0, traceCheck = 0.0;
+    for (int c = 0; c < 23; c++) {
+        double sum = 0.0;
+        for (int r = 0; r < 37; r++) {
+            sum += fabs(getDoubleElement(&mats[4], r, c));
+        }
+        oneCheck = (sum > oneCheck) ? sum : oneCheck;
+        traceCheck += getDoubleElement(&mats[4], c, c);
+    }
+    for (int r = 0; r < 37; r++) {
+        double sum = 0.0;
+        for (int c = 0; c < 23; c++) {
+            sum += fabs(getDoubleElement(&mats[4], r, c));
+        }
+        infCheck = (sum > infCheck) ? sum : infCheck;
+    }
 
     // Then
-    // Should error null pointer
-    mu_assert("TEST FAILED: Should return invalid data error.", status == ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: Norms and trace should match loops over the elements",
+              normsOk && one == oneCheck && inf == infCheck && frobenius == frobeniusCheck &&
+              oneOfTranspose == infCheck && trace == traceCheck && traceOfTranspose == traceCheck);
+
+    // When
+    // A big row vector is split between threads. 1e16 swallows every 1 that is added straight to it, but a
+    // compensated sum keeps them.
+    MatrixVector big = createVector(1 << 18, DOUBLE);
+    for (int i = 0; i < (1 << 18); i++) {
+        ((double *)big.values)[i] = (i == 0) ? 1e16 : (i == (1 << 18) - 1) ? -1e16 : 1.0;
+    }
+    ((double *)big.values)[1000] = 5.0;
+    ((double *)big.values)[200000] = 5.0;
+    MatrixView bigView = vectorMatrixView(&big);
+    MatrixView bigRow = transposeMatrixView(&bigView);
+    double compensated = 0.0, argmin = 0.0, argminRow = 0.0;
+    int bigOk = reduceMatrixView(&bigRow, REDUCE_SUM, SUMMATION_COMPENSATED, &compensated) == MATRIX_SUCCESS;
+    bigOk &= reduceMatrixView(&bigView, REDUCE_ARGMIN, SUMMATION_FAST, &argmin) == MATRIX_SUCCESS;
+    bigOk &= reduceMatrixView(&bigRow, REDUCE_ARGMIN, SUMMATION_FAST, &argminRow) == MATRIX_SUCCESS;
+
+    // Then
+    mu_assert("TEST FAILED: Compensated sums should keep every small value",
+              bigOk && compensated == (1 << 18) - 2 + 8.0);
+    mu_assert("TEST FAILED: ARGMIN should find the same position from every thread count",
+              argmin == (1 << 18) - 1 && argminRow == (1 << 18) - 1);
+
+    // Cleanup
+    for (int k = 0; k < 5; k++) {
+        freeMatrix(&mats[k]);
+    }
+    freeVector(&big);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_reduce_errors() {
+    // Intro output
+    const char *functionName = "Reductions - Invalid Reductions";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    Matrix mat = createPackedMatrix(3, 4, DOUBLE);
+    Matrix chars = createPackedMatrix(3, 4, CHAR);
+    MatrixVector rows = createVector(3, DOUBLE);
+    MatrixVector cols = createVector(4, DOUBLE);
+    MatrixVector inMatrix = {3, DOUBLE, mat.block};
+    MatrixView view = viewMatrix(&mat);
+    MatrixView charsView = viewMatrix(&chars);
+    double result = 0.0;
+
+    // Then
+    mu_assert("TEST FAILED: Null result should be refused",
+              reduceMatrixView(&view, REDUCE_SUM, SUMMATION_FAST, NULL) == MATRIX_ERROR_NULL_POINTER);
+    mu_assert("TEST FAILED: CHAR matrices should be refused",
+              matrixViewTrace(&charsView, SUMMATION_FAST, &result) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: Wrong result length should be refused",
+              reduceMatrixViewLines(&view, COL, REDUCE_MAX, SUMMATION_FAST, &rows) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: ARGMAX into DOUBLE results should be refused",
+              reduceMatrixViewLines(&view, COL, REDUCE_ARGMAX, SUMMATION_FAST, &cols) == MATRIX_ERROR_TYPE_MISMATCH);
+    mu_assert("TEST FAILED: Results over the matrix should be refused",
+              reduceMatrixViewLines(&view, ROW, REDUCE_SUM, SUMMATION_FAST, &inMatrix) == MATRIX_ERROR_ALIASING);
 
     // Cleanup
     freeMatrix(&mat);
+    freeMatrix(&chars);
+    freeVector(&rows);
+    freeVector(&cols);
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
     return NULL;
 }
 
-// Valid INT Data
-static char * test_rotate_valid_int_matrix() {
+// Linear systems
+static char * test_matrix_lu() {
     // Intro output
-    const char *functionName = "Rotation - Valid INT";
+    const char *functionName = "Linear Systems - LU Solve, Determinant and Inverse";
     printf("*** TEST START: %s ***\n", functionName);
 
     // Given
-    // Create a 3x3 matrix filled with INTs
-    Matrix mat = createMatrix(3, 3, INT);
+    // A 150 x 150 matrix with a heavy diagonal, in both orders, which is more than one block of the factorization,
+    // and a 3 x 3 matrix that needs its rows swapped, with a determinant of 27
+    StorageOrder orders[2] = {ROW_MAJOR, COLUMN_MAJOR};
+    Matrix mats[2], rhs[2];
+    for (int k = 0; k < 2; k++) {
+        mats[k] = createMatrixWithLayout(150, 150, DOUBLE, orders[k], PACKED_STORAGE);
+        rhs[k] = createMatrixWithLayout(150, 5, DOUBLE, orders[1 - k], PACKED_STORAGE);
+        for (int r = 0; r < 150; r++) {
+            for (int c = 0; c < 150; c++) {
+                setDoubleElement(&mats[k], r, c, ((r * 7 + c * 3) % 19 - 9) * 0.1 + ((r == c) ? 20.0 : 0.0));
+            }
+            for (int c = 0; c < 5; c++) {
+                setDoubleElement(&rhs[k], r, c, (r * (c + 1)) % 11 - 5.0);
+            }
+        }
+    }
+    Matrix small = createMatrix(3, 3, DOUBLE);
+    double smallValues[3][3] = {{0.0, 2.0, 1.0}, {3.0, 1.0, 2.0}, {1.0, 4.0, -2.0}};
     for (int r = 0; r < 3; r++) {
         for (int c = 0; c < 3; c++) {
-            mat.data[r][c].int_val = r * 3 + c;
+            setDoubleElement(&small, r, c, smallValues[r][c]);
         }
     }
 
-    printf("Initial matrix 1:\n");
-    printMatrix(mat);
-
     // When
-    // Rotate it 90*
-    RotationStatus status = rotateMatrix(&mat);
+    // Each matrix is factorized once and solved with several right hand sides, both into a new matrix and in place,
+    // and the residual A * X - B is checked along with the inverse times A
+    int allMatch = 1;
+    for (int k = 0; k < 2; k++) {
+        MatrixView view = viewMatrix(&mats[k]);
+        MatrixView bView = viewMatrix(&rhs[k]);
+        Matrix x = createMatrix(150, 5, DOUBLE);
+        Matrix inPlace = deepCopyMatrix(&rhs[k]);
+        MatrixView xView = viewMatrix(&x);
+        MatrixView inPlaceView = viewMatrix(&inPlace);
+        MatrixLU lu;
+        allMatch &= factorizeLU(&view, &lu) == MATRIX_SUCCESS && isValidLU(&lu) && !lu.singular;
+        allMatch &= solveLU(&lu, &bView, &xView) == MATRIX_SUCCESS;
+        allMatch &= solveLU(&lu, &inPlaceView, &inPlaceView) == MATRIX_SUCCESS;
+        for (int r = 0; r < 150; r++) {
+            for (int c = 0; c < 5; c++) {
+                double sum = 0.0;
+                for (int i = 0; i < 150; i++) {
+                    sum += getDoubleElement(&mats[k], r, i) * getDoubleElement(&x, i, c);
+                }
+                allMatch &= fabs(sum - getDoubleElement(&rhs[k], r, c)) < 1e-9;
+                allMatch &= getDoubleElement(&inPlace, r, c) == getDoubleElement(&x, r, c);
+            }
+        }
+        Matrix inverse = inverseMatrix(&mats[k]);
+        allMatch &= isValid(&inverse) && inverse.order == orders[k];
+        for (int r = 0; r < 150 && allMatch; r++) {
+            for (int c = 0; c < 150; c++) {
+                double sum = 0.0;
+                for (int i = 0; i < 150; i++) {
+                    sum += getDoubleElement(&inverse, r, i) * getDoubleElement(&mats[k], i, c);
+                }
+                allMatch &= fabs(sum - ((r == c) ? 1.0 : 0.0)) < 1e-12;
+            }
+        }
+        freeLU(&lu);
+        freeMatrix(&x);
+        freeMatrix(&inPlace);
+        freeMatrix(&inverse);
+    }
+    MatrixView smallView = viewMatrix(&small);
+    MatrixView smallTransposed = transposeMatrixView(&smallView);
+    double determinant = 0.0, transposedDeterminant = 0.0;
+    allMatch &= determinantMatrixView(&smallView, &determinant) == MATRIX_SUCCESS;
+    allMatch &= determinantMatrixView(&smallTransposed, &transposedDeterminant) == MATRIX_SUCCESS;
 
     // Then
-    printf("Post Rotation:\n");
-    printMatrix(mat);
+    mu_assert("TEST FAILED: LU solves or inverses do not match", allMatch);
+    mu_assert("TEST FAILED: Determinant does not match", fabs(determinant - 27.0) < 1e-12);
+    mu_assert("TEST FAILED: Determinant of the transpose does not match", fabs(transposedDeterminant - 27.0) < 1e-12);
 
-    // Should succeed
-    mu_assert("TEST FAILED: Should return invalid data error.", status == SUCCESS);
+    // Cleanup
+    for (int k = 0; k < 2; k++) {
+        freeMatrix(&mats[k]);
+        freeMatrix(&rhs[k]);
+    }
+    freeMatrix(&small);
 
-    // Check a few random cells
-    mu_assert("TEST FAILED: Cell 0,0 should have value 6", mat.data[0][0].int_val == 6);
-    mu_assert("TEST FAILED: Cell 1,1 should have value 4", mat.data[1][1].int_val == 4); // This element doesn't move
-    mu_assert("TEST FAILED: Cell 0,2 should have value 0", mat.data[0][2].int_val == 0);
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+static char * test_matrix_lu_errors() {
+    // Intro output
+    const char *functionName = "Linear Systems - Invalid and Singular Systems";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    // A singular matrix, its second row being twice its first
+    Matrix singular = createMatrix(3, 3, DOUBLE);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            setDoubleElement(&singular, r, c, (r == 2) ? c * c + 1.0 : (r + 1.0) * (c + 1.0));
+        }
+    }
+    Matrix wide = createMatrix(3, 4, DOUBLE);
+    Matrix ints = createMatrix(3, 3, INT);
+    Matrix b = createMatrix(3, 2, DOUBLE);
+    Matrix tall = createMatrix(4, 2, DOUBLE);
+    MatrixView singularView = viewMatrix(&singular);
+    MatrixView wideView = viewMatrix(&wide);
+    MatrixView intsView = viewMatrix(&ints);
+    MatrixView bView = viewMatrix(&b);
+    MatrixView tallView = viewMatrix(&tall);
+    MatrixLU lu;
+    double determinant = -1.0;
+
+    // When
+    MatrixStatus factorStatus = factorizeLU(&singularView, &lu);
+    MatrixStatus solveStatus = solveLU(&lu, &bView, &bView);
+    Matrix inverse = inverseMatrix(&singular);
+
+    // Then
+    mu_assert("TEST FAILED: Singular matrices should still factorize", factorStatus == MATRIX_SUCCESS && lu.singular);
+    mu_assert("TEST FAILED: Singular systems should be refused", solveStatus == MATRIX_ERROR_SINGULAR);
+    mu_assert("TEST FAILED: Singular determinant should be 0", determinantLU(&lu) == 0.0);
+    mu_assert("TEST FAILED: Singular inverse should be invalid", !isValid(&inverse));
+    mu_assert("TEST FAILED: Wrong right hand side rows should be refused",
+              solveLU(&lu, &tallView, &tallView) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: Non square matrices should be refused",
+              determinantMatrixView(&wideView, &determinant) == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: INT matrices should be refused",
+              solveMatrixViews(&intsView, &bView, &bView) == MATRIX_ERROR_UNSUPPORTED_TYPE);
+    mu_assert("TEST FAILED: Null result should be refused",
+              determinantMatrixView(&singularView, NULL) == MATRIX_ERROR_NULL_POINTER);
 
     // Cleanup
-    freeMatrix(&mat);
+    freeLU(&lu);
+    mu_assert("TEST FAILED: Freed factorization should be invalid", !isValidLU(&lu));
+    freeMatrix(&singular);
+    freeMatrix(&wide);
+    freeMatrix(&ints);
+    freeMatrix(&b);
+    freeMatrix(&tall);
 
     // Success output
     printf("*** TEST PASSED: %s ***\n\n", functionName);
@@ -1501,6 +4620,11 @@ static char * all_tests() {
     mu_run_test(test_create_double_matrix);
     mu_run_test(test_create_int_matrix);
     mu_run_test(test_create_char_matrix);
+    mu_run_test(test_create_matrix_contiguous);
+    mu_run_test(test_create_packed_matrix);
+    mu_run_test(test_typed_accessors_packed_matrix);
+    mu_run_test(test_inline_accessors_matrix);
+    mu_run_test(test_convert_matrix_order);
     
     // Multiple Operations
     mu_run_test(test_matrix_operations);
@@ -1508,15 +4632,22 @@ static char * all_tests() {
     // Setting full rows and columns
     mu_run_test(test_set_row);
     mu_run_test(test_set_column);
+    mu_run_test(test_row_and_column_values);
     
     // Subset creations
     mu_run_test(test_create_matrix_subset_complete);
     mu_run_test(test_create_matrix_subset_single_element);
+
+    // Views
+    mu_run_test(test_create_matrix_view);
+    mu_run_test(test_adding_and_multiplying_matrix_views);
+    mu_run_test(test_sameness_matrix_views);
     
     // Resizing
     mu_run_test(test_resize_matrix_increase);
     mu_run_test(test_resize_matrix_decrease);
     mu_run_test(test_resize_matrix_to_zero);
+    mu_run_test(test_resize_matrix_contiguous);
 
     // Subset setting
     mu_run_test(test_set_matrix_subset);
@@ -1524,6 +4655,8 @@ static char * all_tests() {
     // Matrix Addition
     mu_run_test(test_adding_integer_matrix);
     mu_run_test(test_adding_double_matrix);
+    mu_run_test(test_adding_packed_matrix);
+    mu_run_test(test_adding_mixed_order_matrix);
     mu_run_test(test_adding_invalid_data_matrix);
     mu_run_test(test_adding_bad_dimensions_matrix);
 
@@ -1536,6 +4669,11 @@ static char * all_tests() {
     // Matrix multiplication
     mu_run_test(test_multiplying_integer_matrix);
     mu_run_test(test_multiplying_double_matrix);
+    mu_run_test(test_multiplying_packed_matrix);
+    mu_run_test(test_multiplying_mixed_order_matrix);
+    mu_run_test(test_multiplying_large_matrix);
+    mu_run_test(test_instruction_sets_matrix);
+    mu_run_test(test_thread_pool_matrix);
     mu_run_test(test_multiplying_invalid_data_matrix);
     mu_run_test(test_multiplying_bad_dimensions_matrix);
 
@@ -1543,17 +4681,69 @@ static char * all_tests() {
     mu_run_test(test_deep_copy_int_matrix);
     mu_run_test(test_deep_copy_double_matrix);
     mu_run_test(test_deep_copy_char_matrix);
+    mu_run_test(test_deep_copy_independent_matrix);
     mu_run_test(test_deep_copy_invalid_matrix);
 
+    // Into variants
+    mu_run_test(test_into_arithmetic_matrix);
+    mu_run_test(test_into_invalid_matrix);
+    mu_run_test(test_copy_into_matrix);
+    mu_run_test(test_gemm_matrix);
+
+    // Expressions
+    mu_run_test(test_matrix_expr);
+    mu_run_test(test_matrix_expr_errors);
+
+    // Fixed size matrices
+    mu_run_test(test_fixed_matrix);
+
+    // Batches
+    mu_run_test(test_matrix_batch);
+    mu_run_test(test_matrix_batch_errors);
+
+    // Vectors
+    mu_run_test(test_matrix_vector);
+    mu_run_test(test_matrix_vector_errors);
+
+    // Reductions
+    mu_run_test(test_matrix_reduce);
+    mu_run_test(test_matrix_reduce_errors);
+
+    // Linear systems
+    mu_run_test(test_matrix_lu);
+    mu_run_test(test_matrix_lu_errors);
+
+    // Allocators
+    mu_run_test(test_custom_allocator_matrix);
+    mu_run_test(test_arena_and_pool_allocators_matrix);
+
+    // Sparse
+    mu_run_test(test_sparse_conversions_matrix);
+    mu_run_test(test_sparse_arithmetic_matrix);
+    mu_run_test(test_sparse_large_matrix);
+
+    // Matrix files
+    mu_run_test(test_matrix_file_round_trip);
+    mu_run_test(test_matrix_file_writer_and_errors);
+
+    // Matrix text
+    mu_run_test(test_matrix_text);
+    mu_run_test(test_read_matrix_text);
+    mu_run_test(test_read_matrix_market);
+
     // Sameness
     mu_run_test(test_sameness_instance_matrix);
     mu_run_test(test_sameness_element_matrix);
+    mu_run_test(test_sameness_packed_matrix);
     mu_run_test(test_sameness_neither_matrix);
 
     // Rotation
     mu_run_test(test_rotate_nonsquare_matrix);
     mu_run_test(test_rotate_invalid_matrix);
     mu_run_test(test_rotate_valid_int_matrix);
+    mu_run_test(test_rotate_column_major_matrix);
+    mu_run_test(test_rotate_half_turn_matrix);
+    mu_run_test(test_rotated_and_transposed_copies);
 
     return 0;
 }
@@ -0,0 +1,148 @@
+#include "minunit.h"
+#include "matrix.hpp"
+#include <stdio.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+int tests_run = 0;
+int tests_failed = 0;
+char test_details[1024] = {0}; // Buffer to store test results
+
+// Typed matrices
+static char * test_typed_matrix_access() {
+    // Intro output
+    const char *functionName = "C++ - Typed Access and Views";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    matrix::Matrix<int> rows(3, 4);
+    matrix::Matrix<int, matrix::ColumnMajor> cols(3, 4);
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            rows(r, c) = r * 10 + c;
+            cols(r, c) = r * 10 + c;
+        }
+    }
+
+    // When
+    matrix::View<int> inside = rows.view(1, 2, 1, 3);
+    matrix::View<int, matrix::ColumnMajor> flipped = inside.transposed();
+    matrix::View<const int, matrix::ColumnMajor> readOnly = cols.view();
+    inside(0, 0) = -1;
+
+    // Then
+    mu_assert("TEST FAILED: Row major values should be laid out along rows",
+              rows.data()[6] == 12 && rows.data()[4] == 10);
+    mu_assert("TEST FAILED: Column major values should be laid out along columns",
+              cols.data()[1] == 10 && cols.data()[3] == 1);
+    mu_assert("TEST FAILED: Only the cell written through the view should differ", rows(2, 3) == cols(2, 3) && rows != cols);
+    mu_assert("TEST FAILED: View should be 2x3", inside.rows() == 2 && inside.cols() == 3);
+    mu_assert("TEST FAILED: Writing through a view should write the matrix", rows(1, 1) == -1);
+    mu_assert("TEST FAILED: Transposed view should swap rows and columns",
+              flipped.rows() == 3 && flipped(2, 1) == 23 && flipped(0, 0) == -1);
+    mu_assert("TEST FAILED: Read only view should see the matrix", readOnly(2, 1) == 21);
+    MatrixView c = inside.c();
+    mu_assert("TEST FAILED: C view should see the same cells",
+              c.data_type == INT && c.storage == PACKED_STORAGE && getViewElement(&c, 1, 2).int_val == 23);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Ownership and arithmetic
+static char * test_typed_matrix_ownership() {
+    // Intro output
+    const char *functionName = "C++ - Ownership and Arithmetic";
+    printf("*** TEST START: %s ***\n", functionName);
+
+    // Given
+    matrix::Matrix<double> a(2, 2);
+    matrix::Matrix<double, matrix::ColumnMajor> b(2, 2);
+    a(0, 0) = 1.0;
+    a(0, 1) = 2.0;
+    a(1, 0) = 3.0;
+    a(1, 1) = 4.0;
+    b(0, 0) = 1.0;
+    b(1, 1) = 1.0;
+
+    // When
+    matrix::Matrix<double> moved = std::move(a);
+    matrix::Matrix<double> copy = moved.clone();
+    copy(0, 0) = 9.0;
+    matrix::Matrix<double> sum = moved + b;
+    matrix::Matrix<double> product = moved * b;
+    matrix::Matrix<double, matrix::ColumnMajor> transposed(2, 2);
+    matrix::copyInto(transposed.view(), moved.view().transposed());
+
+    // A vector growing past its capacity moves its matrices, since copying them isn't allowed
+    std::vector<matrix::Matrix<double> > stack;
+    for (int i = 0; i < 5; i++) {
+        stack.push_back(matrix::Matrix<double>(2, 2));
+        stack.back()(1, 1) = i;
+    }
+
+    // Then
+    mu_assert("TEST FAILED: Moves should never throw",
+              std::is_nothrow_move_constructible<matrix::Matrix<double> >::value &&
+              std::is_nothrow_move_assignable<matrix::Matrix<double> >::value);
+    mu_assert("TEST FAILED: Matrices moved by a vector should keep their values",
+              stack.size() == 5 && stack[0](1, 1) == 0.0 && stack[4](1, 1) == 4.0);
+    mu_assert("TEST FAILED: Moved from matrix should be empty", a.empty() && !moved.empty());
+    mu_assert("TEST FAILED: Clone should be independent", moved(0, 0) == 1.0 && copy(0, 0) == 9.0);
+    mu_assert("TEST FAILED: Sum is wrong", sum(0, 0) == 2.0 && sum(0, 1) == 2.0 && sum(1, 1) == 5.0);
+    mu_assert("TEST FAILED: Multiplying by the identity should change nothing", product == moved);
+    mu_assert("TEST FAILED: Copy of a transposed view is wrong",
+              transposed(0, 1) == 3.0 && transposed(1, 0) == 2.0);
+
+    // When
+    // Mismatched sizes are refused with the library's status, and the C matrix can be taken over and given back
+    matrix::Matrix<double> wrong(3, 2);
+    MatrixStatus status = MATRIX_SUCCESS;
+    try {
+        matrix::addInto(wrong, moved, b);
+    } catch (const matrix::Error &error) {
+        status = error.status();
+    }
+    matrix::Matrix<double> adopted = matrix::Matrix<double>::adopt(
+        createMatrixWithLayout(2, 2, DOUBLE, ROW_MAJOR, PACKED_STORAGE));
+    Matrix released = adopted.release_c();
+
+    // Then
+    mu_assert("TEST FAILED: Size mismatch should be thrown", status == MATRIX_ERROR_SIZE_MISMATCH);
+    mu_assert("TEST FAILED: Released matrix should be handed over", adopted.empty() && isValid(&released));
+
+    // Cleanup
+    freeMatrix(&released);
+
+    // Success output
+    printf("*** TEST PASSED: %s ***\n\n", functionName);
+    return NULL;
+}
+
+// Run the tests
+static char * all_tests() {
+    mu_run_test(test_typed_matrix_access);
+    mu_run_test(test_typed_matrix_ownership);
+
+    return 0;
+}
+
+int main() {
+    // Run all the tests
+    all_tests();
+
+    // Calculate a pass percentage and cast it to a double for proper maths
+    double passPercent = ((double)(tests_run - tests_failed) / tests_run) * 100;
+
+    // Output a report of our passes and failures
+    printf("\n***** TEST RESULTS REPORT: *****\n");
+    printf("There were a total of %d tests that ran.\n", tests_run);
+    printf("Out of those tests, %d passed and %d failed.\n", (tests_run-tests_failed), tests_failed);
+    printf("Pass percentage: %.2f%%.\n",passPercent);
+    if (tests_failed) {
+        printf("\nFailed test details are as follows:\n%s", test_details);
+    }
+    return tests_failed != 0;
+}